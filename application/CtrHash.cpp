@@ -41,6 +41,7 @@
 
 #include <CtrHash.h>
 #include <MurmurHash.h>
+#include <iomanip>
 
 namespace Ctr
 {
@@ -121,4 +122,13 @@ Hash::append(const Hash& other)
     MurmurHash3_x64_128(stream.str().c_str(), (int32_t)(stream.str().length() * sizeof(uint8_t)), 0, &_hash[0]);
 }
 
+std::string
+Hash::toString() const
+{
+    std::ostringstream stream;
+    stream << std::hex << std::setfill('0') 
+           << std::setw(16) << _hash[0] 
+           << std::setw(16) << _hash[1];
+    return stream.str();
+}
 }
\ No newline at end of file
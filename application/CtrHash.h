@@ -65,6 +65,9 @@ class Hash
     void                       build(const std::wstring& string);
     void                       append(const Hash& hash);
 
+    // 32 hex digits, usable as a file name.
+    std::string                toString() const;
+
   private:
     static const size_t HashSize = sizeof(uint64_t)* 2;
     uint64_t                   _hash[2];
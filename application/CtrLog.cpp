@@ -40,6 +40,7 @@
 //------------------------------------------------------------------------------------//
 
 #include <CtrLog.h>
+#include <mutex>
 
 namespace Ctr
 {
@@ -50,6 +51,7 @@ LoggingLevel   Log::_logLevel = LogCritical;
 namespace
 {
 Log applicationLog;
+std::mutex logLock;
 }
 
 void Log::initialize(const std::string& filePathName)
@@ -68,6 +70,7 @@ Log::write (const std::string& buffer, LogEntryLevel level)
     if (level < _logLevel)
         return;
 
+    std::lock_guard<std::mutex> lock(logLock);
     if (!_initialized)
     {
         Log::initialize(Log::_filePathName);
@@ -49,7 +49,8 @@ namespace Ctr
 //-----------------------------------------------------------
 // class Log
 // Very, very simple and dumb logging to file wrapper.
-// Not threadsafe. Prints to std out along with file io.
+// Writes are serialized, so it may be used from loader threads.
+// Prints to std out along with file io.
 //-----------------------------------------------------------
 enum LogEntryLevel
 {
@@ -130,6 +130,22 @@ typedef HANDLE    OSHandle;
 
 #endif
 
+// SSE2 is part of the x64 baseline, x86 builds need /arch:SSE2 (or -msse2).
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CTR_SSE2 1
+#include <emmintrin.h>
+#else
+#define CTR_SSE2 0
+#endif
+
+// F16C half conversions, available with /arch:AVX2 (or -mf16c).
+#if CTR_SSE2 && (defined(__F16C__) || defined(__AVX2__))
+#define CTR_F16C 1
+#include <immintrin.h>
+#else
+#define CTR_F16C 0
+#endif
+
 #define THROW(text)                                                \
 {                                                                  \
     std::ostringstream s;                                          \
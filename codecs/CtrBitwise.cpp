@@ -0,0 +1,225 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrBitwise.h>
+
+namespace Ctr
+{
+namespace
+{
+//-----------------------------------------------------------------
+// Lookup tables for the scalar span conversions, built from the 
+// per value routines so that both give identical results.
+//-----------------------------------------------------------------
+struct HalfTables
+{
+    HalfTables()
+    {
+        // float = mantissa[offset[h >> 10] + (h & 0x3ff)] + exponent[h >> 10]
+        for (uint32_t m = 0; m < 1024; ++m)
+        {
+            mantissa[m] = Bitwise::halfToFloatI(uint16_t(m));
+            mantissa[m + 1024] = 0x38000000 + (m << 13);
+        }
+        for (uint32_t e = 0; e < 32; ++e)
+        {
+            const uint32_t bits = e == 31 ? 0x47800000 : (e << 23);
+            exponent[e] = bits;
+            exponent[e + 32] = 0x80000000 | bits;
+            offset[e] = offset[e + 32] = e == 0 ? 0 : 1024;
+        }
+
+        // half = base[f >> 23] + ((f & 0x7fffff) >> shift[f >> 23])
+        for (uint32_t i = 0; i < 512; ++i)
+        {
+            const int e = int(i & 0xff) - (127 - 15);
+            base[i] = Bitwise::floatToHalfI(i << 23);
+            if (e < -10 || (e > 30 && e != 0xff - (127 - 15)))
+                shift[i] = 24;
+            else if (e <= 0)
+                shift[i] = uint8_t(14 - e);
+            else
+                shift[i] = 13;
+        }
+    }
+
+    uint32_t                   mantissa[2048];
+    uint32_t                   exponent[64];
+    uint16_t                   offset[64];
+    uint16_t                   base[512];
+    uint8_t                    shift[512];
+};
+
+const HalfTables&
+halfTables()
+{
+    static const HalfTables tables;
+    return tables;
+}
+
+inline uint16_t
+tableFloatToHalf(const HalfTables& tables, uint32_t f)
+{
+    const uint32_t index = f >> 23;
+    uint16_t h = uint16_t(tables.base[index] + ((f & 0x007fffff) >> tables.shift[index]));
+    // NaNs whose payload is lost to truncation must not become Inf.
+    if ((f & 0x7fffffff) > 0x7f800000 && (h & 0x03ff) == 0)
+        h |= 1;
+    return h;
+}
+
+inline uint32_t
+tableHalfToFloat(const HalfTables& tables, uint16_t h)
+{
+    const uint32_t index = h >> 10;
+    return tables.mantissa[tables.offset[index] + (h & 0x03ff)] + tables.exponent[index];
+}
+
+#if CTR_SSE2
+inline __m128i
+select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Four floats to halfs in the low 16 bits of each lane.
+inline __m128i
+floatToHalf4(__m128 value)
+{
+    const __m128i bits = _mm_castps_si128(value);
+    const __m128i absolute = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+    const __m128i infinity = _mm_set1_epi32(0x7c00);
+
+    // Values below the smallest half denormal flush to +0.
+    const __m128i sign = _mm_andnot_si128(_mm_cmplt_epi32(absolute, _mm_set1_epi32(0x33000000)),
+                                          _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000)));
+
+    const __m128i normal = _mm_sub_epi32(_mm_srli_epi32(absolute, 13), _mm_set1_epi32((127 - 15) << 10));
+    // Scaling by 2^24 is exact, truncating matches the scalar shifts.
+    const __m128i denormal = _mm_cvttps_epi32(_mm_mul_ps(_mm_castsi128_ps(absolute), _mm_set1_ps(16777216.0f)));
+    const __m128i payload = _mm_srli_epi32(_mm_and_si128(absolute, _mm_set1_epi32(0x007fffff)), 13);
+    const __m128i nan = _mm_or_si128(_mm_or_si128(infinity, payload),
+                                     _mm_and_si128(_mm_cmpeq_epi32(payload, _mm_setzero_si128()), _mm_set1_epi32(1)));
+
+    __m128i half = select(_mm_cmplt_epi32(absolute, _mm_set1_epi32(0x38800000)), denormal, normal);
+    half = select(_mm_cmpgt_epi32(absolute, _mm_set1_epi32(0x477fffff)), infinity, half);
+    half = select(_mm_cmpgt_epi32(absolute, _mm_set1_epi32(0x7f800000)), nan, half);
+    return _mm_or_si128(half, sign);
+}
+
+// Halfs in the low 16 bits of each lane to four floats.
+inline __m128
+halfToFloat4(__m128i half)
+{
+    const __m128i exponentMask = _mm_set1_epi32(0x7c00 << 13);
+
+    __m128i bits = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7fff)), 13);
+    const __m128i exponent = _mm_and_si128(bits, exponentMask);
+    bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+    bits = _mm_add_epi32(bits, _mm_and_si128(_mm_cmpeq_epi32(exponent, exponentMask), 
+                                             _mm_set1_epi32((128 - 16) << 23)));
+
+    // Denormals are renormalised by the float unit, exactly.
+    const __m128 renormalised = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), 
+                                           _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+    bits = select(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()), _mm_castps_si128(renormalised), bits);
+
+    bits = _mm_or_si128(bits, _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16));
+    return _mm_castsi128_ps(bits);
+}
+#endif
+}
+
+void
+Bitwise::floatToHalf(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+#if CTR_SSE2
+    // F16C rounds to nearest and saturates differently, so the truncating
+    // SSE2 path is used in all builds to keep results identical.
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i low = floatToHalf4(_mm_loadu_ps(src + i));
+        const __m128i high = floatToHalf4(_mm_loadu_ps(src + i + 4));
+        // Sign extend so that the signed saturating pack is exact.
+        const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(low, 16), 16),
+                                               _mm_srai_epi32(_mm_slli_epi32(high, 16), 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+#endif
+    if (i < count)
+    {
+        const HalfTables& tables = halfTables();
+        const uint32_t* bits = reinterpret_cast<const uint32_t*>(src);
+        for (; i < count; ++i)
+            dst[i] = tableFloatToHalf(tables, bits[i]);
+    }
+}
+
+void
+Bitwise::halfToFloat(const uint16_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+#if CTR_F16C
+    // Note that F16C quiets signalling NaNs.
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i halfs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(dst + i, _mm_cvtph_ps(halfs));
+        _mm_storeu_ps(dst + i + 4, _mm_cvtph_ps(_mm_srli_si128(halfs, 8)));
+    }
+#elif CTR_SSE2
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i halfs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(dst + i, halfToFloat4(_mm_unpacklo_epi16(halfs, _mm_setzero_si128())));
+        _mm_storeu_ps(dst + i + 4, halfToFloat4(_mm_unpackhi_epi16(halfs, _mm_setzero_si128())));
+    }
+#endif
+    if (i < count)
+    {
+        const HalfTables& tables = halfTables();
+        uint32_t* bits = reinterpret_cast<uint32_t*>(dst);
+        for (; i < count; ++i)
+            bits[i] = tableHalfToFloat(tables, src[i]);
+    }
+}
+}
@@ -350,6 +350,16 @@ namespace Ctr
         
             return (s << 31) | (e << 23) | m;
         }
+
+        /** Converts count floats to halfs, giving the same results as
+            floatToHalf (mantissas are truncated).
+        */
+        static void floatToHalf(const float* src, uint16_t* dst, size_t count);
+
+        /** Converts count halfs to floats, giving the same results as
+            halfToFloat.
+        */
+        static void halfToFloat(const uint16_t* src, float* dst, size_t count);
          
 
     };
@@ -0,0 +1,1641 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrBlockCompressor.h>
+#include <CtrBC7Tables.h>
+#include <CtrBitwise.h>
+#include <ppl.h>
+
+namespace Ctr
+{
+namespace
+{
+inline float
+clampChannel(float value, float maxValue = 255.0f)
+{
+    return value < 0.0f ? 0.0f : (value > maxValue ? maxValue : value);
+}
+
+// Mean and (unnormalized) covariance of a set of points.
+class PointStatistics
+{
+  public:
+    PointStatistics(const float points[][4], size_t count, uint32_t channels)
+        : mChannels(channels)
+    {
+        memset(mMean, 0, sizeof(mMean));
+        memset(mCovariance, 0, sizeof(mCovariance));
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (uint32_t c = 0; c < channels; ++c)
+                mMean[c] += points[i][c];
+        }
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            mMean[c] /= float(count);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            float delta[4];
+            for (uint32_t c = 0; c < channels; ++c)
+                delta[c] = points[i][c] - mMean[c];
+            for (uint32_t row = 0; row < channels; ++row)
+            {
+                for (uint32_t column = row; column < channels; ++column)
+                    mCovariance[row][column] += delta[row] * delta[column];
+            }
+        }
+        for (uint32_t row = 0; row < channels; ++row)
+        {
+            for (uint32_t column = 0; column < row; ++column)
+                mCovariance[row][column] = mCovariance[column][row];
+        }
+    }
+
+    const float* mean() const { return mMean; }
+
+    float totalVariance() const
+    {
+        float trace = 0.0f;
+        for (uint32_t c = 0; c < mChannels; ++c)
+            trace += mCovariance[c][c];
+        return trace;
+    }
+
+    // Principal axis by power iteration, returns the variance along it.
+    float principalAxis(float axis[4]) const
+    {
+        memset(axis, 0, sizeof(float) * 4);
+        uint32_t largest = 0;
+        for (uint32_t c = 1; c < mChannels; ++c)
+        {
+            if (mCovariance[c][c] > mCovariance[largest][largest])
+                largest = c;
+        }
+        if (mCovariance[largest][largest] <= 0.0f)
+        {
+            return 0.0f;
+        }
+
+        for (uint32_t c = 0; c < mChannels; ++c)
+        {
+            axis[c] = mCovariance[largest][c];
+        }
+        for (uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            float scale = 0.0f;
+            for (uint32_t row = 0; row < mChannels; ++row)
+            {
+                for (uint32_t column = 0; column < mChannels; ++column)
+                    next[row] += mCovariance[row][column] * axis[column];
+                scale = std::max(scale, fabsf(next[row]));
+            }
+            if (scale <= 0.0f)
+            {
+                break;
+            }
+            for (uint32_t c = 0; c < mChannels; ++c)
+                axis[c] = next[c] / scale;
+        }
+
+        float length = 0.0f;
+        for (uint32_t c = 0; c < mChannels; ++c)
+        {
+            length += axis[c] * axis[c];
+        }
+        length = sqrtf(length);
+        float variance = 0.0f;
+        for (uint32_t row = 0; row < mChannels; ++row)
+        {
+            axis[row] /= length;
+        }
+        for (uint32_t row = 0; row < mChannels; ++row)
+        {
+            for (uint32_t column = 0; column < mChannels; ++column)
+                variance += axis[row] * mCovariance[row][column] * axis[column];
+        }
+        return variance;
+    }
+
+  private:
+    uint32_t mChannels;
+    float    mMean[4];
+    float    mCovariance[4][4];
+};
+
+// Endpoints at the extremes of the points projected onto axis.
+void
+rangeFitEndpoints(const float points[][4], size_t count, uint32_t channels,
+                  const float mean[4], const float axis[4], float start[4], float end[4],
+                  float maxValue = 255.0f)
+{
+    float minProjection = FLT_MAX;
+    float maxProjection = -FLT_MAX;
+    for (size_t i = 0; i < count; ++i)
+    {
+        float projection = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c)
+            projection += (points[i][c] - mean[c]) * axis[c];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        start[c] = clampChannel(mean[c] + axis[c] * minProjection, maxValue);
+        end[c] = clampChannel(mean[c] + axis[c] * maxProjection, maxValue);
+    }
+}
+
+// Least squares endpoints for points that are interpolated with the given weight of
+// the start endpoint. Returns false if the system is singular.
+bool
+leastSquaresEndpoints(const float points[][4], size_t count, uint32_t channels,
+                      const float* weights, float start[4], float end[4],
+                      float maxValue = 255.0f)
+{
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < count; ++i)
+    {
+        float a = weights[i];
+        float b = 1.0f - a;
+        aa += a * a;
+        bb += b * b;
+        ab += a * b;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            ax[c] += a * points[i][c];
+            bx[c] += b * points[i][c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) < 1e-6f)
+    {
+        return false;
+    }
+    float inverse = 1.0f / determinant;
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        start[c] = clampChannel((ax[c] * bb - bx[c] * ab) * inverse, maxValue);
+        end[c] = clampChannel((bx[c] * aa - ax[c] * ab) * inverse, maxValue);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------
+// BC1 - BC3 colour blocks
+//------------------------------------------------------------------
+inline uint32_t
+expandBits(uint32_t value, uint32_t bits)
+{
+    return (value << (8 - bits)) | (value >> (2 * bits - 8));
+}
+
+inline uint32_t
+quantizeChannel(float value, uint32_t bits)
+{
+    const uint32_t maxValue = (1 << bits) - 1;
+    return std::min(uint32_t(value * float(maxValue) / 255.0f + 0.5f), maxValue);
+}
+
+inline uint16_t
+packColor565(const float color[4])
+{
+    return uint16_t((quantizeChannel(color[0], 5) << 11) | 
+                    (quantizeChannel(color[1], 6) << 5) | 
+                     quantizeChannel(color[2], 5));
+}
+
+inline void
+unpackColor565(uint16_t color, int rgb[3])
+{
+    rgb[0] = int(expandBits((color >> 11) & 0x1f, 5));
+    rgb[1] = int(expandBits((color >> 5) & 0x3f, 6));
+    rgb[2] = int(expandBits(color & 0x1f, 5));
+}
+
+// Rounds a colour to the nearest 5:6:5 representable value.
+inline void
+snapColor565(float color[4])
+{
+    color[0] = float(expandBits(quantizeChannel(color[0], 5), 5));
+    color[1] = float(expandBits(quantizeChannel(color[1], 6), 6));
+    color[2] = float(expandBits(quantizeChannel(color[2], 5), 5));
+}
+
+// Palette of a colour block, as built by BlockDecompressor.
+void
+buildColorPalette(uint16_t color0, uint16_t color1, bool fourColor, int palette[4][3])
+{
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        int a = palette[0][c];
+        int b = palette[1][c];
+        if (fourColor)
+        {
+            palette[2][c] = (2 * a + b) / 3;
+            palette[3][c] = (a + 2 * b) / 3;
+        }
+        else
+        {
+            palette[2][c] = (a + b) >> 1;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+// Picks the closest palette entry for every texel and returns the squared error.
+// Transparent texels take index 3 of the three colour palette.
+uint32_t
+selectColorIndices(const int colors[16][3], uint32_t transparentMask,
+                   uint16_t color0, uint16_t color1, bool fourColor, uint8_t indices[16])
+{
+    int palette[4][3];
+    buildColorPalette(color0, color1, fourColor, palette);
+    const uint32_t entries = fourColor ? 4 : 3;
+
+    uint32_t error = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        if (transparentMask & (1 << i))
+        {
+            indices[i] = 3;
+            continue;
+        }
+        uint32_t bestDistance = UINT_MAX;
+        for (uint32_t entry = 0; entry < entries; ++entry)
+        {
+            int dr = colors[i][0] - palette[entry][0];
+            int dg = colors[i][1] - palette[entry][1];
+            int db = colors[i][2] - palette[entry][2];
+            uint32_t distance = uint32_t(dr * dr + dg * dg + db * db);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                indices[i] = uint8_t(entry);
+            }
+        }
+        error += bestDistance;
+    }
+    return error;
+}
+
+// Orders the endpoints for the palette mode (color0 > color1 selects four colours)
+// and writes the 8 byte block.
+void
+writeColorBlock(uint16_t color0, uint16_t color1, uint8_t indices[16], bool fourColor, uint8_t* block)
+{
+    if (fourColor)
+    {
+        if (color0 < color1)
+        {
+            std::swap(color0, color1);
+            for (uint32_t i = 0; i < 16; ++i)
+                indices[i] ^= 1;
+        }
+        else if (color0 == color1)
+        {
+            // Every entry of the palette is the same colour, BC1 would read
+            // these endpoints as a three colour block.
+            memset(indices, 0, 16);
+        }
+    }
+    else if (color0 > color1)
+    {
+        std::swap(color0, color1);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            if (indices[i] < 2)
+                indices[i] ^= 1;
+        }
+    }
+
+    uint32_t packed = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        packed |= uint32_t(indices[i]) << (i * 2);
+    }
+    block[0] = uint8_t(color0);
+    block[1] = uint8_t(color0 >> 8);
+    block[2] = uint8_t(color1);
+    block[3] = uint8_t(color1 >> 8);
+    block[4] = uint8_t(packed);
+    block[5] = uint8_t(packed >> 8);
+    block[6] = uint8_t(packed >> 16);
+    block[7] = uint8_t(packed >> 24);
+}
+
+// Endpoint pairs that reproduce a single 8 bit value exactly (or as close as possible)
+// through the 2/3 : 1/3 palette entry.
+struct SingleColorTables
+{
+    uint8_t endpoints5[256][2];
+    uint8_t endpoints6[256][2];
+
+    SingleColorTables()
+    {
+        build(endpoints5, 5);
+        build(endpoints6, 6);
+    }
+
+    static void build(uint8_t table[256][2], uint32_t bits)
+    {
+        const int levels = 1 << bits;
+        for (int value = 0; value < 256; ++value)
+        {
+            int bestError = INT_MAX;
+            int bestSpread = INT_MAX;
+            for (int e0 = 0; e0 < levels; ++e0)
+            {
+                int x0 = int(expandBits(e0, bits));
+                for (int e1 = 0; e1 < levels; ++e1)
+                {
+                    int x1 = int(expandBits(e1, bits));
+                    int error = abs((2 * x0 + x1) / 3 - value);
+                    // Close endpoints are the least sensitive to decoder rounding.
+                    int spread = abs(x0 - x1);
+                    if (error < bestError || (error == bestError && spread < bestSpread))
+                    {
+                        bestError = error;
+                        bestSpread = spread;
+                        table[value][0] = uint8_t(e0);
+                        table[value][1] = uint8_t(e1);
+                    }
+                }
+            }
+        }
+    }
+};
+
+const SingleColorTables singleColorTables;
+
+// Least squares fit for every ordering preserving split of the points into palette 
+// clusters along axis, scored on the 5:6:5 grid (the squish cluster fit).
+void
+clusterFitEndpoints(const float points[][4], size_t count, const float axis[4], 
+                    bool fourColor, float start[4], float end[4])
+{
+    float projections[16];
+    uint8_t order[16];
+    for (size_t i = 0; i < count; ++i)
+    {
+        projections[i] = points[i][0] * axis[0] + points[i][1] * axis[1] + points[i][2] * axis[2];
+        order[i] = uint8_t(i);
+    }
+    std::sort(order, order + count, [&](uint8_t a, uint8_t b) { return projections[a] < projections[b]; });
+
+    float prefix[17][3];
+    prefix[0][0] = prefix[0][1] = prefix[0][2] = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            prefix[i + 1][c] = prefix[i][c] + points[order[i]][c];
+    }
+    const float* total = prefix[count];
+
+    float bestError = FLT_MAX;
+    auto evaluate = [&](float aa, float bb, float ab, const float ax[3])
+    {
+        float determinant = aa * bb - ab * ab;
+        if (fabsf(determinant) < 1e-6f)
+        {
+            return;
+        }
+        float inverse = 1.0f / determinant;
+        float a[4], b[4];
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            float bx = total[c] - ax[c];
+            a[c] = clampChannel((ax[c] * bb - bx * ab) * inverse);
+            b[c] = clampChannel((bx * aa - ax[c] * ab) * inverse);
+        }
+        snapColor565(a);
+        snapColor565(b);
+
+        // Squared error less the constant sum of the squared points.
+        float error = 0.0f;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            float bx = total[c] - ax[c];
+            error += a[c] * (aa * a[c] - 2.0f * ax[c]) + 
+                     b[c] * (bb * b[c] - 2.0f * bx) + 
+                     2.0f * ab * a[c] * b[c];
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            memcpy(start, a, sizeof(float) * 3);
+            memcpy(end, b, sizeof(float) * 3);
+        }
+    };
+
+    float ax[3];
+    if (fourColor)
+    {
+        // Clusters [0, i), [i, j), [j, k) and [k, count) take weights 1, 2/3, 1/3 and 0.
+        for (size_t i = 0; i <= count; ++i)
+        {
+            for (size_t j = i; j <= count; ++j)
+            {
+                for (size_t k = j; k <= count; ++k)
+                {
+                    float n1 = float(j - i);
+                    float n2 = float(k - j);
+                    float aa = float(i) + n1 * (4.0f / 9.0f) + n2 * (1.0f / 9.0f);
+                    float bb = float(count - k) + n2 * (4.0f / 9.0f) + n1 * (1.0f / 9.0f);
+                    float ab = (n1 + n2) * (2.0f / 9.0f);
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        ax[c] = prefix[i][c] + 
+                                (prefix[j][c] - prefix[i][c]) * (2.0f / 3.0f) + 
+                                (prefix[k][c] - prefix[j][c]) * (1.0f / 3.0f);
+                    }
+                    evaluate(aa, bb, ab, ax);
+                }
+            }
+        }
+    }
+    else
+    {
+        // Clusters [0, i), [i, j) and [j, count) take weights 1, 1/2 and 0.
+        for (size_t i = 0; i <= count; ++i)
+        {
+            for (size_t j = i; j <= count; ++j)
+            {
+                float n1 = float(j - i);
+                float aa = float(i) + n1 * 0.25f;
+                float bb = float(count - j) + n1 * 0.25f;
+                float ab = n1 * 0.25f;
+                for (uint32_t c = 0; c < 3; ++c)
+                    ax[c] = prefix[i][c] + (prefix[j][c] - prefix[i][c]) * 0.5f;
+                evaluate(aa, bb, ab, ax);
+            }
+        }
+    }
+}
+
+void
+encodeColorBlock(const uint8_t texels[16][4], bool allowTransparent, 
+                 BlockCompressor::Quality quality, uint8_t* block)
+{
+    int colors[16][3];
+    float points[16][4];
+    uint8_t pointTexels[16];
+    uint32_t transparentMask = 0;
+    size_t count = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            colors[i][c] = texels[i][c];
+        if (allowTransparent && texels[i][3] < 128)
+        {
+            transparentMask |= 1 << i;
+            continue;
+        }
+        for (uint32_t c = 0; c < 3; ++c)
+            points[count][c] = float(texels[i][c]);
+        points[count][3] = 0.0f;
+        pointTexels[count++] = uint8_t(i);
+    }
+
+    uint8_t indices[16];
+    const bool fourColor = transparentMask == 0;
+    if (count == 0)
+    {
+        memset(indices, 3, sizeof(indices));
+        writeColorBlock(0, 0, indices, false, block);
+        return;
+    }
+
+    PointStatistics statistics(points, count, 3);
+    if (statistics.totalVariance() <= 0.0f)
+    {
+        uint16_t color0, color1;
+        if (fourColor)
+        {
+            const uint8_t* r = singleColorTables.endpoints5[colors[0][0]];
+            const uint8_t* g = singleColorTables.endpoints6[colors[0][1]];
+            const uint8_t* b = singleColorTables.endpoints5[colors[0][2]];
+            color0 = uint16_t((r[0] << 11) | (g[0] << 5) | b[0]);
+            color1 = uint16_t((r[1] << 11) | (g[1] << 5) | b[1]);
+            memset(indices, 2, sizeof(indices));
+        }
+        else
+        {
+            color0 = color1 = packColor565(points[0]);
+            selectColorIndices(colors, transparentMask, color0, color1, false, indices);
+        }
+        writeColorBlock(color0, color1, indices, fourColor, block);
+        return;
+    }
+
+    float axis[4];
+    float start[4], end[4];
+    statistics.principalAxis(axis);
+    rangeFitEndpoints(points, count, 3, statistics.mean(), axis, start, end);
+
+    uint16_t bestColor0 = packColor565(start);
+    uint16_t bestColor1 = packColor565(end);
+    bool bestFourColor = fourColor;
+    uint32_t bestError = selectColorIndices(colors, transparentMask, bestColor0, bestColor1, fourColor, indices);
+
+    auto tryEndpoints = [&](const float* start, const float* end, bool four) -> bool
+    {
+        uint16_t color0 = packColor565(start);
+        uint16_t color1 = packColor565(end);
+        uint8_t candidate[16];
+        uint32_t error = selectColorIndices(colors, transparentMask, color0, color1, four, candidate);
+        if (error >= bestError)
+        {
+            return false;
+        }
+        bestError = error;
+        bestColor0 = color0;
+        bestColor1 = color1;
+        bestFourColor = four;
+        memcpy(indices, candidate, sizeof(indices));
+        return true;
+    };
+
+    if (quality != BlockCompressor::QUALITY_FAST)
+    {
+        // Refit the endpoints to the selected indices while that improves the block.
+        static const float fourColorWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        static const float threeColorWeights[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+        const float* paletteWeights = fourColor ? fourColorWeights : threeColorWeights;
+        const uint32_t iterations = quality == BlockCompressor::QUALITY_HIGH ? 4 : 2;
+        for (uint32_t iteration = 0; iteration < iterations && bestError > 0; ++iteration)
+        {
+            float weights[16];
+            for (size_t i = 0; i < count; ++i)
+                weights[i] = paletteWeights[indices[pointTexels[i]]];
+            if (!leastSquaresEndpoints(points, count, 3, weights, start, end) ||
+                !tryEndpoints(start, end, fourColor))
+            {
+                break;
+            }
+        }
+    }
+
+    if (quality == BlockCompressor::QUALITY_HIGH && bestError > 0)
+    {
+        clusterFitEndpoints(points, count, axis, fourColor, start, end);
+        tryEndpoints(start, end, fourColor);
+        if (allowTransparent && fourColor)
+        {
+            // Opaque BC1 blocks can still use the three colour palette.
+            clusterFitEndpoints(points, count, axis, false, start, end);
+            tryEndpoints(start, end, false);
+        }
+    }
+
+    writeColorBlock(bestColor0, bestColor1, indices, bestFourColor, block);
+}
+
+// BC2 explicit 4 bit alpha.
+void
+encodeExplicitAlphaBlock(const uint8_t texels[16][4], uint8_t* block)
+{
+    for (uint32_t y = 0; y < 4; ++y)
+    {
+        uint32_t row = 0;
+        for (uint32_t x = 0; x < 4; ++x)
+            row |= ((texels[y * 4 + x][3] * 15 + 127) / 255) << (x * 4);
+        block[y * 2] = uint8_t(row);
+        block[y * 2 + 1] = uint8_t(row >> 8);
+    }
+}
+
+//------------------------------------------------------------------
+// BC3 alpha, BC4 and BC5 channel blocks
+//------------------------------------------------------------------
+
+// Palette of a channel block, as built by BlockDecompressor.
+void
+buildChannelPalette(int value0, int value1, int palette[8])
+{
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1)
+    {
+        for (int i = 0; i < 6; ++i)
+            palette[i + 2] = ((6 - i) * value0 + (i + 1) * value1 + 3) / 7;
+    }
+    else
+    {
+        for (int i = 0; i < 4; ++i)
+            palette[i + 2] = ((4 - i) * value0 + (i + 1) * value1 + 2) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+uint32_t
+selectChannelIndices(const uint8_t values[16], int value0, int value1, uint8_t indices[16])
+{
+    int palette[8];
+    buildChannelPalette(value0, value1, palette);
+
+    uint32_t error = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        uint32_t bestDistance = UINT_MAX;
+        for (uint32_t entry = 0; entry < 8; ++entry)
+        {
+            int delta = int(values[i]) - palette[entry];
+            uint32_t distance = uint32_t(delta * delta);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                indices[i] = uint8_t(entry);
+            }
+        }
+        error += bestDistance;
+    }
+    return error;
+}
+
+void
+encodeChannelBlock(const uint8_t values[16], BlockCompressor::Quality quality, uint8_t* block)
+{
+    int minValue = 255, maxValue = 0;
+    int minInner = 255, maxInner = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        int value = values[i];
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+        if (value != 0 && value != 255)
+        {
+            minInner = std::min(minInner, value);
+            maxInner = std::max(maxInner, value);
+        }
+    }
+
+    uint8_t indices[16];
+    int best0 = maxValue;
+    int best1 = minValue;
+    uint32_t bestError = selectChannelIndices(values, best0, best1, indices);
+
+    auto tryEndpoints = [&](int value0, int value1) -> bool
+    {
+        uint8_t candidate[16];
+        uint32_t error = selectChannelIndices(values, value0, value1, candidate);
+        if (error >= bestError)
+        {
+            return false;
+        }
+        bestError = error;
+        best0 = value0;
+        best1 = value1;
+        memcpy(indices, candidate, sizeof(indices));
+        return true;
+    };
+
+    if (bestError > 0)
+    {
+        // Six interpolated values plus explicit 0 and 255, endpoints ordered low to high.
+        if (minInner <= maxInner)
+            tryEndpoints(minInner, maxInner);
+        else
+            tryEndpoints(0, 0);
+    }
+
+    if (quality != BlockCompressor::QUALITY_FAST && bestError > 0 && best0 > best1)
+    {
+        // Weight of the first endpoint for each index of the eight value palette.
+        static const float paletteWeights[8] = 
+        {
+            1.0f, 0.0f, 6.0f / 7.0f, 5.0f / 7.0f, 4.0f / 7.0f, 3.0f / 7.0f, 2.0f / 7.0f, 1.0f / 7.0f
+        };
+        float points[16][4];
+        float weights[16];
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            points[i][0] = float(values[i]);
+            weights[i] = paletteWeights[indices[i]];
+        }
+        float start[4], end[4];
+        if (leastSquaresEndpoints(points, 16, 1, weights, start, end))
+        {
+            int value0 = int(start[0] + 0.5f);
+            int value1 = int(end[0] + 0.5f);
+            if (value0 > value1)
+                tryEndpoints(value0, value1);
+        }
+    }
+
+    if (quality == BlockCompressor::QUALITY_HIGH && bestError > 0)
+    {
+        // Search the eight value palette around the range of the block.
+        const int radius = 4;
+        for (int value0 = std::max(maxValue - radius, 1); value0 <= std::min(maxValue + radius, 255); ++value0)
+        {
+            for (int value1 = std::max(minValue - radius, 0); value1 <= minValue + radius && value1 < value0; ++value1)
+                tryEndpoints(value0, value1);
+        }
+    }
+
+    uint64_t packed = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        packed |= uint64_t(indices[i]) << (i * 3);
+    }
+    block[0] = uint8_t(best0);
+    block[1] = uint8_t(best1);
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        block[i + 2] = uint8_t(packed >> (i * 8));
+    }
+}
+
+//------------------------------------------------------------------
+// BC7
+//------------------------------------------------------------------
+struct BC7Encoding
+{
+    uint32_t mode;
+    uint32_t partition;
+    // Quantized endpoints without p-bits, two per subset.
+    uint32_t endpoints[6][4];
+    uint32_t pbits[6];
+    uint8_t  indices[16];
+    uint32_t error;
+};
+
+// Writes the fields of a 128 bit block, least significant bit first.
+class BlockBitWriter
+{
+  public:
+    BlockBitWriter(uint8_t* data) : mData(data), mPosition(0)
+    {
+        memset(mData, 0, 16);
+    }
+
+    void write(uint32_t value, uint32_t bits)
+    {
+        for (uint32_t i = 0; i < bits; ++i, ++mPosition)
+        {
+            if (value & (1 << i))
+                mData[mPosition >> 3] |= uint8_t(1 << (mPosition & 7));
+        }
+    }
+
+  private:
+    uint8_t* mData;
+    uint32_t mPosition;
+};
+
+// Nearest quantized value with bits of precision plus an optional p-bit (pbit < 0 for none).
+// decoded receives the 8 bit value the decoder will reconstruct.
+uint32_t
+quantizeBC7Channel(float value, uint32_t bits, int pbit, uint32_t& decoded)
+{
+    const uint32_t totalBits = pbit < 0 ? bits : bits + 1;
+    const int maxValue = (1 << bits) - 1;
+    const float scaled = value * float((1 << totalBits) - 1) / 255.0f;
+    const int estimate = pbit < 0 ? int(scaled + 0.5f) : int((scaled - float(pbit)) * 0.5f + 0.5f);
+
+    uint32_t best = 0;
+    float bestError = FLT_MAX;
+    for (int candidate = std::max(estimate - 1, 0); candidate <= std::min(estimate + 1, maxValue); ++candidate)
+    {
+        uint32_t stored = pbit < 0 ? uint32_t(candidate) : (uint32_t(candidate) << 1) | uint32_t(pbit);
+        uint32_t value8 = BC7::unquantize(stored, totalBits);
+        float error = fabsf(float(value8) - value);
+        if (error < bestError)
+        {
+            bestError = error;
+            best = uint32_t(candidate);
+            decoded = value8;
+        }
+    }
+    return best;
+}
+
+void
+quantizeBC7Endpoint(const BC7::ModeInfo& info, const float color[4], int pbit, 
+                    uint32_t quantized[4], uint32_t decoded[4])
+{
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        quantized[c] = quantizeBC7Channel(color[c], info.colorBits, pbit, decoded[c]);
+    }
+    if (info.alphaBits)
+    {
+        quantized[3] = quantizeBC7Channel(color[3], info.alphaBits, pbit, decoded[3]);
+    }
+    else
+    {
+        quantized[3] = 0;
+        decoded[3] = 255;
+    }
+}
+
+// Squared error of the subset texels against the palette of the decoded endpoints.
+uint32_t
+selectBC7Indices(const BC7::ModeInfo& info, const uint8_t texels[16][4], 
+                 const uint8_t* members, size_t count,
+                 const uint32_t decoded0[4], const uint32_t decoded1[4], uint8_t indices[16])
+{
+    const uint32_t entries = 1 << info.indexBits;
+    const uint32_t* weights = BC7::weights(info.indexBits);
+    int palette[16][4];
+    for (uint32_t entry = 0; entry < entries; ++entry)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+            palette[entry][c] = int(BC7::interpolate(decoded0[c], decoded1[c], weights[entry]));
+    }
+
+    uint32_t error = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint8_t* texel = texels[members[i]];
+        uint32_t bestDistance = UINT_MAX;
+        for (uint32_t entry = 0; entry < entries; ++entry)
+        {
+            uint32_t distance = 0;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                int delta = int(texel[c]) - palette[entry][c];
+                distance += uint32_t(delta * delta);
+            }
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                indices[members[i]] = uint8_t(entry);
+            }
+        }
+        error += bestDistance;
+    }
+    return error;
+}
+
+// Fits the endpoints of one subset, trying every p-bit assignment.
+uint32_t
+encodeBC7Subset(const BC7::ModeInfo& info, const uint8_t texels[16][4], 
+                const uint8_t* members, size_t count, 
+                BlockCompressor::Quality quality,
+                uint32_t endpoints[2][4], uint32_t pbits[2], uint8_t indices[16])
+{
+    const uint32_t channels = info.alphaBits ? 4 : 3;
+    float points[16][4];
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+            points[i][c] = float(texels[members[i]][c]);
+    }
+
+    PointStatistics statistics(points, count, channels);
+    float start[4], end[4];
+    memcpy(start, statistics.mean(), sizeof(start));
+    memcpy(end, statistics.mean(), sizeof(end));
+    float axis[4];
+    if (statistics.principalAxis(axis) > 0.0f)
+    {
+        rangeFitEndpoints(points, count, channels, statistics.mean(), axis, start, end);
+    }
+
+    // p-bit pairs to try for the two endpoints, -1 for modes without them.
+    int pbitPairs[4][2] = { { -1, -1 } };
+    uint32_t numPairs = 1;
+    if (info.endpointPBits)
+    {
+        for (uint32_t pair = 0; pair < 4; ++pair)
+        {
+            pbitPairs[pair][0] = int(pair & 1);
+            pbitPairs[pair][1] = int(pair >> 1);
+        }
+        numPairs = 4;
+    }
+    else if (info.sharedPBits)
+    {
+        pbitPairs[0][0] = pbitPairs[0][1] = 0;
+        pbitPairs[1][0] = pbitPairs[1][1] = 1;
+        numPairs = 2;
+    }
+
+    uint32_t bestError = UINT_MAX;
+    auto tryEndpoints = [&](const float* start, const float* end) -> bool
+    {
+        bool improved = false;
+        for (uint32_t pair = 0; pair < numPairs; ++pair)
+        {
+            uint32_t quantized[2][4], decoded[2][4];
+            quantizeBC7Endpoint(info, start, pbitPairs[pair][0], quantized[0], decoded[0]);
+            quantizeBC7Endpoint(info, end, pbitPairs[pair][1], quantized[1], decoded[1]);
+
+            uint8_t candidate[16];
+            uint32_t error = selectBC7Indices(info, texels, members, count, decoded[0], decoded[1], candidate);
+            if (error < bestError)
+            {
+                bestError = error;
+                memcpy(endpoints, quantized, sizeof(quantized));
+                pbits[0] = uint32_t(std::max(pbitPairs[pair][0], 0));
+                pbits[1] = uint32_t(std::max(pbitPairs[pair][1], 0));
+                for (size_t i = 0; i < count; ++i)
+                    indices[members[i]] = candidate[members[i]];
+                improved = true;
+            }
+        }
+        return improved;
+    };
+
+    tryEndpoints(start, end);
+
+    const uint32_t iterations = quality == BlockCompressor::QUALITY_HIGH ? 3 : 
+                                (quality == BlockCompressor::QUALITY_NORMAL ? 1 : 0);
+    const uint32_t* paletteWeights = BC7::weights(info.indexBits);
+    for (uint32_t iteration = 0; iteration < iterations && bestError > 0; ++iteration)
+    {
+        float weights[16];
+        for (size_t i = 0; i < count; ++i)
+            weights[i] = 1.0f - float(paletteWeights[indices[members[i]]]) / 64.0f;
+        if (!leastSquaresEndpoints(points, count, channels, weights, start, end) ||
+            !tryEndpoints(start, end))
+        {
+            break;
+        }
+    }
+    return bestError;
+}
+
+uint32_t
+encodeBC7Mode(uint32_t mode, uint32_t partition, const uint8_t texels[16][4], 
+              BlockCompressor::Quality quality, BC7Encoding& encoding)
+{
+    const BC7::ModeInfo& info = BC7::Modes[mode];
+    uint8_t members[3][16];
+    size_t counts[3] = { 0, 0, 0 };
+    for (uint32_t texel = 0; texel < 16; ++texel)
+    {
+        uint32_t subset = BC7::subsetOf(info.numSubsets, partition, texel);
+        members[subset][counts[subset]++] = uint8_t(texel);
+    }
+
+    encoding.mode = mode;
+    encoding.partition = partition;
+    encoding.error = 0;
+    for (uint32_t subset = 0; subset < info.numSubsets; ++subset)
+    {
+        encoding.error += encodeBC7Subset(info, texels, members[subset], counts[subset], quality,
+                                          encoding.endpoints + subset * 2, 
+                                          encoding.pbits + subset * 2, 
+                                          encoding.indices);
+    }
+    return encoding.error;
+}
+
+// Orders the two subset partitions by how far their texels lie from a line 
+// in colour space, the most promising first.
+void
+rankBC7Partitions(const uint8_t texels[16][4], uint32_t channels, uint32_t ranked[64])
+{
+    float estimates[64];
+    for (uint32_t partition = 0; partition < 64; ++partition)
+    {
+        estimates[partition] = 0.0f;
+        for (uint32_t subset = 0; subset < 2; ++subset)
+        {
+            float points[16][4];
+            size_t count = 0;
+            for (uint32_t texel = 0; texel < 16; ++texel)
+            {
+                if (BC7::PartitionTable2[partition][texel] != subset)
+                    continue;
+                for (uint32_t c = 0; c < 4; ++c)
+                    points[count][c] = float(texels[texel][c]);
+                count++;
+            }
+            PointStatistics statistics(points, count, channels);
+            float axis[4];
+            estimates[partition] += statistics.totalVariance() - statistics.principalAxis(axis);
+        }
+        ranked[partition] = partition;
+    }
+    std::sort(ranked, ranked + 64, [&](uint32_t a, uint32_t b) { return estimates[a] < estimates[b]; });
+}
+
+void
+writeBC7Block(BC7Encoding encoding, uint8_t* block)
+{
+    const BC7::ModeInfo& info = BC7::Modes[encoding.mode];
+    const uint32_t maxIndex = (1 << info.indexBits) - 1;
+    const uint32_t highBit = 1 << (info.indexBits - 1);
+
+    // Anchor texels are stored without the top index bit, swap the endpoints of
+    // any subset whose anchor needs it. The weight table is symmetric.
+    for (uint32_t subset = 0; subset < info.numSubsets; ++subset)
+    {
+        uint32_t anchor = BC7::anchorOf(info.numSubsets, encoding.partition, subset);
+        if ((encoding.indices[anchor] & highBit) == 0)
+        {
+            continue;
+        }
+        for (uint32_t c = 0; c < 4; ++c)
+            std::swap(encoding.endpoints[subset * 2][c], encoding.endpoints[subset * 2 + 1][c]);
+        std::swap(encoding.pbits[subset * 2], encoding.pbits[subset * 2 + 1]);
+        for (uint32_t texel = 0; texel < 16; ++texel)
+        {
+            if (BC7::subsetOf(info.numSubsets, encoding.partition, texel) == subset)
+                encoding.indices[texel] = uint8_t(maxIndex - encoding.indices[texel]);
+        }
+    }
+
+    const uint32_t numEndpoints = info.numSubsets * 2;
+    BlockBitWriter bits(block);
+    bits.write(1 << encoding.mode, encoding.mode + 1);
+    bits.write(encoding.partition, info.partitionBits);
+    bits.write(0, info.rotationBits);
+    bits.write(0, info.indexSelectionBits);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        for (uint32_t e = 0; e < numEndpoints; ++e)
+            bits.write(encoding.endpoints[e][c], info.colorBits);
+    }
+    for (uint32_t e = 0; e < numEndpoints; ++e)
+    {
+        bits.write(encoding.endpoints[e][3], info.alphaBits);
+    }
+    if (info.endpointPBits)
+    {
+        for (uint32_t e = 0; e < numEndpoints; ++e)
+            bits.write(encoding.pbits[e], 1);
+    }
+    else if (info.sharedPBits)
+    {
+        for (uint32_t subset = 0; subset < info.numSubsets; ++subset)
+            bits.write(encoding.pbits[subset * 2], 1);
+    }
+    for (uint32_t texel = 0; texel < 16; ++texel)
+    {
+        uint32_t subset = BC7::subsetOf(info.numSubsets, encoding.partition, texel);
+        bool anchor = texel == BC7::anchorOf(info.numSubsets, encoding.partition, subset);
+        bits.write(encoding.indices[texel], anchor ? info.indexBits - 1 : info.indexBits);
+    }
+}
+
+// Mode 6 (one subset RGBA) is always tried. The two subset modes 1 and 3 (opaque)
+// or 7 (with alpha) are searched over the best ranked partitions.
+void
+encodeBC7Block(const uint8_t texels[16][4], BlockCompressor::Quality quality, uint8_t* block)
+{
+    bool opaque = true;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        opaque &= texels[i][3] == 255;
+    }
+
+    BC7Encoding best;
+    encodeBC7Mode(6, 0, texels, quality, best);
+
+    if (quality != BlockCompressor::QUALITY_FAST && best.error > 0)
+    {
+        static const uint32_t opaqueModes[] = { 1, 3 };
+        static const uint32_t alphaModes[] = { 7 };
+        const uint32_t* modes = opaque ? opaqueModes : alphaModes;
+        const uint32_t numModes = opaque ? 2 : 1;
+        const uint32_t numPartitions = quality == BlockCompressor::QUALITY_HIGH ? 16 : 4;
+
+        uint32_t ranked[64];
+        rankBC7Partitions(texels, opaque ? 3 : 4, ranked);
+
+        BC7Encoding candidate;
+        for (uint32_t partition = 0; partition < numPartitions && best.error > 0; ++partition)
+        {
+            for (uint32_t mode = 0; mode < numModes; ++mode)
+            {
+                if (encodeBC7Mode(modes[mode], ranked[partition], texels, quality, candidate) < best.error)
+                    best = candidate;
+            }
+        }
+    }
+
+    writeBC7Block(best, block);
+}
+
+//------------------------------------------------------------------
+// BC6H (unsigned half float, single subset modes 11 and 12)
+//------------------------------------------------------------------
+// Endpoints are fitted to the half float bit patterns rescaled to the 16 bit
+// range the hardware interpolates in. Interpolating bit patterns is close to
+// interpolating logarithmically, so errors are weighted towards dark texels
+// the same way the decoder distributes its precision.
+struct BC6HEncoding
+{
+    // Mode 11 (10 bit endpoints) or mode 12 (11 bit base, 9 bit delta).
+    uint32_t mode;
+    uint32_t endpoints[2][3];
+    uint8_t  indices[16];
+    uint64_t error;
+};
+
+// Bit pattern of the nearest non negative, finite half float.
+inline uint32_t
+unsignedHalf(float value)
+{
+    if (!(value > 0.0f))
+    {
+        // Negative values and NaNs.
+        return 0;
+    }
+    return std::min(uint32_t(Bitwise::floatToHalf(value)), uint32_t(0x7bff));
+}
+
+// Expands an n bit unsigned endpoint to the 16 bit interpolation range.
+inline uint32_t
+unquantizeBC6HChannel(uint32_t value, uint32_t bits)
+{
+    if (value == 0)
+        return 0;
+    if (value == (1u << bits) - 1)
+        return 0xffff;
+    return ((value << 16) + 0x8000) >> bits;
+}
+
+// Scales an interpolated value back to a half float bit pattern.
+inline uint32_t
+finishBC6HChannel(uint32_t value)
+{
+    return (value * 31) >> 6;
+}
+
+inline uint32_t
+quantizeBC6HChannel(float value, uint32_t bits)
+{
+    const int maxValue = (1 << bits) - 1;
+    const int base = std::min(int(value * float(1 << bits) / 65536.0f), maxValue);
+    int best = base;
+    float bestDistance = FLT_MAX;
+    for (int candidate = std::max(base - 1, 0); candidate <= std::min(base + 1, maxValue); ++candidate)
+    {
+        float distance = fabsf(float(unquantizeBC6HChannel(uint32_t(candidate), bits)) - value);
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = candidate;
+        }
+    }
+    return uint32_t(best);
+}
+
+// Squared error of the texels against the palette of the quantized endpoints.
+uint64_t
+selectBC6HIndices(const uint32_t texels[16][3], const uint32_t endpoints[2][3], 
+                  uint32_t bits, uint8_t indices[16])
+{
+    uint32_t palette[16][3];
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        const uint32_t start = unquantizeBC6HChannel(endpoints[0][c], bits);
+        const uint32_t end = unquantizeBC6HChannel(endpoints[1][c], bits);
+        for (uint32_t entry = 0; entry < 16; ++entry)
+            palette[entry][c] = finishBC6HChannel(BC7::interpolate(start, end, BC7::Weights4[entry]));
+    }
+
+    uint64_t error = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        uint64_t bestDistance = UINT64_MAX;
+        for (uint32_t entry = 0; entry < 16; ++entry)
+        {
+            uint64_t distance = 0;
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                int64_t delta = int64_t(texels[i][c]) - int64_t(palette[entry][c]);
+                distance += uint64_t(delta * delta);
+            }
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                indices[i] = uint8_t(entry);
+            }
+        }
+        error += bestDistance;
+    }
+    return error;
+}
+
+// Fits and quantizes the endpoints for one mode. Returns false if the
+// endpoints can not be represented (mode 12 deltas out of range).
+bool
+encodeBC6HMode(uint32_t mode, const uint32_t texels[16][3], 
+               BlockCompressor::Quality quality, BC6HEncoding& encoding)
+{
+    const uint32_t bits = mode == 11 ? 10 : 11;
+
+    float points[16][4];
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            points[i][c] = float(texels[i][c]) * (64.0f / 31.0f);
+        points[i][3] = 0.0f;
+    }
+
+    PointStatistics statistics(points, 16, 3);
+    float start[4], end[4];
+    memcpy(start, statistics.mean(), sizeof(start));
+    memcpy(end, statistics.mean(), sizeof(end));
+    float axis[4];
+    if (statistics.principalAxis(axis) > 0.0f)
+    {
+        rangeFitEndpoints(points, 16, 3, statistics.mean(), axis, start, end, 65535.0f);
+    }
+
+    encoding.mode = mode;
+    encoding.error = UINT64_MAX;
+    auto tryEndpoints = [&](const uint32_t endpoints[2][3]) -> bool
+    {
+        uint8_t candidate[16];
+        uint64_t error = selectBC6HIndices(texels, endpoints, bits, candidate);
+        if (error < encoding.error)
+        {
+            encoding.error = error;
+            memcpy(encoding.endpoints, endpoints, sizeof(encoding.endpoints));
+            memcpy(encoding.indices, candidate, sizeof(candidate));
+            return true;
+        }
+        return false;
+    };
+    auto tryFloatEndpoints = [&](const float* start, const float* end) -> bool
+    {
+        uint32_t endpoints[2][3];
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            endpoints[0][c] = quantizeBC6HChannel(start[c], bits);
+            endpoints[1][c] = quantizeBC6HChannel(end[c], bits);
+        }
+        return tryEndpoints(endpoints);
+    };
+
+    tryFloatEndpoints(start, end);
+
+    const uint32_t iterations = quality == BlockCompressor::QUALITY_HIGH ? 3 : 
+                                (quality == BlockCompressor::QUALITY_NORMAL ? 1 : 0);
+    for (uint32_t iteration = 0; iteration < iterations && encoding.error > 0; ++iteration)
+    {
+        float weights[16];
+        for (uint32_t i = 0; i < 16; ++i)
+            weights[i] = 1.0f - float(BC7::Weights4[encoding.indices[i]]) / 64.0f;
+        if (!leastSquaresEndpoints(points, 16, 3, weights, start, end, 65535.0f) ||
+            !tryFloatEndpoints(start, end))
+        {
+            break;
+        }
+    }
+
+    if (quality == BlockCompressor::QUALITY_HIGH)
+    {
+        // Nudge each quantized endpoint channel by one step while it helps.
+        const int maxValue = (1 << bits) - 1;
+        bool improved = encoding.error > 0;
+        while (improved)
+        {
+            improved = false;
+            for (uint32_t component = 0; component < 6; ++component)
+            {
+                for (int step = -1; step <= 1; step += 2)
+                {
+                    uint32_t endpoints[2][3];
+                    memcpy(endpoints, encoding.endpoints, sizeof(endpoints));
+                    int value = int(endpoints[component / 3][component % 3]) + step;
+                    if (value < 0 || value > maxValue)
+                        continue;
+                    endpoints[component / 3][component % 3] = uint32_t(value);
+                    improved |= tryEndpoints(endpoints);
+                }
+            }
+        }
+    }
+
+    // The most significant index bit of the first texel is implicitly zero.
+    if (encoding.indices[0] & 0x8)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            std::swap(encoding.endpoints[0][c], encoding.endpoints[1][c]);
+        for (uint32_t i = 0; i < 16; ++i)
+            encoding.indices[i] = uint8_t(15 - encoding.indices[i]);
+    }
+
+    if (mode == 12)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            int delta = int(encoding.endpoints[1][c]) - int(encoding.endpoints[0][c]);
+            if (delta < -256 || delta > 255)
+                return false;
+        }
+    }
+    return true;
+}
+
+void
+writeBC6HBlock(const BC6HEncoding& encoding, uint8_t* block)
+{
+    BlockBitWriter writer(block);
+    if (encoding.mode == 11)
+    {
+        writer.write(0x03, 5);
+        for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+                writer.write(encoding.endpoints[endpoint][c], 10);
+        }
+    }
+    else
+    {
+        // Low 10 bits of the base, then each delta followed by bit 10 of the base.
+        writer.write(0x07, 5);
+        for (uint32_t c = 0; c < 3; ++c)
+            writer.write(encoding.endpoints[0][c] & 0x3ff, 10);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            int delta = int(encoding.endpoints[1][c]) - int(encoding.endpoints[0][c]);
+            writer.write(uint32_t(delta) & 0x1ff, 9);
+            writer.write(encoding.endpoints[0][c] >> 10, 1);
+        }
+    }
+
+    writer.write(encoding.indices[0], 3);
+    for (uint32_t i = 1; i < 16; ++i)
+        writer.write(encoding.indices[i], 4);
+}
+
+void
+encodeBC6HBlock(const float texels[16][4], BlockCompressor::Quality quality, uint8_t* block)
+{
+    uint32_t halves[16][3];
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+            halves[i][c] = unsignedHalf(texels[i][c]);
+    }
+
+    BC6HEncoding best;
+    encodeBC6HMode(11, halves, quality, best);
+    if (quality != BlockCompressor::QUALITY_FAST && best.error > 0)
+    {
+        BC6HEncoding candidate;
+        if (encodeBC6HMode(12, halves, quality, candidate) && candidate.error < best.error)
+            best = candidate;
+    }
+    writeBC6HBlock(best, block);
+}
+
+// BGRA (blue lowest) to RGBA (red lowest).
+inline void
+loadRowSwapRB(const uint32_t* src, uint32_t* dst, size_t count)
+{
+    for (size_t x = 0; x < count; ++x)
+    {
+        uint32_t v = src[x];
+        dst[x] = (v & 0xff00ff00) | ((v & 0xff) << 16) | ((v >> 16) & 0xff);
+    }
+}
+}
+
+bool
+BlockCompressor::canCompress(PixelFormat format)
+{
+    switch (format)
+    {
+        case PF_DXT1:
+        case PF_DXT2:
+        case PF_DXT3:
+        case PF_DXT4:
+        case PF_DXT5:
+        case PF_BC4:
+        case PF_BC5:
+        case PF_BC7:
+        case PF_BC6H:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void
+BlockCompressor::encodeBlock(PixelFormat format,
+                             const uint32_t texels[16],
+                             uint8_t* block,
+                             Quality quality)
+{
+    uint8_t rgba[16][4];
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        rgba[i][0] = uint8_t(texels[i]);
+        rgba[i][1] = uint8_t(texels[i] >> 8);
+        rgba[i][2] = uint8_t(texels[i] >> 16);
+        rgba[i][3] = uint8_t(texels[i] >> 24);
+    }
+
+    uint8_t channel[16];
+    switch (format)
+    {
+        case PF_DXT1:
+            encodeColorBlock(rgba, true, quality, block);
+            break;
+        case PF_DXT2:
+        case PF_DXT3:
+            // Premultiplied (DXT2) data is stored as given.
+            encodeExplicitAlphaBlock(rgba, block);
+            encodeColorBlock(rgba, false, quality, block + 8);
+            break;
+        case PF_DXT4:
+        case PF_DXT5:
+            for (uint32_t i = 0; i < 16; ++i)
+                channel[i] = rgba[i][3];
+            encodeChannelBlock(channel, quality, block);
+            encodeColorBlock(rgba, false, quality, block + 8);
+            break;
+        case PF_BC4:
+            for (uint32_t i = 0; i < 16; ++i)
+                channel[i] = rgba[i][0];
+            encodeChannelBlock(channel, quality, block);
+            break;
+        case PF_BC5:
+            for (uint32_t i = 0; i < 16; ++i)
+                channel[i] = rgba[i][0];
+            encodeChannelBlock(channel, quality, block);
+            for (uint32_t i = 0; i < 16; ++i)
+                channel[i] = rgba[i][1];
+            encodeChannelBlock(channel, quality, block + 8);
+            break;
+        case PF_BC7:
+            encodeBC7Block(rgba, quality, block);
+            break;
+        default:
+            throw(std::exception("Unsupported block compressed format - BlockCompressor::encodeBlock"));
+    }
+}
+
+void
+BlockCompressor::encodeBlock(PixelFormat format,
+                             const float texels[16][4],
+                             uint8_t* block,
+                             Quality quality)
+{
+    if (format != PF_BC6H)
+    {
+        throw(std::exception("Unsupported floating point block compressed format - BlockCompressor::encodeBlock"));
+    }
+    encodeBC6HBlock(texels, quality, block);
+}
+
+void
+BlockCompressor::compress(const PixelBox& src, const PixelBox& dst, Quality quality)
+{
+    assert(src.size().x == dst.size().x &&
+           src.size().y == dst.size().y &&
+           src.size().z == dst.size().z);
+
+    if (!canCompress(dst.format))
+    {
+        throw(std::exception("Unsupported block compressed format - BlockCompressor::compress"));
+    }
+    if (PixelUtil::isCompressed(src.format))
+    {
+        throw(std::exception("Source must be uncompressed - BlockCompressor::compress"));
+    }
+
+    const size_t blockBytes = PixelUtil::getMemorySize(4, 4, 1, dst.format);
+    const size_t width = src.size().x;
+    const size_t height = src.size().y;
+    const size_t depth = src.size().z;
+    const size_t blocksWide = (width + 3) / 4;
+    const size_t blocksHigh = (height + 3) / 4;
+    const size_t rowBytes = blocksWide * blockBytes;
+    const size_t sliceBytes = rowBytes * blocksHigh;
+    const size_t texelPitch = blocksWide * 4;
+    const bool hdr = PixelUtil::isFloatingPoint(dst.format);
+
+    uint8_t* blockData = static_cast<uint8_t*>(dst.data);
+    const size_t srcPixelSize = PixelUtil::getNumElemBytes(src.format);
+
+    // One task per row of blocks, over all slices.
+    concurrency::parallel_for(size_t(0), blocksHigh * depth, [&](size_t blockRow)
+    {
+        const size_t z = blockRow / blocksHigh;
+        const size_t by = blockRow % blocksHigh;
+        uint8_t* blockRowData = blockData + z * sliceBytes + by * rowBytes;
+
+        // Source row y of this block row, clamped at the bottom edge.
+        auto sourceRow = [&](size_t y) -> const uint8_t*
+        {
+            const size_t srcY = src.minExtent.y + std::min(by * 4 + y, height - 1);
+            const size_t srcZ = src.minExtent.z + z;
+            return static_cast<const uint8_t*>(src.data) + 
+                (src.minExtent.x + srcY * src.rowPitch + srcZ * src.slicePitch) * srcPixelSize;
+        };
+
+        if (hdr)
+        {
+            // Expand 4 rows to 32 bit float RGBA, clamping at the right edge.
+            std::vector<float> texels(texelPitch * 4 * 4);
+            for (size_t y = 0; y < 4; ++y)
+            {
+                float* texelRow = &texels[y * texelPitch * 4];
+                if (src.format == PF_FLOAT32_RGBA)
+                {
+                    memcpy(texelRow, sourceRow(y), width * 4 * sizeof(float));
+                }
+                else
+                {
+                    PixelBox srcBox(width, 1, 1, src.format, const_cast<uint8_t*>(sourceRow(y)));
+                    PixelBox texelBox(width, 1, 1, PF_FLOAT32_RGBA, texelRow);
+                    PixelUtil::bulkPixelConversion(srcBox, texelBox);
+                }
+                for (size_t x = width; x < texelPitch; ++x)
+                    memcpy(texelRow + x * 4, texelRow + (width - 1) * 4, 4 * sizeof(float));
+            }
+
+            for (size_t bx = 0; bx < blocksWide; ++bx)
+            {
+                float block[16][4];
+                for (size_t y = 0; y < 4; ++y)
+                    memcpy(block[y * 4], &texels[(y * texelPitch + bx * 4) * 4], 16 * sizeof(float));
+                encodeBlock(dst.format, block, blockRowData + bx * blockBytes, quality);
+            }
+            return;
+        }
+
+        // Expand 4 rows to RGBA8, clamping at the right edge.
+        std::vector<uint32_t> texels(texelPitch * 4);
+        for (size_t y = 0; y < 4; ++y)
+        {
+            const uint8_t* srcRow = sourceRow(y);
+            uint32_t* texelRow = &texels[y * texelPitch];
+
+            switch (src.format)
+            {
+                case PF_A8B8G8R8:
+                    memcpy(texelRow, srcRow, width * sizeof(uint32_t));
+                    break;
+                case PF_A8R8G8B8:
+                    loadRowSwapRB(reinterpret_cast<const uint32_t*>(srcRow), texelRow, width);
+                    break;
+                default:
+                {
+                    PixelBox srcBox(width, 1, 1, src.format, const_cast<uint8_t*>(srcRow));
+                    PixelBox texelBox(width, 1, 1, PF_A8B8G8R8, texelRow);
+                    PixelUtil::bulkPixelConversion(srcBox, texelBox);
+                    break;
+                }
+            }
+            std::fill(texelRow + width, texelRow + texelPitch, texelRow[width - 1]);
+        }
+
+        for (size_t bx = 0; bx < blocksWide; ++bx)
+        {
+            uint32_t block[16];
+            for (size_t y = 0; y < 4; ++y)
+                memcpy(block + y * 4, &texels[y * texelPitch + bx * 4], 4 * sizeof(uint32_t));
+            encodeBlock(dst.format, block, blockRowData + bx * blockBytes, quality);
+        }
+    });
+}
+
+}
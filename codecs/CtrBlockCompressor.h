@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_BLOCK_COMPRESSOR
+#define INCLUDED_CRT_BLOCK_COMPRESSOR
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Encoder for BC1 - BC5 (DXT1 - DXT5, ATI1, ATI2), BC6H (unsigned)
+// and BC7 block compressed data. Rows of 4x4 blocks are encoded in parallel.
+//-----------------------------------------------------------------
+class BlockCompressor
+{
+  public:
+    enum Quality
+    {
+        // Principal axis range fit, BC7 mode 6 and BC6H mode 11 only.
+        QUALITY_FAST,
+        // Range fit refined by least squares, BC7 searches 
+        // the two subset modes over the most likely partitions,
+        // BC6H adds the delta encoded mode 12.
+        QUALITY_NORMAL,
+        // Cluster fit, BC7 searches more partitions and p-bit combinations,
+        // BC6H searches around the quantized endpoints.
+        QUALITY_HIGH
+    };
+
+    static bool                canCompress(PixelFormat format);
+
+    // Encodes 16 8 bit RGBA texels (PF_A8B8G8R8 layout, red in the lowest byte,
+    // row major) into a single block of format.
+    static void                encodeBlock(PixelFormat format,
+                                           const uint32_t texels[16],
+                                           uint8_t* block,
+                                           Quality quality);
+
+    // Encodes 16 linear RGB texels (4 floats per texel, alpha is ignored, 
+    // row major) into a single BC6H block. Negative values encode as zero.
+    static void                encodeBlock(PixelFormat format,
+                                           const float texels[16][4],
+                                           uint8_t* block,
+                                           Quality quality);
+
+    // Compresses src into dst. src may be any uncompressed format, partial 
+    // blocks at the right and bottom edges are padded by clamping.
+    // BC6H destinations read src as floating point RGB.
+    static void                compress(const PixelBox& src, 
+                                        const PixelBox& dst,
+                                        Quality quality = QUALITY_NORMAL);
+};
+}
+
+#endif
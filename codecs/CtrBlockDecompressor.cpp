@@ -0,0 +1,585 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrBlockDecompressor.h>
+#include <CtrBC7Tables.h>
+#include <ppl.h>
+
+namespace Ctr
+{
+namespace
+{
+inline uint16_t
+readUint16(const uint8_t* data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+inline uint32_t
+readUint32(const uint8_t* data)
+{
+    return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | 
+           (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+}
+
+// 5:6:5 to 8:8:8 by bit replication, alpha is set to 255.
+inline uint32_t
+expand565(uint16_t color)
+{
+    uint32_t r = (color >> 11) & 0x1f;
+    uint32_t g = (color >> 5) & 0x3f;
+    uint32_t b = color & 0x1f;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    return r | (g << 8) | (b << 16) | 0xff000000;
+}
+
+// Builds the 4 entry palette for a colour block.
+// Three colour mode (DXT1 with color0 <= color1) has transparent black as the last entry.
+inline void
+buildColorPalette(uint16_t color0, uint16_t color1, bool fourColor, uint32_t palette[4])
+{
+    palette[0] = expand565(color0);
+    palette[1] = expand565(color1);
+
+#if CTR_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i p0 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(palette[0])), zero);
+    __m128i p1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(palette[1])), zero);
+    if (fourColor)
+    {
+        // (2a + b) / 3 and (a + 2b) / 3, the divide is a multiply high by 65536 / 3.
+        const __m128i third = _mm_set1_epi16(0x5556);
+        __m128i p2 = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(p0, p0), p1), third);
+        __m128i p3 = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(p1, p1), p0), third);
+        __m128i packed = _mm_packus_epi16(_mm_unpacklo_epi64(p2, p3), zero);
+        palette[2] = uint32_t(_mm_cvtsi128_si32(packed));
+        palette[3] = uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(packed, 4)));
+    }
+    else
+    {
+        __m128i p2 = _mm_srli_epi16(_mm_add_epi16(p0, p1), 1);
+        palette[2] = uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(p2, zero)));
+        palette[3] = 0;
+    }
+#else
+    const uint32_t p0 = palette[0];
+    const uint32_t p1 = palette[1];
+    palette[2] = 0;
+    palette[3] = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t c0 = (p0 >> shift) & 0xff;
+        uint32_t c1 = (p1 >> shift) & 0xff;
+        if (fourColor)
+        {
+            palette[2] |= ((2 * c0 + c1) / 3) << shift;
+            palette[3] |= ((c0 + 2 * c1) / 3) << shift;
+        }
+        else
+        {
+            palette[2] |= ((c0 + c1) >> 1) << shift;
+        }
+    }
+#endif
+}
+
+// Builds the 8 entry palette of an interpolated channel block (BC3 alpha, BC4, BC5).
+inline void
+buildChannelPalette(uint8_t value0, uint8_t value1, uint8_t palette[8])
+{
+#if CTR_SSE2
+    __m128i a0 = _mm_set1_epi16(value0);
+    __m128i a1 = _mm_set1_epi16(value1);
+    __m128i result;
+    if (value0 > value1)
+    {
+        // 6 interpolated values, rounded (w0 * a0 + w1 * a1 + 3) / 7
+        const __m128i w0 = _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1);
+        const __m128i w1 = _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6);
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a0, w0), _mm_mullo_epi16(a1, w1)), 
+                                    _mm_set1_epi16(3));
+        result = _mm_mulhi_epu16(sum, _mm_set1_epi16(9363));
+    }
+    else
+    {
+        // 4 interpolated values, rounded (w0 * a0 + w1 * a1 + 2) / 5, then 0 and 255
+        const __m128i w0 = _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0);
+        const __m128i w1 = _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0);
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a0, w0), _mm_mullo_epi16(a1, w1)), 
+                                    _mm_setr_epi16(2, 2, 2, 2, 2, 2, 0, 0));
+        result = _mm_mulhi_epu16(sum, _mm_set1_epi16(13108));
+        result = _mm_or_si128(result, _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+    }
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(palette), _mm_packus_epi16(result, result));
+#else
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1)
+    {
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            palette[i + 2] = uint8_t(((6 - i) * value0 + (i + 1) * value1 + 3) / 7);
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            palette[i + 2] = uint8_t(((4 - i) * value0 + (i + 1) * value1 + 2) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+#endif
+}
+
+// BC1 - BC3 colour block, 8 bytes.
+inline void
+decodeColorBlock(const uint8_t* block, bool allowThreeColor, uint32_t* texels, size_t pitch)
+{
+    uint16_t color0 = readUint16(block);
+    uint16_t color1 = readUint16(block + 2);
+
+    uint32_t palette[4];
+    buildColorPalette(color0, color1, !allowThreeColor || color0 > color1, palette);
+
+    uint32_t indices = readUint32(block + 4);
+    for (size_t y = 0; y < 4; ++y, indices >>= 8)
+    {
+        uint32_t* row = texels + y * pitch;
+        row[0] = palette[indices & 0x3];
+        row[1] = palette[(indices >> 2) & 0x3];
+        row[2] = palette[(indices >> 4) & 0x3];
+        row[3] = palette[(indices >> 6) & 0x3];
+    }
+}
+
+// BC2 explicit alpha block, 8 bytes of 4 bit alpha values.
+inline void
+decodeExplicitAlphaBlock(const uint8_t* block, uint32_t* texels, size_t pitch)
+{
+    for (size_t y = 0; y < 4; ++y)
+    {
+        uint32_t* row = texels + y * pitch;
+        uint32_t alphaRow = readUint16(block + y * 2);
+        for (size_t x = 0; x < 4; ++x, alphaRow >>= 4)
+        {
+            uint32_t alpha = alphaRow & 0xf;
+            row[x] = (row[x] & 0x00ffffff) | ((alpha | (alpha << 4)) << 24);
+        }
+    }
+}
+
+// Interpolated single channel block, 8 bytes. Writes the channel at shift.
+inline void
+decodeChannelBlock(const uint8_t* block, uint32_t shift, uint32_t* texels, size_t pitch)
+{
+    uint8_t palette[8];
+    buildChannelPalette(block[0], block[1], palette);
+
+    // 16 3 bit indices, little endian
+    uint64_t indices = uint64_t(readUint32(block + 2)) | (uint64_t(readUint16(block + 6)) << 32);
+    const uint32_t mask = ~(0xffu << shift);
+    for (size_t y = 0; y < 4; ++y)
+    {
+        uint32_t* row = texels + y * pitch;
+        for (size_t x = 0; x < 4; ++x, indices >>= 3)
+        {
+            row[x] = (row[x] & mask) | (uint32_t(palette[indices & 0x7]) << shift);
+        }
+    }
+}
+
+// Reads the fields of a 128 bit BC7 block, least significant bit first.
+class BlockBitReader
+{
+  public:
+    BlockBitReader(const uint8_t* data) : mData(data), mPosition(0) {}
+
+    uint32_t read(uint32_t bits)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; ++i, ++mPosition)
+        {
+            value |= uint32_t((mData[mPosition >> 3] >> (mPosition & 7)) & 1) << i;
+        }
+        return value;
+    }
+
+  private:
+    const uint8_t* mData;
+    uint32_t       mPosition;
+};
+
+// BC7 block, 16 bytes. Reserved (mode 8) blocks decode to transparent black.
+inline void
+decodeBC7Block(const uint8_t* block, uint32_t* texels, size_t pitch)
+{
+    uint32_t mode = 0;
+    while (mode < 8 && (block[0] & (1 << mode)) == 0)
+    {
+        ++mode;
+    }
+    if (mode == 8)
+    {
+        for (size_t y = 0; y < 4; ++y)
+            std::fill(texels + y * pitch, texels + y * pitch + 4, 0);
+        return;
+    }
+
+    const BC7::ModeInfo& info = BC7::Modes[mode];
+    BlockBitReader bits(block);
+    bits.read(mode + 1);
+    const uint32_t partition = bits.read(info.partitionBits);
+    const uint32_t rotation = bits.read(info.rotationBits);
+    const uint32_t indexSelection = bits.read(info.indexSelectionBits);
+
+    // Endpoints are stored channel by channel.
+    const uint32_t numEndpoints = info.numSubsets * 2;
+    uint32_t endpoints[6][4];
+    for (uint32_t channel = 0; channel < 3; ++channel)
+    {
+        for (uint32_t e = 0; e < numEndpoints; ++e)
+            endpoints[e][channel] = bits.read(info.colorBits);
+    }
+    for (uint32_t e = 0; e < numEndpoints; ++e)
+    {
+        endpoints[e][3] = bits.read(info.alphaBits);
+    }
+
+    uint32_t colorBits = info.colorBits;
+    uint32_t alphaBits = info.alphaBits;
+    if (info.endpointPBits || info.sharedPBits)
+    {
+        uint32_t pbits[6];
+        if (info.endpointPBits)
+        {
+            for (uint32_t e = 0; e < numEndpoints; ++e)
+                pbits[e] = bits.read(1);
+        }
+        else
+        {
+            for (uint32_t subset = 0; subset < info.numSubsets; ++subset)
+                pbits[subset * 2] = pbits[subset * 2 + 1] = bits.read(1);
+        }
+        for (uint32_t e = 0; e < numEndpoints; ++e)
+        {
+            for (uint32_t channel = 0; channel < 4; ++channel)
+                endpoints[e][channel] = (endpoints[e][channel] << 1) | pbits[e];
+        }
+        colorBits++;
+        if (alphaBits)
+            alphaBits++;
+    }
+
+    for (uint32_t e = 0; e < numEndpoints; ++e)
+    {
+        for (uint32_t channel = 0; channel < 3; ++channel)
+            endpoints[e][channel] = BC7::unquantize(endpoints[e][channel], colorBits);
+        endpoints[e][3] = alphaBits ? BC7::unquantize(endpoints[e][3], alphaBits) : 255;
+    }
+
+    // Anchor texels store their index without the top bit.
+    uint32_t subsets[16];
+    uint32_t indices[16];
+    uint32_t secondaryIndices[16];
+    for (uint32_t texel = 0; texel < 16; ++texel)
+    {
+        subsets[texel] = BC7::subsetOf(info.numSubsets, partition, texel);
+        bool anchor = texel == BC7::anchorOf(info.numSubsets, partition, subsets[texel]);
+        indices[texel] = bits.read(anchor ? info.indexBits - 1 : info.indexBits);
+    }
+    if (info.secondaryIndexBits)
+    {
+        for (uint32_t texel = 0; texel < 16; ++texel)
+            secondaryIndices[texel] = bits.read(texel == 0 ? info.secondaryIndexBits - 1 : info.secondaryIndexBits);
+    }
+
+    const uint32_t* colorWeights = BC7::weights(info.indexBits);
+    const uint32_t* alphaWeights = colorWeights;
+    const uint32_t* colorIndices = indices;
+    const uint32_t* alphaIndices = indices;
+    if (info.secondaryIndexBits)
+    {
+        alphaWeights = BC7::weights(info.secondaryIndexBits);
+        alphaIndices = secondaryIndices;
+        if (indexSelection)
+        {
+            std::swap(colorWeights, alphaWeights);
+            std::swap(colorIndices, alphaIndices);
+        }
+    }
+
+    for (uint32_t texel = 0; texel < 16; ++texel)
+    {
+        const uint32_t* e0 = endpoints[subsets[texel] * 2];
+        const uint32_t* e1 = endpoints[subsets[texel] * 2 + 1];
+        uint32_t colorWeight = colorWeights[colorIndices[texel]];
+        uint32_t alphaWeight = alphaWeights[alphaIndices[texel]];
+        uint32_t rgba[4] = 
+        {
+            BC7::interpolate(e0[0], e1[0], colorWeight),
+            BC7::interpolate(e0[1], e1[1], colorWeight),
+            BC7::interpolate(e0[2], e1[2], colorWeight),
+            BC7::interpolate(e0[3], e1[3], alphaWeight)
+        };
+        // Rotation swaps alpha with one of the colour channels.
+        if (rotation)
+        {
+            std::swap(rgba[3], rgba[rotation - 1]);
+        }
+        texels[(texel >> 2) * pitch + (texel & 3)] = rgba[0] | (rgba[1] << 8) | (rgba[2] << 16) | (rgba[3] << 24);
+    }
+}
+
+// RGBA (red lowest) to BGRA (blue lowest).
+inline void
+storeRowSwapRB(const uint32_t* src, uint32_t* dst, size_t count)
+{
+    size_t x = 0;
+#if CTR_SSE2
+    const __m128i agMask = _mm_set1_epi32(0xff00ff00);
+    const __m128i lowMask = _mm_set1_epi32(0x000000ff);
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        __m128i ag = _mm_and_si128(v, agMask);
+        __m128i r = _mm_slli_epi32(_mm_and_si128(v, lowMask), 16);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), lowMask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_or_si128(ag, _mm_or_si128(r, b)));
+    }
+#endif
+    for (; x < count; ++x)
+    {
+        uint32_t v = src[x];
+        dst[x] = (v & 0xff00ff00) | ((v & 0xff) << 16) | ((v >> 16) & 0xff);
+    }
+}
+
+// RGBA8 to normalized float RGBA.
+inline void
+storeRowFloat(const uint32_t* src, float* dst, size_t count)
+{
+    const float scale = 1.0f / 255.0f;
+    size_t x = 0;
+#if CTR_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale4 = _mm_set1_ps(scale);
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        float* out = dst + x * 4;
+        _mm_storeu_ps(out,      _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale4));
+        _mm_storeu_ps(out + 4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale4));
+        _mm_storeu_ps(out + 8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale4));
+        _mm_storeu_ps(out + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale4));
+    }
+#endif
+    for (; x < count; ++x)
+    {
+        uint32_t v = src[x];
+        float* out = dst + x * 4;
+        out[0] = float(v & 0xff) * scale;
+        out[1] = float((v >> 8) & 0xff) * scale;
+        out[2] = float((v >> 16) & 0xff) * scale;
+        out[3] = float(v >> 24) * scale;
+    }
+}
+}
+
+bool
+BlockDecompressor::canDecompress(PixelFormat format)
+{
+    return blockSize(format) != 0;
+}
+
+size_t
+BlockDecompressor::blockSize(PixelFormat format)
+{
+    switch (format)
+    {
+        case PF_DXT1:
+        case PF_BC4:
+            return 8;
+        case PF_DXT2:
+        case PF_DXT3:
+        case PF_DXT4:
+        case PF_DXT5:
+        case PF_BC5:
+        case PF_BC7:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+void
+BlockDecompressor::decodeBlockRow(PixelFormat format, 
+                                  const uint8_t* blocks, 
+                                  size_t numBlocks,
+                                  uint32_t* texels, 
+                                  size_t texelPitch)
+{
+    switch (format)
+    {
+        case PF_DXT1:
+            for (size_t i = 0; i < numBlocks; ++i, blocks += 8)
+                decodeColorBlock(blocks, true, texels + i * 4, texelPitch);
+            break;
+        case PF_DXT2:
+        case PF_DXT3:
+            // Premultiplied (DXT2) data is returned as stored.
+            for (size_t i = 0; i < numBlocks; ++i, blocks += 16)
+            {
+                decodeColorBlock(blocks + 8, false, texels + i * 4, texelPitch);
+                decodeExplicitAlphaBlock(blocks, texels + i * 4, texelPitch);
+            }
+            break;
+        case PF_DXT4:
+        case PF_DXT5:
+            for (size_t i = 0; i < numBlocks; ++i, blocks += 16)
+            {
+                decodeColorBlock(blocks + 8, false, texels + i * 4, texelPitch);
+                decodeChannelBlock(blocks, 24, texels + i * 4, texelPitch);
+            }
+            break;
+        case PF_BC4:
+            for (size_t y = 0; y < 4; ++y)
+                std::fill(texels + y * texelPitch, texels + y * texelPitch + numBlocks * 4, 0xff000000);
+            for (size_t i = 0; i < numBlocks; ++i, blocks += 8)
+                decodeChannelBlock(blocks, 0, texels + i * 4, texelPitch);
+            break;
+        case PF_BC5:
+            for (size_t y = 0; y < 4; ++y)
+                std::fill(texels + y * texelPitch, texels + y * texelPitch + numBlocks * 4, 0xff000000);
+            for (size_t i = 0; i < numBlocks; ++i, blocks += 16)
+            {
+                decodeChannelBlock(blocks, 0, texels + i * 4, texelPitch);
+                decodeChannelBlock(blocks + 8, 8, texels + i * 4, texelPitch);
+            }
+            break;
+        case PF_BC7:
+            for (size_t i = 0; i < numBlocks; ++i, blocks += 16)
+                decodeBC7Block(blocks, texels + i * 4, texelPitch);
+            break;
+        default:
+            throw(std::exception("Unsupported block compressed format - BlockDecompressor::decodeBlockRow"));
+    }
+}
+
+void
+BlockDecompressor::decompress(const PixelBox& src, const PixelBox& dst)
+{
+    assert(src.size().x == dst.size().x &&
+           src.size().y == dst.size().y &&
+           src.size().z == dst.size().z);
+
+    const size_t blockBytes = blockSize(src.format);
+    if (blockBytes == 0)
+    {
+        throw(std::exception("Unsupported block compressed format - BlockDecompressor::decompress"));
+    }
+    if (PixelUtil::isCompressed(dst.format))
+    {
+        throw(std::exception("Destination must be uncompressed - BlockDecompressor::decompress"));
+    }
+
+    const size_t width = src.size().x;
+    const size_t height = src.size().y;
+    const size_t depth = src.size().z;
+    const size_t blocksWide = (width + 3) / 4;
+    const size_t blocksHigh = (height + 3) / 4;
+    const size_t rowBytes = blocksWide * blockBytes;
+    const size_t sliceBytes = rowBytes * blocksHigh;
+    const size_t texelPitch = blocksWide * 4;
+
+    const uint8_t* blockData = static_cast<const uint8_t*>(src.data);
+    const size_t dstPixelSize = PixelUtil::getNumElemBytes(dst.format);
+
+    // One task per row of blocks, over all slices.
+    concurrency::parallel_for(size_t(0), blocksHigh * depth, [&](size_t blockRow)
+    {
+        const size_t z = blockRow / blocksHigh;
+        const size_t by = blockRow % blocksHigh;
+        const size_t rows = std::min(size_t(4), height - by * 4);
+
+        std::vector<uint32_t> texels(texelPitch * 4);
+        decodeBlockRow(src.format, blockData + z * sliceBytes + by * rowBytes, 
+                       blocksWide, &texels[0], texelPitch);
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            const size_t dstY = dst.minExtent.y + by * 4 + y;
+            const size_t dstZ = dst.minExtent.z + z;
+            uint8_t* dstRow = static_cast<uint8_t*>(dst.data) + 
+                (dst.minExtent.x + dstY * dst.rowPitch + dstZ * dst.slicePitch) * dstPixelSize;
+            const uint32_t* texelRow = &texels[y * texelPitch];
+
+            switch (dst.format)
+            {
+                case PF_A8B8G8R8:
+                case PF_X8B8G8R8:
+                    memcpy(dstRow, texelRow, width * sizeof(uint32_t));
+                    break;
+                case PF_A8R8G8B8:
+                case PF_X8R8G8B8:
+                    storeRowSwapRB(texelRow, reinterpret_cast<uint32_t*>(dstRow), width);
+                    break;
+                case PF_FLOAT32_RGBA:
+                    storeRowFloat(texelRow, reinterpret_cast<float*>(dstRow), width);
+                    break;
+                default:
+                {
+                    PixelBox texelBox(width, 1, 1, PF_A8B8G8R8, const_cast<uint32_t*>(texelRow));
+                    PixelBox dstBox(width, 1, 1, dst.format, dstRow);
+                    PixelUtil::bulkPixelConversion(texelBox, dstBox);
+                    break;
+                }
+            }
+        }
+    });
+}
+
+}
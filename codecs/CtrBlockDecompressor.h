@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_BLOCK_DECOMPRESSOR
+#define INCLUDED_CRT_BLOCK_DECOMPRESSOR
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Decoder for BC1 - BC5 (DXT1 - DXT5, ATI1, ATI2) and BC7 block compressed
+// data. Whole rows of 4x4 blocks are decoded at a time and block
+// rows are processed in parallel.
+//-----------------------------------------------------------------
+class BlockDecompressor
+{
+  public:
+    static bool                canDecompress(PixelFormat format);
+
+    // Size in bytes of a single 4x4 block, 0 for unsupported formats.
+    static size_t              blockSize(PixelFormat format);
+
+    // Decodes numBlocks consecutive blocks into 4 rows of 8 bit RGBA texels 
+    // (PF_A8B8G8R8 layout, red in the lowest byte). 
+    // texelPitch is the distance between texel rows, in texels.
+    static void                decodeBlockRow(PixelFormat format, 
+                                              const uint8_t* blocks, 
+                                              size_t numBlocks,
+                                              uint32_t* texels, 
+                                              size_t texelPitch);
+
+    // Decompresses src into dst. PF_A8B8G8R8, PF_A8R8G8B8 and PF_FLOAT32_RGBA
+    // destinations are written directly, other formats go through
+    // PixelUtil::bulkPixelConversion.
+    static void                decompress(const PixelBox& src, const PixelBox& dst);
+};
+}
+
+#endif
@@ -0,0 +1,450 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrCookedTextureCodec.h>
+#include <CtrTextureImage.h>
+#include <CtrLog.h>
+#include <ppl.h>
+#include <atomic>
+#include <fstream>
+#include <zlib.h>
+
+namespace Ctr
+{
+namespace
+{
+#pragma pack (push, 1)
+
+struct CookedHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t numFaces;
+    uint32_t numMipmaps;
+    uint32_t chunkCount;
+    uint32_t reserved;
+    // Decoded size of the whole image.
+    uint64_t size;
+};
+
+struct CookedChunk
+{
+    // From the start of the container.
+    uint64_t offset;
+    uint32_t storedSize;
+    uint32_t size;
+    uint16_t face;
+    uint16_t mip;
+    uint32_t compression;
+};
+
+#pragma pack (pop)
+
+const uint32_t COOKED_MAGIC = 'C' | ('T' << 8) | ('E' << 16) | ('X' << 24);
+const uint32_t COOKED_STORED = 0;
+const uint32_t COOKED_ZLIB = 1;
+
+size_t
+alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Splits the image into chunks, in TextureImage order. Offsets are left
+// for the caller.
+void
+buildChunks(const ImageCodec::ImageData* imgData, 
+            size_t numFaces, 
+            std::vector<CookedChunk>& chunks)
+{
+    for (size_t face = 0; face < numFaces; face++)
+    {
+        size_t width = imgData->width;
+        size_t height = imgData->height;
+        size_t depth = imgData->depth;
+        for (size_t mip = 0; mip <= imgData->num_mipmaps; mip++)
+        {
+            size_t levelSize = PixelUtil::getMemorySize(width, height, depth, imgData->format);
+            for (size_t levelOffset = 0; levelOffset < levelSize; levelOffset += CookedTextureCodec::ChunkSize)
+            {
+                CookedChunk chunk;
+                memset(&chunk, 0, sizeof(chunk));
+                chunk.size = static_cast<uint32_t>(std::min(CookedTextureCodec::ChunkSize, levelSize - levelOffset));
+                chunk.face = static_cast<uint16_t>(face);
+                chunk.mip = static_cast<uint16_t>(mip);
+                chunks.push_back(chunk);
+            }
+            if(width!=1) width /= 2;
+            if(height!=1) height /= 2;
+            if(depth!=1) depth /= 2;
+        }
+    }
+}
+}
+
+int CookedTextureCodec::msCompressionLevel = Z_DEFAULT_COMPRESSION;
+CookedTextureCodec* CookedTextureCodec::msInstance = 0;
+
+int
+CookedTextureCodec::compressionLevel()
+{
+    return msCompressionLevel;
+}
+
+void
+CookedTextureCodec::setCompressionLevel(int level)
+{
+    msCompressionLevel = level;
+}
+
+void 
+CookedTextureCodec::startup(void)
+{
+    if (!msInstance)
+    {
+        LOG("Cooked texture codec registering");
+
+        msInstance = new CookedTextureCodec();
+        Codec::registerCodec(msInstance);
+    }
+}
+
+void 
+CookedTextureCodec::shutdown(void)
+{
+    if(msInstance)
+    {
+        Codec::unRegisterCodec(msInstance);
+        delete msInstance;
+        msInstance = 0;
+    }
+}
+
+CookedTextureCodec::CookedTextureCodec():
+    mType("ctex")
+{ 
+}
+
+std::string 
+CookedTextureCodec::getType() const 
+{
+    return mType;
+}
+
+std::string 
+CookedTextureCodec::magicNumberToFileExt(const char *magicNumberPtr, size_t maxbytes) const
+{
+    if (maxbytes >= sizeof(uint32_t))
+    {
+        uint32_t fileType;
+        memcpy(&fileType, magicNumberPtr, sizeof(uint32_t));
+        if (fileType == COOKED_MAGIC)
+        {
+            return mType;
+        }
+    }
+    return std::string();
+}
+
+void
+CookedTextureCodec::encode(const MemoryDataStreamPtr& input, 
+                           const ImageData* imgData,
+                           std::vector<uint8_t>& output) const
+{
+    size_t numFaces = imgData->num_images;
+    if (imgData->size != TextureImage::calculateSize(imgData->num_mipmaps, numFaces, imgData->width, 
+                                                     imgData->height, imgData->depth, imgData->format))
+    {
+        throw(std::exception("Image size does not match its description - CookedTextureCodec::encode"));
+    }
+
+    std::vector<CookedChunk> chunks;
+    buildChunks(imgData, numFaces, chunks);
+
+    // Compress the chunks in parallel, keeping the ones that shrink.
+    std::vector<size_t> sourceOffsets(chunks.size());
+    for (size_t chunkId = 0, offset = 0; chunkId < chunks.size(); chunkId++)
+    {
+        sourceOffsets[chunkId] = offset;
+        offset += chunks[chunkId].size;
+    }
+
+    const uint8_t* source = input->getPtr();
+    std::vector<std::vector<uint8_t> > packed(chunks.size());
+    if (msCompressionLevel != 0)
+    {
+        concurrency::parallel_for(size_t(0), chunks.size(), [&](size_t chunkId)
+        {
+            CookedChunk& chunk = chunks[chunkId];
+            std::vector<uint8_t>& buffer = packed[chunkId];
+            uLongf packedSize = compressBound(chunk.size);
+            buffer.resize(packedSize);
+            if (compress2(&buffer[0], &packedSize, source + sourceOffsets[chunkId], 
+                          chunk.size, msCompressionLevel) == Z_OK &&
+                packedSize < chunk.size)
+            {
+                buffer.resize(packedSize);
+                chunk.compression = COOKED_ZLIB;
+            }
+            else
+            {
+                std::vector<uint8_t>().swap(buffer);
+            }
+        });
+    }
+
+    // Lay out the payloads after the chunk table.
+    size_t tableSize = sizeof(CookedHeader) + chunks.size() * sizeof(CookedChunk);
+    size_t offset = alignUp(tableSize, Alignment);
+    for (auto it = chunks.begin(); it != chunks.end(); it++)
+    {
+        it->offset = offset;
+        it->storedSize = it->compression == COOKED_ZLIB ? 
+            static_cast<uint32_t>(packed[it - chunks.begin()].size()) : it->size;
+        offset += it->storedSize;
+    }
+
+    CookedHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = COOKED_MAGIC;
+    header.version = Version;
+    header.format = static_cast<uint32_t>(imgData->format);
+    header.width = static_cast<uint32_t>(imgData->width);
+    header.height = static_cast<uint32_t>(imgData->height);
+    header.depth = static_cast<uint32_t>(imgData->depth);
+    header.numFaces = static_cast<uint32_t>(numFaces);
+    header.numMipmaps = imgData->num_mipmaps;
+    header.chunkCount = static_cast<uint32_t>(chunks.size());
+    header.size = imgData->size;
+
+    output.assign(offset, 0);
+    memcpy(&output[0], &header, sizeof(header));
+    if (chunks.size())
+    {
+        memcpy(&output[sizeof(header)], &chunks[0], chunks.size() * sizeof(CookedChunk));
+    }
+    for (size_t chunkId = 0; chunkId < chunks.size(); chunkId++)
+    {
+        const CookedChunk& chunk = chunks[chunkId];
+        const uint8_t* payload = chunk.compression == COOKED_ZLIB ? 
+            &packed[chunkId][0] : source + sourceOffsets[chunkId];
+        memcpy(&output[chunk.offset], payload, chunk.storedSize);
+    }
+}
+
+DataStreamPtr 
+CookedTextureCodec::code(MemoryDataStreamPtr& input, Codec::CodecDataPtr& pData) const
+{
+    const ImageData* imgData = static_cast<const ImageData*>(pData.get());
+
+    std::vector<uint8_t> encoded;
+    encode(input, imgData, encoded);
+
+    MemoryDataStream* output = new MemoryDataStream(encoded.size());
+    memcpy(output->getPtr(), &encoded[0], encoded.size());
+    return DataStreamPtr(output);
+}
+
+void 
+CookedTextureCodec::codeToFile(MemoryDataStreamPtr& input, 
+                               const std::string& outFileName, 
+                               Codec::CodecDataPtr& pData) const
+{
+    const ImageData* imgData = static_cast<const ImageData*>(pData.get());
+
+    std::vector<uint8_t> encoded;
+    encode(input, imgData, encoded);
+
+    std::ofstream of;
+    of.open(outFileName.c_str(), std::ios_base::binary|std::ios_base::out);
+    of.write((const char *)&encoded[0], encoded.size());
+    of.close();
+}
+
+Codec::DecodeResult 
+CookedTextureCodec::decode(DataStreamPtr& stream) const
+{
+    // Chunks are read in place, bring streams that are not already in 
+    // memory in first. The image takes ownership of the stream if it
+    // references the payload, so the copy replaces the caller's stream.
+    if (!stream->getDataPtr())
+    {
+        DataStreamPtr memoryStream(new MemoryDataStream(*stream));
+        stream = std::move(memoryStream);
+    }
+
+    const uint8_t* base = stream->getDataPtr() + stream->tell();
+    size_t available = stream->size() - stream->tell();
+
+    CookedHeader header;
+    if (available < sizeof(header))
+    {
+        throw(std::exception("Truncated header - CookedTextureCodec::decode"));
+    }
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != COOKED_MAGIC)
+    {
+        throw(std::exception("This is not a cooked texture file - CookedTextureCodec::decode"));
+    }
+    if (header.version != Version)
+    {
+        throw(std::exception("Unsupported cooked texture version - CookedTextureCodec::decode"));
+    }
+    if (header.numFaces != 1 && header.numFaces != 6)
+    {
+        throw(std::exception("Number of faces must be 6 or 1 - CookedTextureCodec::decode"));
+    }
+    if (header.format >= PF_COUNT)
+    {
+        throw(std::exception("Unknown pixel format - CookedTextureCodec::decode"));
+    }
+
+    size_t tableSize = sizeof(CookedHeader) + size_t(header.chunkCount) * sizeof(CookedChunk);
+    if (available < tableSize)
+    {
+        throw(std::exception("Truncated chunk table - CookedTextureCodec::decode"));
+    }
+    std::vector<CookedChunk> chunks(header.chunkCount);
+    if (chunks.size())
+    {
+        memcpy(&chunks[0], base + sizeof(CookedHeader), chunks.size() * sizeof(CookedChunk));
+    }
+
+    ImageData* imgData = new ImageData();
+    CodecDataPtr codecData(imgData);
+    imgData->format = static_cast<PixelFormat>(header.format);
+    imgData->width = header.width;
+    imgData->height = header.height;
+    imgData->depth = header.depth;
+    imgData->num_mipmaps = static_cast<uint16_t>(header.numMipmaps);
+    imgData->num_images = static_cast<uint16_t>(header.numFaces);
+    imgData->size = TextureImage::calculateSize(imgData->num_mipmaps, header.numFaces, 
+                                                imgData->width, imgData->height, 
+                                                imgData->depth, imgData->format);
+    if (header.numFaces == 6)
+        imgData->flags |= IF_CUBEMAP;
+    if (imgData->depth > 1)
+        imgData->flags |= IF_3D_TEXTURE;
+    if (PixelUtil::isCompressed(imgData->format))
+        imgData->flags |= IF_COMPRESSED;
+
+    // Validate the table, and see if the payload can be used as is.
+    std::vector<size_t> offsets(chunks.size());
+    size_t size = 0;
+    bool contiguous = true;
+    for (size_t chunkId = 0; chunkId < chunks.size(); chunkId++)
+    {
+        const CookedChunk& chunk = chunks[chunkId];
+        // Written so that hostile offsets and sizes cannot wrap around.
+        if (chunk.offset > available || chunk.storedSize > available - chunk.offset)
+        {
+            throw(std::exception("Chunk is outside of the file - CookedTextureCodec::decode"));
+        }
+        if (chunk.size > header.size - size)
+        {
+            throw(std::exception("Chunk sizes do not match the image - CookedTextureCodec::decode"));
+        }
+        if (chunk.compression != COOKED_STORED && chunk.compression != COOKED_ZLIB)
+        {
+            throw(std::exception("Unknown chunk compression - CookedTextureCodec::decode"));
+        }
+        if (chunk.compression != COOKED_STORED || chunk.storedSize != chunk.size ||
+            chunk.offset != chunks[0].offset + size)
+        {
+            contiguous = false;
+        }
+        offsets[chunkId] = size;
+        size += chunk.size;
+    }
+    if (size != imgData->size || size != header.size)
+    {
+        throw(std::exception("Chunk sizes do not match the image - CookedTextureCodec::decode"));
+    }
+
+    DecodeResult ret;
+    if (contiguous && size)
+    {
+        ret.first.reset(new MemoryDataStream(const_cast<uint8_t*>(base + chunks[0].offset), size, false));
+        imgData->borrowed = true;
+    }
+    else
+    {
+        ret.first.reset(new MemoryDataStream(size));
+        uint8_t* output = ret.first->getPtr();
+
+        std::atomic<bool> failed(false);
+        concurrency::parallel_for(size_t(0), chunks.size(), [&](size_t chunkId)
+        {
+            const CookedChunk& chunk = chunks[chunkId];
+            const uint8_t* payload = base + chunk.offset;
+            if (chunk.compression == COOKED_ZLIB)
+            {
+                uLongf unpackedSize = chunk.size;
+                if (uncompress(output + offsets[chunkId], &unpackedSize, payload, chunk.storedSize) != Z_OK ||
+                    unpackedSize != chunk.size)
+                {
+                    failed = true;
+                }
+            }
+            else if (chunk.storedSize == chunk.size)
+            {
+                memcpy(output + offsets[chunkId], payload, chunk.size);
+            }
+            else
+            {
+                failed = true;
+            }
+        });
+
+        if (failed)
+        {
+            throw(std::exception("Corrupt chunk - CookedTextureCodec::decode"));
+        }
+    }
+
+    ret.second = std::move(codecData);
+    return ret;
+}
+}
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_COOKED_TEXTURE_CODEC
+#define INCLUDED_CRT_COOKED_TEXTURE_CODEC
+
+#include <CtrImageCodec.h>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Critter's native texture container (.ctex). Stores a TextureImage
+// exactly as it sits in memory (format, faces, mips) so it loads
+// without conversion or mip generation.
+//
+// Layout: a header, a chunk table, then the chunk payloads starting
+// on an Alignment boundary. Each face/mip level is split into chunks
+// of at most ChunkSize bytes, stored in TextureImage order (all mips
+// of a face, then the next face). A chunk is zlib compressed when that
+// makes it smaller, otherwise it is stored as is.
+//
+// Chunks are decoded in parallel. When every chunk is stored 
+// uncompressed and the source is in memory (mapped file), the image 
+// references the payload directly instead of copying it.
+//-----------------------------------------------------------------
+class CookedTextureCodec : public ImageCodec
+{
+  public:
+    static const uint32_t      Version = 1;
+    static const size_t        Alignment = 64;
+    static const size_t        ChunkSize = size_t(256) << 10;
+
+    CookedTextureCodec();
+    virtual ~CookedTextureCodec() { }
+
+    /// @copydoc Codec::code
+    DataStreamPtr              code(MemoryDataStreamPtr& input, CodecDataPtr& pData) const;
+    /// @copydoc Codec::codeToFile
+    void                       codeToFile(MemoryDataStreamPtr& input, const std::string& outFileName, CodecDataPtr& pData) const;
+    /// @copydoc Codec::decode
+    DecodeResult               decode(DataStreamPtr& input) const;
+    /// @copydoc Codec::magicNumberToFileExt
+    std::string                magicNumberToFileExt(const char *magicNumberPtr, size_t maxbytes) const;
+
+    virtual std::string        getType() const;
+
+    /// Static method to startup and register the codec
+    static void                startup(void);
+    /// Static method to shutdown and unregister the codec
+    static void                shutdown(void);
+
+    /// zlib level used when writing, 0 stores every chunk uncompressed.
+    static int                 compressionLevel();
+    static void                setCompressionLevel(int level);
+
+  private:
+    void                       encode(const MemoryDataStreamPtr& input, 
+                                      const ImageData* imgData,
+                                      std::vector<uint8_t>& output) const;
+
+    std::string                mType;
+
+    /// Single registered codec instance
+    static CookedTextureCodec* msInstance;
+    static int                 msCompressionLevel;
+};
+}
+
+#endif
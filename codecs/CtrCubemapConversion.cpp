@@ -0,0 +1,427 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrCubemapConversion.h>
+#include <ppl.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Ctr
+{
+namespace
+{
+const float Pi = 3.14159265358979323f;
+
+//-----------------------------------------------------------------
+// D3D cube face frames, direction = normal + u * right + v * down.
+//-----------------------------------------------------------------
+const float FaceNormal[6][3] = { {  1,  0,  0 }, { -1,  0,  0 }, 
+                                 {  0,  1,  0 }, {  0, -1,  0 }, 
+                                 {  0,  0,  1 }, {  0,  0, -1 } };
+const float FaceRight[6][3]  = { {  0,  0, -1 }, {  0,  0,  1 }, 
+                                 {  1,  0,  0 }, {  1,  0,  0 }, 
+                                 {  1,  0,  0 }, { -1,  0,  0 } };
+const float FaceDown[6][3]   = { {  0, -1,  0 }, {  0, -1,  0 }, 
+                                 {  0,  0,  1 }, {  0,  0, -1 }, 
+                                 {  0, -1,  0 }, {  0, -1,  0 } };
+
+// Cells of the cross layouts, in face sized units.
+const size_t HorizontalCrossCells[6][2] = { { 2, 1 }, { 0, 1 }, { 1, 0 }, { 1, 2 }, { 1, 1 }, { 3, 1 } };
+const size_t VerticalCrossCells[6][2]   = { { 2, 1 }, { 0, 1 }, { 1, 0 }, { 1, 2 }, { 1, 1 }, { 1, 3 } };
+
+// Most supersamples per axis for CUBE_SAMPLE_AREA.
+const size_t MaxAreaSamples = 16;
+
+//-----------------------------------------------------------------
+// Rectangle of the float RGBA source that a sample falls in,
+// sampled with wrapping along x (lat-long) or clamping.
+//-----------------------------------------------------------------
+struct Cell
+{
+    size_t                     x;
+    size_t                     y;
+    size_t                     width;
+    size_t                     height;
+    bool                       wrap;
+};
+
+struct SourceImage
+{
+    const float*               texels;
+    size_t                     width;
+    size_t                     height;
+};
+
+inline int
+clampIndex(int value, size_t size)
+{
+    return std::min(std::max(value, 0), int(size) - 1);
+}
+
+inline int
+wrapIndex(int value, size_t size)
+{
+    value %= int(size);
+    return value < 0 ? value + int(size) : value;
+}
+
+// accum += weight * bilinear sample at (sx, sy), in texels from the
+// top left corner of cell.
+inline void
+sampleBilinear(const SourceImage& source, const Cell& cell, 
+               float sx, float sy, float weight, float* accum)
+{
+    sx -= 0.5f;
+    sy -= 0.5f;
+    const float floorX = std::floor(sx);
+    const float floorY = std::floor(sy);
+    const float fx = sx - floorX;
+    const float fy = sy - floorY;
+
+    int x0 = int(floorX);
+    int x1 = x0 + 1;
+    if (cell.wrap)
+    {
+        x0 = wrapIndex(x0, cell.width);
+        x1 = wrapIndex(x1, cell.width);
+    }
+    else
+    {
+        x0 = clampIndex(x0, cell.width);
+        x1 = clampIndex(x1, cell.width);
+    }
+    const int y0 = clampIndex(int(floorY), cell.height);
+    const int y1 = clampIndex(int(floorY) + 1, cell.height);
+
+    const float* row0 = source.texels + ((cell.y + y0) * source.width + cell.x) * 4;
+    const float* row1 = source.texels + ((cell.y + y1) * source.width + cell.x) * 4;
+#if CTR_SSE2
+    const __m128 wx = _mm_set1_ps(fx);
+    const __m128 wy = _mm_set1_ps(fy);
+    const __m128 t00 = _mm_loadu_ps(row0 + x0 * 4);
+    const __m128 t01 = _mm_loadu_ps(row1 + x0 * 4);
+    const __m128 top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row0 + x1 * 4), t00), wx));
+    const __m128 bottom = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row1 + x1 * 4), t01), wx));
+    const __m128 colour = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy));
+    _mm_storeu_ps(accum, _mm_add_ps(_mm_loadu_ps(accum), _mm_mul_ps(colour, _mm_set1_ps(weight))));
+#else
+    for (size_t c = 0; c < 4; ++c)
+    {
+        const float top = row0[x0 * 4 + c] + (row0[x1 * 4 + c] - row0[x0 * 4 + c]) * fx;
+        const float bottom = row1[x0 * 4 + c] + (row1[x1 * 4 + c] - row1[x0 * 4 + c]) * fx;
+        accum[c] += (top + (bottom - top) * fy) * weight;
+    }
+#endif
+}
+
+//-----------------------------------------------------------------
+// Source cell and texel coordinates of the unit direction (x, y, z).
+//-----------------------------------------------------------------
+class LayoutMapping
+{
+  public:
+    LayoutMapping(CubemapLayout layout, size_t width, size_t height) :
+        _layout(layout),
+        _width(width),
+        _height(height),
+        _cellSize(layout == CUBE_LAYOUT_HORIZONTAL_CROSS ? width / 4 : 
+                  layout == CUBE_LAYOUT_VERTICAL_CROSS ? width / 3 : 0)
+    {
+    }
+
+    void
+    locate(float x, float y, float z, Cell& cell, float& sx, float& sy) const
+    {
+        switch (_layout)
+        {
+            case CUBE_LAYOUT_LATLONG:
+            {
+                cell = wholeImage(true);
+                sx = (0.5f + std::atan2(x, z) * (0.5f / Pi)) * float(_width);
+                sy = std::acos(std::min(std::max(y, -1.0f), 1.0f)) * (1.0f / Pi) * float(_height);
+                break;
+            }
+            case CUBE_LAYOUT_OCTAHEDRAL:
+            {
+                const float norm = 1.0f / (std::fabs(x) + std::fabs(y) + std::fabs(z));
+                float px = x * norm;
+                float py = z * norm;
+                if (y < 0.0f)
+                {
+                    const float fx = (1.0f - std::fabs(py)) * (px < 0.0f ? -1.0f : 1.0f);
+                    const float fy = (1.0f - std::fabs(px)) * (py < 0.0f ? -1.0f : 1.0f);
+                    px = fx;
+                    py = fy;
+                }
+                cell = wholeImage(false);
+                sx = (px * 0.5f + 0.5f) * float(_width);
+                sy = (py * 0.5f + 0.5f) * float(_height);
+                break;
+            }
+            default:
+            {
+                float u, v;
+                const size_t face = CubemapConversion::directionToFace(x, y, z, u, v);
+                const size_t* position = _layout == CUBE_LAYOUT_HORIZONTAL_CROSS ? 
+                    HorizontalCrossCells[face] : VerticalCrossCells[face];
+                if (_layout == CUBE_LAYOUT_VERTICAL_CROSS && face == 5)
+                {
+                    u = -u;
+                    v = -v;
+                }
+                cell.x = position[0] * _cellSize;
+                cell.y = position[1] * _cellSize;
+                cell.width = _cellSize;
+                cell.height = _cellSize;
+                cell.wrap = false;
+                sx = (u * 0.5f + 0.5f) * float(_cellSize);
+                sy = (v * 0.5f + 0.5f) * float(_cellSize);
+                break;
+            }
+        }
+    }
+
+  private:
+    Cell
+    wholeImage(bool wrap) const
+    {
+        Cell cell = { 0, 0, _width, _height, wrap };
+        return cell;
+    }
+
+    CubemapLayout              _layout;
+    size_t                     _width;
+    size_t                     _height;
+    size_t                     _cellSize;
+};
+}
+
+bool
+CubemapConversion::detectLayout(size_t width, size_t height, CubemapLayout& layout)
+{
+    if (width == 0 || height == 0)
+        return false;
+
+    if (width == height * 2)
+        layout = CUBE_LAYOUT_LATLONG;
+    else if (width * 3 == height * 4)
+        layout = CUBE_LAYOUT_HORIZONTAL_CROSS;
+    else if (width * 4 == height * 3)
+        layout = CUBE_LAYOUT_VERTICAL_CROSS;
+    else
+        return false;
+    return true;
+}
+
+size_t
+CubemapConversion::naturalFaceSize(CubemapLayout layout, size_t width)
+{
+    switch (layout)
+    {
+        case CUBE_LAYOUT_LATLONG:
+        case CUBE_LAYOUT_HORIZONTAL_CROSS:
+            return std::max<size_t>(width / 4, 1);
+        case CUBE_LAYOUT_VERTICAL_CROSS:
+            return std::max<size_t>(width / 3, 1);
+        default:
+            // A w x w octahedral map has w^2 texels. Faces of w / sqrt(3)
+            // give 6 (w / sqrt(3))^2 = 2 w^2 cube texels, about two per source texel.
+            return std::max<size_t>(size_t(float(width) * 0.57735f), 1);
+    }
+}
+
+void
+CubemapConversion::faceDirections(size_t face, float v, const float* us, size_t count,
+                                  float* x, float* y, float* z)
+{
+    const float* normal = FaceNormal[face];
+    const float* right = FaceRight[face];
+    const float* down = FaceDown[face];
+    const float baseX = normal[0] + v * down[0];
+    const float baseY = normal[1] + v * down[1];
+    const float baseZ = normal[2] + v * down[2];
+
+    size_t i = 0;
+#if CTR_SSE2
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 u = _mm_loadu_ps(us + i);
+        const __m128 dx = _mm_add_ps(_mm_set1_ps(baseX), _mm_mul_ps(u, _mm_set1_ps(right[0])));
+        const __m128 dy = _mm_add_ps(_mm_set1_ps(baseY), _mm_mul_ps(u, _mm_set1_ps(right[1])));
+        const __m128 dz = _mm_add_ps(_mm_set1_ps(baseZ), _mm_mul_ps(u, _mm_set1_ps(right[2])));
+        const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), 
+                                                     _mm_mul_ps(dz, dz)));
+        const __m128 inverse = _mm_div_ps(one, length);
+        _mm_storeu_ps(x + i, _mm_mul_ps(dx, inverse));
+        _mm_storeu_ps(y + i, _mm_mul_ps(dy, inverse));
+        _mm_storeu_ps(z + i, _mm_mul_ps(dz, inverse));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        const float dx = baseX + us[i] * right[0];
+        const float dy = baseY + us[i] * right[1];
+        const float dz = baseZ + us[i] * right[2];
+        const float inverse = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz);
+        x[i] = dx * inverse;
+        y[i] = dy * inverse;
+        z[i] = dz * inverse;
+    }
+}
+
+size_t
+CubemapConversion::directionToFace(float x, float y, float z, float& u, float& v)
+{
+    const float ax = std::fabs(x);
+    const float ay = std::fabs(y);
+    const float az = std::fabs(z);
+    if (ax >= ay && ax >= az)
+    {
+        const float inverse = 1.0f / ax;
+        u = (x > 0.0f ? -z : z) * inverse;
+        v = -y * inverse;
+        return x > 0.0f ? 0 : 1;
+    }
+    if (ay >= az)
+    {
+        const float inverse = 1.0f / ay;
+        u = x * inverse;
+        v = (y > 0.0f ? z : -z) * inverse;
+        return y > 0.0f ? 2 : 3;
+    }
+    const float inverse = 1.0f / az;
+    u = (z > 0.0f ? x : -x) * inverse;
+    v = -y * inverse;
+    return z > 0.0f ? 4 : 5;
+}
+
+TextureImagePtr
+CubemapConversion::convert(const TextureImage& source, 
+                           CubemapLayout layout,
+                           size_t faceSize,
+                           CubemapSampling sampling,
+                           PixelFormat format,
+                           uint32_t numMipmaps)
+{
+    if (PixelUtil::isCompressed(source.getFormat()))
+        throw(std::exception("Compressed sources are not supported - CubemapConversion::convert"));
+
+    const ConstPixelBox sourceBox = source.getPixelBox(0, 0);
+    const size_t width = sourceBox.size().x;
+    const size_t height = sourceBox.size().y;
+    if ((layout == CUBE_LAYOUT_HORIZONTAL_CROSS && (width < 4 || height < 3)) ||
+        (layout == CUBE_LAYOUT_VERTICAL_CROSS && (width < 3 || height < 4)) ||
+        width == 0 || height == 0)
+    {
+        throw(std::exception("Source is too small for the layout - CubemapConversion::convert"));
+    }
+
+    // Sampled as float RGBA.
+    std::vector<float> expanded;
+    SourceImage image = { static_cast<const float*>(sourceBox.data), width, height };
+    if (sourceBox.format != PF_FLOAT32_RGBA || sourceBox.rowPitch != width)
+    {
+        expanded.resize(width * height * 4);
+        PixelUtil::bulkPixelConversion(sourceBox.source(), PixelBox(width, height, 1, PF_FLOAT32_RGBA, &expanded[0]));
+        image.texels = &expanded[0];
+    }
+
+    const size_t naturalSize = naturalFaceSize(layout, width);
+    if (faceSize == 0)
+        faceSize = naturalSize;
+    if (format == PF_UNKNOWN)
+        format = source.getFormat();
+
+    // Supersamples per axis, enough for every source texel under a face texel.
+    const size_t samples = sampling == CUBE_SAMPLE_AREA ? 
+        std::min(std::max<size_t>((naturalSize + faceSize - 1) / faceSize, 1), MaxAreaSamples) : 1;
+    const float weight = 1.0f / float(samples * samples);
+
+    TextureImagePtr cubemap(new TextureImage());
+    cubemap->create(Vector2i(int32_t(faceSize), int32_t(faceSize)), format, numMipmaps, IF_CUBEMAP);
+
+    const LayoutMapping mapping(layout, width, height);
+    const size_t dstPixelSize = PixelUtil::getNumElemBytes(format);
+    concurrency::parallel_for(size_t(0), faceSize * 6, [&](size_t row)
+    {
+        const size_t face = row / faceSize;
+        const size_t y = row % faceSize;
+
+        std::vector<float> accum(faceSize * 4, 0.0f);
+        std::vector<float> us(faceSize);
+        std::vector<float> directions(faceSize * 3);
+        float* dx = &directions[0];
+        float* dy = dx + faceSize;
+        float* dz = dy + faceSize;
+
+        for (size_t sy = 0; sy < samples; ++sy)
+        {
+            const float v = (float(y) + (float(sy) + 0.5f) / float(samples)) * 2.0f / float(faceSize) - 1.0f;
+            for (size_t sx = 0; sx < samples; ++sx)
+            {
+                const float offset = (float(sx) + 0.5f) / float(samples);
+                for (size_t x = 0; x < faceSize; ++x)
+                    us[x] = (float(x) + offset) * 2.0f / float(faceSize) - 1.0f;
+                faceDirections(face, v, &us[0], faceSize, dx, dy, dz);
+
+                for (size_t x = 0; x < faceSize; ++x)
+                {
+                    Cell cell;
+                    float px, py;
+                    mapping.locate(dx[x], dy[x], dz[x], cell, px, py);
+                    sampleBilinear(image, cell, px, py, weight, &accum[x * 4]);
+                }
+            }
+        }
+
+        PixelBox faceBox = cubemap->getWritablePixelBox(face, 0);
+        PixelUtil::bulkPixelConversion(&accum[0], PF_FLOAT32_RGBA, 
+                                       static_cast<uint8_t*>(faceBox.data) + y * faceBox.rowPitch * dstPixelSize, 
+                                       format, static_cast<unsigned int>(faceSize));
+    });
+
+    if (numMipmaps > 0)
+        cubemap->generateMipmaps();
+    return cubemap;
+}
+}
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_CUBEMAP_CONVERSION
+#define INCLUDED_CRT_CUBEMAP_CONVERSION
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+#include <CtrTextureImage.h>
+
+namespace Ctr
+{
+enum CubemapLayout
+{
+    // 2:1 equirectangular, +Y at the top, +Z at the centre column
+    // and +X a quarter of the way to the right of it.
+    CUBE_LAYOUT_LATLONG,
+    // 4:3, -X +Z +X -Z across the middle row, +Y above and -Y below +Z.
+    CUBE_LAYOUT_HORIZONTAL_CROSS,
+    // 3:4, -X +Z +X across the second row, +Y above +Z, then -Y and
+    // -Z (rotated by 180 degrees) below it.
+    CUBE_LAYOUT_VERTICAL_CROSS,
+    // 1:1 octahedral map, +Y at the centre and -Y at the corners.
+    CUBE_LAYOUT_OCTAHEDRAL
+};
+
+enum CubemapSampling
+{
+    // One bilinear sample through each texel centre.
+    CUBE_SAMPLE_BILINEAR,
+    // Box filter over the texel footprint, supersampled so that 
+    // every source texel under the footprint contributes.
+    CUBE_SAMPLE_AREA
+};
+
+//-----------------------------------------------------------------
+// Builds cube maps (IF_CUBEMAP, faces in D3D order +X -X +Y -Y +Z -Z)
+// from lat-long, cross and octahedral environment images.
+// Face rows are converted in parallel, texel directions are 
+// generated four at a time with SSE2.
+//-----------------------------------------------------------------
+class CubemapConversion
+{
+  public:
+    // Guesses the layout of a width x height image from its aspect ratio,
+    // 2:1 is lat-long and 4:3 or 3:4 a cross. Square images are ambiguous,
+    // so octahedral maps are never detected and must be asked for. 
+    // Returns false if no layout matches.
+    static bool                detectLayout(size_t width, size_t height, 
+                                            CubemapLayout& layout);
+
+    // Converts the top level of face 0 of source into a new cube map.
+    // A faceSize of 0 keeps the source resolution, PF_UNKNOWN keeps the
+    // source format. numMipmaps levels are generated after the top level.
+    static TextureImagePtr     convert(const TextureImage& source, 
+                                       CubemapLayout layout,
+                                       size_t faceSize = 0,
+                                       CubemapSampling sampling = CUBE_SAMPLE_BILINEAR,
+                                       PixelFormat format = PF_UNKNOWN,
+                                       uint32_t numMipmaps = 0);
+
+    // Face size that keeps the resolution of a source width texels wide.
+    static size_t              naturalFaceSize(CubemapLayout layout, size_t width);
+
+    // Unit directions through count points of face at (us[i], v), 
+    // with u and v in [-1, 1] running along the face rows and columns.
+    static void                faceDirections(size_t face, float v, 
+                                              const float* us, size_t count,
+                                              float* x, float* y, float* z);
+
+    // Face of the major axis of direction (x, y, z) and the (u, v)
+    // face coordinates in [-1, 1] it passes through.
+    static size_t              directionToFace(float x, float y, float z, 
+                                               float& u, float& v);
+};
+}
+
+#endif
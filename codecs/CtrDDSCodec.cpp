@@ -67,6 +67,7 @@ THE SOFTWARE.
 */
 #include <CtrDDSCodec.h>
 #include <CtrTextureImage.h>
+#include <CtrBlockDecompressor.h>
 #include <CtrLog.h>
 
 namespace Ctr 
@@ -131,23 +132,6 @@ typedef struct
         // 16 2-bit indexes, each byte here is one row
         uint8_t indexRow[4];
     };
-    // An 8-byte DXT explicit alpha block, represents a 4x4 texel area. Used by DXT2/3
-    struct DXTExplicitAlphaBlock
-    {
-        // 16 4-bit values, each 16-bit value is one row
-        uint16_t alphaRow[4];
-    };
-    // An 8-byte DXT interpolated alpha block, represents a 4x4 texel area. Used by DXT4/5
-    struct DXTInterpolatedAlphaBlock
-    {
-        // 2 alpha ranges
-        uint8_t alpha_0;
-        uint8_t alpha_1;
-        // 16 3-bit indexes. Unfortunately 3 bits doesn't map too well to row bytes
-        // so just stored raw
-        uint8_t indexes[6];
-    };
-    
 
 #pragma pack (pop)
 
@@ -187,6 +171,12 @@ typedef struct
     const uint32_t D3DFMT_G32R32F         = 115;
     const uint32_t D3DFMT_A32B32G32R32F   = 116;
 
+    // D3D10 resource misc flag for cube maps in the DX10 header
+    const uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+    // D3D10 resource dimensions in the DX10 header
+    const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+    const uint32_t DDS_DIMENSION_TEXTURE3D = 4;
+
 
     //---------------------------------------------------------------------
     DDSCodec* DDSCodec::msInstance = 0;
@@ -221,7 +211,15 @@ typedef struct
     //---------------------------------------------------------------------
     DataStreamPtr DDSCodec::code(MemoryDataStreamPtr& input, Codec::CodecDataPtr& pData) const
     {        
-        throw (std::exception("DDS encoding not supported DDSCodec::code" ));
+        ImageData* imgData = static_cast<ImageData* >(pData.get());
+
+        std::vector<uint8_t> header;
+        encodeHeader(imgData, header);
+
+        MemoryDataStream* output = new MemoryDataStream(header.size() + imgData->size);
+        memcpy(output->getPtr(), &header[0], header.size());
+        memcpy(output->getPtr() + header.size(), input->getPtr(), imgData->size);
+        return DataStreamPtr(output);
     }
     //---------------------------------------------------------------------
     void DDSCodec::codeToFile(MemoryDataStreamPtr& input, 
@@ -231,7 +229,19 @@ typedef struct
         // Unwrap codecDataPtr - data is cleaned by calling function
         ImageData* imgData = static_cast<ImageData* >(pData.get());  
 
+        std::vector<uint8_t> header;
+        encodeHeader(imgData, header);
 
+        // Write the file
+        std::ofstream of;
+        of.open(outFileName.c_str(), std::ios_base::binary|std::ios_base::out);
+        of.write((const char *)&header[0], header.size());
+        of.write((const char *)input->getPtr(), (uint32_t)imgData->size);
+        of.close();
+    }
+    //---------------------------------------------------------------------
+    void DDSCodec::encodeHeader(const ImageData* imgData, std::vector<uint8_t>& header) const
+    {
         // Check size for cube map faces
         bool isCubeMap = (imgData->size == 
             TextureImage::calculateSize(imgData->num_mipmaps, 6, imgData->width, 
@@ -240,6 +250,7 @@ typedef struct
         // Establish texture attributes
         bool isVolume = (imgData->depth > 1);
         bool isFloat32r = (imgData->format == PF_FLOAT32_R);
+        bool isCompressed = PixelUtil::isCompressed(imgData->format);
         bool hasAlpha = false;
         bool notImplemented = false;
         std::string notImplementedString = "";
@@ -286,6 +297,17 @@ typedef struct
         case PF_FLOAT32_RGBA:
         case PF_FLOAT32_RGB:
             break;
+        case PF_DXT1:
+        case PF_DXT2:
+        case PF_DXT3:
+        case PF_DXT4:
+        case PF_DXT5:
+        case PF_BC4:
+        case PF_BC5:
+        case PF_BC7:
+        case PF_BC6H:
+            // Block compressed formats are described by a DX10 header
+            break;
         default:
             // No crazy FOURCC or 565 et al. file formats at this stage
             notImplemented = true;
@@ -298,7 +320,7 @@ typedef struct
         // Except if any 'not implemented' conditions were met
         if (notImplemented)
         {
-            throw("DDS encoding not supported") ;
+            throw(std::exception(("DDS encoding not supported:" + notImplementedString + " - DDSCodec::encodeHeader").c_str()));
         }
         else
         {
@@ -371,7 +393,15 @@ typedef struct
             }
 
             // Initalise the SizeOrPitch flags (power two textures for now)
-            ddsHeaderSizeOrPitch = ddsHeaderRgbBits * (uint32_t)(imgData->width);
+            if (isCompressed)
+            {
+                ddsHeaderFlags |= DDSD_LINEARSIZE;
+                ddsHeaderSizeOrPitch = (uint32_t)PixelUtil::getMemorySize(imgData->width, imgData->height, 1, imgData->format);
+            }
+            else
+            {
+                ddsHeaderSizeOrPitch = ddsHeaderRgbBits * (uint32_t)(imgData->width);
+            }
 
             // Initalise the caps flags
             ddsHeaderCaps1 = (isVolume||isCubeMap) ? DDSCAPS_COMPLEX|DDSCAPS_TEXTURE : DDSCAPS_TEXTURE;
@@ -443,12 +473,23 @@ typedef struct
                 ddsHeader.pixelFormat.flags = DDPF_FOURCC;
                 //ddsHeader.pixelFormat.fourCC = D3DFMT_B32G32R32F;
                 break;
+            default:
+                if (isCompressed)
+                {
+                    ddsHeader.pixelFormat.flags = DDPF_FOURCC;
+                    ddsHeader.pixelFormat.fourCC = FOURCC('D', 'X', '1', '0');
+                }
+                break;
             }
 
             ddsHeader.pixelFormat.rgbBits = ddsHeaderRgbBits;
             ddsHeader.pixelFormat.alphaMask = (isFloat32r) ? 0x00000000 : (hasAlpha)   ? 0xFF000000 : 0x00000000;
             
-            if (colorReverse)
+            if (isCompressed)
+            {
+                // No masks for block compressed data
+            }
+            else if (colorReverse)
             {
                 ddsHeader.pixelFormat.redMask = (isFloat32r) ? 0xFFFFFFFF : 0x000000FF;
                 ddsHeader.pixelFormat.greenMask = (isFloat32r) ? 0x00000000 : 0x0000FF00;
@@ -466,8 +507,8 @@ typedef struct
             ddsHeader.caps.reserved[0] = 0;
             ddsHeader.caps.reserved[1] = 0;
 
-            // Do mip maps.
-            if (imgData->num_mipmaps == 0 || imgData->num_mipmaps == 1)
+            // Do mip maps. num_mipmaps does not count the top level.
+            if (imgData->num_mipmaps == 0)
             {
                 ddsHeader.flags &= ~DDSD_MIPMAPCOUNT;
                 ddsHeader.mipMapCount = 1;
@@ -483,21 +524,32 @@ typedef struct
             else
             {
                 ddsHeader.flags |= DDSD_MIPMAPCOUNT;
-                ddsHeader.mipMapCount = imgData->num_mipmaps;
+                ddsHeader.mipMapCount = imgData->num_mipmaps + 1;
                 ddsHeader.caps.caps1 |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
             }
 
+            DDS_HEADER_DXT10 dx10Header;
+            memset(&dx10Header, 0, sizeof(DDS_HEADER_DXT10));
+            if (isCompressed)
+            {
+                dx10Header.dxgiFormat = convertToDXGIFormat(imgData->format);
+                dx10Header.resourceDimension = isVolume ? DDS_DIMENSION_TEXTURE3D : DDS_DIMENSION_TEXTURE2D;
+                dx10Header.miscFlag = isCubeMap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+                dx10Header.arraySize = 1;
+            }
+
             // Swap endian
             flipEndian(&ddsMagic, sizeof(uint32_t), 1);
             flipEndian(&ddsHeader, 4, sizeof(DDSHeader) / 4);
+            flipEndian(&dx10Header, 4, sizeof(DDS_HEADER_DXT10) / 4);
 
-            // Write the file
-            std::ofstream of;
-            of.open(outFileName.c_str(), std::ios_base::binary|std::ios_base::out);
-            of.write((const char *)&ddsMagic, sizeof(uint32_t));
-            of.write((const char *)&ddsHeader, DDS_HEADER_SIZE);
-            of.write((const char *)input->getPtr(), (uint32_t)imgData->size);
-            of.close();
+            header.resize(sizeof(uint32_t) + DDS_HEADER_SIZE + (isCompressed ? sizeof(DDS_HEADER_DXT10) : 0));
+            memcpy(&header[0], &ddsMagic, sizeof(uint32_t));
+            memcpy(&header[sizeof(uint32_t)], &ddsHeader, DDS_HEADER_SIZE);
+            if (isCompressed)
+            {
+                memcpy(&header[sizeof(uint32_t) + DDS_HEADER_SIZE], &dx10Header, sizeof(DDS_HEADER_DXT10));
+            }
         }
     }
     //---------------------------------------------------------------------
@@ -516,11 +568,12 @@ typedef struct
             return PF_DXT4;
         case FOURCC('D','X','T','5'):
             return PF_DXT5;
-        case FOURCC('D','X','1', '0'):
-        {
-            //DXGI_FORMAT_BC4_TYPELESS
-            return PF_DXT3;
-        }
+        case FOURCC('A','T','I','1'):
+        case FOURCC('B','C','4','U'):
+            return PF_BC4;
+        case FOURCC('A','T','I','2'):
+        case FOURCC('B','C','5','U'):
+            return PF_BC5;
         case 36: // Fourcc legacy.
             return PF_FLOAT16_RGBA;
         case D3DFMT_R16F:
@@ -571,144 +624,80 @@ typedef struct
 
     }
     //---------------------------------------------------------------------
-    void DDSCodec::unpackDXTColor(PixelFormat pf, const DXTColorBlock& block, 
-        ColorValue* pCol) const
-    {
-        // Note - we assume all values have already been endian swapped
-
-        // Color lookup table
-        ColorValue derivedColors[4];
-
-        if (pf == PF_DXT1 && block.colour_0 <= block.colour_1)
-        {
-            // 1-bit alpha
-            PixelUtil::unpackColor(&(derivedColors[0]), PF_R5G6B5, &(block.colour_0));
-            PixelUtil::unpackColor(&(derivedColors[1]), PF_R5G6B5, &(block.colour_1));
-            // one intermediate colour, half way between the other two
-            derivedColors[2] = (derivedColors[0] + derivedColors[1]) / 2;
-            // transparent colour
-            derivedColors[3] = ColorValue::ZERO;
-        }
-        else
-        {
-            PixelUtil::unpackColor(&(derivedColors[0]), PF_R5G6B5, &(block.colour_0));
-            PixelUtil::unpackColor(&(derivedColors[1]), PF_R5G6B5, &(block.colour_1));
-            // first interpolated colour, 1/3 of the way along
-            derivedColors[2] = (2 * derivedColors[0] + derivedColors[1]) / 3;
-            // second interpolated colour, 2/3 of the way along
-            derivedColors[3] = (derivedColors[0] + 2 * derivedColors[1]) / 3;
-        }
-
-        // Process 4x4 block of texels
-        for (size_t row = 0; row < 4; ++row)
-        {
-            for (size_t x = 0; x < 4; ++x)
-            {
-                // LSB come first
-                uint8_t colIdx = static_cast<uint8_t>(block.indexRow[row] >> (x * 2) & 0x3);
-                if (pf == PF_DXT1)
-                {
-                    // Overwrite entire colour
-                    pCol[(row * 4) + x] = derivedColors[colIdx];
-                }
-                else
-                {
-                    // alpha has already been read (alpha precedes colour)
-                    ColorValue& col = pCol[(row * 4) + x];
-                    col.r = derivedColors[colIdx].r;
-                    col.g = derivedColors[colIdx].g;
-                    col.b = derivedColors[colIdx].b;
-                }
-            }
-
-        }
-
-
-    }
-
-    void DDSCodec::unpackDXTAlpha(const DXTExplicitAlphaBlock& block, 
-                                  ColorValue* pCol) const
+    PixelFormat DDSCodec::convertDXGIFormat(uint32_t dxgiFormat) const
     {
-        // Note - we assume all values have already been endian swapped
-        
-        // This is an explicit alpha block, 4 bits per pixel, LSB first
-        for (size_t row = 0; row < 4; ++row)
+        // Values from the DXGI_FORMAT enumeration.
+        switch(dxgiFormat)
         {
-            for (size_t x = 0; x < 4; ++x)
-            {
-                // Shift and mask off to 4 bits
-                uint8_t val = static_cast<uint8_t>(block.alphaRow[row] >> (x * 4) & 0xF);
-                // Convert to [0,1]
-                pCol->a = (float )val / (float )0xF;
-                pCol++;
-                
-            }
-        }
+        case 2:  // DXGI_FORMAT_R32G32B32A32_FLOAT
+            return PF_FLOAT32_RGBA;
+        case 6:  // DXGI_FORMAT_R32G32B32_FLOAT
+            return PF_FLOAT32_RGB;
+        case 10: // DXGI_FORMAT_R16G16B16A16_FLOAT
+            return PF_FLOAT16_RGBA;
+        case 28: // DXGI_FORMAT_R8G8B8A8_UNORM
+        case 29: // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+            return PF_A8B8G8R8;
+        case 41: // DXGI_FORMAT_R32_FLOAT
+            return PF_FLOAT32_R;
+        case 54: // DXGI_FORMAT_R16_FLOAT
+            return PF_FLOAT16_R;
+        case 70: // DXGI_FORMAT_BC1_TYPELESS
+        case 71: // DXGI_FORMAT_BC1_UNORM
+        case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+            return PF_DXT1;
+        case 73: // DXGI_FORMAT_BC2_TYPELESS
+        case 74: // DXGI_FORMAT_BC2_UNORM
+        case 75: // DXGI_FORMAT_BC2_UNORM_SRGB
+            return PF_DXT3;
+        case 76: // DXGI_FORMAT_BC3_TYPELESS
+        case 77: // DXGI_FORMAT_BC3_UNORM
+        case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+            return PF_DXT5;
+        case 79: // DXGI_FORMAT_BC4_TYPELESS
+        case 80: // DXGI_FORMAT_BC4_UNORM
+            return PF_BC4;
+        case 82: // DXGI_FORMAT_BC5_TYPELESS
+        case 83: // DXGI_FORMAT_BC5_UNORM
+            return PF_BC5;
+        case 94: // DXGI_FORMAT_BC6H_TYPELESS
+        case 95: // DXGI_FORMAT_BC6H_UF16
+            return PF_BC6H;
+        case 97: // DXGI_FORMAT_BC7_TYPELESS
+        case 98: // DXGI_FORMAT_BC7_UNORM
+        case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+            return PF_BC7;
+        case 87: // DXGI_FORMAT_B8G8R8A8_UNORM
+        case 91: // DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+            return PF_A8R8G8B8;
+        default:
+            throw(std::exception("Unsupported DXGI format found in DDS file - DDSCodec::decode"));
+        };
     }
     //---------------------------------------------------------------------
-    void DDSCodec::unpackDXTAlpha(const DXTInterpolatedAlphaBlock& block, 
-                                  ColorValue* pCol) const
+    uint32_t DDSCodec::convertToDXGIFormat(PixelFormat format) const
     {
-        // 8 derived alpha values to be indexed
-        float  derivedAlphas[8];
-
-        // Explicit extremes
-        derivedAlphas[0] = block.alpha_0 / (float )0xFF;
-        derivedAlphas[1] = block.alpha_1 / (float )0xFF;
-        
-        
-        if (block.alpha_0 <= block.alpha_1)
-        {
-            // 4 interpolated alphas, plus zero and one            
-            // full range including extremes at [0] and [5]
-            // we want to fill in [1] through [4] at weights ranging
-            // from 1/5 to 4/5
-            float  denom = 1.0f / 5.0f;
-            for (size_t i = 0; i < 4; ++i) 
-            {
-                float  factor0 = (4 - i) * denom;
-                float  factor1 = (i + 1) * denom;
-                derivedAlphas[i + 2] = 
-                    (factor0 * block.alpha_0) + (factor1 * block.alpha_1);
-            }
-            derivedAlphas[6] = 0.0f;
-            derivedAlphas[7] = 1.0f;
-
-        }
-        else
+        switch(format)
         {
-            // 6 interpolated alphas
-            // full range including extremes at [0] and [7]
-            // we want to fill in [1] through [6] at weights ranging
-            // from 1/7 to 6/7
-            float  denom = 1.0f / 7.0f;
-            for (size_t i = 0; i < 6; ++i) 
-            {
-                float  factor0 = (6 - i) * denom;
-                float  factor1 = (i + 1) * denom;
-                derivedAlphas[i + 2] = 
-                    (factor0 * block.alpha_0) + (factor1 * block.alpha_1);
-            }
-            
-        }
-
-        // Ok, now we've built the reference values, process the indexes
-        for (size_t i = 0; i < 16; ++i)
-        {
-            size_t baseByte = (i * 3) / 8;
-            size_t baseBit = (i * 3) % 8;
-            uint8_t bits = static_cast<uint8_t>(block.indexes[baseByte] >> baseBit & 0x7);
-            // do we need to stitch in next byte too?
-            if (baseBit > 5)
-            {
-                uint8_t extraBits = static_cast<uint8_t>(
-                    (block.indexes[baseByte+1] << (8 - baseBit)) & 0xFF);
-                bits |= extraBits & 0x7;
-            }
-            pCol[i].a = derivedAlphas[bits];
-
-        }
-
+        case PF_DXT1:
+            return 71; // DXGI_FORMAT_BC1_UNORM
+        case PF_DXT2:
+        case PF_DXT3:
+            return 74; // DXGI_FORMAT_BC2_UNORM
+        case PF_DXT4:
+        case PF_DXT5:
+            return 77; // DXGI_FORMAT_BC3_UNORM
+        case PF_BC4:
+            return 80; // DXGI_FORMAT_BC4_UNORM
+        case PF_BC5:
+            return 83; // DXGI_FORMAT_BC5_UNORM
+        case PF_BC7:
+            return 98; // DXGI_FORMAT_BC7_UNORM
+        case PF_BC6H:
+            return 95; // DXGI_FORMAT_BC6H_UF16
+        default:
+            throw(std::exception("Unsupported format for the DX10 header - DDSCodec::convertToDXGIFormat"));
+        };
     }
     //---------------------------------------------------------------------
     Codec::DecodeResult 
@@ -742,32 +731,15 @@ typedef struct
             throw(std::exception("DDS header size mismatch! - DDSCodec::decode"));
         }
 
-        if ((header.pixelFormat.flags &  0x00000004) &&
-             (MAKEFOURCC('D', 'X', '1', '0') == header.pixelFormat.fourCC))
+        bool hasDX10Header = false;
+        DDS_HEADER_DXT10 dx10Header;
+        if ((header.pixelFormat.flags & DDPF_FOURCC) &&
+             (FOURCC('D', 'X', '1', '0') == header.pixelFormat.fourCC))
         {
-            LOG("DX10 format detected.");
-            DDS_HEADER_DXT10 dx10Crap;
-            stream->read(&dx10Crap, sizeof(DDS_HEADER_DXT10));
-
-            LOG("Format is " << dx10Crap.dxgiFormat);
-
-                /*
-    DXGI_FORMAT_BC1_TYPELESS                = 70,
-    DXGI_FORMAT_BC1_UNORM                   = 71,
-    DXGI_FORMAT_BC1_UNORM_SRGB              = 72,
-    DXGI_FORMAT_BC2_TYPELESS                = 73,
-    DXGI_FORMAT_BC2_UNORM                   = 74,
-    DXGI_FORMAT_BC2_UNORM_SRGB              = 75,
-    DXGI_FORMAT_BC3_TYPELESS                = 76,
-    DXGI_FORMAT_BC3_UNORM                   = 77,
-    DXGI_FORMAT_BC3_UNORM_SRGB              = 78,
-    DXGI_FORMAT_BC4_TYPELESS                = 79,
-    DXGI_FORMAT_BC4_UNORM                   = 80,
-    DXGI_FORMAT_BC4_SNORM                   = 81,
-    DXGI_FORMAT_BC5_TYPELESS                = 82,
-    DXGI_FORMAT_BC5_UNORM                   = 83,
-    DXGI_FORMAT_BC5_SNORM                   = 84,
-            */
+            stream->read(&dx10Header, sizeof(DDS_HEADER_DXT10));
+            flipEndian(&dx10Header, 4, sizeof(DDS_HEADER_DXT10) / 4);
+            hasDX10Header = true;
+            LOG("DX10 format detected. Format is " << dx10Header.dxgiFormat);
         }
 
         ImageData* imgData = new ImageData();
@@ -790,7 +762,8 @@ typedef struct
 
         bool decompressDXT = false;
         // Figure out basic image type
-        if (header.caps.caps2 & DDSCAPS2_CUBEMAP)
+        if ((header.caps.caps2 & DDSCAPS2_CUBEMAP) ||
+            (hasDX10Header && (dx10Header.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)))
         {
             imgData->flags |= IF_CUBEMAP;
             numFaces = 6;
@@ -803,7 +776,11 @@ typedef struct
         // Pixel format
         PixelFormat sourceFormat = PF_UNKNOWN;
 
-        if (header.pixelFormat.flags & DDPF_FOURCC)
+        if (hasDX10Header)
+        {
+            sourceFormat = convertDXGIFormat(dx10Header.dxgiFormat);
+        }
+        else if (header.pixelFormat.flags & DDPF_FOURCC)
         {
             sourceFormat = convertFourCCFormat(header.pixelFormat.fourCC);
         }
@@ -824,7 +801,7 @@ typedef struct
 
         if (PixelUtil::isCompressed(sourceFormat))
         {
-            if (_forceDecompression)
+            if (_forceDecompression && BlockDecompressor::canDecompress(sourceFormat))
             {
                 // We'll need to decompress
                 decompressDXT = true;
@@ -862,6 +839,14 @@ typedef struct
                     // full alpha present, formats vary only in encoding 
                     imgData->format = PF_BYTE_RGBA;
                     break;
+                case PF_BC4:
+                case PF_BC5:
+                    // red / red green, decoded with opaque alpha
+                    imgData->format = PF_BYTE_RGBA;
+                    break;
+                case PF_BC7:
+                    imgData->format = PF_BYTE_RGBA;
+                    break;
                 default:
                     // all other cases need no special format handling
                     break;
@@ -886,6 +871,44 @@ typedef struct
         imgData->size = TextureImage::calculateSize(imgData->num_mipmaps, numFaces, 
             imgData->width, imgData->height, imgData->depth, imgData->format);
 
+        // If the source is resident in memory (mapped file or memory stream) and the
+        // payload is already laid out the way TextureImage expects it, reference it
+        // directly instead of copying every face and mip into a new buffer. A mapped
+        // file stays open while the image borrows from it, see MappedFileDataStream.
+        const uint8_t* sourceData = stream->getDataPtr();
+        size_t sourceOffset = stream->tell();
+        if (sourceData && !decompressDXT && 
+            sourceOffset + imgData->size <= stream->size())
+        {
+            bool contiguous = true;
+            if (!PixelUtil::isCompressed(sourceFormat) && (header.flags & DDSD_PITCH))
+            {
+                size_t width = imgData->width;
+                for (size_t mip = 0; mip <= imgData->num_mipmaps; ++mip)
+                {
+                    size_t dstPitch = width * PixelUtil::getNumElemBytes(imgData->format);
+                    if ((header.sizeOrPitch >> mip) != dstPitch)
+                    {
+                        contiguous = false;
+                        break;
+                    }
+                    if(width!=1) width /= 2;
+                }
+            }
+
+            if (contiguous)
+            {
+                output.reset(new MemoryDataStream(const_cast<uint8_t*>(sourceData + sourceOffset), 
+                                                  imgData->size, false));
+                imgData->borrowed = true;
+
+                DecodeResult ret;
+                ret.first = output;
+                ret.second = CodecDataPtr(imgData);
+                return ret;
+            }
+        }
+
         // Bind output buffer
         output.reset(new MemoryDataStream(imgData->size));
         
@@ -908,79 +931,28 @@ typedef struct
                     // Compressed data
                     if (decompressDXT )
                     {
-                        DXTColorBlock col;
-                        DXTInterpolatedAlphaBlock iAlpha;
-                        DXTExplicitAlphaBlock eAlpha;
-                        // 4x4 block of decompressed colour
-                        ColorValue tempColors[16];
-                        size_t destBpp = PixelUtil::getNumElemBytes(imgData->format);
-                        size_t sx = std::min(width, (size_t)4);
-                        size_t sy = std::min(height, (size_t)4);
-                        size_t destPitchMinus4 = dstPitch - destBpp * sx;
-                        // slices are done individually
-                        for(size_t z = 0; z < depth; ++z)
+                        size_t dxtSize = PixelUtil::getMemorySize(width, height, depth, sourceFormat);
+                        const uint8_t* blockData = stream->getDataPtr();
+                        std::vector<uint8_t> blockBuffer;
+                        if (blockData && stream->tell() + dxtSize <= stream->size())
                         {
-                            // 4x4 blocks in x/y
-                            for (size_t y = 0; y < height; y += 4)
-                            {
-                                for (size_t x = 0; x < width; x += 4)
-                                {
-                                    if (sourceFormat == PF_DXT2 || 
-                                        sourceFormat == PF_DXT3)
-                                    {
-                                        // explicit alpha
-                                        stream->read(&eAlpha, sizeof(DXTExplicitAlphaBlock));
-                                        flipEndian(eAlpha.alphaRow, sizeof(uint16_t), 4);
-                                        unpackDXTAlpha(eAlpha, tempColors) ;
-                                    }
-                                    else if (sourceFormat == PF_DXT4 || 
-                                        sourceFormat == PF_DXT5)
-                                    {
-                                        // interpolated alpha
-                                        stream->read(&iAlpha, sizeof(DXTInterpolatedAlphaBlock));
-                                        flipEndian(&(iAlpha.alpha_0), sizeof(uint16_t), 1);
-                                        flipEndian(&(iAlpha.alpha_1), sizeof(uint16_t), 1);
-                                        unpackDXTAlpha(iAlpha, tempColors) ;
-                                    }
-                                    // always read colour
-                                    stream->read(&col, sizeof(DXTColorBlock));
-                                    flipEndian(&(col.colour_0), sizeof(uint16_t), 1);
-                                    flipEndian(&(col.colour_1), sizeof(uint16_t), 1);
-                                    unpackDXTColor(sourceFormat, col, tempColors);
-
-                                    // write 4x4 block to uncompressed version
-                                    for (size_t by = 0; by < sy; ++by)
-                                    {
-                                        for (size_t bx = 0; bx < sx; ++bx)
-                                        {
-                                            PixelUtil::packColor(tempColors[by*4+bx],
-                                                imgData->format, destPtr);
-                                            destPtr = static_cast<void*>(
-                                                static_cast<uint8_t*>(destPtr) + destBpp);
-                                        }
-                                        // advance to next row
-                                        destPtr = static_cast<void*>(
-                                            static_cast<uint8_t*>(destPtr) + destPitchMinus4);
-                                    }
-                                    // next block. Our dest pointer is 4 lines down
-                                    // from where it started
-                                    if (x + 4 >= width)
-                                    {
-                                        // Jump back to the start of the line
-                                        destPtr = static_cast<void*>(
-                                            static_cast<uint8_t*>(destPtr) - destPitchMinus4);
-                                    }
-                                    else
-                                    {
-                                        // Jump back up 4 rows and 4 pixels to the
-                                        // right to be at the next block to the right
-                                        destPtr = static_cast<void*>(
-                                            static_cast<uint8_t*>(destPtr) - dstPitch * sy + destBpp * sx);
-
-                                    }
-                                }
-                            }
+                            // Decode straight out of the resident source.
+                            blockData += stream->tell();
+                            stream->skip(static_cast<long>(dxtSize));
                         }
+                        else
+                        {
+                            blockBuffer.resize(dxtSize);
+                            stream->read(&blockBuffer[0], dxtSize);
+                            blockData = &blockBuffer[0];
+                        }
+
+                        PixelBox srcBox(width, height, depth, sourceFormat, const_cast<uint8_t*>(blockData));
+                        PixelBox dstBox(width, height, depth, imgData->format, destPtr);
+                        BlockDecompressor::decompress(srcBox, dstBox);
+
+                        destPtr = static_cast<void*>(static_cast<uint8_t*>(destPtr) + 
+                            PixelUtil::getMemorySize(width, height, depth, imgData->format));
                     }
                     else
                     {
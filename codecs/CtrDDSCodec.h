@@ -73,11 +73,6 @@ THE SOFTWARE.
 
 namespace Ctr
 {
-// Forward declarations
-struct DXTColorBlock;
-struct DXTExplicitAlphaBlock;
-struct DXTInterpolatedAlphaBlock;
-
 /** Codec specialized in loading DDS (Direct Draw Surface) images.
 @remarks
     We implement our own codec here since we need to be able to keep DXT
@@ -94,13 +89,12 @@ class DDSCodec : public ImageCodec
     PixelFormat convertFourCCFormat(uint32_t fourcc) const;
     PixelFormat convertPixelFormat(uint32_t rgbBits, uint32_t rMask, 
                                    uint32_t gMask, uint32_t bMask, uint32_t aMask) const;
-
-    /// Unpack DXT colours into array of 16 colour values
-    void unpackDXTColor(PixelFormat pf, const DXTColorBlock& block, ColorValue* pCol) const;
-    /// Unpack DXT alphas into array of 16 colour values
-    void unpackDXTAlpha(const DXTExplicitAlphaBlock& block, ColorValue* pCol) const;
-    /// Unpack DXT alphas into array of 16 colour values
-    void unpackDXTAlpha(const DXTInterpolatedAlphaBlock& block, ColorValue* pCol) const;
+    /// Format from the DX10 extended header
+    PixelFormat convertDXGIFormat(uint32_t dxgiFormat) const;
+    /// DX10 extended header format of a block compressed format
+    uint32_t convertToDXGIFormat(PixelFormat format) const;
+    /// Magic number, DDS header and (for block compressed formats) DX10 header
+    void encodeHeader(const ImageData* imgData, std::vector<uint8_t>& header) const;
 
     /// Single registered codec instance
     static DDSCodec* msInstance;
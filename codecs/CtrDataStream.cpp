@@ -69,6 +69,13 @@ THE SOFTWARE.
 #include <CtrDataStream.h>
 #include <CtrLog.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace Ctr
 {
     template <typename T> DataStream& DataStream::operator >>(T& val)
@@ -629,4 +636,159 @@ namespace Ctr
         }
     }
 
+    MappedFileDataStream::MappedFileDataStream(const std::string& name)
+        : DataStream(name, READ),
+          mData(nullptr),
+          mPos(nullptr),
+          mEnd(nullptr),
+#ifdef _WIN32
+          mFileHandle(INVALID_HANDLE_VALUE),
+          mMappingHandle(nullptr)
+#else
+          mFileDescriptor(-1)
+#endif
+    {
+#ifdef _WIN32
+        // Images borrow from the mapping for as long as they live, sharing
+        // delete lets the file be renamed, deleted or replaced meanwhile.
+        mFileHandle = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (mFileHandle == INVALID_HANDLE_VALUE)
+        {
+            LOG("Cannot open file for mapping: " << name);
+            return;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(mFileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return;
+        }
+
+        mMappingHandle = CreateFileMappingA(mFileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (mMappingHandle == nullptr)
+        {
+            LOG("Cannot create file mapping: " << name);
+            close();
+            return;
+        }
+
+        mData = static_cast<uint8_t*>(MapViewOfFile(mMappingHandle, FILE_MAP_COPY, 0, 0, 0));
+        if (mData == nullptr)
+        {
+            LOG("Cannot map view of file: " << name);
+            close();
+            return;
+        }
+        mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+        mFileDescriptor = open(name.c_str(), O_RDONLY);
+        if (mFileDescriptor < 0)
+        {
+            LOG("Cannot open file for mapping: " << name);
+            return;
+        }
+
+        struct stat finfo;
+        if (fstat(mFileDescriptor, &finfo) != 0 || finfo.st_size == 0)
+        {
+            close();
+            return;
+        }
+
+        void* mapped = mmap(nullptr, static_cast<size_t>(finfo.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, mFileDescriptor, 0);
+        if (mapped == MAP_FAILED)
+        {
+            LOG("Cannot map file: " << name);
+            close();
+            return;
+        }
+        mData = static_cast<uint8_t*>(mapped);
+        mSize = static_cast<size_t>(finfo.st_size);
+#endif
+        mPos = mData;
+        mEnd = mData + mSize;
+    }
+
+    MappedFileDataStream::~MappedFileDataStream()
+    {
+        close();
+    }
+
+    bool
+    MappedFileDataStream::ok() const
+    {
+        return (mPos <= mEnd && mPos >= mData) && mData != nullptr;
+    }
+
+    size_t MappedFileDataStream::read(void* buf, size_t count)
+    {
+        size_t cnt = count;
+        if (mPos + cnt > mEnd)
+            cnt = mEnd - mPos;
+        if (cnt == 0)
+            return 0;
+
+        memcpy(buf, mPos, cnt);
+        mPos += cnt;
+        return cnt;
+    }
+
+    void MappedFileDataStream::skip(long count)
+    {
+        size_t newpos = (size_t)( ( mPos - mData ) + count );
+        assert( mData + newpos <= mEnd );
+
+        mPos = mData + newpos;
+    }
+
+    void MappedFileDataStream::seek( size_t pos )
+    {
+        assert( mData + pos <= mEnd );
+        mPos = mData + pos;
+    }
+
+    size_t MappedFileDataStream::tell(void) const
+    {
+        return mPos - mData;
+    }
+
+    bool MappedFileDataStream::eof(void) const
+    {
+        return mPos >= mEnd;
+    }
+
+    void MappedFileDataStream::close(void)
+    {
+#ifdef _WIN32
+        if (mData)
+        {
+            UnmapViewOfFile(mData);
+        }
+        if (mMappingHandle)
+        {
+            CloseHandle(mMappingHandle);
+            mMappingHandle = nullptr;
+        }
+        if (mFileHandle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(mFileHandle);
+            mFileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (mData)
+        {
+            munmap(mData, mSize);
+        }
+        if (mFileDescriptor >= 0)
+        {
+            ::close(mFileDescriptor);
+            mFileDescriptor = -1;
+        }
+#endif
+        mData = mPos = mEnd = nullptr;
+        mSize = 0;
+    }
+
 }
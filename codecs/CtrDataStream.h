@@ -224,10 +224,15 @@ public:
 
     size_t size(void) const;
 
+    // Direct access to the stream contents when they are resident in memory
+    // (memory and mapped file streams). nullptr for streams that must be read.
+    virtual const uint8_t*     getDataPtr(void) const { return nullptr; }
+
     virtual void close(void) = 0;
 };
 
 typedef std::unique_ptr<DataStream> DataStreamPtr;
+typedef std::shared_ptr<DataStream> SharedDataStreamPtr;
 typedef std::list<DataStreamPtr> DataStreamList;
 
 class MemoryDataStream : public DataStream
@@ -258,6 +263,7 @@ class MemoryDataStream : public DataStream
 
     uint8_t *                  getPtr(void) { return mData; }    
     uint8_t *                  getCurrentPtr(void) { return mPos; }
+    const uint8_t*             getDataPtr(void) const { return mData; }
     size_t                     read(void* buf, size_t count);
     size_t                     write(const void* buf, size_t count);
     size_t                     readLine(char* buf, size_t maxCount, const std::string& delim = "\n");
@@ -350,6 +356,45 @@ class FileHandleDataStream : public DataStream
     void close(void);
 
 };
+
+// Read only stream over a memory mapped file.
+// The file contents are paged in on demand by the OS, so consumers
+// that use getPtr() can parse directly from the page cache without
+// first copying the whole file into a heap buffer.
+// The view is mapped copy-on-write: data handed out through getPtr()
+// may be modified in place without touching the file on disk.
+// Images that borrow the view (see TextureImage::load) keep the file
+// open. It can be renamed or deleted meanwhile, but not rewritten in
+// place, so files are replaced by writing a new one and renaming it.
+class MappedFileDataStream : public DataStream
+{
+  protected:
+    uint8_t* mData;
+    uint8_t* mPos;
+    uint8_t* mEnd;
+#ifdef _WIN32
+    HANDLE mFileHandle;
+    HANDLE mMappingHandle;
+#else
+    int mFileDescriptor;
+#endif
+
+  public:
+    MappedFileDataStream(const std::string& name);
+    virtual ~MappedFileDataStream();
+
+    uint8_t *                  getPtr(void) { return mData; }
+    uint8_t *                  getCurrentPtr(void) { return mPos; }
+    const uint8_t*             getDataPtr(void) const { return mData; }
+
+    virtual bool               ok() const;
+    size_t                     read(void* buf, size_t count);
+    void                       skip(long count);
+    void                       seek( size_t pos );
+    size_t                     tell(void) const;
+    bool                       eof(void) const;
+    void                       close(void);
+};
 }
 #endif
 
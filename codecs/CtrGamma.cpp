@@ -0,0 +1,370 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrGamma.h>
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <mutex>
+
+namespace Ctr
+{
+namespace
+{
+//-----------------------------------------------------------------
+// pow(x, p) = exp2(p * log2(x)) for x in (0, 1]. The logarithm is the
+// Cephes logf polynomial, the exponential the Cephes exp2f polynomial.
+// The scalar and SSE2 versions evaluate the same expressions in the
+// same order, so they give identical results.
+//-----------------------------------------------------------------
+const float SmallestNormal = 1.17549435e-38f;
+const float Log2e = 1.44269504088896341f;
+
+inline float
+asFloat(int32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline int32_t
+asInt(float value)
+{
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float
+powScalar(float x, float power)
+{
+    x = x > SmallestNormal ? x : SmallestNormal;
+    x = x < 1.0f ? x : 1.0f;
+
+    // x = m * 2^e with m in [sqrt(0.5), sqrt(2)).
+    int32_t bits = asInt(x);
+    float e = float((bits >> 23) - 126);
+    float m = asFloat((bits & 0x007fffff) | 0x3f000000);
+    if (m < 0.707106781186547524f)
+    {
+        e = e - 1.0f;
+        m = m + m - 1.0f;
+    }
+    else
+    {
+        m = m - 1.0f;
+    }
+
+    float z = m * m;
+    float y = 7.0376836292e-2f;
+    y = y * m - 1.1514610310e-1f;
+    y = y * m + 1.1676998740e-1f;
+    y = y * m - 1.2420140846e-1f;
+    y = y * m + 1.4249322787e-1f;
+    y = y * m - 1.6668057665e-1f;
+    y = y * m + 2.0000714765e-1f;
+    y = y * m - 2.4999993993e-1f;
+    y = y * m + 3.3333331174e-1f;
+    y = y * m * z;
+    y = y + e * -2.12194440e-4f;
+    y = y - 0.5f * z;
+    float logx = m + y;
+    logx = logx + e * 0.693359375f;
+
+    // 2^t with t = i + f, f in [-0.5, 0.5].
+    float t = power * logx * Log2e;
+    t = t > -126.0f ? t : -126.0f;
+    t = t < 0.0f ? t : 0.0f;
+    float i = std::floor(t + 0.5f);
+    float f = t - i;
+
+    float p = 1.535336188319500e-4f;
+    p = p * f + 1.339887440266574e-3f;
+    p = p * f + 9.618437357674640e-3f;
+    p = p * f + 5.550332471162809e-2f;
+    p = p * f + 2.402264791363012e-1f;
+    p = p * f + 6.931472028550421e-1f;
+    p = p * f + 1.0f;
+
+    float result = p * asFloat((int32_t(i) + 127) << 23);
+    return result < 1.0f ? result : 1.0f;
+}
+
+#if CTR_SSE2
+inline __m128
+powSSE2(__m128 x, __m128 power)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    x = _mm_max_ps(x, _mm_set1_ps(SmallestNormal));
+    x = _mm_min_ps(x, one);
+
+    __m128i bits = _mm_castps_si128(x);
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), 
+                                             _mm_set1_epi32(0x3f000000)));
+    __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+    e = _mm_sub_ps(e, _mm_and_ps(small, one));
+    m = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(small, m)), one);
+
+    __m128 z = _mm_mul_ps(m, m);
+    __m128 y = _mm_set1_ps(7.0376836292e-2f);
+    y = _mm_sub_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1514610310e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1676998740e-1f));
+    y = _mm_sub_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.2420140846e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.4249322787e-1f));
+    y = _mm_sub_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.6668057665e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.0000714765e-1f));
+    y = _mm_sub_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.4999993993e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(3.3333331174e-1f));
+    y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+    y = _mm_sub_ps(y, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+    __m128 logx = _mm_add_ps(m, y);
+    logx = _mm_add_ps(logx, _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+
+    __m128 t = _mm_mul_ps(_mm_mul_ps(power, logx), _mm_set1_ps(Log2e));
+    t = _mm_max_ps(t, _mm_set1_ps(-126.0f));
+    t = _mm_min_ps(t, _mm_setzero_ps());
+    // floor(t + 0.5), truncation rounds the negative values up.
+    __m128 rounded = _mm_add_ps(t, _mm_set1_ps(0.5f));
+    __m128 i = _mm_cvtepi32_ps(_mm_cvttps_epi32(rounded));
+    i = _mm_sub_ps(i, _mm_and_ps(_mm_cmpgt_ps(i, rounded), one));
+    __m128 f = _mm_sub_ps(t, i);
+
+    __m128 p = _mm_set1_ps(1.535336188319500e-4f);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.339887440266574e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.618437357674640e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.550332471162809e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.402264791363012e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.931472028550421e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), one);
+
+    __m128i scale = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(i), _mm_set1_epi32(127)), 23);
+    return _mm_min_ps(_mm_mul_ps(p, _mm_castsi128_ps(scale)), one);
+}
+#endif
+
+inline float
+srgbToLinearScalar(float x)
+{
+    if (x <= 0.04045f)
+        return x > 0.0f ? x / 12.92f : 0.0f;
+    return powScalar((x + 0.055f) / 1.055f, 2.4f);
+}
+
+inline float
+linearToSrgbScalar(float x)
+{
+    if (x <= 0.0031308f)
+        return x > 0.0f ? x * 12.92f : 0.0f;
+    return 1.055f * powScalar(x, 1.0f / 2.4f) - 0.055f;
+}
+
+//-----------------------------------------------------------------
+// Small most recently used cache of tables keyed by power.
+//-----------------------------------------------------------------
+class TableCache
+{
+  public:
+    TableCache(size_t entries) : _entries(entries) {}
+
+    Gamma::Table               table(float power, float maximum)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            for (auto it = _tables.begin(); it != _tables.end(); it++)
+            {
+                if (it->first == power)
+                {
+                    _tables.splice(_tables.begin(), _tables, it);
+                    return it->second;
+                }
+            }
+        }
+
+        // Build outside of the lock, a racing thread may build the same table.
+        std::shared_ptr<std::vector<float> > values(new std::vector<float>(size_t(maximum) + 1));
+        for (size_t i = 0; i < values->size(); i++)
+        {
+            float converted = std::pow(float(i) / maximum, power);
+            (*values)[i] = converted < 0.0f ? 0.0f : (converted > 1.0f ? 1.0f : converted);
+        }
+
+        std::lock_guard<std::mutex> lock(_lock);
+        _tables.push_front(std::make_pair(power, Gamma::Table(values)));
+        if (_tables.size() > _entries)
+            _tables.pop_back();
+        return _tables.front().second;
+    }
+
+  private:
+    std::mutex                 _lock;
+    std::list<std::pair<float, Gamma::Table> > _tables;
+    size_t                     _entries;
+};
+
+TableCache&
+unorm8Tables()
+{
+    static TableCache* tables = new TableCache(16);
+    return *tables;
+}
+
+TableCache&
+unorm16Tables()
+{
+    static TableCache* tables = new TableCache(4);
+    return *tables;
+}
+}
+
+float
+Gamma::fastPow(float x, float power)
+{
+    return powScalar(x, power);
+}
+
+float
+Gamma::srgbToLinear(float x)
+{
+    return srgbToLinearScalar(x);
+}
+
+float
+Gamma::linearToSrgb(float x)
+{
+    return linearToSrgbScalar(x);
+}
+
+void
+Gamma::applyPower(const float* src, float* dst, size_t count, float power)
+{
+    size_t i = 0;
+#if CTR_SSE2
+    const __m128 power4 = _mm_set1_ps(power);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(dst + i, powSSE2(_mm_loadu_ps(src + i), power4));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        dst[i] = powScalar(src[i], power);
+    }
+}
+
+void
+Gamma::applyPower(const uint8_t* src, float* dst, size_t count, float power)
+{
+    Table table = unorm8Table(power);
+    const float* values = &(*table)[0];
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = values[src[i]];
+    }
+}
+
+void
+Gamma::applyPower(const uint16_t* src, float* dst, size_t count, float power)
+{
+    Table table = unorm16Table(power);
+    const float* values = &(*table)[0];
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = values[src[i]];
+    }
+}
+
+void
+Gamma::srgbToLinear(const float* src, float* dst, size_t count)
+{
+    size_t i = 0;
+#if CTR_SSE2
+    const __m128 power = _mm_set1_ps(2.4f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(src + i);
+        __m128 curve = powSSE2(_mm_div_ps(_mm_add_ps(x, _mm_set1_ps(0.055f)), _mm_set1_ps(1.055f)), power);
+        __m128 linear = _mm_max_ps(_mm_div_ps(x, _mm_set1_ps(12.92f)), _mm_setzero_ps());
+        __m128 useLinear = _mm_cmple_ps(x, _mm_set1_ps(0.04045f));
+        _mm_storeu_ps(dst + i, _mm_or_ps(_mm_and_ps(useLinear, linear), _mm_andnot_ps(useLinear, curve)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        dst[i] = srgbToLinearScalar(src[i]);
+    }
+}
+
+void
+Gamma::linearToSrgb(const float* src, float* dst, size_t count)
+{
+    size_t i = 0;
+#if CTR_SSE2
+    const __m128 power = _mm_set1_ps(1.0f / 2.4f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(src + i);
+        __m128 curve = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(1.055f), powSSE2(x, power)), _mm_set1_ps(0.055f));
+        __m128 linear = _mm_max_ps(_mm_mul_ps(x, _mm_set1_ps(12.92f)), _mm_setzero_ps());
+        __m128 useLinear = _mm_cmple_ps(x, _mm_set1_ps(0.0031308f));
+        _mm_storeu_ps(dst + i, _mm_or_ps(_mm_and_ps(useLinear, linear), _mm_andnot_ps(useLinear, curve)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        dst[i] = linearToSrgbScalar(src[i]);
+    }
+}
+
+Gamma::Table
+Gamma::unorm8Table(float power)
+{
+    return unorm8Tables().table(power, 255.0f);
+}
+
+Gamma::Table
+Gamma::unorm16Table(float power)
+{
+    return unorm16Tables().table(power, 65535.0f);
+}
+}
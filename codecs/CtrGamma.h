@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_GAMMA
+#define INCLUDED_CRT_GAMMA
+
+#include <CtrPlatform.h>
+#include <memory>
+#include <vector>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Gamma and sRGB transfer functions for image data.
+// Integer sources go through cached lookup tables of exact pow()
+// results. Float sources use a polynomial log/exp approximation
+// (relative error around 1e-6), four lanes at a time with SSE2.
+// Results are saturated to [0, 1]. Thread safe.
+//-----------------------------------------------------------------
+class Gamma
+{
+  public:
+    typedef std::shared_ptr<const std::vector<float> > Table;
+
+    // saturate(pow(x, power)), power must be positive.
+    static float               fastPow(float x, float power);
+    static float               srgbToLinear(float x);
+    static float               linearToSrgb(float x);
+
+    // dst[i] = saturate(pow(src[i], power)), with integer sources
+    // normalized to [0, 1] first. src and dst may alias for floats.
+    static void                applyPower(const float* src, float* dst, size_t count, float power);
+    static void                applyPower(const uint8_t* src, float* dst, size_t count, float power);
+    static void                applyPower(const uint16_t* src, float* dst, size_t count, float power);
+
+    static void                srgbToLinear(const float* src, float* dst, size_t count);
+    static void                linearToSrgb(const float* src, float* dst, size_t count);
+
+    // Tables of saturate(pow(i / 255, power)) and saturate(pow(i / 65535, power)).
+    // The most recently used powers are cached.
+    static Table               unorm8Table(float power);
+    static Table               unorm16Table(float power);
+};
+}
+
+#endif
@@ -0,0 +1,251 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrHDRPacking.h>
+#include <ppl.h>
+
+namespace Ctr
+{
+namespace
+{
+inline float
+nonNegative(float value)
+{
+    // Also maps NaNs to zero.
+    return value > 0.0f ? value : 0.0f;
+}
+
+inline void
+packRGBM(const float colour[4], float range, uint8_t packed[4])
+{
+    const float r = nonNegative(colour[0]);
+    const float g = nonNegative(colour[1]);
+    const float b = nonNegative(colour[2]);
+    const float multiplier = std::min(std::max(std::max(r, g), b) / range, 1.0f);
+    const uint32_t quantized = uint32_t(ceilf(multiplier * 255.0f));
+    if (quantized == 0)
+    {
+        memset(packed, 0, 4);
+        return;
+    }
+
+    const float scale = 255.0f * 255.0f / (float(quantized) * range);
+    packed[0] = uint8_t(std::min(r * scale + 0.5f, 255.0f));
+    packed[1] = uint8_t(std::min(g * scale + 0.5f, 255.0f));
+    packed[2] = uint8_t(std::min(b * scale + 0.5f, 255.0f));
+    packed[3] = uint8_t(quantized);
+}
+
+inline void
+unpackRGBM(const uint8_t packed[4], float range, float colour[4])
+{
+    const float scale = float(packed[3]) * range / (255.0f * 255.0f);
+    colour[0] = float(packed[0]) * scale;
+    colour[1] = float(packed[1]) * scale;
+    colour[2] = float(packed[2]) * scale;
+    colour[3] = 1.0f;
+}
+
+inline void
+packRGBE(const float colour[4], uint8_t packed[4])
+{
+    const float r = nonNegative(colour[0]);
+    const float g = nonNegative(colour[1]);
+    const float b = nonNegative(colour[2]);
+    const float value = std::min(std::max(std::max(r, g), b), FLT_MAX);
+    if (value < 1e-32f)
+    {
+        memset(packed, 0, 4);
+        return;
+    }
+
+    int exponent;
+    const float scale = frexpf(value, &exponent) * 256.0f / value;
+    packed[0] = uint8_t(std::min(r * scale, 255.0f));
+    packed[1] = uint8_t(std::min(g * scale, 255.0f));
+    packed[2] = uint8_t(std::min(b * scale, 255.0f));
+    packed[3] = uint8_t(exponent + 128);
+}
+
+inline void
+unpackRGBE(const uint8_t packed[4], float colour[4])
+{
+    if (packed[3] == 0)
+    {
+        colour[0] = colour[1] = colour[2] = 0.0f;
+    }
+    else
+    {
+        const float scale = ldexpf(1.0f, int(packed[3]) - (128 + 8));
+        colour[0] = (float(packed[0]) + 0.5f) * scale;
+        colour[1] = (float(packed[1]) + 0.5f) * scale;
+        colour[2] = (float(packed[2]) + 0.5f) * scale;
+    }
+    colour[3] = 1.0f;
+}
+
+// Row y and slice z of box, in bytes.
+inline uint8_t*
+rowData(const PixelBox& box, size_t y, size_t z)
+{
+    return static_cast<uint8_t*>(box.data) + 
+        (box.minExtent.x + (box.minExtent.y + y) * box.rowPitch + 
+         (box.minExtent.z + z) * box.slicePitch) * PixelUtil::getNumElemBytes(box.format);
+}
+}
+
+const float HDRPacking::DefaultRGBMRange = 6.0f;
+
+bool
+HDRPacking::canPack(PixelFormat format)
+{
+    return format == PF_A8B8G8R8 || format == PF_A8R8G8B8;
+}
+
+void
+HDRPacking::pack(const PixelBox& src, const PixelBox& dst, Mode mode, float range)
+{
+    assert(src.size().x == dst.size().x &&
+           src.size().y == dst.size().y &&
+           src.size().z == dst.size().z);
+
+    if (!canPack(dst.format))
+    {
+        throw(std::exception("Destination must be 8 bit RGBA - HDRPacking::pack"));
+    }
+    if (PixelUtil::isCompressed(src.format))
+    {
+        throw(std::exception("Source must be uncompressed - HDRPacking::pack"));
+    }
+
+    const size_t width = src.size().x;
+    const size_t height = src.size().y;
+    // Packed texels are written red first, swap for BGRA destinations.
+    const size_t red = dst.format == PF_A8R8G8B8 ? 2 : 0;
+    const size_t blue = 2 - red;
+
+    concurrency::parallel_for(size_t(0), height * src.size().z, [&](size_t row)
+    {
+        const size_t y = row % height;
+        const size_t z = row / height;
+
+        std::vector<float> colours(width * 4);
+        if (src.format == PF_FLOAT32_RGBA)
+        {
+            memcpy(&colours[0], rowData(src, y, z), width * 4 * sizeof(float));
+        }
+        else
+        {
+            PixelBox srcBox(width, 1, 1, src.format, rowData(src, y, z));
+            PixelBox colourBox(width, 1, 1, PF_FLOAT32_RGBA, &colours[0]);
+            PixelUtil::bulkPixelConversion(srcBox, colourBox);
+        }
+
+        uint8_t* dstRow = rowData(dst, y, z);
+        for (size_t x = 0; x < width; ++x)
+        {
+            uint8_t packed[4];
+            if (mode == HDR_PACKING_RGBM)
+                packRGBM(&colours[x * 4], range, packed);
+            else
+                packRGBE(&colours[x * 4], packed);
+
+            uint8_t* texel = dstRow + x * 4;
+            texel[red] = packed[0];
+            texel[1] = packed[1];
+            texel[blue] = packed[2];
+            texel[3] = packed[3];
+        }
+    });
+}
+
+void
+HDRPacking::unpack(const PixelBox& src, const PixelBox& dst, Mode mode, float range)
+{
+    assert(src.size().x == dst.size().x &&
+           src.size().y == dst.size().y &&
+           src.size().z == dst.size().z);
+
+    if (!canPack(src.format))
+    {
+        throw(std::exception("Source must be 8 bit RGBA - HDRPacking::unpack"));
+    }
+    if (PixelUtil::isCompressed(dst.format))
+    {
+        throw(std::exception("Destination must be uncompressed - HDRPacking::unpack"));
+    }
+
+    const size_t width = src.size().x;
+    const size_t height = src.size().y;
+    const size_t red = src.format == PF_A8R8G8B8 ? 2 : 0;
+    const size_t blue = 2 - red;
+
+    concurrency::parallel_for(size_t(0), height * src.size().z, [&](size_t row)
+    {
+        const size_t y = row % height;
+        const size_t z = row / height;
+
+        std::vector<float> colours(width * 4);
+        const uint8_t* srcRow = rowData(src, y, z);
+        for (size_t x = 0; x < width; ++x)
+        {
+            const uint8_t* texel = srcRow + x * 4;
+            const uint8_t packed[4] = { texel[red], texel[1], texel[blue], texel[3] };
+            if (mode == HDR_PACKING_RGBM)
+                unpackRGBM(packed, range, &colours[x * 4]);
+            else
+                unpackRGBE(packed, &colours[x * 4]);
+        }
+
+        if (dst.format == PF_FLOAT32_RGBA)
+        {
+            memcpy(rowData(dst, y, z), &colours[0], width * 4 * sizeof(float));
+        }
+        else
+        {
+            PixelBox colourBox(width, 1, 1, PF_FLOAT32_RGBA, &colours[0]);
+            PixelBox dstBox(width, 1, 1, dst.format, rowData(dst, y, z));
+            PixelUtil::bulkPixelConversion(colourBox, dstBox);
+        }
+    });
+}
+
+}
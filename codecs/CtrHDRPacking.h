@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_HDR_PACKING
+#define INCLUDED_CRT_HDR_PACKING
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Packs linear floating point RGB into 8 bit RGBA and back.
+// RGBM stores colour / (M * range) in rgb and a shared multiplier M 
+// in alpha. RGBE stores an 8 bit mantissa per channel and a shared 
+// exponent in alpha (Radiance .hdr encoding).
+// Rows are processed in parallel.
+//-----------------------------------------------------------------
+class HDRPacking
+{
+  public:
+    enum Mode
+    {
+        HDR_PACKING_RGBM,
+        HDR_PACKING_RGBE
+    };
+
+    // Largest value RGBM can represent is range, the multiplier is
+    // stored with 8 bits so small values lose precision as range grows.
+    static const float         DefaultRGBMRange;
+
+    static bool                canPack(PixelFormat format);
+
+    // Packs src (any uncompressed format) into dst, which must be 
+    // PF_A8B8G8R8 or PF_A8R8G8B8. Alpha in src is discarded.
+    static void                pack(const PixelBox& src, 
+                                    const PixelBox& dst, 
+                                    Mode mode,
+                                    float range = DefaultRGBMRange);
+
+    // Unpacks src (PF_A8B8G8R8 or PF_A8R8G8B8) into dst (any uncompressed
+    // format) with an alpha of one.
+    static void                unpack(const PixelBox& src, 
+                                      const PixelBox& dst, 
+                                      Mode mode,
+                                      float range = DefaultRGBMRange);
+};
+}
+
+#endif
@@ -0,0 +1,244 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrImageBufferPool.h>
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Ctr
+{
+namespace
+{
+struct Pool
+{
+    Pool() : maxPooledBytes(ImageBufferPool::DefaultMaxPooledBytes)
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    std::mutex                 lock;
+    // Free buffers by bucket size.
+    std::map<size_t, std::vector<uint8_t*> > buckets;
+    size_t                     maxPooledBytes;
+    ImageBufferPool::Stats     stats;
+};
+
+Pool&
+pool()
+{
+    // Never destroyed, images may release buffers during static destruction.
+    static Pool* instance = new Pool();
+    return *instance;
+}
+
+uint8_t*
+alignedAllocate(size_t size)
+{
+#if defined(_MSC_VER)
+    void* buffer = _aligned_malloc(size, ImageBufferPool::Alignment);
+#else
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, ImageBufferPool::Alignment, size) != 0)
+        buffer = nullptr;
+#endif
+    if (!buffer)
+        throw std::bad_alloc();
+    return static_cast<uint8_t*>(buffer);
+}
+
+void
+alignedFree(uint8_t* buffer)
+{
+#if defined(_MSC_VER)
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+// Frees pooled buffers, largest first, until no more than bytes are pooled.
+// The pool lock must be held.
+void
+evict(Pool& pool, size_t bytes)
+{
+    while (pool.stats.bytesPooled > bytes && !pool.buckets.empty())
+    {
+        auto bucket = std::prev(pool.buckets.end());
+        alignedFree(bucket->second.back());
+        bucket->second.pop_back();
+        pool.stats.bytesPooled -= bucket->first;
+        pool.stats.evictions++;
+        if (bucket->second.empty())
+            pool.buckets.erase(bucket);
+    }
+}
+}
+
+const size_t ImageBufferPool::Alignment;
+const size_t ImageBufferPool::DefaultMaxPooledBytes;
+
+size_t
+ImageBufferPool::bucketSize(size_t size)
+{
+    size = std::max(size, Alignment);
+    size_t octave = 1;
+    while ((octave << 1) <= size)
+        octave <<= 1;
+    const size_t step = std::max(octave / 4, Alignment);
+    return (size + step - 1) / step * step;
+}
+
+uint8_t*
+ImageBufferPool::allocate(size_t size)
+{
+    const size_t bucketBytes = bucketSize(size);
+    Pool& buffers = pool();
+    {
+        std::lock_guard<std::mutex> lock(buffers.lock);
+        buffers.stats.bytesInUse += bucketBytes;
+        buffers.stats.peakBytesInUse = std::max(buffers.stats.peakBytesInUse, buffers.stats.bytesInUse);
+
+        auto bucket = buffers.buckets.find(bucketBytes);
+        if (bucket != buffers.buckets.end())
+        {
+            uint8_t* buffer = bucket->second.back();
+            bucket->second.pop_back();
+            if (bucket->second.empty())
+                buffers.buckets.erase(bucket);
+            buffers.stats.bytesPooled -= bucketBytes;
+            buffers.stats.hits++;
+            return buffer;
+        }
+        buffers.stats.misses++;
+    }
+
+    try
+    {
+        return alignedAllocate(bucketBytes);
+    }
+    catch (...)
+    {
+        // Give the pooled memory back to the system and try again.
+        {
+            std::lock_guard<std::mutex> lock(buffers.lock);
+            evict(buffers, 0);
+        }
+        try
+        {
+            return alignedAllocate(bucketBytes);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(buffers.lock);
+            buffers.stats.bytesInUse -= bucketBytes;
+            throw;
+        }
+    }
+}
+
+void
+ImageBufferPool::release(uint8_t* buffer, size_t size)
+{
+    if (!buffer)
+        return;
+
+    const size_t bucketBytes = bucketSize(size);
+    Pool& buffers = pool();
+    {
+        std::lock_guard<std::mutex> lock(buffers.lock);
+        buffers.stats.bytesInUse -= bucketBytes;
+        if (buffers.stats.bytesPooled + bucketBytes <= buffers.maxPooledBytes)
+        {
+            buffers.buckets[bucketBytes].push_back(buffer);
+            buffers.stats.bytesPooled += bucketBytes;
+            return;
+        }
+        buffers.stats.evictions++;
+    }
+    alignedFree(buffer);
+}
+
+std::shared_ptr<uint8_t>
+ImageBufferPool::allocateShared(size_t size)
+{
+    return std::shared_ptr<uint8_t>(allocate(size), [size](uint8_t* buffer)
+    {
+        release(buffer, size);
+    });
+}
+
+void
+ImageBufferPool::setMaxPooledBytes(size_t bytes)
+{
+    Pool& buffers = pool();
+    std::lock_guard<std::mutex> lock(buffers.lock);
+    buffers.maxPooledBytes = bytes;
+    evict(buffers, bytes);
+}
+
+size_t
+ImageBufferPool::maxPooledBytes()
+{
+    Pool& buffers = pool();
+    std::lock_guard<std::mutex> lock(buffers.lock);
+    return buffers.maxPooledBytes;
+}
+
+void
+ImageBufferPool::trim()
+{
+    Pool& buffers = pool();
+    std::lock_guard<std::mutex> lock(buffers.lock);
+    evict(buffers, 0);
+}
+
+ImageBufferPool::Stats
+ImageBufferPool::stats()
+{
+    Pool& buffers = pool();
+    std::lock_guard<std::mutex> lock(buffers.lock);
+    return buffers.stats;
+}
+}
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_IMAGE_BUFFER_POOL
+#define INCLUDED_CRT_IMAGE_BUFFER_POOL
+
+#include <CtrPlatform.h>
+#include <memory>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Recycles image pixel buffers. Requests are rounded up to size 
+// buckets (a quarter of an octave apart) and released buffers are 
+// kept per bucket for reuse, up to a cap on the pooled memory.
+// Buffers are aligned to Alignment bytes. Thread safe.
+//-----------------------------------------------------------------
+class ImageBufferPool
+{
+  public:
+    static const size_t        Alignment = 64;
+    static const size_t        DefaultMaxPooledBytes = size_t(256) << 20;
+
+    struct Stats
+    {
+        // allocate() calls served from the pool and from the system.
+        size_t                 hits;
+        size_t                 misses;
+        // Buffers freed to keep within the cap, or by trim().
+        size_t                 evictions;
+        size_t                 bytesInUse;
+        size_t                 peakBytesInUse;
+        size_t                 bytesPooled;
+    };
+
+    // Returns an uninitialized buffer of at least size bytes, 
+    // which must be handed back with release(buffer, size).
+    static uint8_t*            allocate(size_t size);
+    static void                release(uint8_t* buffer, size_t size);
+
+    // Buffer that is released when the last reference goes.
+    static std::shared_ptr<uint8_t> 
+                               allocateShared(size_t size);
+
+    // Memory kept for reuse is capped at bytes, lowering the cap
+    // frees pooled buffers as needed.
+    static void                setMaxPooledBytes(size_t bytes);
+    static size_t              maxPooledBytes();
+
+    // Frees every pooled buffer.
+    static void                trim();
+
+    static Stats               stats();
+    static size_t              bucketSize(size_t size);
+};
+}
+
+#endif
@@ -86,7 +86,7 @@ namespace Ctr
             ImageData():
                 height(0), width(0), depth(1), size(0), 
                 num_mipmaps(0), flags(0), format(PF_UNKNOWN),
-                num_images(1)
+                num_images(1), borrowed(false)
             {
             }
 
@@ -100,6 +100,11 @@ namespace Ctr
 
             PixelFormat format;
 
+            // The decoded stream points directly into the memory of the
+            // input stream (no copy was made). The input stream must
+            // outlive the decoded data, which keeps a mapped file open.
+            bool borrowed;
+
         public:
             std::string dataType() const
             {
@@ -70,6 +70,7 @@ THE SOFTWARE.
 #define IBL_IMAGE_SAMPLER
 
 #include <algorithm>
+#include <vector>
 #include <ppl.h>
 
 namespace Ctr
@@ -126,15 +127,23 @@ namespace Ctr
     };
 
 
-    // default floating-point linear resampler, does format conversion
+    // default floating-point linear resampler, does format conversion.
+    // each destination row unpacks its (up to) four source rows into
+    // per-channel float spans with PixelUtil::unpackRow, blends them a
+    // channel at a time and packs the result with PixelUtil::packRow.
+    // rows are processed in parallel.
     struct LinearResampler {
         static void scale(const PixelBox& src, const PixelBox& dst) {
-            size_t srcelemsize = PixelUtil::getNumElemBytes(src.format);
-            size_t dstelemsize = PixelUtil::getNumElemBytes(dst.format);
+            const size_t srcelemsize = PixelUtil::getNumElemBytes(src.format);
+            const size_t dstelemsize = PixelUtil::getNumElemBytes(dst.format);
+            const size_t srcWidth = src.size().x;
+            const size_t dstWidth = dst.size().x;
+            const size_t dstHeight = dst.size().y;
+            const size_t dstDepth = dst.size().z;
 
-            // srcdata stays at beginning, pdst is a moving pointer
-            uint8_t* srcdata = (uint8_t*)src.data;
-            uint8_t* pdst = (uint8_t*)dst.data;
+            // srcdata and dstdata stay at the beginning of their boxes
+            const uint8_t* srcdata = (const uint8_t*)src.data;
+            uint8_t* dstdata = (uint8_t*)dst.data;
 
             // sx_48,sy_48,sz_48 represent current position in source
             // using 16/48-bit fixed precision, incremented by steps
@@ -142,68 +151,77 @@ namespace Ctr
             uint64_t stepy = ((uint64_t)src.size().y << 48) / dst.size().y;
             uint64_t stepz = ((uint64_t)src.size().z << 48) / dst.size().z;
 
-            // temp is 16/16 bit fixed precision, used to adjust a source
-            // coordinate (x, y, or z) backwards by half a pixel so that the
-            // integer bits represent the first sample (eg, sx1) and the
-            // fractional bits are the blend weight of the second sample
-            unsigned int temp;
-
-            // note: ((stepz>>1) - 1) is an extra half-step increment to adjust
+            // source columns and weights are the same for every row.
+            // note: ((stepx>>1) - 1) is an extra half-step increment to adjust
             // for the center of the destination pixel, not the top-left corner
-            uint64_t sz_48 = (stepz >> 1) - 1;
-            for (size_t z = dst.minExtent.z; z < dst.maxExtent.z; z++, sz_48 += stepz) {
-                temp = static_cast<unsigned int>(sz_48 >> 32);
-                temp = (temp > 0x8000) ? temp - 0x8000 : 0;
-                size_t sz1 = temp >> 16;                 // src z, sample #1
-                size_t sz2 = std::min(sz1 + 1, src.size().z - 1);// src z, sample #2
-                float szf = (temp & 0xFFFF) / 65536.f; // weight of sample #2
-
-                uint64_t sy_48 = (stepy >> 1) - 1;
-                for (size_t y = dst.minExtent.y; y < dst.maxExtent.y; y++, sy_48 += stepy) {
-                    temp = static_cast<unsigned int>(sy_48 >> 32);
-                    temp = (temp > 0x8000) ? temp - 0x8000 : 0;
-                    size_t sy1 = temp >> 16;                    // src y #1
-                    size_t sy2 = std::min(sy1 + 1, src.size().y - 1);// src y #2
-                    float syf = (temp & 0xFFFF) / 65536.f; // weight of #2
-
-                    uint64_t sx_48 = (stepx >> 1) - 1;
-                    for (size_t x = dst.minExtent.x; x < dst.maxExtent.x; x++, sx_48 += stepx) {
-                        temp = static_cast<unsigned int>(sx_48 >> 32);
-                        temp = (temp > 0x8000) ? temp - 0x8000 : 0;
-                        size_t sx1 = temp >> 16;                    // src x #1
-                        size_t sx2 = std::min(sx1 + 1, src.size().x - 1);// src x #2
-                        float sxf = (temp & 0xFFFF) / 65536.f; // weight of #2
-
-                        ColorValue x1y1z1, x2y1z1, x1y2z1, x2y2z1;
-                        ColorValue x1y1z2, x2y1z2, x1y2z2, x2y2z2;
-
-#define UNPACK(dst,x,y,z) PixelUtil::unpackColor(&dst, src.format, \
-    srcdata + srcelemsize*((x)+(y)*src.rowPitch+(z)*src.slicePitch))
-
-                        UNPACK(x1y1z1, sx1, sy1, sz1); UNPACK(x2y1z1, sx2, sy1, sz1);
-                        UNPACK(x1y2z1, sx1, sy2, sz1); UNPACK(x2y2z1, sx2, sy2, sz1);
-                        UNPACK(x1y1z2, sx1, sy1, sz2); UNPACK(x2y1z2, sx2, sy1, sz2);
-                        UNPACK(x1y2z2, sx1, sy2, sz2); UNPACK(x2y2z2, sx2, sy2, sz2);
-#undef UNPACK
-
-                        ColorValue accum =
-                            x1y1z1 * ((1.0f - sxf)*(1.0f - syf)*(1.0f - szf)) +
-                            x2y1z1 * (sxf *(1.0f - syf)*(1.0f - szf)) +
-                            x1y2z1 * ((1.0f - sxf)*        syf *(1.0f - szf)) +
-                            x2y2z1 * (sxf *        syf *(1.0f - szf)) +
-                            x1y1z2 * ((1.0f - sxf)*(1.0f - syf)*        szf) +
-                            x2y1z2 * (sxf *(1.0f - syf)*        szf) +
-                            x1y2z2 * ((1.0f - sxf)*        syf *        szf) +
-                            x2y2z2 * (sxf *        syf *        szf);
-
-                        PixelUtil::packColor(accum, dst.format, pdst);
+            std::vector<size_t> sx1(dstWidth), sx2(dstWidth);
+            std::vector<float> sxf(dstWidth);
+            uint64_t sx_48 = (stepx >> 1) - 1;
+            for (size_t x = 0; x < dstWidth; x++, sx_48 += stepx)
+                sample(sx_48, srcWidth, sx1[x], sx2[x], sxf[x]);
+
+            concurrency::parallel_for(size_t(0), dstHeight * dstDepth, [&](size_t row) {
+                const size_t y = row % dstHeight;
+                const size_t z = row / dstHeight;
+
+                size_t sy1, sy2, sz1, sz2;
+                float syf, szf;
+                sample((stepy >> 1) - 1 + stepy * y, src.size().y, sy1, sy2, syf);
+                sample((stepz >> 1) - 1 + stepz * z, src.size().z, sz1, sz2, szf);
+
+                // r, g, b and a spans of the source rows at (sy1, sz1), 
+                // (sy2, sz1), (sy1, sz2) and (sy2, sz2), then the output row
+                std::vector<float> spans((4 * 4 * srcWidth) + (4 * dstWidth));
+                const size_t sources[4][2] = { { sy1, sz1 }, { sy2, sz1 }, { sy1, sz2 }, { sy2, sz2 } };
+                const float* channels[4][4];
+                for (size_t k = 0; k < 4; k++) {
+                    float* span = &spans[k * 4 * srcWidth];
+                    PixelUtil::unpackRow(src.format, 
+                                         srcdata + srcelemsize*(sources[k][0]*src.rowPitch + sources[k][1]*src.slicePitch), 
+                                         srcWidth, span, span + srcWidth, span + 2*srcWidth, span + 3*srcWidth);
+                    for (size_t c = 0; c < 4; c++)
+                        channels[k][c] = span + c*srcWidth;
+                }
 
-                        pdst += dstelemsize;
+                float* out = &spans[4 * 4 * srcWidth];
+                for (size_t c = 0; c < 4; c++) {
+                    const float* y1z1 = channels[0][c];
+                    const float* y2z1 = channels[1][c];
+                    const float* y1z2 = channels[2][c];
+                    const float* y2z2 = channels[3][c];
+                    float* accum = out + c*dstWidth;
+                    for (size_t x = 0; x < dstWidth; x++) {
+                        const size_t x1 = sx1[x];
+                        const size_t x2 = sx2[x];
+                        const float f = sxf[x];
+                        accum[x] =
+                            y1z1[x1] * ((1.0f - f)*(1.0f - syf)*(1.0f - szf)) +
+                            y1z1[x2] * (f *(1.0f - syf)*(1.0f - szf)) +
+                            y2z1[x1] * ((1.0f - f)*        syf *(1.0f - szf)) +
+                            y2z1[x2] * (f *        syf *(1.0f - szf)) +
+                            y1z2[x1] * ((1.0f - f)*(1.0f - syf)*        szf) +
+                            y1z2[x2] * (f *(1.0f - syf)*        szf) +
+                            y2z2[x1] * ((1.0f - f)*        syf *        szf) +
+                            y2z2[x2] * (f *        syf *        szf);
                     }
-                    pdst += dstelemsize*dst.getRowSkip();
                 }
-                pdst += dstelemsize*dst.getSliceSkip();
-            }
+
+                PixelUtil::packRow(dst.format, out, out + dstWidth, out + 2*dstWidth, out + 3*dstWidth,
+                                   dstdata + dstelemsize*(y*dst.rowPitch + z*dst.slicePitch), dstWidth);
+            });
+        }
+
+      private:
+        // temp is 16/16 bit fixed precision, used to adjust a source
+        // coordinate (x, y, or z) backwards by half a pixel so that the
+        // integer bits represent the first sample (eg, sx1) and the
+        // fractional bits are the blend weight of the second sample
+        static void sample(uint64_t s_48, size_t size, size_t& s1, size_t& s2, float& sf) {
+            unsigned int temp = static_cast<unsigned int>(s_48 >> 32);
+            temp = (temp > 0x8000) ? temp - 0x8000 : 0;
+            s1 = temp >> 16;                        // src, sample #1
+            s2 = std::min(s1 + 1, size - 1);        // src, sample #2
+            sf = (temp & 0xFFFF) / 65536.f;         // weight of sample #2
         }
     };
 
@@ -382,6 +400,254 @@ namespace Ctr
             });
         }
     };
+    // filter kernels for SeparableResampler
+    enum ResampleKernel {
+        RESAMPLE_BOX,
+        RESAMPLE_TENT,
+        // Mitchell-Netravali cubic, B = C = 1/3
+        RESAMPLE_MITCHELL,
+        RESAMPLE_LANCZOS3,
+        // Kaiser windowed sinc, radius 3, alpha 4
+        RESAMPLE_KAISER
+    };
+
+    struct FilterKernel {
+        // radius of the kernel in source pixels when not minifying
+        static float support(ResampleKernel kernel) {
+            switch (kernel) {
+            case RESAMPLE_BOX: return 0.5f;
+            case RESAMPLE_TENT: return 1.0f;
+            case RESAMPLE_MITCHELL: return 2.0f;
+            default: return 3.0f;
+            }
+        }
+
+        static float evaluate(ResampleKernel kernel, float x) {
+            x = fabsf(x);
+            switch (kernel) {
+            case RESAMPLE_BOX:
+                return x <= 0.5f ? 1.0f : 0.0f;
+            case RESAMPLE_TENT:
+                return x < 1.0f ? 1.0f - x : 0.0f;
+            case RESAMPLE_MITCHELL: {
+                const float B = 1.0f / 3.0f;
+                const float C = 1.0f / 3.0f;
+                if (x < 1.0f)
+                    return ((12.0f - 9.0f*B - 6.0f*C)*x*x*x + 
+                            (-18.0f + 12.0f*B + 6.0f*C)*x*x + (6.0f - 2.0f*B)) / 6.0f;
+                if (x < 2.0f)
+                    return ((-B - 6.0f*C)*x*x*x + (6.0f*B + 30.0f*C)*x*x + 
+                            (-12.0f*B - 48.0f*C)*x + (8.0f*B + 24.0f*C)) / 6.0f;
+                return 0.0f;
+            }
+            case RESAMPLE_LANCZOS3:
+                return x < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+            case RESAMPLE_KAISER: {
+                if (x >= 3.0f)
+                    return 0.0f;
+                const float alpha = 4.0f;
+                const float t = x / 3.0f;
+                return sinc(x) * besselI0(alpha * sqrtf(1.0f - t*t)) / besselI0(alpha);
+            }
+            }
+            return 0.0f;
+        }
+
+        static float sinc(float x) {
+            if (x < 1e-5f)
+                return 1.0f;
+            const float pix = 3.14159265358979f * x;
+            return sinf(pix) / pix;
+        }
+
+        // modified bessel function of the first kind, order zero
+        static float besselI0(float x) {
+            float sum = 1.0f;
+            float term = 1.0f;
+            const float halfx = x * 0.5f;
+            for (int k = 1; k < 32 && term > sum * 1e-7f; k++) {
+                term *= (halfx / k) * (halfx / k);
+                sum += term;
+            }
+            return sum;
+        }
+    };
+
+    // per destination pixel filter taps along one axis. every destination 
+    // pixel has the same number of taps, source indices are clamped to the edge
+    struct FilterWeights {
+        size_t taps;
+        std::vector<size_t> indices;
+        std::vector<float> weights;
+
+        FilterWeights(ResampleKernel kernel, size_t srcSize, size_t dstSize) {
+            const float scale = float(dstSize) / float(srcSize);
+            // widen the kernel when minifying so that it covers every source pixel
+            const float filterScale = std::min(scale, 1.0f);
+            const float radius = FilterKernel::support(kernel) / filterScale;
+            taps = size_t(ceilf(radius * 2.0f)) + 1;
+            indices.resize(dstSize * taps);
+            weights.resize(dstSize * taps);
+
+            for (size_t i = 0; i < dstSize; i++) {
+                // center of the destination pixel in source pixels
+                const float center = (float(i) + 0.5f) / scale;
+                const int first = int(ceilf(center - radius - 0.5f));
+                float total = 0.0f;
+                for (size_t k = 0; k < taps; k++) {
+                    const int s = first + int(k);
+                    const float w = FilterKernel::evaluate(kernel, (float(s) + 0.5f - center) * filterScale);
+                    indices[i*taps + k] = size_t(std::min(std::max(s, 0), int(srcSize) - 1));
+                    weights[i*taps + k] = w;
+                    total += w;
+                }
+                if (total == 0.0f) {
+                    // no source pixel under the kernel (box magnification rounding),
+                    // fall back to the nearest one
+                    const size_t nearest = std::min(size_t(center), srcSize - 1);
+                    for (size_t k = 0; k < taps; k++) {
+                        indices[i*taps + k] = nearest;
+                        weights[i*taps + k] = k == 0 ? 1.0f : 0.0f;
+                    }
+                    total = 1.0f;
+                }
+                for (size_t k = 0; k < taps; k++)
+                    weights[i*taps + k] /= total;
+            }
+        }
+    };
+
+    // separable polyphase resampler, does format conversion. rows are 
+    // expanded to float32 RGBA, filtered horizontally, then vertically 
+    // (and across slices for volumes), with weights precomputed per 
+    // destination column, row and slice. output rows are processed in parallel.
+    struct SeparableResampler {
+        static void scale(const PixelBox& src, const PixelBox& dst, ResampleKernel kernel) {
+            const size_t srcWidth = src.size().x;
+            const size_t srcHeight = src.size().y;
+            const size_t srcDepth = src.size().z;
+            const size_t dstWidth = dst.size().x;
+            const size_t dstHeight = dst.size().y;
+            const size_t dstDepth = dst.size().z;
+
+            FilterWeights columns(kernel, srcWidth, dstWidth);
+            FilterWeights rows(kernel, srcHeight, dstHeight);
+
+            // horizontal pass, every source row into dstWidth x srcHeight x srcDepth
+            const size_t rowFloats = dstWidth * 4;
+            std::vector<float> horizontal(rowFloats * srcHeight * srcDepth);
+            concurrency::parallel_for(size_t(0), srcHeight * srcDepth, [&](size_t row) {
+                std::vector<float> expanded(srcWidth * 4);
+                loadRow(src, row % srcHeight, row / srcHeight, &expanded[0]);
+                filterRow(&expanded[0], columns, dstWidth, &horizontal[row * rowFloats]);
+            });
+
+            if (srcDepth == dstDepth) {
+                // vertical pass straight into dst
+                concurrency::parallel_for(size_t(0), dstHeight * dstDepth, [&](size_t row) {
+                    const size_t y = row % dstHeight;
+                    const size_t z = row / dstHeight;
+                    std::vector<float> filtered(rowFloats);
+                    filterSpans(&horizontal[z * srcHeight * rowFloats], rowFloats, 
+                                rows, y, rowFloats, &filtered[0]);
+                    storeRow(dst, y, z, &filtered[0]);
+                });
+                return;
+            }
+
+            // vertical pass, then across slices
+            FilterWeights slices(kernel, srcDepth, dstDepth);
+            const size_t sliceFloats = rowFloats * dstHeight;
+            std::vector<float> vertical(sliceFloats * srcDepth);
+            concurrency::parallel_for(size_t(0), dstHeight * srcDepth, [&](size_t row) {
+                const size_t y = row % dstHeight;
+                const size_t z = row / dstHeight;
+                filterSpans(&horizontal[z * srcHeight * rowFloats], rowFloats, 
+                            rows, y, rowFloats, &vertical[z * sliceFloats + y * rowFloats]);
+            });
+            concurrency::parallel_for(size_t(0), dstHeight * dstDepth, [&](size_t row) {
+                const size_t y = row % dstHeight;
+                const size_t z = row / dstHeight;
+                std::vector<float> filtered(rowFloats);
+                filterSpans(&vertical[y * rowFloats], sliceFloats, 
+                            slices, z, rowFloats, &filtered[0]);
+                storeRow(dst, y, z, &filtered[0]);
+            });
+        }
+
+      private:
+        static uint8_t* rowData(const PixelBox& box, size_t y, size_t z) {
+            return static_cast<uint8_t*>(box.data) + PixelUtil::getNumElemBytes(box.format) *
+                (box.minExtent.x + (box.minExtent.y + y) * box.rowPitch + (box.minExtent.z + z) * box.slicePitch);
+        }
+
+        static void loadRow(const PixelBox& src, size_t y, size_t z, float* row) {
+            if (src.format == PF_FLOAT32_RGBA) {
+                memcpy(row, rowData(src, y, z), src.size().x * 4 * sizeof(float));
+            }
+            else {
+                PixelUtil::bulkPixelConversion(rowData(src, y, z), src.format, row, PF_FLOAT32_RGBA, 
+                                               static_cast<unsigned int>(src.size().x));
+            }
+        }
+
+        static void storeRow(const PixelBox& dst, size_t y, size_t z, float* row) {
+            if (dst.format == PF_FLOAT32_RGBA) {
+                memcpy(rowData(dst, y, z), row, dst.size().x * 4 * sizeof(float));
+            }
+            else {
+                PixelUtil::bulkPixelConversion(row, PF_FLOAT32_RGBA, rowData(dst, y, z), dst.format, 
+                                               static_cast<unsigned int>(dst.size().x));
+            }
+        }
+
+        // filters one RGBA row along x
+        static void filterRow(const float* src, const FilterWeights& columns, size_t dstWidth, float* dst) {
+            const size_t taps = columns.taps;
+            for (size_t x = 0; x < dstWidth; x++) {
+                const size_t* indices = &columns.indices[x * taps];
+                const float* weights = &columns.weights[x * taps];
+#if CTR_SSE2
+                __m128 accum = _mm_setzero_ps();
+                for (size_t k = 0; k < taps; k++)
+                    accum = _mm_add_ps(accum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(src + indices[k]*4)));
+                _mm_storeu_ps(dst + x*4, accum);
+#else
+                float accum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (size_t k = 0; k < taps; k++) {
+                    const float* texel = src + indices[k]*4;
+                    accum[0] += weights[k] * texel[0]; accum[1] += weights[k] * texel[1];
+                    accum[2] += weights[k] * texel[2]; accum[3] += weights[k] * texel[3];
+                }
+                memcpy(dst + x*4, accum, sizeof(accum));
+#endif
+            }
+        }
+
+        // dst = weighted sum of the spans (each count floats, stride apart)
+        // selected by the taps of destination index i
+        static void filterSpans(const float* src, size_t stride, const FilterWeights& weights, 
+                                size_t i, size_t count, float* dst) {
+            const size_t taps = weights.taps;
+            const size_t* indices = &weights.indices[i * taps];
+            const float* w = &weights.weights[i * taps];
+            memset(dst, 0, count * sizeof(float));
+            for (size_t k = 0; k < taps; k++) {
+                if (w[k] == 0.0f)
+                    continue;
+                const float* span = src + indices[k] * stride;
+                size_t n = 0;
+#if CTR_SSE2
+                const __m128 weight = _mm_set1_ps(w[k]);
+                for (; n + 4 <= count; n += 4)
+                    _mm_storeu_ps(dst + n, _mm_add_ps(_mm_loadu_ps(dst + n), _mm_mul_ps(weight, _mm_loadu_ps(span + n))));
+#endif
+                for (; n < count; n++)
+                    dst[n] += w[k] * span[n];
+            }
+        }
+    };
+
     /** @} */
     /** @} */
 }
@@ -0,0 +1,478 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrImageStatistics.h>
+#include <ppl.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Ctr
+{
+namespace
+{
+// Mantissa bits of sqrt(2), splitting each stop into two histogram bins.
+const int32_t HalfStopMantissa = 0x3504F3;
+const float LuminanceWeights[3] = { 0.2126f, 0.7152f, 0.0722f };
+
+inline int32_t
+asInt(float value)
+{
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Histogram bin of a positive luminance from its exponent and mantissa.
+inline size_t
+luminanceBin(int32_t bits)
+{
+    const int32_t exponent = ((bits >> 23) & 0xFF) - 127 - ImageStatistics::HistogramMinExponent;
+    const int32_t bin = exponent * 2 + ((bits & 0x7FFFFF) >= HalfStopMantissa ? 1 : 0);
+    return size_t(std::min(std::max(bin, 0), int32_t(ImageStatistics::HistogramBins) - 1));
+}
+
+#if CTR_SSE2
+const int BitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+inline float
+horizontalMin(__m128 value)
+{
+    value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_min_ss(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
+
+inline float
+horizontalMax(__m128 value)
+{
+    value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_max_ss(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
+
+inline float
+horizontalSum(__m128 value)
+{
+    value = _mm_add_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_add_ss(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
+#endif
+
+//-----------------------------------------------------------------
+// Minimum, maximum, sum and non finite counts of one channel span.
+//-----------------------------------------------------------------
+void
+reduceChannel(const float* values, size_t count, ImageStatistics::Summary& summary, size_t channel)
+{
+    float minimum = summary.minimum[channel];
+    float maximum = summary.maximum[channel];
+    float sum = 0.0f;
+    size_t nans = 0;
+    size_t infs = 0;
+
+    size_t i = 0;
+#if CTR_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128 negativeInfinity = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    __m128 minimums = _mm_set1_ps(minimum);
+    __m128 maximums = _mm_set1_ps(maximum);
+    __m128 sums = zero;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 value = _mm_loadu_ps(values + i);
+        // value - value is 0 for finite values, NaN for infinities and NaNs.
+        const __m128 finite = _mm_cmpeq_ps(_mm_sub_ps(value, value), zero);
+        const int finiteMask = _mm_movemask_ps(finite);
+        if (finiteMask != 0xF)
+        {
+            const int nanMask = _mm_movemask_ps(_mm_cmpunord_ps(value, value));
+            nans += BitCount[nanMask];
+            infs += BitCount[~(finiteMask | nanMask) & 0xF];
+        }
+        minimums = _mm_min_ps(minimums, _mm_or_ps(_mm_and_ps(finite, value), _mm_andnot_ps(finite, infinity)));
+        maximums = _mm_max_ps(maximums, _mm_or_ps(_mm_and_ps(finite, value), _mm_andnot_ps(finite, negativeInfinity)));
+        sums = _mm_add_ps(sums, _mm_and_ps(finite, value));
+    }
+    minimum = horizontalMin(minimums);
+    maximum = horizontalMax(maximums);
+    sum = horizontalSum(sums);
+#endif
+    for (; i < count; ++i)
+    {
+        const float value = values[i];
+        if (value != value)
+        {
+            nans++;
+        }
+        else if (value - value != 0.0f)
+        {
+            infs++;
+        }
+        else
+        {
+            minimum = std::min(minimum, value);
+            maximum = std::max(maximum, value);
+            sum += value;
+        }
+    }
+
+    summary.minimum[channel] = minimum;
+    summary.maximum[channel] = maximum;
+    summary.sum[channel] += sum;
+    summary.nanCount[channel] += nans;
+    summary.infCount[channel] += infs;
+    summary.finiteCount[channel] += count - nans - infs;
+}
+
+//-----------------------------------------------------------------
+// Brightest texel and luminance histogram of one row.
+// lengths is scratch space for count floats.
+//-----------------------------------------------------------------
+void
+reduceColours(const float* r, const float* g, const float* b, size_t count, 
+              float* lengths, ImageStatistics::Summary& summary)
+{
+    const float brightest = summary.brightestLength * summary.brightestLength;
+    float rowBrightest = 0.0f;
+
+    size_t i = 0;
+#if CTR_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 weightR = _mm_set1_ps(LuminanceWeights[0]);
+    const __m128 weightG = _mm_set1_ps(LuminanceWeights[1]);
+    const __m128 weightB = _mm_set1_ps(LuminanceWeights[2]);
+    const __m128i exponentMask = _mm_set1_epi32(0xFF);
+    const __m128i mantissaMask = _mm_set1_epi32(0x7FFFFF);
+    const __m128i halfStop = _mm_set1_epi32(HalfStopMantissa - 1);
+    const __m128i exponentBias = _mm_set1_epi32(127 + ImageStatistics::HistogramMinExponent);
+    const __m128i lastBin = _mm_set1_epi32(ImageStatistics::HistogramBins - 1);
+    __m128 maximums = zero;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 red = _mm_loadu_ps(r + i);
+        const __m128 green = _mm_loadu_ps(g + i);
+        const __m128 blue = _mm_loadu_ps(b + i);
+        __m128 length = _mm_add_ps(_mm_add_ps(_mm_mul_ps(red, red), _mm_mul_ps(green, green)), 
+                                   _mm_mul_ps(blue, blue));
+        // Texels with non finite channels are not candidates.
+        length = _mm_and_ps(_mm_cmpeq_ps(_mm_sub_ps(length, length), zero), length);
+        maximums = _mm_max_ps(maximums, length);
+        _mm_storeu_ps(lengths + i, length);
+
+        const __m128 luminance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(red, weightR), _mm_mul_ps(green, weightG)), 
+                                            _mm_mul_ps(blue, weightB));
+        const __m128i bits = _mm_castps_si128(luminance);
+        __m128i bins = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), exponentMask), exponentBias);
+        bins = _mm_add_epi32(_mm_add_epi32(bins, bins), 
+                             _mm_srli_epi32(_mm_cmpgt_epi32(_mm_and_si128(bits, mantissaMask), halfStop), 31));
+        // Clamp to [0, last], then send non positive luminance to bin 0.
+        bins = _mm_and_si128(bins, _mm_cmpgt_epi32(bins, _mm_setzero_si128()));
+        const __m128i over = _mm_cmpgt_epi32(bins, lastBin);
+        bins = _mm_or_si128(_mm_andnot_si128(over, bins), _mm_and_si128(over, lastBin));
+        bins = _mm_and_si128(bins, _mm_castps_si128(_mm_cmpgt_ps(luminance, zero)));
+
+        int32_t indices[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), bins);
+        const int nanMask = _mm_movemask_ps(_mm_cmpunord_ps(luminance, luminance));
+        for (size_t t = 0; t < 4; ++t)
+        {
+            if (!(nanMask & (1 << t)))
+                summary.histogram[indices[t]]++;
+        }
+    }
+    rowBrightest = horizontalMax(maximums);
+#endif
+    for (; i < count; ++i)
+    {
+        float length = r[i] * r[i] + g[i] * g[i] + b[i] * b[i];
+        length = length - length == 0.0f ? length : 0.0f;
+        rowBrightest = std::max(rowBrightest, length);
+        lengths[i] = length;
+
+        const float luminance = r[i] * LuminanceWeights[0] + g[i] * LuminanceWeights[1] + 
+                                b[i] * LuminanceWeights[2];
+        if (luminance == luminance)
+            summary.histogram[ImageStatistics::Summary::histogramBin(luminance)]++;
+    }
+
+    if (rowBrightest > brightest)
+    {
+        const size_t texel = std::find(lengths, lengths + count, rowBrightest) - lengths;
+        summary.brightest[0] = r[texel];
+        summary.brightest[1] = g[texel];
+        summary.brightest[2] = b[texel];
+        summary.brightest[3] = 0.0f;
+        summary.brightestLength = std::sqrt(rowBrightest);
+    }
+}
+
+ImageStatistics::Summary
+reduceBox(const PixelBox& box)
+{
+    if (PixelUtil::isCompressed(box.format))
+        throw(std::exception("Cannot compute statistics of a compressed PixelBox - ImageStatistics::compute"));
+
+    ImageStatistics::Summary summary;
+    const size_t width = box.size().x;
+    const size_t elemSize = PixelUtil::getNumElemBytes(box.format);
+    if (width == 0)
+        return summary;
+
+    // r, g, b and a spans, then the length scratch span.
+    std::vector<float> spans(width * 5);
+    float* r = &spans[0];
+    float* g = r + width;
+    float* b = g + width;
+    float* a = b + width;
+    float* lengths = a + width;
+    for (size_t z = 0; z < box.size().z; ++z)
+    {
+        for (size_t y = 0; y < box.size().y; ++y)
+        {
+            const uint8_t* row = static_cast<const uint8_t*>(box.data) + elemSize *
+                (box.minExtent.x + (box.minExtent.y + y) * box.rowPitch + (box.minExtent.z + z) * box.slicePitch);
+            PixelUtil::unpackRow(box.format, row, width, r, g, b, a);
+            for (size_t channel = 0; channel < 4; ++channel)
+                reduceChannel(&spans[channel * width], width, summary, channel);
+            reduceColours(r, g, b, width, lengths, summary);
+            summary.count += width;
+        }
+    }
+    return summary;
+}
+
+inline size_t
+tileCount(size_t size, size_t tileSize)
+{
+    return std::max<size_t>((size + tileSize - 1) / tileSize, 1);
+}
+
+// Tile (tx, ty) of box, clamped to its extent.
+inline PixelBox
+tileBox(const PixelBox& box, size_t tx, size_t ty, size_t tileSize)
+{
+    const Vector3ui minExtent(box.minExtent.x + uint32_t(tx * tileSize), 
+                              box.minExtent.y + uint32_t(ty * tileSize), 
+                              box.minExtent.z);
+    const Vector3ui maxExtent(std::min(minExtent.x + uint32_t(tileSize), box.maxExtent.x),
+                              std::min(minExtent.y + uint32_t(tileSize), box.maxExtent.y),
+                              box.maxExtent.z);
+    return box.getSubVolume(Region3ui(minExtent, maxExtent));
+}
+}
+
+ImageStatistics::Summary::Summary() :
+    count(0),
+    brightestLength(0.0f)
+{
+    for (size_t channel = 0; channel < 4; ++channel)
+    {
+        finiteCount[channel] = 0;
+        nanCount[channel] = 0;
+        infCount[channel] = 0;
+        minimum[channel] = std::numeric_limits<float>::infinity();
+        maximum[channel] = -std::numeric_limits<float>::infinity();
+        sum[channel] = 0.0;
+        brightest[channel] = 0.0f;
+    }
+    memset(histogram, 0, sizeof(histogram));
+}
+
+void
+ImageStatistics::Summary::merge(const Summary& other)
+{
+    count += other.count;
+    for (size_t channel = 0; channel < 4; ++channel)
+    {
+        finiteCount[channel] += other.finiteCount[channel];
+        nanCount[channel] += other.nanCount[channel];
+        infCount[channel] += other.infCount[channel];
+        minimum[channel] = std::min(minimum[channel], other.minimum[channel]);
+        maximum[channel] = std::max(maximum[channel], other.maximum[channel]);
+        sum[channel] += other.sum[channel];
+    }
+    if (other.brightestLength > brightestLength)
+    {
+        memcpy(brightest, other.brightest, sizeof(brightest));
+        brightestLength = other.brightestLength;
+    }
+    for (size_t bin = 0; bin < HistogramBins; ++bin)
+        histogram[bin] += other.histogram[bin];
+}
+
+float
+ImageStatistics::Summary::mean(size_t channel) const
+{
+    return finiteCount[channel] ? float(sum[channel] / double(finiteCount[channel])) : 0.0f;
+}
+
+size_t
+ImageStatistics::Summary::histogramBin(float luminance)
+{
+    return luminance > 0.0f ? luminanceBin(asInt(luminance)) : 0;
+}
+
+ImageStatistics::Summary
+ImageStatistics::compute(const PixelBox& box)
+{
+    const size_t tilesX = tileCount(box.size().x, DefaultTileSize);
+    const size_t tilesY = tileCount(box.size().y, DefaultTileSize);
+    if (tilesX * tilesY == 1)
+        return reduceBox(box);
+
+    std::vector<Summary> tiles(tilesX * tilesY);
+    concurrency::parallel_for(size_t(0), tiles.size(), [&](size_t tile)
+    {
+        tiles[tile] = reduceBox(tileBox(box, tile % tilesX, tile / tilesX, DefaultTileSize));
+    });
+
+    // Merged in order so that the result does not depend on scheduling.
+    Summary summary;
+    for (auto it = tiles.begin(); it != tiles.end(); ++it)
+        summary.merge(*it);
+    return summary;
+}
+
+ImageStatistics::Summary
+ImageStatistics::compute(const TextureImage& image, size_t mip)
+{
+    Summary summary;
+    for (size_t face = 0; face < image.getNumFaces(); ++face)
+        summary.merge(compute(image.getPixelBox(face, mip).source()));
+    return summary;
+}
+
+ImageStatistics::ImageStatistics(size_t tileSize) :
+    _image(nullptr),
+    _tileSize(std::max<size_t>(tileSize, 1))
+{
+}
+
+ImageStatistics::~ImageStatistics()
+{
+}
+
+void
+ImageStatistics::evaluate(const TextureImage* image)
+{
+    _image = image;
+    _levels.clear();
+    if (!_image)
+        return;
+
+    const size_t mipCount = _image->getNumMipmaps() + 1;
+    _levels.resize(_image->getNumFaces() * mipCount);
+    for (size_t face = 0; face < _image->getNumFaces(); ++face)
+    {
+        for (size_t mip = 0; mip < mipCount; ++mip)
+        {
+            Level& level = _levels[face * mipCount + mip];
+            level.box = _image->getPixelBox(face, mip);
+            level.tilesX = tileCount(level.box.size().x, _tileSize);
+            level.tilesY = tileCount(level.box.size().y, _tileSize);
+            level.tiles.resize(level.tilesX * level.tilesY);
+            reduceTiles(level, Region3ui(level.box.minExtent, level.box.maxExtent));
+        }
+    }
+}
+
+void
+ImageStatistics::update(size_t face, size_t mip, const Region3ui& region)
+{
+    reduceTiles(_levels[levelIndex(face, mip)], region);
+}
+
+const ImageStatistics::Summary&
+ImageStatistics::summary(size_t face, size_t mip) const
+{
+    return _levels[levelIndex(face, mip)].total;
+}
+
+ImageStatistics::Summary
+ImageStatistics::summary(size_t mip) const
+{
+    Summary merged;
+    if (_image)
+    {
+        for (size_t face = 0; face < _image->getNumFaces(); ++face)
+            merged.merge(summary(face, mip));
+    }
+    return merged;
+}
+
+void
+ImageStatistics::reduceTiles(Level& level, const Region3ui& region)
+{
+    const PixelBox& box = level.box.source();
+    const size_t minX = std::max(region.minExtent.x, box.minExtent.x) - box.minExtent.x;
+    const size_t minY = std::max(region.minExtent.y, box.minExtent.y) - box.minExtent.y;
+    const size_t maxX = std::min(region.maxExtent.x, box.maxExtent.x) - box.minExtent.x;
+    const size_t maxY = std::min(region.maxExtent.y, box.maxExtent.y) - box.minExtent.y;
+    if (minX >= maxX || minY >= maxY)
+        return;
+
+    const size_t firstX = minX / _tileSize;
+    const size_t firstY = minY / _tileSize;
+    const size_t columns = (maxX + _tileSize - 1) / _tileSize - firstX;
+    const size_t rows = (maxY + _tileSize - 1) / _tileSize - firstY;
+    concurrency::parallel_for(size_t(0), columns * rows, [&](size_t tile)
+    {
+        const size_t tx = firstX + tile % columns;
+        const size_t ty = firstY + tile / columns;
+        level.tiles[ty * level.tilesX + tx] = reduceBox(tileBox(box, tx, ty, _tileSize));
+    });
+
+    level.total = Summary();
+    for (auto it = level.tiles.begin(); it != level.tiles.end(); ++it)
+        level.total.merge(*it);
+}
+
+size_t
+ImageStatistics::levelIndex(size_t face, size_t mip) const
+{
+    if (!_image || face >= _image->getNumFaces() || mip > _image->getNumMipmaps())
+        throw(std::exception("Face or mip out of range - ImageStatistics::levelIndex"));
+    return face * (_image->getNumMipmaps() + 1) + mip;
+}
+}
@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_IMAGE_STATISTICS
+#define INCLUDED_CRT_IMAGE_STATISTICS
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+#include <CtrTextureImage.h>
+#include <vector>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Per channel statistics of a PixelBox: minimum, maximum, sum and
+// mean of the finite values, counts of NaN and infinite values, 
+// the texel with the largest rgb length and a log2 luminance 
+// histogram. Rows are unpacked with PixelUtil::unpackRow and reduced
+// with SSE2, boxes are split into tiles that are reduced in parallel.
+//-----------------------------------------------------------------
+class ImageStatistics
+{
+  public:
+    enum
+    {
+        // Luminance histogram bins, two per stop from 2^-16 to 2^16.
+        HistogramBins = 64,
+        HistogramMinExponent = -16,
+        // Tile edge used to split boxes for parallel reduction.
+        DefaultTileSize = 64
+    };
+
+    struct Summary
+    {
+        Summary();
+
+        // Folds other into this summary.
+        void                   merge(const Summary& other);
+
+        float                  mean(size_t channel) const;
+        // Bin holding luminance value, non positive values go to bin 0.
+        static size_t          histogramBin(float luminance);
+
+        // Texels reduced.
+        size_t                 count;
+        // Finite values per channel, r, g, b, a.
+        size_t                 finiteCount[4];
+        size_t                 nanCount[4];
+        size_t                 infCount[4];
+        float                  minimum[4];
+        float                  maximum[4];
+        double                 sum[4];
+        // rgb of the texel with the largest rgb length (alpha is 0)
+        // and that length.
+        float                  brightest[4];
+        float                  brightestLength;
+        // Counts of Rec. 709 luminance per bin, see histogramBin.
+        uint32_t               histogram[HistogramBins];
+    };
+
+    // Reduces box, in parallel when it is larger than one tile.
+    static Summary             compute(const PixelBox& box);
+    // Merged summary of a mip level over every face.
+    static Summary             compute(const TextureImage& image, size_t mip = 0);
+
+    // Tracks the summaries of every face and mip of an image so that 
+    // they can be refreshed for just the region that changed.
+    ImageStatistics(size_t tileSize = DefaultTileSize);
+    ~ImageStatistics();
+
+    // Reduces every face and mip of image, which must stay alive 
+    // (and keep its layout) until the next evaluate.
+    void                       evaluate(const TextureImage* image);
+    // Re-reduces the tiles of face and mip overlapping region, 
+    // after the image has been written there.
+    void                       update(size_t face, size_t mip, const Region3ui& region);
+
+    const Summary&             summary(size_t face, size_t mip) const;
+    // Merged over every face of mip.
+    Summary                    summary(size_t mip) const;
+
+  protected:
+    struct Level
+    {
+        ConstPixelBox          box;
+        size_t                 tilesX;
+        size_t                 tilesY;
+        std::vector<Summary>   tiles;
+        Summary                total;
+    };
+
+    void                       reduceTiles(Level& level, const Region3ui& region);
+    size_t                     levelIndex(size_t face, size_t mip) const;
+
+    const TextureImage*        _image;
+    size_t                     _tileSize;
+    std::vector<Level>         _levels;
+};
+}
+
+#endif
@@ -0,0 +1,634 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrPixelConversionKernels.h>
+#include <CtrBitwise.h>
+#include <CtrLog.h>
+#include <ppl.h>
+#include <algorithm>
+#include <chrono>
+
+namespace Ctr
+{
+namespace
+{
+// Texels converted per run through the float scratch buffer.
+const size_t RunLength = 256;
+// Boxes smaller than this are converted on the calling thread.
+const size_t ParallelTexels = 16384;
+
+struct Unorm8
+{
+    typedef uint8_t Type;
+    enum { IsUnorm8 = 1, IsHalf = 0, IsFloat32 = 0 };
+
+    static inline float decode(Type value) { return Bitwise::fixedToFloat(value, 8); }
+    static inline Type  encode(float value) { return (Type)Bitwise::floatToFixed(value, 8); }
+};
+
+struct Unorm16
+{
+    typedef uint16_t Type;
+    enum { IsUnorm8 = 0, IsHalf = 0, IsFloat32 = 0 };
+
+    static inline float decode(Type value) { return Bitwise::fixedToFloat(value, 16); }
+    static inline Type  encode(float value) { return (Type)Bitwise::floatToFixed(value, 16); }
+};
+
+struct Half
+{
+    typedef uint16_t Type;
+    enum { IsUnorm8 = 0, IsHalf = 1, IsFloat32 = 0 };
+
+    static inline float decode(Type value) { return Bitwise::halfToFloat(value); }
+    static inline Type  encode(float value) { return Bitwise::floatToHalf(value); }
+};
+
+struct Float32
+{
+    typedef float Type;
+    enum { IsUnorm8 = 0, IsHalf = 0, IsFloat32 = 1 };
+
+    static inline float decode(Type value) { return value; }
+    static inline Type  encode(float value) { return value; }
+};
+
+//-----------------------------------------------------------------
+// Channels components of type Component per texel, R, G, B and A
+// give the component holding each channel (-1 if absent). 
+// Luminance formats map r, g and b to the same component.
+//-----------------------------------------------------------------
+template <typename Component, int Channels, int R, int G, int B, int A>
+struct Layout
+{
+    typedef typename Component::Type Type;
+
+    enum
+    {
+        // Component left unused by four channel formats without alpha.
+        Padding = (Channels == 4 && A < 0) ? 6 - R - G - B : -1,
+        Identity = Channels == 4 && R == 0 && G == 1 && B == 2 && A == 3,
+        ByteQuads = Component::IsUnorm8 && Channels == 4 && A >= 0,
+        // Channel stored in each component, for shuffling RGBA into place.
+        Slot0 = R == 0 ? 0 : G == 0 ? 1 : B == 0 ? 2 : 3,
+        Slot1 = R == 1 ? 0 : G == 1 ? 1 : B == 1 ? 2 : 3,
+        Slot2 = R == 2 ? 0 : G == 2 ? 1 : B == 2 ? 2 : 3,
+        Slot3 = R == 3 ? 0 : G == 3 ? 1 : B == 3 ? 2 : 3,
+    };
+
+    static void
+    unpack(const uint8_t* src, float* rgba, size_t count)
+    {
+        if (Component::IsFloat32 && Identity)
+        {
+            memcpy(rgba, src, count * 4 * sizeof(float));
+            return;
+        }
+        if (Component::IsHalf)
+        {
+            unpackHalfs(src, rgba, count);
+            return;
+        }
+
+        size_t i = 0;
+#if CTR_SSE2
+        if (ByteQuads)
+            i = unpackQuads(src, rgba, count);
+#endif
+        const Type* texel = reinterpret_cast<const Type*>(src) + i * Channels;
+        for (; i < count; ++i, texel += Channels)
+        {
+            float* colour = rgba + i * 4;
+            colour[0] = Component::decode(texel[R]);
+            colour[1] = Component::decode(texel[G]);
+            colour[2] = Component::decode(texel[B]);
+            colour[3] = A >= 0 ? Component::decode(texel[A >= 0 ? A : 0]) : 1.0f;
+        }
+    }
+
+    static void
+    pack(const float* rgba, uint8_t* dst, size_t count)
+    {
+        if (Component::IsFloat32 && Identity)
+        {
+            memcpy(dst, rgba, count * 4 * sizeof(float));
+            return;
+        }
+        if (Component::IsHalf)
+        {
+            packHalfs(rgba, dst, count);
+            return;
+        }
+
+        size_t i = 0;
+#if CTR_SSE2
+        if (ByteQuads)
+            i = packQuads(rgba, dst, count);
+#endif
+        Type* texel = reinterpret_cast<Type*>(dst) + i * Channels;
+        for (; i < count; ++i, texel += Channels)
+        {
+            const float* colour = rgba + i * 4;
+            // Red is written last so that it wins where channels share
+            // a component (luminance, GR), as PixelUtil::packColor does.
+            texel[B] = Component::encode(colour[2]);
+            texel[G] = Component::encode(colour[1]);
+            texel[R] = Component::encode(colour[0]);
+            if (A >= 0)
+                texel[A >= 0 ? A : 0] = Component::encode(colour[3]);
+            if (Padding >= 0)
+                texel[Padding >= 0 ? Padding : 0] = 0;
+        }
+    }
+
+    // Halfs are converted a run at a time with the Bitwise span 
+    // conversions and shuffled by the matching float layout.
+    static void
+    unpackHalfs(const uint8_t* src, float* rgba, size_t count)
+    {
+        const uint16_t* halfs = reinterpret_cast<const uint16_t*>(src);
+        if (Identity)
+        {
+            Bitwise::halfToFloat(halfs, rgba, count * 4);
+            return;
+        }
+
+        float values[RunLength * Channels];
+        for (size_t i = 0; i < count; i += RunLength)
+        {
+            const size_t run = std::min(RunLength, count - i);
+            Bitwise::halfToFloat(halfs + i * Channels, values, run * Channels);
+            Layout<Float32, Channels, R, G, B, A>::unpack(reinterpret_cast<const uint8_t*>(values), 
+                                                          rgba + i * 4, run);
+        }
+    }
+
+    static void
+    packHalfs(const float* rgba, uint8_t* dst, size_t count)
+    {
+        uint16_t* halfs = reinterpret_cast<uint16_t*>(dst);
+        if (Identity)
+        {
+            Bitwise::floatToHalf(rgba, halfs, count * 4);
+            return;
+        }
+
+        float values[RunLength * Channels];
+        for (size_t i = 0; i < count; i += RunLength)
+        {
+            const size_t run = std::min(RunLength, count - i);
+            Layout<Float32, Channels, R, G, B, A>::pack(rgba + i * 4, 
+                                                        reinterpret_cast<uint8_t*>(values), run);
+            Bitwise::floatToHalf(values, halfs + i * Channels, run * Channels);
+        }
+    }
+
+    // Structure of arrays variants, each channel goes to its own span.
+    static void
+    unpackPlanar(const uint8_t* src, float* r, float* g, float* b, float* a, size_t count)
+    {
+        if (Component::IsHalf)
+        {
+            float values[RunLength * Channels];
+            const uint16_t* halfs = reinterpret_cast<const uint16_t*>(src);
+            for (size_t i = 0; i < count; i += RunLength)
+            {
+                const size_t run = std::min(RunLength, count - i);
+                Bitwise::halfToFloat(halfs + i * Channels, values, run * Channels);
+                Layout<Float32, Channels, R, G, B, A>::unpackPlanar(reinterpret_cast<const uint8_t*>(values), 
+                                                                    r + i, g + i, b + i, a + i, run);
+            }
+            return;
+        }
+
+        size_t i = 0;
+#if CTR_SSE2
+        if (ByteQuads)
+            i = unpackPlanarQuads(src, r, g, b, a, count);
+#endif
+        const Type* texel = reinterpret_cast<const Type*>(src) + i * Channels;
+        for (; i < count; ++i, texel += Channels)
+        {
+            r[i] = Component::decode(texel[R]);
+            g[i] = Component::decode(texel[G]);
+            b[i] = Component::decode(texel[B]);
+            a[i] = A >= 0 ? Component::decode(texel[A >= 0 ? A : 0]) : 1.0f;
+        }
+    }
+
+    static void
+    packPlanar(const float* r, const float* g, const float* b, const float* a, uint8_t* dst, size_t count)
+    {
+        if (Component::IsHalf)
+        {
+            float values[RunLength * Channels];
+            uint16_t* halfs = reinterpret_cast<uint16_t*>(dst);
+            for (size_t i = 0; i < count; i += RunLength)
+            {
+                const size_t run = std::min(RunLength, count - i);
+                Layout<Float32, Channels, R, G, B, A>::packPlanar(r + i, g + i, b + i, a + i, 
+                                                                  reinterpret_cast<uint8_t*>(values), run);
+                Bitwise::floatToHalf(values, halfs + i * Channels, run * Channels);
+            }
+            return;
+        }
+
+        size_t i = 0;
+#if CTR_SSE2
+        if (ByteQuads)
+            i = packPlanarQuads(r, g, b, a, dst, count);
+#endif
+        Type* texel = reinterpret_cast<Type*>(dst) + i * Channels;
+        for (; i < count; ++i, texel += Channels)
+        {
+            texel[B] = Component::encode(b[i]);
+            texel[G] = Component::encode(g[i]);
+            texel[R] = Component::encode(r[i]);
+            if (A >= 0)
+                texel[A >= 0 ? A : 0] = Component::encode(a[i]);
+            if (Padding >= 0)
+                texel[Padding >= 0 ? Padding : 0] = 0;
+        }
+    }
+
+#if CTR_SSE2
+    // Four 8 bit texels at a time, returns the number converted.
+    static size_t
+    unpackQuads(const uint8_t* src, float* rgba, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 maxValue = _mm_set1_ps(255.0f);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            const __m128i texels[4] = { _mm_unpacklo_epi16(low, zero),
+                                        _mm_unpackhi_epi16(low, zero),
+                                        _mm_unpacklo_epi16(high, zero),
+                                        _mm_unpackhi_epi16(high, zero) };
+            for (size_t t = 0; t < 4; ++t)
+            {
+                // Divide rather than multiply by the reciprocal to match
+                // Bitwise::fixedToFloat exactly.
+                const __m128 colour = _mm_div_ps(_mm_cvtepi32_ps(texels[t]), maxValue);
+                _mm_storeu_ps(rgba + (i + t) * 4, 
+                              _mm_shuffle_ps(colour, colour, _MM_SHUFFLE(A & 3, B, G, R)));
+            }
+        }
+        return i;
+    }
+
+    static size_t
+    packQuads(const float* rgba, uint8_t* dst, size_t count)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 scale = _mm_set1_ps(256.0f);
+        const __m128 maxValue = _mm_set1_ps(255.0f);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i texels[4];
+            for (size_t t = 0; t < 4; ++t)
+            {
+                __m128 colour = _mm_loadu_ps(rgba + (i + t) * 4);
+                colour = _mm_shuffle_ps(colour, colour, _MM_SHUFFLE(Slot3, Slot2, Slot1, Slot0));
+                // Same rounding as Bitwise::floatToFixed, max also maps NaN to 0.
+                colour = _mm_min_ps(_mm_mul_ps(_mm_max_ps(colour, zero), scale), maxValue);
+                texels[t] = _mm_cvttps_epi32(colour);
+            }
+            const __m128i low = _mm_packs_epi32(texels[0], texels[1]);
+            const __m128i high = _mm_packs_epi32(texels[2], texels[3]);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(low, high));
+        }
+        return i;
+    }
+
+    // As unpackQuads, transposing the four texels into channel spans.
+    static size_t
+    unpackPlanarQuads(const uint8_t* src, float* r, float* g, float* b, float* a, size_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 maxValue = _mm_set1_ps(255.0f);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            __m128 components[4] = { _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)),
+                                     _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)),
+                                     _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)),
+                                     _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)) };
+            _MM_TRANSPOSE4_PS(components[0], components[1], components[2], components[3]);
+            _mm_storeu_ps(r + i, _mm_div_ps(components[R], maxValue));
+            _mm_storeu_ps(g + i, _mm_div_ps(components[G], maxValue));
+            _mm_storeu_ps(b + i, _mm_div_ps(components[B], maxValue));
+            _mm_storeu_ps(a + i, _mm_div_ps(components[A & 3], maxValue));
+        }
+        return i;
+    }
+
+    static size_t
+    packPlanarQuads(const float* r, const float* g, const float* b, const float* a, 
+                    uint8_t* dst, size_t count)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 scale = _mm_set1_ps(256.0f);
+        const __m128 maxValue = _mm_set1_ps(255.0f);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 components[4];
+            components[R] = _mm_loadu_ps(r + i);
+            components[G] = _mm_loadu_ps(g + i);
+            components[B] = _mm_loadu_ps(b + i);
+            components[A & 3] = _mm_loadu_ps(a + i);
+            _MM_TRANSPOSE4_PS(components[0], components[1], components[2], components[3]);
+
+            __m128i texels[4];
+            for (size_t t = 0; t < 4; ++t)
+            {
+                const __m128 colour = _mm_min_ps(_mm_mul_ps(_mm_max_ps(components[t], zero), scale), maxValue);
+                texels[t] = _mm_cvttps_epi32(colour);
+            }
+            const __m128i low = _mm_packs_epi32(texels[0], texels[1]);
+            const __m128i high = _mm_packs_epi32(texels[2], texels[3]);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(low, high));
+        }
+        return i;
+    }
+#endif
+};
+
+//                             format           component channels r  g  b   a
+#define CTR_PIXEL_CONVERSION_LAYOUTS(LAYOUT)                                  \
+    LAYOUT(PF_L8,              Unorm8,   1,       0, 0, 0, -1)              \
+    LAYOUT(PF_L16,             Unorm16,  1,       0, 0, 0, -1)              \
+    LAYOUT(PF_BYTE_LA,         Unorm8,   2,       0, 0, 0,  1)              \
+    LAYOUT(PF_R8G8B8,          Unorm8,   3,       2, 1, 0, -1)              \
+    LAYOUT(PF_B8G8R8,          Unorm8,   3,       0, 1, 2, -1)              \
+    LAYOUT(PF_A8R8G8B8,        Unorm8,   4,       2, 1, 0,  3)              \
+    LAYOUT(PF_A8B8G8R8,        Unorm8,   4,       0, 1, 2,  3)              \
+    LAYOUT(PF_B8G8R8A8,        Unorm8,   4,       1, 2, 3,  0)              \
+    LAYOUT(PF_R8G8B8A8,        Unorm8,   4,       3, 2, 1,  0)              \
+    LAYOUT(PF_X8R8G8B8,        Unorm8,   4,       2, 1, 0, -1)              \
+    LAYOUT(PF_X8B8G8R8,        Unorm8,   4,       0, 1, 2, -1)              \
+    LAYOUT(PF_SHORT_RGB,       Unorm16,  3,       0, 1, 2, -1)              \
+    LAYOUT(PF_SHORT_RGBA,      Unorm16,  4,       0, 1, 2,  3)              \
+    LAYOUT(PF_FLOAT16_R,       Half,     1,       0, 0, 0, -1)              \
+    LAYOUT(PF_FLOAT16_GR,      Half,     2,       1, 0, 1, -1)              \
+    LAYOUT(PF_FLOAT16_RGB,     Half,     3,       0, 1, 2, -1)              \
+    LAYOUT(PF_FLOAT16_RGBA,    Half,     4,       0, 1, 2,  3)              \
+    LAYOUT(PF_FLOAT32_R,       Float32,  1,       0, 0, 0, -1)              \
+    LAYOUT(PF_FLOAT32_GR,      Float32,  2,       1, 0, 1, -1)              \
+    LAYOUT(PF_FLOAT32_RGB,     Float32,  3,       0, 1, 2, -1)              \
+    LAYOUT(PF_FLOAT32_RGBA,    Float32,  4,       0, 1, 2,  3)
+
+inline uint8_t*
+rowData(const PixelBox& box, size_t y, size_t z)
+{
+    return static_cast<uint8_t*>(box.data) + 
+        (box.minExtent.x + (box.minExtent.y + y) * box.rowPitch + 
+         (box.minExtent.z + z) * box.slicePitch) * PixelUtil::getNumElemBytes(box.format);
+}
+}
+
+PixelConversionKernels::UnpackRow
+PixelConversionKernels::unpackKernel(PixelFormat format)
+{
+    switch (format)
+    {
+#define CTR_UNPACK_KERNEL(fmt, component, channels, r, g, b, a) \
+        case fmt: return &Layout<component, channels, r, g, b, a>::unpack;
+        CTR_PIXEL_CONVERSION_LAYOUTS(CTR_UNPACK_KERNEL)
+#undef CTR_UNPACK_KERNEL
+        default:
+            return nullptr;
+    }
+}
+
+PixelConversionKernels::PackRow
+PixelConversionKernels::packKernel(PixelFormat format)
+{
+    switch (format)
+    {
+#define CTR_PACK_KERNEL(fmt, component, channels, r, g, b, a) \
+        case fmt: return &Layout<component, channels, r, g, b, a>::pack;
+        CTR_PIXEL_CONVERSION_LAYOUTS(CTR_PACK_KERNEL)
+#undef CTR_PACK_KERNEL
+        default:
+            return nullptr;
+    }
+}
+
+PixelConversionKernels::UnpackPlanarRow
+PixelConversionKernels::unpackPlanarKernel(PixelFormat format)
+{
+    switch (format)
+    {
+#define CTR_UNPACK_PLANAR_KERNEL(fmt, component, channels, r, g, b, a) \
+        case fmt: return &Layout<component, channels, r, g, b, a>::unpackPlanar;
+        CTR_PIXEL_CONVERSION_LAYOUTS(CTR_UNPACK_PLANAR_KERNEL)
+#undef CTR_UNPACK_PLANAR_KERNEL
+        default:
+            return nullptr;
+    }
+}
+
+PixelConversionKernels::PackPlanarRow
+PixelConversionKernels::packPlanarKernel(PixelFormat format)
+{
+    switch (format)
+    {
+#define CTR_PACK_PLANAR_KERNEL(fmt, component, channels, r, g, b, a) \
+        case fmt: return &Layout<component, channels, r, g, b, a>::packPlanar;
+        CTR_PIXEL_CONVERSION_LAYOUTS(CTR_PACK_PLANAR_KERNEL)
+#undef CTR_PACK_PLANAR_KERNEL
+        default:
+            return nullptr;
+    }
+}
+
+bool
+PixelConversionKernels::canConvert(PixelFormat srcFormat, PixelFormat dstFormat)
+{
+    return unpackKernel(srcFormat) && packKernel(dstFormat);
+}
+
+bool
+PixelConversionKernels::convert(const PixelBox& src, const PixelBox& dst)
+{
+    const UnpackRow unpack = unpackKernel(src.format);
+    const PackRow pack = packKernel(dst.format);
+    if (!unpack || !pack)
+        return false;
+
+    const size_t srcPixelSize = PixelUtil::getNumElemBytes(src.format);
+    const size_t dstPixelSize = PixelUtil::getNumElemBytes(dst.format);
+    const size_t width = src.size().x;
+    const size_t height = src.size().y;
+    const size_t rows = height * src.size().z;
+
+    auto convertRow = [&](size_t row)
+    {
+        const size_t y = row % height;
+        const size_t z = row / height;
+        const uint8_t* srcRow = rowData(src, y, z);
+        uint8_t* dstRow = rowData(dst, y, z);
+
+        // Float RGBA rows can be used as the scratch buffer directly.
+        if (src.format == PF_FLOAT32_RGBA)
+        {
+            pack(reinterpret_cast<const float*>(srcRow), dstRow, width);
+        }
+        else if (dst.format == PF_FLOAT32_RGBA)
+        {
+            unpack(srcRow, reinterpret_cast<float*>(dstRow), width);
+        }
+        else
+        {
+            float colours[RunLength * 4];
+            for (size_t x = 0; x < width; x += RunLength)
+            {
+                const size_t count = std::min(RunLength, width - x);
+                unpack(srcRow + x * srcPixelSize, colours, count);
+                pack(colours, dstRow + x * dstPixelSize, count);
+            }
+        }
+    };
+
+    if (rows > 1 && width * rows >= ParallelTexels)
+    {
+        concurrency::parallel_for(size_t(0), rows, convertRow);
+    }
+    else
+    {
+        for (size_t row = 0; row < rows; ++row)
+            convertRow(row);
+    }
+    return true;
+}
+
+std::vector<PixelConversionKernels::BenchmarkResult>
+PixelConversionKernels::benchmark(size_t width, size_t height, size_t iterations)
+{
+    std::vector<PixelFormat> formats;
+    for (int format = PF_UNKNOWN + 1; format < PF_COUNT; ++format)
+    {
+        if (PixelUtil::isAccessible(PixelFormat(format)) &&
+            PixelUtil::getNumElemBytes(PixelFormat(format)) > 0)
+        {
+            formats.push_back(PixelFormat(format));
+        }
+    }
+
+    // Sources are filled with a gradient so that float formats hold
+    // normal values rather than whatever the bytes happen to decode to.
+    std::vector<float> gradient(width * height * 4);
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            float* colour = &gradient[(y * width + x) * 4];
+            colour[0] = float(x) / float(width);
+            colour[1] = float(y) / float(height);
+            colour[2] = float((x + y) & 255) / 255.0f;
+            colour[3] = 1.0f - colour[0];
+        }
+    }
+    const PixelBox gradientBox(width, height, 1, PF_FLOAT32_RGBA, &gradient[0]);
+
+    std::vector<BenchmarkResult> results;
+    std::vector<uint8_t> srcData;
+    std::vector<uint8_t> dstData;
+    for (auto srcFormat : formats)
+    {
+        srcData.resize(PixelUtil::getMemorySize(width, height, 1, srcFormat));
+        const PixelBox srcBox(width, height, 1, srcFormat, &srcData[0]);
+        try
+        {
+            PixelUtil::bulkPixelConversion(gradientBox, srcBox);
+        }
+        catch (const std::exception&)
+        {
+            LOG("Skipping " << PixelUtil::getFormatName(srcFormat) << 
+                ", cannot convert to it - PixelConversionKernels::benchmark");
+            continue;
+        }
+
+        for (auto dstFormat : formats)
+        {
+            dstData.resize(PixelUtil::getMemorySize(width, height, 1, dstFormat));
+            const PixelBox dstBox(width, height, 1, dstFormat, &dstData[0]);
+
+            BenchmarkResult result;
+            result.srcFormat = srcFormat;
+            result.dstFormat = dstFormat;
+            try
+            {
+                const auto start = std::chrono::high_resolution_clock::now();
+                for (size_t iteration = 0; iteration < iterations; ++iteration)
+                    PixelUtil::bulkPixelConversion(srcBox, dstBox);
+                const std::chrono::duration<double> seconds = 
+                    std::chrono::high_resolution_clock::now() - start;
+                result.megaPixelsPerSecond = 
+                    double(width * height * iterations) / (std::max(seconds.count(), 1e-9) * 1e6);
+            }
+            catch (const std::exception&)
+            {
+                continue;
+            }
+
+            LOG(PixelUtil::getFormatName(srcFormat) << " -> " << 
+                PixelUtil::getFormatName(dstFormat) << ": " << 
+                result.megaPixelsPerSecond << " MPixels/s");
+            results.push_back(result);
+        }
+    }
+    return results;
+}
+}
@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_PIXEL_CONVERSION_KERNELS
+#define INCLUDED_CRT_PIXEL_CONVERSION_KERNELS
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+#include <vector>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Table of row conversion kernels for the 8 and 16 bit unorm, half
+// and float formats with one to four channels, in any channel order.
+// A conversion unpacks runs of texels to float RGBA and packs them
+// into the destination, giving the same results as 
+// PixelUtil::unpackColor / packColor. Rows are converted in parallel.
+//-----------------------------------------------------------------
+class PixelConversionKernels
+{
+  public:
+    typedef void (*UnpackRow)(const uint8_t* src, float* rgba, size_t count);
+    typedef void (*PackRow)(const float* rgba, uint8_t* dst, size_t count);
+    // Structure of arrays kernels, one float span per channel.
+    typedef void (*UnpackPlanarRow)(const uint8_t* src, float* r, float* g, 
+                                    float* b, float* a, size_t count);
+    typedef void (*PackPlanarRow)(const float* r, const float* g, const float* b, 
+                                  const float* a, uint8_t* dst, size_t count);
+
+    // Kernels for format, null if the format has no kernel.
+    static UnpackRow           unpackKernel(PixelFormat format);
+    static PackRow             packKernel(PixelFormat format);
+    static UnpackPlanarRow     unpackPlanarKernel(PixelFormat format);
+    static PackPlanarRow       packPlanarKernel(PixelFormat format);
+
+    static bool                canConvert(PixelFormat srcFormat, 
+                                          PixelFormat dstFormat);
+
+    // Converts src into dst, which must have the same size.
+    // Returns false without touching dst if either format has no kernel.
+    static bool                convert(const PixelBox& src, 
+                                       const PixelBox& dst);
+
+    struct BenchmarkResult
+    {
+        PixelFormat            srcFormat;
+        PixelFormat            dstFormat;
+        // Millions of texels per second through bulkPixelConversion.
+        double                 megaPixelsPerSecond;
+    };
+
+    // Times PixelUtil::bulkPixelConversion between every pair of accessible
+    // formats on a width x height image, logging the throughput of each pair.
+    static std::vector<BenchmarkResult> 
+                               benchmark(size_t width = 1024, 
+                                         size_t height = 1024, 
+                                         size_t iterations = 4);
+};
+}
+
+#endif
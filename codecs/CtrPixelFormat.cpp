@@ -69,6 +69,9 @@ THE SOFTWARE.
 #include <CtrColorValue.h>
 #include <CtrBitwise.h>
 #include <CtrStringUtilities.h>
+#include <CtrBlockCompressor.h>
+#include <CtrBlockDecompressor.h>
+#include <CtrPixelConversionKernels.h>
 
 namespace 
 {
@@ -728,6 +731,58 @@ namespace Ctr
         /* Masks and shifts */
         0, 0, 0, 0, 0, 0, 0, 0
         },
+    //-----------------------------------------------------------------------
+        {"PF_BC4",
+        /* Bytes per element */
+        0,
+        /* Flags */
+        PFF_COMPRESSED,
+        /* Component type and count */
+        PCT_BYTE, 1,
+        /* rbits, gbits, bbits, abits */
+        0, 0, 0, 0,
+        /* Masks and shifts */
+        0, 0, 0, 0, 0, 0, 0, 0
+        },
+    //-----------------------------------------------------------------------
+        {"PF_BC5",
+        /* Bytes per element */
+        0,
+        /* Flags */
+        PFF_COMPRESSED,
+        /* Component type and count */
+        PCT_BYTE, 2,
+        /* rbits, gbits, bbits, abits */
+        0, 0, 0, 0,
+        /* Masks and shifts */
+        0, 0, 0, 0, 0, 0, 0, 0
+        },
+    //-----------------------------------------------------------------------
+        {"PF_BC7",
+        /* Bytes per element */
+        0,
+        /* Flags */
+        PFF_COMPRESSED | PFF_HASALPHA,
+        /* Component type and count */
+        PCT_BYTE, 4,
+        /* rbits, gbits, bbits, abits */
+        0, 0, 0, 0,
+        /* Masks and shifts */
+        0, 0, 0, 0, 0, 0, 0, 0
+        },
+    //-----------------------------------------------------------------------
+        {"PF_BC6H",
+        /* Bytes per element */
+        0,
+        /* Flags */
+        PFF_COMPRESSED | PFF_FLOAT,
+        /* Component type and count */
+        PCT_FLOAT16, 3,
+        /* rbits, gbits, bbits, abits */
+        0, 0, 0, 0,
+        /* Masks and shifts */
+        0, 0, 0, 0, 0, 0, 0, 0
+        },
     };
     //-----------------------------------------------------------------------
     size_t PixelBox::getConsecutiveSize() const
@@ -797,11 +852,15 @@ namespace Ctr
                 // DXT formats work by dividing the image into 4x4 blocks, then encoding each
                 // 4x4 block with a certain number of bytes. 
                 case PF_DXT1:
+                case PF_BC4:
                     return ((width+3)/4)*((height+3)/4)*8 * depth;
                 case PF_DXT2:
                 case PF_DXT3:
                 case PF_DXT4:
                 case PF_DXT5:
+                case PF_BC5:
+                case PF_BC7:
+                case PF_BC6H:
                     return ((width+3)/4)*((height+3)/4)*16 * depth;
 
                 // Size calculations from the PVRTC OpenGL extension spec
@@ -876,6 +935,10 @@ namespace Ctr
                 case PF_DXT3:
                 case PF_DXT4:
                 case PF_DXT5:
+                case PF_BC4:
+                case PF_BC5:
+                case PF_BC7:
+                case PF_BC6H:
                     return ((width&3)==0 && (height&3)==0 && depth==1);
                 default:
                     return true;
@@ -1303,6 +1366,40 @@ namespace Ctr
         }
     }
     //-----------------------------------------------------------------------
+    void PixelUtil::unpackRow(PixelFormat pf, const void* src, size_t count, 
+        float *r, float *g, float *b, float *a)
+    {
+        if(PixelConversionKernels::UnpackPlanarRow unpack = PixelConversionKernels::unpackPlanarKernel(pf))
+        {
+            unpack(static_cast<const uint8_t*>(src), r, g, b, a, count);
+            return;
+        }
+
+        const size_t pixelSize = getNumElemBytes(pf);
+        const uint8_t* srcptr = static_cast<const uint8_t*>(src);
+        for(size_t i = 0; i < count; i++, srcptr += pixelSize)
+        {
+            unpackColor(r + i, g + i, b + i, a + i, pf, srcptr);
+        }
+    }
+
+    void PixelUtil::packRow(PixelFormat pf, const float *r, const float *g, const float *b, 
+        const float *a, void* dest, size_t count)
+    {
+        if(PixelConversionKernels::PackPlanarRow pack = PixelConversionKernels::packPlanarKernel(pf))
+        {
+            pack(r, g, b, a, static_cast<uint8_t*>(dest), count);
+            return;
+        }
+
+        const size_t pixelSize = getNumElemBytes(pf);
+        uint8_t* dstptr = static_cast<uint8_t*>(dest);
+        for(size_t i = 0; i < count; i++, dstptr += pixelSize)
+        {
+            packColor(r[i], g[i], b[i], a[i], pf, dstptr);
+        }
+    }
+    //-----------------------------------------------------------------------
     /* Convert pixels from one format to another */
     void PixelUtil::bulkPixelConversion(void *srcp, PixelFormat srcFormat,
         void *destp, PixelFormat dstFormat, unsigned int count)
@@ -1319,7 +1416,8 @@ namespace Ctr
                src.size().y == dst.size().y &&
                src.size().z == dst.size().z);
 
-        // Check for compressed formats, we don't support decompression, compression or recoding
+        // Check for compressed formats, we support BC1-BC5 and BC7 compression and decompression,
+        // BC6H compression only, but no recoding
         if(PixelUtil::isCompressed(src.format) || PixelUtil::isCompressed(dst.format))
         {
             if(src.format == dst.format)
@@ -1327,6 +1425,16 @@ namespace Ctr
                 memcpy(dst.data, src.data, src.getConsecutiveSize());
                 return;
             }
+            else if (!PixelUtil::isCompressed(dst.format) && BlockDecompressor::canDecompress(src.format))
+            {
+                BlockDecompressor::decompress(src, dst);
+                return;
+            }
+            else if (!PixelUtil::isCompressed(src.format) && BlockCompressor::canCompress(dst.format))
+            {
+                BlockCompressor::compress(src, dst);
+                return;
+            }
             else
             {
                 throw(std::exception("This method can not be used to compress or decompress images PixelUtil::bulkPixelConversion"));
@@ -1405,6 +1513,11 @@ namespace Ctr
             return;
         }
 #endif
+        // Table driven row kernels for the remaining unorm, half and float formats
+        if(PixelConversionKernels::convert(src, dst))
+        {
+            return;
+        }
 
         const size_t srcPixelSize = PixelUtil::getNumElemBytes(src.format);
         const size_t dstPixelSize = PixelUtil::getNumElemBytes(dst.format);
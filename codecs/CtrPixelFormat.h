@@ -186,8 +186,16 @@ namespace Ctr
         PF_DEPTH32 = 45,
         // Depth 24 Stencil 8
         PF_DEPTH24S8 = 46,
+        /// BC4 (ATI1) block compressed format, one channel
+        PF_BC4 = 47,
+        /// BC5 (ATI2) block compressed format, two channels
+        PF_BC5 = 48,
+        /// BC7 block compressed format, RGBA
+        PF_BC7 = 49,
+        /// BC6H block compressed format, unsigned half float RGB
+        PF_BC6H = 50,
         // Number of pixel formats currently defined
-        PF_COUNT = 47,
+        PF_COUNT = 51,
     };
     typedef std::vector<PixelFormat> PixelFormatList;
 
@@ -378,8 +386,44 @@ namespace Ctr
          */
         void setColorAt(ColorValue const &cv, size_t x, size_t y, size_t z);
     };
-    
 
+    /** Read only view of pixel data, as returned by TextureImage::getPixelBox.
+        @remarks
+            The PixelBox is inherited privately, so the view does not convert to a 
+            PixelBox and its pixels cannot be written through it. source() passes 
+            it explicitly to the PixelBox conversion and scaling routines, which 
+            only read their source.
+    */
+    class ConstPixelBox: private PixelBox {
+    public:
+        ConstPixelBox() : data(nullptr) {}
+        explicit ConstPixelBox(const PixelBox& box) : PixelBox(box), data(box.data) {}
+        ~ConstPixelBox() {}
+
+        using PixelBox::minExtent;
+        using PixelBox::maxExtent;
+        using PixelBox::size;
+        using PixelBox::format;
+        using PixelBox::rowPitch;
+        using PixelBox::slicePitch;
+        using PixelBox::getNumChannels;
+        using PixelBox::getRowSkip;
+        using PixelBox::getSliceSkip;
+        using PixelBox::isConsecutive;
+        using PixelBox::getConsecutiveSize;
+
+        /// The view as the source of a PixelBox routine, which must not write to it
+        const PixelBox& source() const { return *this; }
+
+        ConstPixelBox getSubVolume(const Region3ui &def) const
+        {
+            return ConstPixelBox(PixelBox::getSubVolume(def));
+        }
+
+        /// The read only data pointer
+        const void *data;
+    };
+    
     /**
      * Some utility functions for packing and unpacking pixel data
      */
@@ -559,6 +603,25 @@ namespace Ctr
             @param src        Source memory location
         */
         static void unpackColor(float *r, float *g, float *b, float *a, PixelFormat pf,  const void* src);
+
+        /** Unpack consecutive pixels into one float array per channel
+            @param pf         Pixelformat of the source pixels
+            @param src        Source memory location
+            @param count      Number of pixels to unpack
+            @param r,g,b,a    Destination arrays of count floats each
+            @remarks Gives the same values as unpackColor, using a kernel
+            specialised for the format where one exists.
+        */
+        static void unpackRow(PixelFormat pf, const void* src, size_t count, 
+                              float *r, float *g, float *b, float *a);
+        /** Pack one float array per channel into consecutive pixels
+            @param pf         Pixelformat of the destination pixels
+            @param r,g,b,a    Source arrays of count floats each
+            @param dest       Destination memory location
+            @param count      Number of pixels to pack
+        */
+        static void packRow(PixelFormat pf, const float *r, const float *g, const float *b, 
+                            const float *a, void* dest, size_t count);
         
         /** Convert consecutive pixels from one format to another. No dithering or filtering is being done. 
              Converting from RGB to luminance takes the R channel.  In case the source and destination format match,
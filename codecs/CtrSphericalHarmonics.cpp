@@ -0,0 +1,365 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrSphericalHarmonics.h>
+#include <CtrCubemapConversion.h>
+#include <ppl.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Ctr
+{
+namespace
+{
+const float Pi = 3.14159265358979323f;
+
+const float Y0 = 0.282094792f;  // 1 / 2 sqrt(1 / pi)
+const float Y1 = 0.488602512f;  // sqrt(3 / 4 pi)
+const float Y2 = 1.092548431f;  // sqrt(15 / 4 pi)
+const float Y3 = 0.315391565f;  // sqrt(5 / 16 pi)
+const float Y4 = 0.546274215f;  // sqrt(15 / 16 pi)
+
+// Cosine lobe convolution per band, divided by pi.
+const float IrradianceBand[SphericalHarmonics::NumCoefficients] = 
+{ 
+    1.0f, 
+    2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f 
+};
+
+float
+dot(const float* a, const float* b, size_t count)
+{
+    size_t i = 0;
+    float sum = 0.0f;
+#if CTR_SSE2
+    __m128 sums = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+        sums = _mm_add_ps(sums, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    float lanes[4];
+    _mm_storeu_ps(lanes, sums);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+}
+
+SphericalHarmonics::SphericalHarmonics()
+{
+    for (size_t index = 0; index < NumCoefficients; ++index)
+        _coefficients[index] = Vector4f(0, 0, 0, 0);
+}
+
+void
+SphericalHarmonics::basis(const float* x, const float* y, const float* z, size_t count,
+                          float* basis)
+{
+    float* b0 = basis;
+    float* b1 = b0 + count;
+    float* b2 = b1 + count;
+    float* b3 = b2 + count;
+    float* b4 = b3 + count;
+    float* b5 = b4 + count;
+    float* b6 = b5 + count;
+    float* b7 = b6 + count;
+    float* b8 = b7 + count;
+
+    size_t i = 0;
+#if CTR_SSE2
+    const __m128 y0 = _mm_set1_ps(Y0);
+    const __m128 y1 = _mm_set1_ps(Y1);
+    const __m128 y2 = _mm_set1_ps(Y2);
+    const __m128 y3 = _mm_set1_ps(Y3);
+    const __m128 y4 = _mm_set1_ps(Y4);
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 dx = _mm_loadu_ps(x + i);
+        const __m128 dy = _mm_loadu_ps(y + i);
+        const __m128 dz = _mm_loadu_ps(z + i);
+        _mm_storeu_ps(b0 + i, y0);
+        _mm_storeu_ps(b1 + i, _mm_mul_ps(y1, dy));
+        _mm_storeu_ps(b2 + i, _mm_mul_ps(y1, dz));
+        _mm_storeu_ps(b3 + i, _mm_mul_ps(y1, dx));
+        _mm_storeu_ps(b4 + i, _mm_mul_ps(y2, _mm_mul_ps(dx, dy)));
+        _mm_storeu_ps(b5 + i, _mm_mul_ps(y2, _mm_mul_ps(dy, dz)));
+        _mm_storeu_ps(b6 + i, _mm_mul_ps(y3, _mm_sub_ps(_mm_mul_ps(three, _mm_mul_ps(dz, dz)), one)));
+        _mm_storeu_ps(b7 + i, _mm_mul_ps(y2, _mm_mul_ps(dx, dz)));
+        _mm_storeu_ps(b8 + i, _mm_mul_ps(y4, _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        b0[i] = Y0;
+        b1[i] = Y1 * y[i];
+        b2[i] = Y1 * z[i];
+        b3[i] = Y1 * x[i];
+        b4[i] = Y2 * x[i] * y[i];
+        b5[i] = Y2 * y[i] * z[i];
+        b6[i] = Y3 * (3.0f * z[i] * z[i] - 1.0f);
+        b7[i] = Y2 * x[i] * z[i];
+        b8[i] = Y4 * (x[i] * x[i] - y[i] * y[i]);
+    }
+}
+
+SphericalHarmonics
+SphericalHarmonics::project(const TextureImage& cubemap, size_t mip)
+{
+    if (!cubemap.hasFlag(IF_CUBEMAP) || cubemap.getNumFaces() != 6)
+        throw(std::exception("Source is not a cube map - SphericalHarmonics::project"));
+    if (PixelUtil::isCompressed(cubemap.getFormat()))
+        throw(std::exception("Compressed sources are not supported - SphericalHarmonics::project"));
+
+    ConstPixelBox faces[6];
+    for (size_t face = 0; face < 6; ++face)
+        faces[face] = cubemap.getPixelBox(face, mip);
+
+    const size_t size = faces[0].size().x;
+    const size_t elemSize = PixelUtil::getNumElemBytes(cubemap.getFormat());
+    const float texelArea = 4.0f / float(size * size);
+
+    // Per row sums of each coefficient (rgb) followed by the row's solid angle.
+    const size_t rowStride = NumCoefficients * 3 + 1;
+    std::vector<double> rowSums(6 * size * rowStride, 0.0);
+
+    concurrency::parallel_for(size_t(0), 6 * size, [&](size_t row)
+    {
+        const size_t face = row / size;
+        const size_t y = row % size;
+        const ConstPixelBox& box = faces[face];
+
+        // r, g, b, a, u, x, y, z, weight and the 9 basis spans.
+        std::vector<float> spans(size * (9 + NumCoefficients));
+        float* r = &spans[0];
+        float* g = r + size;
+        float* b = g + size;
+        float* a = b + size;
+        float* us = a + size;
+        float* dx = us + size;
+        float* dy = dx + size;
+        float* dz = dy + size;
+        float* weights = dz + size;
+        float* basisValues = weights + size;
+
+        const float v = (float(y) + 0.5f) * 2.0f / float(size) - 1.0f;
+        for (size_t x = 0; x < size; ++x)
+        {
+            us[x] = (float(x) + 0.5f) * 2.0f / float(size) - 1.0f;
+            // Solid angle of the texel, dA / (1 + u^2 + v^2)^3/2.
+            const float distance2 = 1.0f + us[x] * us[x] + v * v;
+            weights[x] = texelArea / (distance2 * std::sqrt(distance2));
+        }
+        CubemapConversion::faceDirections(face, v, us, size, dx, dy, dz);
+        basis(dx, dy, dz, size, basisValues);
+
+        const uint8_t* texels = static_cast<const uint8_t*>(box.data) + 
+            elemSize * (box.minExtent.x + (box.minExtent.y + y) * box.rowPitch);
+        PixelUtil::unpackRow(box.format, texels, size, r, g, b, a);
+        for (size_t x = 0; x < size; ++x)
+        {
+            r[x] *= weights[x];
+            g[x] *= weights[x];
+            b[x] *= weights[x];
+        }
+
+        double* sums = &rowSums[row * rowStride];
+        for (size_t index = 0; index < NumCoefficients; ++index)
+        {
+            const float* function = basisValues + index * size;
+            sums[index * 3 + 0] = dot(function, r, size);
+            sums[index * 3 + 1] = dot(function, g, size);
+            sums[index * 3 + 2] = dot(function, b, size);
+        }
+        float solidAngle = 0.0f;
+        for (size_t x = 0; x < size; ++x)
+            solidAngle += weights[x];
+        sums[NumCoefficients * 3] = solidAngle;
+    });
+
+    // Summed in order so that the result does not depend on scheduling.
+    double totals[NumCoefficients * 3 + 1] = { 0 };
+    for (size_t row = 0; row < 6 * size; ++row)
+    {
+        for (size_t index = 0; index < rowStride; ++index)
+            totals[index] += rowSums[row * rowStride + index];
+    }
+
+    // The texel solid angles only approximate the sphere, normalize to 4 pi.
+    SphericalHarmonics sh;
+    const double normalization = totals[NumCoefficients * 3] > 0.0 ? 
+        4.0 * double(Pi) / totals[NumCoefficients * 3] : 0.0;
+    for (size_t index = 0; index < NumCoefficients; ++index)
+    {
+        sh._coefficients[index] = Vector4f(float(totals[index * 3 + 0] * normalization),
+                                           float(totals[index * 3 + 1] * normalization),
+                                           float(totals[index * 3 + 2] * normalization),
+                                           0.0f);
+    }
+    return sh;
+}
+
+SphericalHarmonics
+SphericalHarmonics::irradiance() const
+{
+    SphericalHarmonics sh;
+    for (size_t index = 0; index < NumCoefficients; ++index)
+    {
+        const Vector4f& c = _coefficients[index];
+        const float band = IrradianceBand[index];
+        sh._coefficients[index] = Vector4f(c.x * band, c.y * band, c.z * band, 0.0f);
+    }
+    return sh;
+}
+
+void
+SphericalHarmonics::evaluate(const float* x, const float* y, const float* z, size_t count,
+                             float* r, float* g, float* b) const
+{
+    std::vector<float> basisValues(count * NumCoefficients);
+    basis(x, y, z, count, &basisValues[0]);
+
+    std::fill(r, r + count, 0.0f);
+    std::fill(g, g + count, 0.0f);
+    std::fill(b, b + count, 0.0f);
+    for (size_t index = 0; index < NumCoefficients; ++index)
+    {
+        const float* function = &basisValues[index * count];
+        const Vector4f& c = _coefficients[index];
+        size_t i = 0;
+#if CTR_SSE2
+        const __m128 cr = _mm_set1_ps(c.x);
+        const __m128 cg = _mm_set1_ps(c.y);
+        const __m128 cb = _mm_set1_ps(c.z);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 f = _mm_loadu_ps(function + i);
+            _mm_storeu_ps(r + i, _mm_add_ps(_mm_loadu_ps(r + i), _mm_mul_ps(f, cr)));
+            _mm_storeu_ps(g + i, _mm_add_ps(_mm_loadu_ps(g + i), _mm_mul_ps(f, cg)));
+            _mm_storeu_ps(b + i, _mm_add_ps(_mm_loadu_ps(b + i), _mm_mul_ps(f, cb)));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            r[i] += function[i] * c.x;
+            g[i] += function[i] * c.y;
+            b[i] += function[i] * c.z;
+        }
+    }
+}
+
+Vector3f
+SphericalHarmonics::evaluate(const Vector3f& direction) const
+{
+    float r, g, b;
+    evaluate(&direction.x, &direction.y, &direction.z, 1, &r, &g, &b);
+    return Vector3f(r, g, b);
+}
+
+TextureImagePtr
+SphericalHarmonics::reconstruct(size_t faceSize, PixelFormat format) const
+{
+    faceSize = std::max<size_t>(faceSize, 1);
+
+    TextureImagePtr cubemap(new TextureImage());
+    cubemap->create(Vector2i(int32_t(faceSize), int32_t(faceSize)), format, 0, IF_CUBEMAP);
+
+    PixelBox faces[6];
+    for (size_t face = 0; face < 6; ++face)
+        faces[face] = cubemap->getWritablePixelBox(face, 0);
+
+    const size_t elemSize = PixelUtil::getNumElemBytes(format);
+    concurrency::parallel_for(size_t(0), 6 * faceSize, [&](size_t row)
+    {
+        const size_t face = row / faceSize;
+        const size_t y = row % faceSize;
+
+        std::vector<float> spans(faceSize * 8);
+        float* r = &spans[0];
+        float* g = r + faceSize;
+        float* b = g + faceSize;
+        float* a = b + faceSize;
+        float* us = a + faceSize;
+        float* dx = us + faceSize;
+        float* dy = dx + faceSize;
+        float* dz = dy + faceSize;
+
+        const float v = (float(y) + 0.5f) * 2.0f / float(faceSize) - 1.0f;
+        for (size_t x = 0; x < faceSize; ++x)
+            us[x] = (float(x) + 0.5f) * 2.0f / float(faceSize) - 1.0f;
+        CubemapConversion::faceDirections(face, v, us, faceSize, dx, dy, dz);
+        evaluate(dx, dy, dz, faceSize, r, g, b);
+        for (size_t x = 0; x < faceSize; ++x)
+        {
+            r[x] = std::max(r[x], 0.0f);
+            g[x] = std::max(g[x], 0.0f);
+            b[x] = std::max(b[x], 0.0f);
+            a[x] = 1.0f;
+        }
+
+        const PixelBox& box = faces[face];
+        PixelUtil::packRow(format, r, g, b, a, 
+                           static_cast<uint8_t*>(box.data) + elemSize * y * box.rowPitch, faceSize);
+    });
+    return cubemap;
+}
+
+const Vector4f&
+SphericalHarmonics::coefficient(size_t index) const
+{
+    return _coefficients[index];
+}
+
+void
+SphericalHarmonics::setCoefficient(size_t index, const Vector4f& value)
+{
+    _coefficients[index] = value;
+}
+
+const float*
+SphericalHarmonics::data() const
+{
+    return &_coefficients[0].x;
+}
+}
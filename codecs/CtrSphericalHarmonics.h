@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_SPHERICAL_HARMONICS
+#define INCLUDED_CRT_SPHERICAL_HARMONICS
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+#include <CtrTextureImage.h>
+#include <CtrVector3.h>
+#include <CtrVector4.h>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// L2 (9 coefficient) RGB spherical harmonics.
+// Cube maps are projected in one parallel pass over the face rows, 
+// each texel weighted by its solid angle, with the basis evaluated 
+// four texels at a time with SSE2.
+// Coefficients are stored as float4 (rgb, 0) so that they can be
+// uploaded to a shader constant array as they are.
+//-----------------------------------------------------------------
+class SphericalHarmonics
+{
+  public:
+    enum
+    {
+        NumCoefficients = 9
+    };
+
+    SphericalHarmonics();
+
+    // Radiance coefficients of mip of a cube map (IF_CUBEMAP).
+    static SphericalHarmonics  project(const TextureImage& cubemap, size_t mip = 0);
+
+    // Cosine convolved coefficients, irradiance / pi, the same quantity
+    // as CubemapPrefilter::irradiance stores.
+    SphericalHarmonics         irradiance() const;
+
+    // Evaluates count unit directions into r, g and b.
+    void                       evaluate(const float* x, const float* y, const float* z, size_t count,
+                                        float* r, float* g, float* b) const;
+    Vector3f                   evaluate(const Vector3f& direction) const;
+
+    // Cube map of faceSize evaluated from the coefficients, negative 
+    // ringing is clamped to 0.
+    TextureImagePtr            reconstruct(size_t faceSize, 
+                                           PixelFormat format = PF_FLOAT32_RGBA) const;
+
+    // The 9 basis functions for count unit directions, 
+    // basis[i * count + j] is function i at direction j.
+    static void                basis(const float* x, const float* y, const float* z, size_t count,
+                                     float* basis);
+
+    const Vector4f&            coefficient(size_t index) const;
+    void                       setCoefficient(size_t index, const Vector4f& value);
+
+    // NumCoefficients float4s.
+    const float*               data() const;
+
+  protected:
+    Vector4f                   _coefficients[NumCoefficients];
+};
+}
+
+#endif
@@ -73,6 +73,10 @@ THE SOFTWARE.
 #include <CtrAssetManager.h>
 #include <CtrLog.h>
 #include <CtrImageResampler.h>
+#include <CtrImageBufferPool.h>
+#include <CtrGamma.h>
+#include <ppl.h>
+#include <algorithm>
 
 namespace Ctr
 {
@@ -110,19 +114,24 @@ TextureImage::TextureImage()
     mNumMipmaps(0),
     mFlags(0),
     mFormat(PF_UNKNOWN),
-    mBuffer( nullptr ),
-    mAutoDelete( true )
+    mPixelSize(0),
+    mBuffer( nullptr )
 {
 }
 
 TextureImage::TextureImage( const TextureImage &img )
-    : mBuffer( nullptr ),
-    mAutoDelete( true )
+    : mBuffer( nullptr )
 {
     // call assignment operator
     *this = img;
 }
 
+TextureImage::TextureImage( TextureImage &&img )
+    : mBuffer( nullptr )
+{
+    *this = std::move(img);
+}
+
 TextureImage::~TextureImage()
 {
     freeMemory();
@@ -130,18 +139,19 @@ TextureImage::~TextureImage()
 
 void TextureImage::freeMemory()
 {
-    //Only delete if this was not a dynamic image (meaning app holds & destroys buffer)
-    if( mBuffer && mAutoDelete )
-    {
-        free(mBuffer);
-        mBuffer = nullptr;
-    }
-
+    // Owned pixels are freed with the last image sharing them. Dynamic images
+    // do not own their buffer (the app holds & destroys it) and borrowed ones
+    // release their reference to the storage.
+    mPixels.reset();
+    mStorage.reset();
+    mBuffer = nullptr;
 }
 
 TextureImage & TextureImage::operator = ( const TextureImage &img )
 {
-    freeMemory();
+    if (this == &img)
+        return *this;
+
     mWidth = img.mWidth;
     mHeight = img.mHeight;
     mDepth = img.mDepth;
@@ -150,107 +160,140 @@ TextureImage & TextureImage::operator = ( const TextureImage &img )
     mFlags = img.mFlags;
     mPixelSize = img.mPixelSize;
     mNumMipmaps = img.mNumMipmaps;
-    mAutoDelete = img.mAutoDelete;
-    //Only create/copy when previous data was not dynamic data
-    if( mAutoDelete )
-    {
-        mBuffer = (uint8_t*)malloc(mBufSize * sizeof(uint8_t));
-        memcpy( mBuffer, img.mBuffer, mBufSize );
-    }
-    else
-    {
-        mBuffer = img.mBuffer;
-    }
+    // Share the pixels, they are copied when either image writes to them.
+    mPixels = img.mPixels;
+    mStorage = img.mStorage;
+    mBuffer = img.mBuffer;
 
     return *this;
 }
 
-TextureImage & TextureImage::flipAroundY()
+TextureImage & TextureImage::operator = ( TextureImage &&img )
 {
-    if( !mBuffer )
-    {
-        throw(std::exception("Can not flip an unitialized texture TextureImage::flipAroundY"));
-    }
-    
-     mNumMipmaps = 0; // TextureImage operations lose precomputed mipmaps
+    if (this == &img)
+        return *this;
 
-    uint8_t    *pTempBuffer1 = nullptr;
-    uint16_t    *pTempBuffer2 = nullptr;
-    uint8_t    *pTempBuffer3 = nullptr;
-    uint32_t    *pTempBuffer4 = nullptr;
+    mWidth = img.mWidth;
+    mHeight = img.mHeight;
+    mDepth = img.mDepth;
+    mFormat = img.mFormat;
+    mBufSize = img.mBufSize;
+    mFlags = img.mFlags;
+    mPixelSize = img.mPixelSize;
+    mNumMipmaps = img.mNumMipmaps;
+    mPixels = std::move(img.mPixels);
+    mStorage = std::move(img.mStorage);
+    mBuffer = img.mBuffer;
+
+    // Leave img empty.
+    img.freeMemory();
+    img.mWidth = img.mHeight = img.mDepth = 0;
+    img.mBufSize = 0;
+    img.mNumMipmaps = 0;
+    img.mFlags = 0;
+    img.mFormat = PF_UNKNOWN;
+    img.mPixelSize = 0;
 
-    uint8_t    *src1 = mBuffer, *dst1 = nullptr;
-    uint16_t    *src2 = (uint16_t *)mBuffer, *dst2 = nullptr;
-    uint8_t    *src3 = mBuffer, *dst3 = nullptr;
-    uint32_t *src4 = (uint32_t *)mBuffer, *dst4 = nullptr;
+    return *this;
+}
 
-    uint16_t y;
-    switch (mPixelSize)
-    {
-    case 1:
-        pTempBuffer1 = (uint8_t*)malloc(mWidth * mHeight * sizeof(uint8_t));
-        for (y = 0; y < mHeight; y++)
-        {
-            dst1 = (pTempBuffer1 + ((y * mWidth) + mWidth - 1));
-            for (uint16_t x = 0; x < mWidth; x++)
-                memcpy(dst1--, src1++, sizeof(uint8_t));
-        }
+bool TextureImage::isShared() const
+{
+    return (mPixels && mPixels.use_count() > 1) || 
+           (mStorage && mStorage.use_count() > 1);
+}
 
-        memcpy(mBuffer, pTempBuffer1, mWidth * mHeight * sizeof(uint8_t));
-        free(pTempBuffer1);
-        break;
+void TextureImage::allocate(size_t size)
+{
+    mStorage.reset();
+    mPixels = ImageBufferPool::allocateShared(size);
+    mBuffer = mPixels.get();
+}
 
-    case 2:
-        pTempBuffer2 = (uint16_t*)malloc(sizeof(uint16_t) * mWidth * mHeight);
-        for (y = 0; y < mHeight; y++)
-        {
-            dst2 = (pTempBuffer2 + ((y * mWidth) + mWidth - 1));
-            for (uint16_t x = 0; x < mWidth; x++)
-                memcpy(dst2--, src2++, sizeof(uint16_t));
-        }
+void TextureImage::unshare()
+{
+    if (!isShared())
+        return;
 
-        memcpy(mBuffer, pTempBuffer2, mWidth * mHeight * sizeof(uint16_t));
-        free(pTempBuffer2);
-        break;
+    // Hold the shared pixels while copying them.
+    std::shared_ptr<uint8_t> source = mPixels;
+    SharedDataStreamPtr storage = mStorage;
+    const uint8_t* pixels = mBuffer;
+    allocate(mBufSize);
+    memcpy(mBuffer, pixels, mBufSize);
+}
 
-    case 3:
-        pTempBuffer3 = (uint8_t*)malloc(mWidth * mHeight * 3 * sizeof(uint8_t));
-        for (y = 0; y < mHeight; y++)
-        {
-            size_t offset = ((y * mWidth) + (mWidth - 1)) * 3;
-            dst3 = pTempBuffer3;
-            dst3 += offset;
-            for (size_t x = 0; x < mWidth; x++)
+namespace
+{
+template <size_t Bytes>
+struct Texel
+{
+    uint8_t bytes[Bytes];
+};
+
+// Reverses the order of the texels in a row.
+void
+mirrorRow(uint8_t* row, size_t width, size_t pixelSize)
+{
+    switch (pixelSize)
+    {
+        case 1: std::reverse(row, row + width); break;
+#define CTR_MIRROR_TEXELS(bytes) \
+        case bytes: std::reverse(reinterpret_cast<Texel<bytes>*>(row), \
+                                 reinterpret_cast<Texel<bytes>*>(row) + width); break;
+        CTR_MIRROR_TEXELS(2)
+        CTR_MIRROR_TEXELS(3)
+        CTR_MIRROR_TEXELS(4)
+        CTR_MIRROR_TEXELS(6)
+        CTR_MIRROR_TEXELS(8)
+        CTR_MIRROR_TEXELS(12)
+        CTR_MIRROR_TEXELS(16)
+#undef CTR_MIRROR_TEXELS
+        default:
+            for (size_t x = 0; x < width / 2; ++x)
             {
-                memcpy(dst3, src3, sizeof(uint8_t) * 3);
-                dst3 -= 3; src3 += 3;
+                uint8_t* left = row + x * pixelSize;
+                std::swap_ranges(left, left + pixelSize, row + (width - 1 - x) * pixelSize);
             }
-        }
+            break;
+    }
+}
 
-        memcpy(mBuffer, pTempBuffer3, mWidth * mHeight * sizeof(uint8_t) * 3);
-        free(pTempBuffer3);
-        break;
+uint8_t*
+rowData(const PixelBox& box, size_t y, size_t z)
+{
+    return static_cast<uint8_t*>(box.data) + 
+        (box.minExtent.x + (box.minExtent.y + y) * box.rowPitch + 
+         (box.minExtent.z + z) * box.slicePitch) * PixelUtil::getNumElemBytes(box.format);
+}
+}
 
-    case 4:
-        pTempBuffer4 = (uint32_t*)malloc(sizeof(uint32_t) *  mWidth * mHeight);
-        for (y = 0; y < mHeight; y++)
+TextureImage & TextureImage::flipAroundY()
+{
+    if( !mBuffer )
+    {
+        throw(std::exception("Can not flip an unitialized texture TextureImage::flipAroundY"));
+    }
+    if (PixelUtil::isCompressed(mFormat))
+    {
+        throw(std::exception("Can not flip a compressed texture TextureImage::flipAroundY"));
+    }
+
+    // Mirror every row of every face and mip level in place.
+    for (size_t face = 0; face < getNumFaces(); ++face)
+    {
+        for (size_t mip = 0; mip <= mNumMipmaps; ++mip)
         {
-            dst4 = (pTempBuffer4 + ((y * mWidth) + mWidth - 1));
-            for (uint16_t x = 0; x < mWidth; x++)
-                memcpy(dst4--, src4++, sizeof(uint32_t));
+            const PixelBox box = getWritablePixelBox(face, mip);
+            const size_t height = box.size().y;
+            concurrency::parallel_for(size_t(0), height * box.size().z, [&](size_t row)
+            {
+                mirrorRow(rowData(box, row % height, row / height), box.size().x, mPixelSize);
+            });
         }
-
-        memcpy(mBuffer, pTempBuffer4, mWidth * mHeight * sizeof(uint32_t));
-        free(pTempBuffer4);
-        break;
-
-    default:
-        throw( std::exception("Unknown pixel depth TextureImage::flipAroundY" ));
-        break;
     }
 
     return *this;
-
 }
 
 TextureImage & TextureImage::flipAroundX()
@@ -259,23 +302,29 @@ TextureImage & TextureImage::flipAroundX()
     {
         throw(std::exception( "Can not flip an unitialized texture TextureImage::flipAroundX" ));
     }
-    
-    mNumMipmaps = 0; // TextureImage operations lose precomputed mipmaps
-
-    size_t rowSpan = mWidth * mPixelSize;
-
-    uint8_t *pTempBuffer = (uint8_t*)malloc(rowSpan * mHeight * sizeof(uint8_t));
-    uint8_t *ptr1 = mBuffer, *ptr2 = pTempBuffer + ( ( mHeight - 1 ) * rowSpan );
-
-    for( uint16_t i = 0; i < mHeight; i++ )
+    if (PixelUtil::isCompressed(mFormat))
     {
-        memcpy( ptr2, ptr1, rowSpan );
-        ptr1 += rowSpan; ptr2 -= rowSpan;
+        throw(std::exception("Can not flip a compressed texture TextureImage::flipAroundX"));
     }
 
-    memcpy( mBuffer, pTempBuffer, rowSpan * mHeight);
-
-    free(pTempBuffer);
+    // Swap rows top to bottom in every slice of every face and mip level in place.
+    for (size_t face = 0; face < getNumFaces(); ++face)
+    {
+        for (size_t mip = 0; mip <= mNumMipmaps; ++mip)
+        {
+            const PixelBox box = getWritablePixelBox(face, mip);
+            const size_t height = box.size().y;
+            const size_t rowSpan = box.size().x * mPixelSize;
+            const size_t swaps = height / 2;
+            concurrency::parallel_for(size_t(0), swaps * box.size().z, [&](size_t pair)
+            {
+                const size_t y = pair % swaps;
+                const size_t z = pair / swaps;
+                uint8_t* top = rowData(box, y, z);
+                std::swap_ranges(top, top + rowSpan, rowData(box, height - 1 - y, z));
+            });
+        }
+    }
 
     return *this;
 }
@@ -307,13 +356,33 @@ TextureImage& TextureImage::loadDynamicTextureImage(uint8_t* pData, size_t uWidt
         throw(std::exception("Number of faces currently must be 6 or 1. TextureImage::loadDynamicTextureImage"));
 
     mBufSize = calculateSize(numMipMaps, numFaces, uWidth, uHeight, depth, eFormat);
+    if (autoDelete)
+        mPixels.reset(pData, free);
     mBuffer = pData;
-    mAutoDelete = autoDelete;
 
     return *this;
 
 }
 
+TextureImage& TextureImage::loadBorrowedTextureImage(uint8_t* pData, const SharedDataStreamPtr& storage,
+                                                     size_t uWidth, size_t uHeight, size_t depth,
+                                                     PixelFormat eFormat,
+                                                     size_t numFaces, size_t numMipMaps)
+{
+    if (!storage)
+    {
+        throw(std::exception("Borrowed image requires storage TextureImage::loadBorrowedTextureImage"));
+    }
+
+    // Hold the storage before releasing any previous contents, in case the
+    // image is being reloaded from the same stream.
+    SharedDataStreamPtr holdStorage = storage;
+    loadDynamicTextureImage(pData, uWidth, uHeight, depth, eFormat, false, numFaces, numMipMaps);
+    mStorage = holdStorage;
+
+    return *this;
+}
+
 TextureImage & TextureImage::loadRawData(
     DataStreamPtr& stream, 
     size_t uWidth, size_t uHeight, size_t uDepth,
@@ -326,12 +395,13 @@ TextureImage & TextureImage::loadRawData(
         throw(std::exception("Stream size does not match calculated image size TextureImage::loadRawData"));
     }
 
-    uint8_t *buffer = (uint8_t*)malloc(sizeof(uint8_t) * size);
-    stream->read(buffer, size);
-
-    return loadDynamicTextureImage(buffer,
+    loadDynamicTextureImage(nullptr,
         uWidth, uHeight, uDepth,
-        eFormat, true, numFaces, numMipMaps);
+        eFormat, false, numFaces, numMipMaps);
+    allocate(size);
+    stream->read(mBuffer, size);
+
+    return *this;
 
 }
 
@@ -382,7 +452,7 @@ TextureImage::valid() const
     return mWidth > 0 || mHeight > 0;
 }
 
-void TextureImage::save(const std::string& filename)
+void TextureImage::save(const std::string& filename) const
 {
     if( !mBuffer )
     {
@@ -418,7 +488,7 @@ void TextureImage::save(const std::string& filename)
     pCodec->codeToFile(wrapper, filename, codeDataPtr);
 }
 
-DataStreamPtr TextureImage::encode(const std::string& formatextension)
+DataStreamPtr TextureImage::encode(const std::string& formatextension) const
 {
     if( !mBuffer )
     {
@@ -434,6 +504,9 @@ DataStreamPtr TextureImage::encode(const std::string& formatextension)
     imgData->height = mHeight;
     imgData->width = mWidth;
     imgData->depth = mDepth;
+    imgData->size = mBufSize;
+    imgData->num_images = mFlags&IF_CUBEMAP?6:1;
+    imgData->num_mipmaps = (uint16_t)(mNumMipmaps);
     // Wrap in CodecDataPtr, this will delete
     Codec::CodecDataPtr codeDataPtr(imgData);
     // Wrap memory, be sure not to delete when stream destroyed
@@ -442,6 +515,90 @@ DataStreamPtr TextureImage::encode(const std::string& formatextension)
     return pCodec->code(wrapper, codeDataPtr);
 }
 
+TextureImage & TextureImage::compress(PixelFormat format, BlockCompressor::Quality quality)
+{
+    if( !mBuffer )
+    {
+        throw(std::exception("No image data loaded - TextureImage::compress"));
+    }
+    if (PixelUtil::isCompressed(mFormat))
+    {
+        throw(std::exception("Image is already compressed - TextureImage::compress"));
+    }
+    if (!BlockCompressor::canCompress(format))
+    {
+        throw(std::exception("Unsupported block compressed format - TextureImage::compress"));
+    }
+
+    convertLevels(format, [quality](const PixelBox& src, const PixelBox& dst)
+    {
+        BlockCompressor::compress(src, dst, quality);
+    });
+    return *this;
+}
+
+TextureImage & TextureImage::packHDR(HDRPacking::Mode mode, float range)
+{
+    if( !mBuffer )
+    {
+        throw(std::exception("No image data loaded - TextureImage::packHDR"));
+    }
+    if (PixelUtil::isCompressed(mFormat))
+    {
+        throw(std::exception("Image is compressed - TextureImage::packHDR"));
+    }
+
+    convertLevels(PF_A8B8G8R8, [mode, range](const PixelBox& src, const PixelBox& dst)
+    {
+        HDRPacking::pack(src, dst, mode, range);
+    });
+    return *this;
+}
+
+TextureImage & TextureImage::unpackHDR(HDRPacking::Mode mode, PixelFormat format, float range)
+{
+    if( !mBuffer )
+    {
+        throw(std::exception("No image data loaded - TextureImage::unpackHDR"));
+    }
+    if (!HDRPacking::canPack(mFormat))
+    {
+        throw(std::exception("Image is not 8 bit RGBA - TextureImage::unpackHDR"));
+    }
+    if (PixelUtil::isCompressed(format))
+    {
+        throw(std::exception("Unpacked format must be uncompressed - TextureImage::unpackHDR"));
+    }
+
+    convertLevels(format, [mode, range](const PixelBox& src, const PixelBox& dst)
+    {
+        HDRPacking::unpack(src, dst, mode, range);
+    });
+    return *this;
+}
+
+void 
+TextureImage::convertLevels(PixelFormat format, 
+                            const std::function<void(const PixelBox&, const PixelBox&)>& convert)
+{
+    // Convert into a buffer with the same face and mip layout.
+    const size_t numFaces = getNumFaces();
+    TextureImage converted;
+    converted.loadDynamicTextureImage(nullptr, mWidth, mHeight, mDepth, format, false, numFaces, mNumMipmaps);
+    converted.allocate(converted.getSize());
+    const TextureImage& source = *this;
+    for (size_t face = 0; face < numFaces; ++face)
+    {
+        for (size_t mip = 0; mip <= mNumMipmaps; ++mip)
+        {
+            convert(source.getPixelBox(face, mip).source(), converted.getWritablePixelBox(face, mip));
+        }
+    }
+
+    // Take over the converted buffer, releasing the current (or borrowed) pixels.
+    *this = std::move(converted);
+}
+
 TextureImage & TextureImage::load(DataStreamPtr& stream, const std::string& type )
 {
     freeMemory();
@@ -486,8 +643,17 @@ TextureImage & TextureImage::load(DataStreamPtr& stream, const std::string& type
     mBuffer = res.first->getPtr();
     // Make sure stream does not delete
     res.first->setFreeOnClose(false);
-    // make sure we delete
-    mAutoDelete = true;
+
+    if (pData->borrowed)
+    {
+        // Decoded data points into the source stream, take ownership of it.
+        mStorage = SharedDataStreamPtr(stream.release());
+    }
+    else
+    {
+        // make sure we delete
+        mPixels.reset(mBuffer, free);
+    }
 
     return *this;
 }
@@ -510,6 +676,7 @@ std::string TextureImage::getFileExtFromMagic(DataStreamPtr stream)
 
 uint8_t* TextureImage::getData()
 {
+    unshare();
     return mBuffer;
 }
 
@@ -593,58 +760,139 @@ void TextureImage::applyGamma( uint8_t *buffer, float gamma, size_t size, uint8_
 
     uint32_t stride = bpp >> 3;
 
-    for( size_t i = 0, j = size / stride; i < j; i++, buffer += stride )
+    // 256 entry ramp from the cached gamma table.
+    Gamma::Table table = Gamma::unorm8Table(1.0f / gamma);
+    uint8_t ramp[256];
+    for (size_t i = 0; i < 256; i++)
     {
-        float r, g, b;
-
-        const float rangeMult = 255.0f;
-        const float rangeMultInv = 1.0f / rangeMult;
-        const float gammaValue = 1.0f / gamma;
-
-        r = rangeMultInv * buffer[0];
-        g = rangeMultInv * buffer[1];
-        b = rangeMultInv * buffer[2];
-
-        r = powf(r, gammaValue);
-        g = powf(g, gammaValue);
-        b = powf(b, gammaValue);
-
-        buffer[0] = (uint8_t)(r * rangeMult);
-        buffer[1] = (uint8_t)(g * rangeMult);
-        buffer[2] = (uint8_t)(b * rangeMult);
+        ramp[i] = (uint8_t)((*table)[i] * 255.0f);
     }
+
+    const size_t pixels = size / stride;
+    const size_t pixelsPerTask = 65536;
+    concurrency::parallel_for(size_t(0), (pixels + pixelsPerTask - 1) / pixelsPerTask, [&](size_t taskId)
+    {
+        uint8_t* pixel = buffer + taskId * pixelsPerTask * stride;
+        uint8_t* end = buffer + std::min(pixels, (taskId + 1) * pixelsPerTask) * stride;
+        for (; pixel < end; pixel += stride)
+        {
+            pixel[0] = ramp[pixel[0]];
+            pixel[1] = ramp[pixel[1]];
+            pixel[2] = ramp[pixel[2]];
+        }
+    });
 }
 
 void TextureImage::resize(size_t width, size_t height, Filter filter)
 {
-    // resizing dynamic images is not supported
-    assert(mAutoDelete);
     assert(mDepth == 1);
 
-    // reassign buffer to temp image, make sure auto-delete is true
-    TextureImage temp;
-    temp.loadDynamicTextureImage(mBuffer, mWidth, mHeight, 1, mFormat, true);
-    // do not delete[] mBuffer!  temp will destroy it
+    // temp takes over the current (owned, shared, dynamic or borrowed) 
+    // pixels and keeps them alive until scaling is done.
+    const TextureImage temp(std::move(*this));
 
     // set new dimensions, allocate new buffer
     mWidth = width;
     mHeight = height;
+    mDepth = 1;
+    mFormat = temp.mFormat;
+    mPixelSize = temp.mPixelSize;
+    mFlags = temp.mFlags;
     mBufSize = PixelUtil::getMemorySize(mWidth, mHeight, 1, mFormat);
-    mBuffer = (uint8_t*)malloc(sizeof(uint8_t) * mBufSize);
+    allocate(mBufSize);
     mNumMipmaps = 0; // Loses precomputed mipmaps
 
     // scale the image from temp into our resized buffer
-    TextureImage::scale(temp.getPixelBox(), getPixelBox(), filter);
+    TextureImage::scale(temp.getPixelBox().source(), getWritablePixelBox(), filter);
+}
+
+namespace
+{
+// Raises the colour channels of float32 RGBA texels to exponent, alpha is left as is.
+void
+raiseColorChannels(std::vector<float>& texels, float exponent)
+{
+    concurrency::parallel_for(size_t(0), texels.size() / 4, size_t(1024), [&](size_t first)
+    {
+        const size_t last = std::min(first + 1024, texels.size() / 4);
+        for (size_t texel = first; texel < last; ++texel)
+        {
+            float* colour = &texels[texel * 4];
+            for (size_t c = 0; c < 3; ++c)
+                colour[c] = colour[c] > 0.0f ? powf(colour[c], exponent) : 0.0f;
+        }
+    });
+}
+}
+
+TextureImage & TextureImage::generateMipmaps(Filter filter, float gammaSpace, const MipLevelCallback& callback)
+{
+    if( !mBuffer )
+    {
+        throw(std::exception("No image data loaded - TextureImage::generateMipmaps"));
+    }
+    if (PixelUtil::isCompressed(mFormat))
+    {
+        throw(std::exception("Can not generate mipmaps for compressed images - TextureImage::generateMipmaps"));
+    }
+
+    const size_t numFaces = getNumFaces();
+    for (size_t face = 0; face < numFaces; ++face)
+    {
+        // Linear float copy of the top level.
+        ConstPixelBox topLevel = getPixelBox(face, 0);
+        PixelBox source(topLevel.size().x, topLevel.size().y, topLevel.size().z, PF_FLOAT32_RGBA);
+        std::vector<float> sourceTexels(source.size().x * source.size().y * source.size().z * 4);
+        source.data = &sourceTexels[0];
+        PixelUtil::bulkPixelConversion(topLevel.source(), source);
+        if (gammaSpace != 1.0f)
+        {
+            raiseColorChannels(sourceTexels, gammaSpace);
+        }
+
+        for (size_t mip = 1; mip <= mNumMipmaps; ++mip)
+        {
+            PixelBox level = getWritablePixelBox(face, mip);
+            PixelBox filtered(level.size().x, level.size().y, level.size().z, PF_FLOAT32_RGBA);
+            std::vector<float> filteredTexels(filtered.size().x * filtered.size().y * filtered.size().z * 4);
+            filtered.data = &filteredTexels[0];
+            scale(source, filtered, filter);
+
+            if (callback)
+            {
+                callback(face, mip, filtered);
+            }
+
+            if (gammaSpace != 1.0f)
+            {
+                std::vector<float> encodedTexels(filteredTexels);
+                raiseColorChannels(encodedTexels, 1.0f / gammaSpace);
+                PixelBox encoded(filtered.size().x, filtered.size().y, filtered.size().z, 
+                                 PF_FLOAT32_RGBA, &encodedTexels[0]);
+                PixelUtil::bulkPixelConversion(encoded, level);
+            }
+            else
+            {
+                PixelUtil::bulkPixelConversion(filtered, level);
+            }
+
+            // This level is the source of the next one.
+            sourceTexels.swap(filteredTexels);
+            source = filtered;
+            source.data = &sourceTexels[0];
+        }
+    }
+    return *this;
 }
 
 void
 TextureImage::copyFrom(intptr_t dstPtr, bool reverse)
 {   
-    const PixelBox& src = getPixelBox();
+    const ConstPixelBox src = getPixelBox();
 
     if (!reverse)
     {
-        memcpy(reinterpret_cast<void*>(dstPtr), (void*)src.data, src.getConsecutiveSize());
+        memcpy(reinterpret_cast<void*>(dstPtr), src.data, src.getConsecutiveSize());
     }
     else
     {
@@ -655,10 +903,10 @@ TextureImage::copyFrom(intptr_t dstPtr, bool reverse)
             for (unsigned int j = 0; j < src.size().x; j++)
             {
                     size_t x = ((i * src.size().x) + j) * 4;
-                    dst[x  ]   = ((unsigned char*)(src.data))[x];
-                    dst[x+1]   = ((unsigned char*)(src.data))[x+1];
-                    dst[x+2]   = ((unsigned char*)(src.data))[x+2];
-                    dst[x+3]   = ((unsigned char*)(src.data))[x+3];
+                    dst[x  ]   = ((const unsigned char*)(src.data))[x];
+                    dst[x+1]   = ((const unsigned char*)(src.data))[x+1];
+                    dst[x+2]   = ((const unsigned char*)(src.data))[x+2];
+                    dst[x+3]   = ((const unsigned char*)(src.data))[x+3];
             }
         }
     }
@@ -761,6 +1009,22 @@ void TextureImage::scale(const PixelBox &src, const PixelBox &scaled, Filter fil
             LinearResampler::scale(src, scaled);
         }
         break;
+
+    case FILTER_BOX:
+        SeparableResampler::scale(src, scaled, RESAMPLE_BOX);
+        break;
+    case FILTER_TRIANGLE:
+        SeparableResampler::scale(src, scaled, RESAMPLE_TENT);
+        break;
+    case FILTER_BICUBIC:
+        SeparableResampler::scale(src, scaled, RESAMPLE_MITCHELL);
+        break;
+    case FILTER_LANCZOS3:
+        SeparableResampler::scale(src, scaled, RESAMPLE_LANCZOS3);
+        break;
+    case FILTER_KAISER:
+        SeparableResampler::scale(src, scaled, RESAMPLE_KAISER);
+        break;
     }
 }
 
@@ -777,7 +1041,14 @@ void TextureImage::setColorAt(ColorValue const &cv, size_t x, size_t y, size_t z
     PixelUtil::packColor(cv, getFormat(), &((unsigned char *)getData())[pixelSize * (z * getWidth() * getHeight() + y * getWidth() + x)]);
 }  
 
-PixelBox TextureImage::getPixelBox(size_t face, size_t mipmap) const
+PixelBox TextureImage::getWritablePixelBox(size_t face, size_t mipmap)
+{
+    unshare();
+    // The base of the view carries the (now unshared) writable pointer.
+    return getPixelBox(face, mipmap).source();
+}
+
+ConstPixelBox TextureImage::getPixelBox(size_t face, size_t mipmap) const
 {
     // TextureImage data is arranged as:
     // face 0, top level (mip 0)
@@ -803,8 +1074,8 @@ PixelBox TextureImage::getPixelBox(size_t face, size_t mipmap) const
     size_t finalFaceSize = 0;
     size_t finalWidth = 0, finalHeight = 0, finalDepth = 0;
 
-    size_t mipRange = Ctr::Limits<int32_t>::maxVal(int32_t(0), int32_t(numMips - 1));
-    for(size_t mip = 0; mip <= mipRange; ++mip)
+    // numMips counts the levels below the top level, the same as calculateSize.
+    for(size_t mip = 0; mip <= numMips; ++mip)
     {
         if (mip == mipmap)
         {
@@ -825,7 +1096,7 @@ PixelBox TextureImage::getPixelBox(size_t face, size_t mipmap) const
     offset += finalFaceSize;
     // Return subface as pixelbox
     PixelBox src(finalWidth, finalHeight, finalDepth, getFormat(), offset);
-    return src;
+    return ConstPixelBox(src);
 }
 
 size_t TextureImage::calculateSize(size_t mipmaps, size_t faces, size_t width, size_t height, size_t depth, 
@@ -889,12 +1160,9 @@ TextureImage::create(const Ctr::Vector2i& size, PixelFormat format, uint32_t num
     // error check here.
     // PF_UNKNOWN, mBufSize etc
 
-    mBuffer = static_cast<uint8_t*>(malloc(mBufSize * sizeof(uint8_t)));
+    allocate(mBufSize);
     memset (mBuffer, 0, sizeof(uint8_t) * mBufSize);
 
-    // make sure we delete
-    mAutoDelete = true;
-
     return *this;
 }
 
@@ -943,10 +1211,7 @@ TextureImage & TextureImage::combineTwoTextureImagesAsRGBA(const TextureImage& r
 
     mPixelSize = static_cast<uint8_t>(PixelUtil::getNumElemBytes( mFormat ));
 
-    mBuffer = static_cast<uint8_t*>(malloc(mBufSize * sizeof(uint8_t)));
-
-    // make sure we delete
-    mAutoDelete = true;
+    allocate(mBufSize);
 
 
     for (size_t face = 0; face < numFaces; ++face)
@@ -954,13 +1219,13 @@ TextureImage & TextureImage::combineTwoTextureImagesAsRGBA(const TextureImage& r
         for (size_t mip = 0; mip <= mNumMipmaps; ++mip)
         {
             // convert the RGB first
-            PixelBox srcRGB = rgb.getPixelBox(face, mip);
-            PixelBox dst = getPixelBox(face, mip);
-            PixelUtil::bulkPixelConversion(srcRGB, dst);
+            ConstPixelBox srcRGB = rgb.getPixelBox(face, mip);
+            PixelBox dst = getWritablePixelBox(face, mip);
+            PixelUtil::bulkPixelConversion(srcRGB.source(), dst);
 
             // now selectively add the alpha
-            PixelBox srcAlpha = alpha.getPixelBox(face, mip);
-            uint8_t* psrcAlpha = static_cast<uint8_t*>(srcAlpha.data);
+            ConstPixelBox srcAlpha = alpha.getPixelBox(face, mip);
+            const uint8_t* psrcAlpha = static_cast<const uint8_t*>(srcAlpha.data);
             uint8_t* pdst = static_cast<uint8_t*>(dst.data);
             for (size_t d = 0; d < mDepth; ++d)
             {
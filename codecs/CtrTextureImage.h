@@ -71,8 +71,12 @@ THE SOFTWARE.
 
 #include <CtrPlatform.h>
 #include <CtrPixelFormat.h>
+#include <CtrBlockCompressor.h>
+#include <CtrHDRPacking.h>
 #include <CtrDataStream.h>
 #include <CtrHash.h>
+#include <functional>
+#include <memory>
 
 namespace Ctr
 {
@@ -91,12 +95,15 @@ class TextureImage
 
   public:
     TextureImage();
+    // Copies share pixel data until one of them writes to it, see getData().
     TextureImage( const TextureImage &img );
+    TextureImage( TextureImage &&img );
     virtual ~TextureImage();
 
     void           copyFrom(intptr_t dstPtr, bool reverse = true);
 
     TextureImage & operator = ( const TextureImage & img );
+    TextureImage & operator = ( TextureImage && img );
     TextureImage & flipAroundY();
     TextureImage & flipAroundX();
     TextureImage& loadDynamicTextureImage(uint8_t* data, size_t width, size_t height, 
@@ -110,6 +117,14 @@ class TextureImage
         return loadDynamicTextureImage(data, width, height, 1, format);
     }
 
+    // Wraps pixel data that lives in memory owned by storage (for example a mapped file).
+    // No pixel data is copied, the storage is kept alive for as long as the image
+    // (or any copy of it) references it.
+    TextureImage& loadBorrowedTextureImage(uint8_t* data, const SharedDataStreamPtr& storage,
+                                           size_t width, size_t height, size_t depth,
+                                           PixelFormat format,
+                                           size_t numFaces = 1, size_t numMipMaps = 0);
+
     TextureImage & loadRawData( 
         DataStreamPtr& stream, 
         size_t width, size_t height, size_t depth,
@@ -131,7 +146,10 @@ class TextureImage
                         const std::string& groupName,
                         const Ctr::Hash& archiveHandle = Hash());
 
-    
+    // If the codec can reference the stream contents directly (mapped DDS files, 
+    // stored cooked textures), the image takes ownership of the stream and borrows 
+    // its storage. Every other format is copied out and the stream is closed once 
+    // decoding finishes.
     TextureImage & load(DataStreamPtr& stream, const std::string& type);
 
     
@@ -145,10 +163,33 @@ class TextureImage
     
     TextureImage & combineTwoTextureImagesAsRGBA(const TextureImage& rgb, const TextureImage& alpha, PixelFormat format);
 
-    void save(const std::string& filename);
+    void save(const std::string& filename) const;
+
+    DataStreamPtr encode(const std::string& formatextension) const;
+
+    // Block compresses every face and mip level in place.
+    TextureImage & compress(PixelFormat format, 
+                            BlockCompressor::Quality quality = BlockCompressor::QUALITY_NORMAL);
 
-    DataStreamPtr encode(const std::string& formatextension);
+    // Packs every face and mip level of a floating point image into 8 bit 
+    // RGBM or RGBE (PF_A8B8G8R8) in place.
+    TextureImage & packHDR(HDRPacking::Mode mode, 
+                           float range = HDRPacking::DefaultRGBMRange);
+
+    // Reverses packHDR, unpacking every face and mip level into format.
+    TextureImage & unpackHDR(HDRPacking::Mode mode, 
+                             PixelFormat format = PF_FLOAT16_RGBA,
+                             float range = HDRPacking::DefaultRGBMRange);
     
+    // Mutable access first gives the image its own copy of pixel data that 
+    // is shared with other images (copy on write). Dynamic images always
+    // write through to the application's buffer.
+    // The pointer only stays private to the image until it is copied 
+    // again. Copies made while it is held share the pixels it writes:
+    //     uint8_t* p = image.getData();
+    //     copy = image;
+    //     p[0] = 0;           // changes image and copy
+    // Call getData again after copying, it unshares the pixels again.
     uint8_t* getData(void);
 
     const uint8_t * getData() const;       
@@ -181,7 +222,12 @@ class TextureImage
     
     void setColorAt(ColorValue const &cv, size_t x, size_t y, size_t z);
 
-    PixelBox getPixelBox(size_t face = 0, size_t mipmap = 0) const;
+    // Read only view of a face and mip level, shared pixel data stays shared.
+    ConstPixelBox getPixelBox(size_t face = 0, size_t mipmap = 0) const;
+
+    // Writable view of a face and mip level, unshares the pixel data like 
+    // getData(), and is shared by the copies made while it is held.
+    PixelBox getWritablePixelBox(size_t face = 0, size_t mipmap = 0);
 
     void freeMemory();
 
@@ -190,13 +236,27 @@ class TextureImage
         FILTER_NEAREST,
         FILTER_LINEAR,
         FILTER_BILINEAR,
+        // Separable filters, see SeparableResampler.
         FILTER_BOX,
         FILTER_TRIANGLE,
-        FILTER_BICUBIC
+        FILTER_BICUBIC,
+        FILTER_LANCZOS3,
+        FILTER_KAISER
     };
 
     static void scale(const PixelBox &src, const PixelBox &dst, Filter filter = FILTER_BILINEAR);
     void   resize(size_t width, size_t height, Filter filter = FILTER_BILINEAR);
+
+    // Called with each generated mip level as float32 RGBA in linear space,
+    // before it is stored and used as the source of the next level.
+    typedef std::function<void(size_t face, size_t mip, const PixelBox& level)> MipLevelCallback;
+
+    // Regenerates mip levels 1 - getNumMipmaps() of every face from the top level,
+    // filtering each level from the previous one in float32. gammaSpace is the gamma
+    // the colour channels are encoded with, they are filtered in linear space.
+    TextureImage & generateMipmaps(Filter filter = FILTER_BOX, 
+                                   float gammaSpace = 1.0f,
+                                   const MipLevelCallback& callback = MipLevelCallback());
     static size_t calculateSize(size_t mipmaps, size_t faces, size_t width, size_t height, size_t depth, PixelFormat format);
     static std::string getFileExtFromMagic(DataStreamPtr stream);
 
@@ -205,7 +265,23 @@ class TextureImage
 
     bool   valid() const;
 
+    bool   isBorrowed() const { return mStorage != nullptr; }
+
+    // True if the pixel data is referenced by other images as well.
+    bool   isShared() const;
+
   protected:
+    // Replaces the pixels with an owned, uninitialized buffer of size bytes.
+    void   allocate(size_t size);
+
+    // Copy on write, copies pixel data that is shared (see isShared).
+    void   unshare();
+
+    // Replaces the pixels with a buffer of format, with the same face and mip
+    // layout, where convert writes each level from the current one.
+    void   convertLevels(PixelFormat format, 
+                         const std::function<void(const PixelBox&, const PixelBox&)>& convert);
+
     size_t mWidth;
     size_t mHeight;
     size_t mDepth;
@@ -218,7 +294,12 @@ class TextureImage
     uint8_t  mPixelSize;
     uint8_t* mBuffer;
 
-    bool mAutoDelete;
+    // Owned pixel data, shared between copies. Null for dynamic images,
+    // where the application holds & destroys the buffer, and borrowed ones.
+    std::shared_ptr<uint8_t> mPixels;
+
+    // Keeps borrowed pixel storage alive (see loadBorrowedTextureImage).
+    SharedDataStreamPtr mStorage;
 };
 
 uint32_t numberOfMipsInChain(uint32_t levelZero);
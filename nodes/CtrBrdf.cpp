@@ -41,10 +41,10 @@
 
 #include <CtrBrdf.h>
 #include <CtrShaderMgr.h>
-#include <CtrIComputeShader.h>
+#include <CtrIShader.h>
 #include <CtrTextureMgr.h>
 #include <CtrITexture.h>
-#include <CtrIComputeShader.h>
+#include <CtrBrdfIntegrator.h>
 #include <CtrLog.h>
 
 namespace Ctr
@@ -52,7 +52,6 @@ namespace Ctr
 Brdf::Brdf(Ctr::IDevice* device) :
     RenderNode(device),
     _brdfLut(nullptr),
-    _brdfLutShader(nullptr),
     _importanceSamplingShaderSpecular (nullptr),
     _importanceSamplingShaderDiffuse (nullptr)
 {
@@ -72,23 +71,12 @@ Brdf::load(const std::string& brdfInclude)
         THROW("Could not add importance sampling shader");
     }
 
-    _device->shaderMgr()->addComputeShaderFromFile("IblBrdf.hlsl", brdfInclude, "CSMain", _brdfLutShader,
-        std::map<std::string, std::string>());
-
-    _brdfLut = _device->
-        createTexture(&TextureParameters("tempTex",
-                                        TextureImagePtr(),
-                                        Ctr::TwoD,
-                                        Ctr::RenderTarget,
-                                        PF_FLOAT32_RGBA,
-                                        Ctr::Vector3i(256, 256, 1),
-                                        false,
-                                        1, 1, 0, 1, true));
-
-    assert(_brdfLut);
-
     setName(brdfInclude);
 
+    // The LUT is valid as soon as the brdf is loaded. A brdf that 
+    // declares an unknown model fails here.
+    createLut();
+
     return true;
 }
 
@@ -100,33 +88,48 @@ Brdf::~Brdf()
 void
 Brdf::compute()
 {
-    if (_hash != _brdfLutShader->hash())
+    // The importance sampling shader hash covers the include, it changes
+    // when the brdf is edited and the shader reloaded.
+    if (_hash != _importanceSamplingShaderSpecular->hash())
     {
-        _hash = _brdfLutShader->hash();
         try
         {
-            // Render
-            std::vector<const Ctr::IRenderResource*> views;
-            views.push_back(_brdfLut);
-
-            _brdfLutShader->setViews(views);
-            _brdfLutShader->bind();
-            _brdfLutShader->dispatch(Ctr::Vector3i(256 / 16, 256 / 16, 1));
-            _brdfLutShader->unbind();
-
-            _hash = _brdfLutShader->hash();
-
-            // Save
-            _brdfLut->save("data/Textures/Procedural/Output.dds");
+            createLut();
         }
         catch (const std::exception& ex)
         {
-            LOG("Exception while computing BRDF!" << ex.what())
-            assert(0);
+            // Keep the previous LUT until the brdf is fixed.
+            LOG("Exception while computing BRDF! " << ex.what())
         }
     }
 }
 
+void
+Brdf::createLut()
+{
+    _hash = _importanceSamplingShaderSpecular->hash();
+
+    // Integrated on the cpu, or loaded from the cache if the brdf did not change.
+    Ctr::TextureImagePtr lut = 
+        Ctr::BrdfIntegrator::cachedLut("data/shadersD3D11/" + name(), "data/Textures/Procedural/");
+
+    Ctr::ITexture* brdfLut = _device->
+        createTexture(&TextureParameters(name(),
+                                        lut,
+                                        Ctr::TwoD,
+                                        Ctr::FromFile,
+                                        PF_FLOAT32_RGBA,
+                                        Ctr::Vector3i((int32_t)lut->getWidth(), 
+                                                      (int32_t)lut->getHeight(), 1)));
+    if (!brdfLut)
+    {
+        THROW("Could not create the LUT for brdf " << name());
+    }
+
+    safedelete(_brdfLut);
+    _brdfLut = brdfLut;
+}
+
 const Ctr::ITexture*
 Brdf::brdfLut() const
 {
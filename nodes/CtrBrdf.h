@@ -72,16 +72,20 @@ class Brdf : public Ctr::RenderNode
 
     bool                       load(const std::string& brdfInclude);
 
+    // Recomputes the LUT if the brdf was edited and reloaded.
     void                       compute();
+    // Valid once load() succeeds.
     const Ctr::ITexture*       brdfLut() const;
 
     const Ctr::IShader*        specularImportanceSamplingShader() const;
     const Ctr::IShader*        diffuseImportanceSamplingShader() const;
 
   private:
-    Ctr::ITexture*             _brdfLut;
+    void                       createLut();
 
-    const Ctr::IComputeShader* _brdfLutShader;
+    // Split sum LUT, see BrdfIntegrator.
+    Ctr::ITexture*             _brdfLut;
+    // Hash of the importance sampling shader the LUT was computed for.
     Ctr::Hash                  _hash;
 
     // Cubemap importance sampling variables and shader.
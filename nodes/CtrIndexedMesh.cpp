@@ -106,6 +106,7 @@ IndexedMesh::load(const aiMesh* inputMesh)
         if (inputMesh->HasPositions())
         {
             memcpy(&vertexPtr[0], inputMesh->mVertices, sizeof(float)* 3 * inputVertexCount);
+            computeBounds(vertexPtr, inputVertexCount);
         }
         if (inputMesh->HasNormals())
         {
@@ -221,6 +222,7 @@ IndexedMesh::load(const tinyobj::shape_t* shape)
             {
                 verticesPtr[positionId] = inputMesh->positions[positionId];
             }
+            computeBounds(reinterpret_cast<const Vector3f*>(verticesPtr), inputMesh->positions.size() / 3);
         }
         {
             for (size_t normalsId = 0; normalsId < inputMesh->normals.size(); normalsId++)
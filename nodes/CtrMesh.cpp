@@ -65,7 +65,8 @@ _locked (false),
 _entity (0),
 _material (0),
 _topologySubtype(Tri),
-_groupId(0)
+_groupId(0),
+_bounds(Vector3f(0, 0, 0))
 {
     _visible = new BoolProperty (this, std::string("visible"));
     setVisible (true);
@@ -90,6 +91,40 @@ Mesh::setGroupId(uint32_t group)
     _groupId = group;
 }
 
+void
+Mesh::computeBounds(const Vector3f* positions, size_t positionCount)
+{
+    if (positionCount == 0)
+    {
+        _bounds = Region<Vector3f>(Vector3f(0, 0, 0));
+        return;
+    }
+
+    _bounds = Region<Vector3f>(positions[0]);
+    for (size_t positionId = 1; positionId < positionCount; ++positionId)
+    {
+        const Vector3f& position = positions[positionId];
+        _bounds.minExtent = Vector3f(Ctr::minValue(_bounds.minExtent.x, position.x),
+                                     Ctr::minValue(_bounds.minExtent.y, position.y),
+                                     Ctr::minValue(_bounds.minExtent.z, position.z));
+        _bounds.maxExtent = Vector3f(Ctr::maxValue(_bounds.maxExtent.x, position.x),
+                                     Ctr::maxValue(_bounds.maxExtent.y, position.y),
+                                     Ctr::maxValue(_bounds.maxExtent.z, position.z));
+    }
+}
+
+const Region<Vector3f>&
+Mesh::bounds() const
+{
+    return _bounds;
+}
+
+Vector3f
+Mesh::boundsCenter() const
+{
+    return (_bounds.minExtent + _bounds.maxExtent) * 0.5f;
+}
+
 bool
 Mesh::dynamic() const 
 { 
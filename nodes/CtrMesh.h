@@ -151,6 +151,13 @@ class Mesh : public Ctr::TransformNode
     void                            setShadowMask(uint32_t);
     uint32_t                        shadowMask() const;
 
+    // Axis aligned bounds of the vertices, computed when the mesh is 
+    // loaded. The scene loaders bake the node transforms into the 
+    // vertices, so the bounds are in world space.
+    void                            computeBounds(const Vector3f* positions, size_t positionCount);
+    const Region<Vector3f>&         bounds() const;
+    Vector3f                        boundsCenter() const;
+
   protected:
     const IVertexBuffer*            vertexBuffer() const;
 
@@ -171,6 +178,7 @@ class Mesh : public Ctr::TransformNode
     Ctr::BoolProperty*               _visible;
     bool                            _dynamic;
     uint32_t                        _groupId;
+    Region<Vector3f>                _bounds;
 };
 }
 #endif
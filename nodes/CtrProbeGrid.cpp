@@ -0,0 +1,303 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrProbeGrid.h>
+#include <CtrMesh.h>
+#include <ppl.h>
+#include <algorithm>
+
+namespace Ctr
+{
+namespace
+{
+//-----------------------------------------------------------------
+// Lower grid coordinate and weight of the upper one along an axis,
+// clamped to the grid.
+//-----------------------------------------------------------------
+void
+axisCoordinate(float position, float origin, float spacing, int32_t dimension,
+               int32_t& lower, int32_t& upper, float& weight)
+{
+    if (dimension <= 1 || spacing <= 0)
+    {
+        lower = upper = 0;
+        weight = 0;
+        return;
+    }
+
+    const float coordinate = Ctr::minValue(Ctr::maxValue((position - origin) / spacing, 0.0f), 
+                                           float(dimension - 1));
+    lower = Ctr::minValue(int32_t(coordinate), dimension - 2);
+    upper = lower + 1;
+    weight = coordinate - float(lower);
+}
+}
+
+ProbeGrid::ProbeGrid() :
+    _origin(0, 0, 0),
+    _spacing(1, 1, 1),
+    _dimensions(0, 0, 0)
+{
+}
+
+ProbeGrid::~ProbeGrid()
+{
+}
+
+void
+ProbeGrid::create(const Vector3f& origin, 
+                  const Vector3f& spacing, 
+                  const Vector3i& dimensions)
+{
+    if (dimensions.x <= 0 || dimensions.y <= 0 || dimensions.z <= 0)
+    {
+        throw(std::exception("Probe grid dimensions must be positive - ProbeGrid::create"));
+    }
+
+    _origin = origin;
+    _spacing = spacing;
+    _dimensions = dimensions;
+
+    const size_t count = size_t(dimensions.x) * size_t(dimensions.y) * size_t(dimensions.z);
+    for (size_t arrayId = 0; arrayId < NumArrays; ++arrayId)
+    {
+        _coefficients[arrayId].assign(count, 0.0f);
+    }
+    clearMeshes();
+}
+
+void
+ProbeGrid::clear()
+{
+    _dimensions = Vector3i(0, 0, 0);
+    for (size_t arrayId = 0; arrayId < NumArrays; ++arrayId)
+    {
+        _coefficients[arrayId].clear();
+    }
+    clearMeshes();
+}
+
+bool
+ProbeGrid::empty() const
+{
+    return probeCount() == 0;
+}
+
+size_t
+ProbeGrid::probeCount() const
+{
+    return _coefficients[0].size();
+}
+
+const Vector3f&
+ProbeGrid::origin() const
+{
+    return _origin;
+}
+
+const Vector3f&
+ProbeGrid::spacing() const
+{
+    return _spacing;
+}
+
+const Vector3i&
+ProbeGrid::dimensions() const
+{
+    return _dimensions;
+}
+
+size_t
+ProbeGrid::probeIndex(int32_t x, int32_t y, int32_t z) const
+{
+    return (size_t(z) * size_t(_dimensions.y) + size_t(y)) * size_t(_dimensions.x) + size_t(x);
+}
+
+Vector3f
+ProbeGrid::probePosition(size_t probeId) const
+{
+    const size_t x = probeId % size_t(_dimensions.x);
+    const size_t y = (probeId / size_t(_dimensions.x)) % size_t(_dimensions.y);
+    const size_t z = probeId / (size_t(_dimensions.x) * size_t(_dimensions.y));
+    return Vector3f(_origin.x + float(x) * _spacing.x,
+                    _origin.y + float(y) * _spacing.y,
+                    _origin.z + float(z) * _spacing.z);
+}
+
+void
+ProbeGrid::setProbe(size_t probeId, const SphericalHarmonics& irradiance)
+{
+    if (probeId >= probeCount())
+    {
+        throw(std::exception("Probe index is out of range - ProbeGrid::setProbe"));
+    }
+
+    for (size_t coefficientId = 0; coefficientId < SphericalHarmonics::NumCoefficients; ++coefficientId)
+    {
+        const Vector4f& coefficient = irradiance.coefficient(coefficientId);
+        _coefficients[coefficientId * NumChannels + 0][probeId] = coefficient.x;
+        _coefficients[coefficientId * NumChannels + 1][probeId] = coefficient.y;
+        _coefficients[coefficientId * NumChannels + 2][probeId] = coefficient.z;
+    }
+}
+
+void
+ProbeGrid::setProbe(size_t probeId, const TextureImage& cubemap)
+{
+    setProbe(probeId, SphericalHarmonics::project(cubemap).irradiance());
+}
+
+SphericalHarmonics
+ProbeGrid::probe(size_t probeId) const
+{
+    SphericalHarmonics irradiance;
+    for (size_t coefficientId = 0; coefficientId < SphericalHarmonics::NumCoefficients; ++coefficientId)
+    {
+        irradiance.setCoefficient(coefficientId, 
+                                  Vector4f(_coefficients[coefficientId * NumChannels + 0][probeId],
+                                           _coefficients[coefficientId * NumChannels + 1][probeId],
+                                           _coefficients[coefficientId * NumChannels + 2][probeId],
+                                           0.0f));
+    }
+    return irradiance;
+}
+
+SphericalHarmonics
+ProbeGrid::sample(const Vector3f& position) const
+{
+    SphericalHarmonics irradiance;
+    if (empty())
+        return irradiance;
+
+    int32_t x0, x1, y0, y1, z0, z1;
+    float fx, fy, fz;
+    axisCoordinate(position.x, _origin.x, _spacing.x, _dimensions.x, x0, x1, fx);
+    axisCoordinate(position.y, _origin.y, _spacing.y, _dimensions.y, y0, y1, fy);
+    axisCoordinate(position.z, _origin.z, _spacing.z, _dimensions.z, z0, z1, fz);
+
+    // The 8 surrounding probes and their trilinear weights.
+    const size_t probes[8] = { probeIndex(x0, y0, z0), probeIndex(x1, y0, z0),
+                               probeIndex(x0, y1, z0), probeIndex(x1, y1, z0),
+                               probeIndex(x0, y0, z1), probeIndex(x1, y0, z1),
+                               probeIndex(x0, y1, z1), probeIndex(x1, y1, z1) };
+    const float weights[8] = { (1 - fx) * (1 - fy) * (1 - fz), fx * (1 - fy) * (1 - fz),
+                               (1 - fx) * fy * (1 - fz),       fx * fy * (1 - fz),
+                               (1 - fx) * (1 - fy) * fz,       fx * (1 - fy) * fz,
+                               (1 - fx) * fy * fz,             fx * fy * fz };
+
+    float blended[NumArrays];
+    for (size_t arrayId = 0; arrayId < NumArrays; ++arrayId)
+    {
+        const float* coefficients = &_coefficients[arrayId][0];
+        float value = 0;
+        for (size_t cornerId = 0; cornerId < 8; ++cornerId)
+        {
+            value += coefficients[probes[cornerId]] * weights[cornerId];
+        }
+        blended[arrayId] = value;
+    }
+
+    for (size_t coefficientId = 0; coefficientId < SphericalHarmonics::NumCoefficients; ++coefficientId)
+    {
+        const float* value = &blended[coefficientId * NumChannels];
+        irradiance.setCoefficient(coefficientId, Vector4f(value[0], value[1], value[2], 0.0f));
+    }
+    return irradiance;
+}
+
+void
+ProbeGrid::sample(const Vector3f* positions, size_t count,
+                  SphericalHarmonics* irradiance) const
+{
+    concurrency::parallel_for(size_t(0), count, [&](size_t positionId)
+    {
+        irradiance[positionId] = sample(positions[positionId]);
+    });
+}
+
+void
+ProbeGrid::blendMeshes(const std::vector<Mesh*>& meshes)
+{
+    if (empty())
+    {
+        clearMeshes();
+        return;
+    }
+
+    if (meshes != _meshes)
+    {
+        // The vertices are in world space, each mesh is sampled at 
+        // the centre of its bounds.
+        _meshes = meshes;
+        _meshPositions.resize(meshes.size());
+        _meshIrradiance.resize(meshes.size());
+        _meshIndices.clear();
+        for (size_t meshId = 0; meshId < meshes.size(); ++meshId)
+        {
+            _meshPositions[meshId] = meshes[meshId]->boundsCenter();
+            _meshIndices[meshes[meshId]] = meshId;
+        }
+    }
+    if (_meshes.empty())
+        return;
+
+    sample(&_meshPositions[0], _meshPositions.size(), &_meshIrradiance[0]);
+}
+
+void
+ProbeGrid::clearMeshes()
+{
+    _meshes.clear();
+    _meshPositions.clear();
+    _meshIrradiance.clear();
+    _meshIndices.clear();
+}
+
+const SphericalHarmonics*
+ProbeGrid::meshIrradiance(const Mesh* mesh) const
+{
+    auto it = _meshIndices.find(mesh);
+    if (it != _meshIndices.end())
+    {
+        return &_meshIrradiance[it->second];
+    }
+    return nullptr;
+}
+}
@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#ifndef INCLUDED_CRT_PROBE_GRID
+#define INCLUDED_CRT_PROBE_GRID
+
+#include <CtrPlatform.h>
+#include <CtrVector3.h>
+#include <CtrSphericalHarmonics.h>
+#include <map>
+#include <vector>
+
+namespace Ctr
+{
+class Mesh;
+
+//-----------------------------------------------------------------
+// Regular grid of irradiance probes, L2 spherical harmonics each.
+// The coefficients are stored structure of arrays, one float array 
+// per coefficient and channel indexed by probe, so hundreds of 
+// probes light a scene without a cube map each.
+// Positions are looked up trilinearly between the 8 surrounding
+// probes and clamped to the grid. blendMeshes looks up every mesh
+// of the scene once a frame, in parallel.
+// The grid is filled by its owner with create and setProbe, the 
+// renderer does not bake it.
+//-----------------------------------------------------------------
+class ProbeGrid
+{
+  public:
+    enum
+    {
+        NumChannels = 3,
+        NumArrays = SphericalHarmonics::NumCoefficients * NumChannels
+    };
+
+    ProbeGrid();
+    virtual ~ProbeGrid();
+
+    // Probes at origin + (x, y, z) * spacing, for x < dimensions.x,
+    // y < dimensions.y and z < dimensions.z. The probes start black.
+    void                       create(const Vector3f& origin, 
+                                      const Vector3f& spacing, 
+                                      const Vector3i& dimensions);
+    void                       clear();
+
+    bool                       empty() const;
+    size_t                     probeCount() const;
+    const Vector3f&            origin() const;
+    const Vector3f&            spacing() const;
+    const Vector3i&            dimensions() const;
+
+    size_t                     probeIndex(int32_t x, int32_t y, int32_t z) const;
+    Vector3f                   probePosition(size_t probeId) const;
+
+    // Irradiance coefficients of a probe, irradiance / pi as in 
+    // SphericalHarmonics::irradiance.
+    void                       setProbe(size_t probeId, const SphericalHarmonics& irradiance);
+    SphericalHarmonics         probe(size_t probeId) const;
+
+    // Projects the radiance of a cube map captured at the probe.
+    void                       setProbe(size_t probeId, const TextureImage& cubemap);
+
+    SphericalHarmonics         sample(const Vector3f& position) const;
+    // Samples count positions in parallel.
+    void                       sample(const Vector3f* positions, size_t count,
+                                      SphericalHarmonics* irradiance) const;
+
+    // Samples the grid at the world position of each mesh. The mesh 
+    // lookup is only rebuilt when the set of meshes changes.
+    void                       blendMeshes(const std::vector<Mesh*>& meshes);
+    // Irradiance of mesh from the last blendMeshes, nullptr if it was not blended.
+    const SphericalHarmonics*  meshIrradiance(const Mesh* mesh) const;
+
+  protected:
+    void                       clearMeshes();
+
+    Vector3f                   _origin;
+    Vector3f                   _spacing;
+    Vector3i                   _dimensions;
+
+    // _coefficients[coefficient * NumChannels + channel][probe].
+    std::vector<float>         _coefficients[NumArrays];
+
+    // The meshes of the last blendMeshes, their bounds centres and irradiance.
+    std::vector<Mesh*>         _meshes;
+    std::vector<Vector3f>      _meshPositions;
+    std::vector<SphericalHarmonics> _meshIrradiance;
+    std::map<const Mesh*, size_t> _meshIndices;
+};
+}
+
+#endif
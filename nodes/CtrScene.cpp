@@ -44,8 +44,10 @@
 #include <CtrMaterial.h>
 #include <CtrIndexedMesh.h>
 #include <CtrShaderMgr.h>
+#include <CtrTextureMgr.h>
 #include <CtrMaterial.h>
 #include <CtrIBLProbe.h>
+#include <CtrProbeGrid.h>
 #include <CtrCamera.h>
 #include <CtrBrdf.h>
 #include <Ctrimgui.h>
@@ -224,9 +226,11 @@ Scene::Scene(Ctr::IDevice* device) :
     Ctr::RenderNode(device),
     _camera(nullptr),
     _activeBrdfProperty(nullptr),
-    _brdfType(nullptr)
+    _brdfType(nullptr),
+    _probeGrid(nullptr)
 {
     _camera = new Ctr::Camera(_device);
+    _probeGrid = new Ctr::ProbeGrid();
     loadBrdfs();
 }
 
@@ -251,6 +255,8 @@ Scene::~Scene()
     }
     _probes.clear();
 
+    safedelete(_probeGrid);
+
     for (auto it = _materials.begin(); it != _materials.end(); it++)
     {
         Ctr::Material* material = *it;
@@ -276,13 +282,25 @@ Scene::loadBrdfs()
     for (auto it = brdfHeaders.begin(); it != brdfHeaders.end(); it++)
     {
         Ctr::Brdf* brdf = new Ctr::Brdf(_device);
-        if (brdf->load(*it))
+        bool loaded = false;
+        try
+        {
+            // Throws if the brdf declares an unknown BRDF_MODEL.
+            loaded = brdf->load(*it);
+        }
+        catch (const std::exception& ex)
+        {
+            LOG("Exception while loading brdf " << *it << " " << ex.what())
+        }
+
+        if (loaded)
         {
             _brdfCache.push_back(brdf);
         }
         else
         {
             LOG("Failed to load brdf " << brdf->name())
+            safedelete(brdf);
         }
     }
 
@@ -396,15 +414,17 @@ const std::string& userMaterialPathName)
             material->twoSidedProperty()->set(true);
 
             //
-            // Load textures
+            // Load textures in the background, the material shows the
+            // placeholder until each one is ready.
             //
+            TextureMgr* textureMgr = _device->textureMgr();
             std::string assetPath = trimPathName(meshFilePathName);
             LOG("asset path " << assetPath)
                 aiString textureFilePath;
             if (mat.GetTexture(aiTextureType_DIFFUSE, 0, &textureFilePath) == aiReturn_SUCCESS)
             {
                 std::string mapFilePathName = assetPath + trimFileName(std::string(textureFilePath.C_Str()));
-                material->setAlbedoMap(mapFilePathName);
+                material->setAlbedoMap(textureMgr->loadTextureAsync(mapFilePathName));
                 // Retarded necessity. ArseImp doesn't load material or mesh names.
                 material->setName(mapFilePathName);
             }
@@ -417,7 +437,7 @@ const std::string& userMaterialPathName)
                 mat.GetTexture(aiTextureType_HEIGHT, 0, &textureFilePath) == aiReturn_SUCCESS)
             {
                 std::string mapFilePathName = assetPath + trimFileName(std::string(textureFilePath.C_Str()));
-                material->setNormalMap(mapFilePathName);
+                material->setNormalMap(textureMgr->loadTextureAsync(mapFilePathName));
             }
             else
             {
@@ -427,7 +447,7 @@ const std::string& userMaterialPathName)
             if (mat.GetTexture(aiTextureType_SPECULAR, 0, &textureFilePath) == aiReturn_SUCCESS)
             {
                 std::string mapFilePathName = assetPath + trimFileName(std::string(textureFilePath.C_Str()));
-                material->setSpecularRMCMap(mapFilePathName);
+                material->setSpecularRMCMap(textureMgr->loadTextureAsync(mapFilePathName));
             }
             else
             {
@@ -527,25 +547,27 @@ Scene::load(const std::string& meshFilePathName,
             material->addPass("color");
 
             //
-            // Load textures
+            // Load textures in the background, the material shows the
+            // placeholder until each one is ready.
             //
+            TextureMgr* textureMgr = _device->textureMgr();
             std::string assetPath = trimPathName(meshFilePathName);
             LOG("asset path " << assetPath)
             
             if (mat->diffuse_texname.length())
             {
                 std::string mapFilePathName = assetPath + (mat->diffuse_texname);
-                material->setAlbedoMap(mapFilePathName);
+                material->setAlbedoMap(textureMgr->loadTextureAsync(mapFilePathName));
             }
             if (mat->normal_texname.length())
             {
                 std::string mapFilePathName = assetPath + (mat->normal_texname);
-                material->setNormalMap(mapFilePathName);
+                material->setNormalMap(textureMgr->loadTextureAsync(mapFilePathName));
             }
             if (mat->specular_texname.length())
             {
                 std::string mapFilePathName = assetPath + (mat->specular_texname);
-                material->setSpecularRMCMap(mapFilePathName);
+                material->setSpecularRMCMap(textureMgr->loadTextureAsync(mapFilePathName));
             }
         }
 
@@ -685,6 +707,10 @@ Scene::update()
 
     _brdfCache[_activeBrdfProperty->get()]->compute();
 
+    if (!_probeGrid->empty())
+    {
+        _probeGrid->blendMeshes(meshesForPass("all"));
+    }
 }
 
 const std::vector<IBLProbe*>&
@@ -701,6 +727,18 @@ Scene::addProbe()
     return probe;
 }
 
+const ProbeGrid*
+Scene::probeGrid() const
+{
+    return _probeGrid;
+}
+
+ProbeGrid*
+Scene::probeGrid()
+{
+    return _probeGrid;
+}
+
 const Camera *
 Scene::camera() const
 {
@@ -55,6 +55,7 @@ class Material;
 class Camera;
 class Brdf;
 class IBLProbe;
+class ProbeGrid;
 
 class Scene : public Ctr::RenderNode
 {
@@ -80,6 +81,13 @@ class Scene : public Ctr::RenderNode
     const std::vector<IBLProbe*>& probes() const;
     IBLProbe*                   addProbe();
 
+    // Irradiance probes for the meshes, blended per mesh in update().
+    // The grid starts empty and the scene does not fill it, the 
+    // application creates it and sets its probes. Until then the 
+    // meshes are lit by the first IBL probe.
+    const ProbeGrid*           probeGrid() const;
+    ProbeGrid*                 probeGrid();
+
     const Brdf*                activeBrdf() const;
     IntProperty*               activeBrdfProperty();
 
@@ -101,6 +109,7 @@ class Scene : public Ctr::RenderNode
 
     std::set<Entity*>          _entities;
     std::vector<IBLProbe*>     _probes;
+    ProbeGrid*                 _probeGrid;
     std::set<Material*>        _materials;
     std::map<std::string, std::vector<Ctr::Mesh*> > _meshesByPass;
 };
@@ -78,19 +78,29 @@ AssetManager::openXmlDocument(const std::string& resourcePathName)
     if (stream)
     {
         xmlDocument = new pugi::xml_document();
-        // Create intermediate buffer;
-        char * buffer = (char*)malloc(sizeof(char) * stream->size()+1);
-        memset(buffer, 0, stream->size()+1);
+        // pugi parses in place from a null terminated, writable buffer.
+        // Build it directly from the mapped file contents where available
+        // and hand ownership to the document (freed by pugi on failure too).
+        size_t streamSize = stream->size();
+        char * buffer = (char*)malloc(sizeof(char) * streamSize+1);
         if (buffer)
         {
-            stream->readBytes(buffer, stream->size());
-            if (xmlDocument->load(buffer) == false)
+            if (const uint8_t* data = stream->getDataPtr())
+            {
+                memcpy(buffer, data, streamSize);
+            }
+            else
+            {
+                stream->readBytes(buffer, streamSize);
+            }
+            buffer[streamSize] = 0;
+
+            if (xmlDocument->parse(pugi::transfer_ownership_tag(), buffer) == false)
             {
                 LOG ("Failed to load xml document from stream: " << resourcePathName)
                 delete xmlDocument;
                 xmlDocument = nullptr;
             }
-            free(buffer);
         }
     }
 
@@ -187,6 +197,23 @@ AssetManager::openStream (const std::string& streamPathName)
     DataStream* stream = nullptr;
     if (AssetManager::fileExists(streamPathName))
     {
+        // Map local files rather than reading them into a heap buffer.
+        // Codecs read straight from the page cache.
+        MappedFileDataStream* mappedStream = new MappedFileDataStream(streamPathName);
+        if (mappedStream->ok())
+        {
+            stream = mappedStream;
+        }
+        else
+        {
+            delete mappedStream;
+            mappedStream = nullptr;
+        }
+    }
+
+    if (!stream && AssetManager::fileExists(streamPathName))
+    {
+        // Fallback for files that cannot be mapped (empty files, special files).
         std::ios::openmode mode = std::ios::in | std::ios::binary;
         std::fstream* rwStream = new std::fstream();
         rwStream->open(streamPathName.c_str(), mode);
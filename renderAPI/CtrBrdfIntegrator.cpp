@@ -0,0 +1,473 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrBrdfIntegrator.h>
+#include <CtrAssetManager.h>
+#include <CtrDataStream.h>
+#include <CtrLog.h>
+#include <ppl.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace Ctr
+{
+namespace
+{
+const float Pi = 3.14159265358979323f;
+
+bool
+readInclude(const std::string& brdfInclude, std::string& contents)
+{
+    if (std::unique_ptr<DataStream> stream = 
+        std::unique_ptr<DataStream>(AssetManager::assetManager()->openStream(brdfInclude)))
+    {
+        contents.resize(stream->size());
+        if (contents.size() > 0)
+            stream->read(&contents[0], contents.size());
+        return true;
+    }
+    return false;
+}
+
+float
+radicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+//-----------------------------------------------------------------
+// Smith shadowing for GGX, Schlick's approximation with k = alpha / 2.
+//-----------------------------------------------------------------
+struct SchlickSmith
+{
+    SchlickSmith(float roughness) : 
+        k(roughness * roughness * 0.5f)
+    {
+    }
+
+    float
+    g1(float cosine) const
+    {
+        return cosine / (cosine * (1.0f - k) + k);
+    }
+
+#if CTR_SSE2
+    __m128
+    g1(__m128 cosine) const
+    {
+        const __m128 kk = _mm_set1_ps(k);
+        return _mm_div_ps(cosine, _mm_add_ps(_mm_mul_ps(cosine, _mm_sub_ps(_mm_set1_ps(1.0f), kk)), kk));
+    }
+#endif
+
+    float                      k;
+};
+
+//-----------------------------------------------------------------
+// Smith shadowing for Beckmann, Walter's rational approximation.
+// c is clamped to 1.6, where the approximation reaches 1.
+//-----------------------------------------------------------------
+struct BeckmannSmith
+{
+    BeckmannSmith(float roughness) : 
+        m(std::max(roughness * roughness, 1e-4f))
+    {
+    }
+
+    float
+    g1(float cosine) const
+    {
+        const float c = std::min(cosine / (m * std::sqrt(std::max(1.0f - cosine * cosine, 1e-8f))), 1.6f);
+        return (3.535f * c + 2.181f * c * c) / (1.0f + 2.276f * c + 2.577f * c * c);
+    }
+
+#if CTR_SSE2
+    __m128
+    g1(__m128 cosine) const
+    {
+        const __m128 sine = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(cosine, cosine)), 
+                                                   _mm_set1_ps(1e-8f)));
+        const __m128 c = _mm_min_ps(_mm_div_ps(cosine, _mm_mul_ps(_mm_set1_ps(m), sine)), _mm_set1_ps(1.6f));
+        const __m128 c2 = _mm_mul_ps(c, c);
+        const __m128 numerator = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(3.535f), c), _mm_mul_ps(_mm_set1_ps(2.181f), c2));
+        const __m128 denominator = _mm_add_ps(_mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(2.276f), c)), 
+                                              _mm_mul_ps(_mm_set1_ps(2.577f), c2));
+        return _mm_div_ps(numerator, denominator);
+    }
+#endif
+
+    float                      m;
+};
+
+//-----------------------------------------------------------------
+// Separable Smith shadowing, G = G1(NdotL) * G1(NdotV). The view 
+// term is G1(NdotV), evaluated once per NdotV.
+//-----------------------------------------------------------------
+template <typename Masking>
+struct Smith
+{
+    Smith(float roughness) : 
+        masking(roughness)
+    {
+    }
+
+    float
+    view(float nDotV) const
+    {
+        return masking.g1(nDotV);
+    }
+
+    float
+    g(float view, float nDotL, float, float) const
+    {
+        return masking.g1(nDotL) * view;
+    }
+
+#if CTR_SSE2
+    __m128
+    g(__m128 view, __m128 nDotL, __m128, __m128) const
+    {
+        return _mm_mul_ps(masking.g1(nDotL), view);
+    }
+#endif
+
+    Masking                    masking;
+};
+
+//-----------------------------------------------------------------
+// Cook-Torrance V-cavity shadowing, used for Blinn-Phong.
+// G = min(1, 2 NdotH min(NdotV, NdotL) / VdotH). Unlike the Beckmann
+// Smith term it holds for any NDF, so it stays energy conserving 
+// at the low exponents of rough Blinn-Phong, where the Beckmann 
+// slope equivalence breaks down.
+//-----------------------------------------------------------------
+struct CookTorrance
+{
+    CookTorrance(float)
+    {
+    }
+
+    float
+    view(float nDotV) const
+    {
+        return nDotV;
+    }
+
+    float
+    g(float nDotV, float nDotL, float nDotH, float vDotH) const
+    {
+        return std::min(1.0f, 2.0f * nDotH * std::min(nDotV, nDotL) / std::max(vDotH, 1e-6f));
+    }
+
+#if CTR_SSE2
+    __m128
+    g(__m128 nDotV, __m128 nDotL, __m128 nDotH, __m128 vDotH) const
+    {
+        const __m128 cavity = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(2.0f), nDotH), _mm_min_ps(nDotV, nDotL)), 
+                                         _mm_max_ps(vDotH, _mm_set1_ps(1e-6f)));
+        return _mm_min_ps(_mm_set1_ps(1.0f), cavity);
+    }
+#endif
+};
+
+// Cosine of the half vector angle for uniform e of the NDF importance sampling.
+float
+halfVectorCosine(BrdfIntegrator::Model model, float roughness, float e)
+{
+    const float alpha = roughness * roughness;
+    switch (model)
+    {
+        case BrdfIntegrator::BRDF_BECKMANN:
+        {
+            const float tan2 = -alpha * alpha * std::log(std::max(1.0f - e, 1e-8f));
+            return 1.0f / std::sqrt(1.0f + tan2);
+        }
+        case BrdfIntegrator::BRDF_BLINN_PHONG:
+        {
+            // D ~ (n + 2) / 2pi cos^n, with n = 2 / alpha^2 - 2.
+            const float exponent = std::max(2.0f / std::max(alpha * alpha, 1e-8f) - 2.0f, 0.0f);
+            return std::pow(e, 1.0f / (exponent + 2.0f));
+        }
+        default:
+            return std::sqrt((1.0f - e) / (1.0f + (alpha * alpha - 1.0f) * e));
+    }
+}
+
+//-----------------------------------------------------------------
+// Integrates one roughness row. hx and hz are the half vectors in
+// tangent space (only the plane holding V matters), padded to a 
+// multiple of four with hz = 0, which never passes the NdotL test.
+//-----------------------------------------------------------------
+template <typename Geometry>
+void
+integrateRow(const Geometry& geometry, const float* hx, const float* hz, 
+             size_t sampleCount, size_t paddedCount,
+             size_t resolution, float* row, float& rowEnergy)
+{
+    for (size_t x = 0; x < resolution; ++x)
+    {
+        const float nDotV = (float(x) + 0.5f) / float(resolution);
+        const float vx = std::sqrt(1.0f - nDotV * nDotV);
+        const float vz = nDotV;
+        const float view = geometry.view(nDotV);
+
+        float scale = 0.0f;
+        float bias = 0.0f;
+        size_t i = 0;
+#if CTR_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 vvx = _mm_set1_ps(vx);
+        const __m128 vvz = _mm_set1_ps(vz);
+        const __m128 viewV = _mm_set1_ps(view);
+        const __m128 invNDotV = _mm_set1_ps(1.0f / nDotV);
+        __m128 scales = zero;
+        __m128 biases = zero;
+        for (; i < paddedCount; i += 4)
+        {
+            const __m128 x4 = _mm_loadu_ps(hx + i);
+            const __m128 z4 = _mm_loadu_ps(hz + i);
+            const __m128 vDotH = _mm_max_ps(_mm_add_ps(_mm_mul_ps(vvx, x4), _mm_mul_ps(vvz, z4)), zero);
+            const __m128 nDotL = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(two, vDotH), z4), vvz);
+            const __m128 valid = _mm_and_ps(_mm_cmpgt_ps(nDotL, zero), _mm_cmpgt_ps(z4, zero));
+
+            // G * VdotH / (NdotH * NdotV), zero for the samples below the horizon.
+            const __m128 safeNDotL = _mm_max_ps(nDotL, _mm_set1_ps(1e-6f));
+            const __m128 safeNDotH = _mm_max_ps(z4, _mm_set1_ps(1e-6f));
+            const __m128 shadowing = geometry.g(viewV, safeNDotL, safeNDotH, vDotH);
+            const __m128 visibility = _mm_and_ps(valid, 
+                _mm_div_ps(_mm_mul_ps(_mm_mul_ps(shadowing, invNDotV), vDotH), safeNDotH));
+
+            const __m128 f1 = _mm_sub_ps(one, vDotH);
+            const __m128 f2 = _mm_mul_ps(f1, f1);
+            const __m128 fresnel = _mm_mul_ps(_mm_mul_ps(f2, f2), f1);
+            scales = _mm_add_ps(scales, _mm_mul_ps(_mm_sub_ps(one, fresnel), visibility));
+            biases = _mm_add_ps(biases, _mm_mul_ps(fresnel, visibility));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, scales);
+        scale = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        _mm_storeu_ps(lanes, biases);
+        bias = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+        for (; i < paddedCount; ++i)
+        {
+            const float vDotH = std::max(vx * hx[i] + vz * hz[i], 0.0f);
+            const float nDotL = 2.0f * vDotH * hz[i] - vz;
+            if (nDotL <= 0.0f || hz[i] <= 0.0f)
+                continue;
+
+            const float visibility = geometry.g(view, nDotL, hz[i], vDotH) * vDotH / (hz[i] * nDotV);
+            const float fresnel = std::pow(1.0f - vDotH, 5.0f);
+            scale += (1.0f - fresnel) * visibility;
+            bias += fresnel * visibility;
+        }
+
+        // Under a white furnace the BRDF reflects at most what it 
+        // receives, scale + bias <= 1. Sampling noise past that is 
+        // normalized away, the largest sum is reported by integrate.
+        scale /= float(sampleCount);
+        bias /= float(sampleCount);
+        const float energy = scale + bias;
+        if (energy > 1.0f)
+        {
+            scale /= energy;
+            bias /= energy;
+        }
+        rowEnergy = std::max(rowEnergy, energy);
+
+        float* texel = row + x * 4;
+        texel[0] = scale;
+        texel[1] = bias;
+        texel[2] = 0.0f;
+        texel[3] = 1.0f;
+    }
+}
+}
+
+BrdfIntegrator::Model
+BrdfIntegrator::modelFromInclude(const std::string& brdfInclude)
+{
+    std::string contents;
+    if (!readInclude(brdfInclude, contents))
+    {
+        THROW("Could not open brdf include " << brdfInclude << " - BrdfIntegrator::modelFromInclude");
+    }
+
+    // Looks for: #define BRDF_MODEL <model>
+    std::istringstream lines(contents);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::istringstream tokens(line);
+        std::string directive, define, model;
+        tokens >> directive >> define >> model;
+        if (directive != "#define" || define != "BRDF_MODEL")
+            continue;
+
+        if (model == "GGX")
+            return BRDF_GGX;
+        if (model == "BECKMANN")
+            return BRDF_BECKMANN;
+        if (model == "BLINN_PHONG")
+            return BRDF_BLINN_PHONG;
+        THROW("Unknown BRDF_MODEL " << model << " in " << brdfInclude << " - BrdfIntegrator::modelFromInclude");
+    }
+    LOG("No BRDF_MODEL declared in " << brdfInclude << ", integrating it as GGX");
+    return BRDF_GGX;
+}
+
+TextureImagePtr
+BrdfIntegrator::integrate(Model model, size_t resolution, size_t sampleCount)
+{
+    resolution = std::max<size_t>(resolution, 1);
+    sampleCount = std::max<size_t>(sampleCount, 1);
+    const size_t paddedCount = (sampleCount + 3) & ~size_t(3);
+
+    TextureImagePtr lut(new TextureImage());
+    lut->create(Vector2i(int32_t(resolution), int32_t(resolution)), PF_FLOAT32_RGBA, 0);
+    float* texels = reinterpret_cast<float*>(lut->getData());
+    std::vector<float> rowEnergy(resolution, 0.0f);
+
+    concurrency::parallel_for(size_t(0), resolution, [&](size_t y)
+    {
+        const float roughness = (float(y) + 0.5f) / float(resolution);
+
+        std::vector<float> halfVectors(paddedCount * 2, 0.0f);
+        float* hx = &halfVectors[0];
+        float* hz = hx + paddedCount;
+        for (size_t sampleId = 0; sampleId < sampleCount; ++sampleId)
+        {
+            const float phi = 2.0f * Pi * float(sampleId) / float(sampleCount);
+            const float cosTheta = halfVectorCosine(model, roughness, radicalInverse(uint32_t(sampleId)));
+            const float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+            hx[sampleId] = sinTheta * std::cos(phi);
+            hz[sampleId] = cosTheta;
+        }
+
+        float* row = texels + y * resolution * 4;
+        if (model == BRDF_GGX)
+            integrateRow(Smith<SchlickSmith>(roughness), hx, hz, sampleCount, paddedCount, resolution, row, rowEnergy[y]);
+        else if (model == BRDF_BECKMANN)
+            integrateRow(Smith<BeckmannSmith>(roughness), hx, hz, sampleCount, paddedCount, resolution, row, rowEnergy[y]);
+        else
+            integrateRow(CookTorrance(roughness), hx, hz, sampleCount, paddedCount, resolution, row, rowEnergy[y]);
+    });
+
+    // More than sampling noise above 1 means the NDF and shadowing 
+    // terms of the model do not match.
+    const float energy = *std::max_element(rowEnergy.begin(), rowEnergy.end());
+    if (energy > 1.01f)
+    {
+        LOG("Brdf model " << model << " gains energy, scale + bias reached " << energy << 
+            " - BrdfIntegrator::integrate");
+    }
+    return lut;
+}
+
+Hash
+BrdfIntegrator::lutHash(const std::string& brdfInclude, size_t resolution, size_t sampleCount)
+{
+    // The contents include the BRDF_MODEL declaration.
+    std::string contents;
+    if (!readInclude(brdfInclude, contents))
+    {
+        LOG("Could not open brdf include " << brdfInclude << ", hashing its name only");
+    }
+
+    std::ostringstream parameters;
+    parameters << brdfInclude << "_" << resolution << "_" << sampleCount;
+
+    Hash hash(contents);
+    hash.append(Hash(parameters.str()));
+    return hash;
+}
+
+TextureImagePtr
+BrdfIntegrator::cachedLut(const std::string& brdfInclude,
+                          const std::string& cacheDirectory,
+                          size_t resolution,
+                          size_t sampleCount)
+{
+    // Checked up front, so an include with an unknown model fails even 
+    // when a LUT for it is still in the cache.
+    const Model model = modelFromInclude(brdfInclude);
+    const std::string cachePathName = cacheDirectory + "Brdf_" + 
+        lutHash(brdfInclude, resolution, sampleCount).toString() + ".dds";
+
+    if (AssetManager::fileExists(cachePathName))
+    {
+        try
+        {
+            TextureImagePtr lut(new TextureImage());
+            lut->load(cachePathName, std::string());
+            if (lut->getWidth() == resolution && lut->getHeight() == resolution && 
+                lut->getFormat() == PF_FLOAT32_RGBA)
+            {
+                return lut;
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            LOG("Could not load cached brdf " << cachePathName << " " << ex.what());
+        }
+    }
+
+    LOG("Integrating brdf " << brdfInclude);
+    TextureImagePtr lut = integrate(model, resolution, sampleCount);
+    try
+    {
+        lut->save(cachePathName);
+    }
+    catch (const std::exception& ex)
+    {
+        LOG("Could not cache brdf " << cachePathName << " " << ex.what());
+    }
+    return lut;
+}
+}
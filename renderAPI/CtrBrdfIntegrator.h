@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_BRDF_INTEGRATOR
+#define INCLUDED_CRT_BRDF_INTEGRATOR
+
+#include <CtrPlatform.h>
+#include <CtrTextureImage.h>
+#include <CtrHash.h>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// CPU split sum integration of the specular BRDF, the LUT that
+// IblBrdf.hlsl computes on the device.
+// Texel (x, y) holds the scale (r) and bias (g) on F0 for 
+// NdotV = (x + 0.5) / size and roughness = (y + 0.5) / size.
+// Rows are integrated in parallel, samples four at a time with SSE2.
+// Results are cached on disk, keyed by the hash of the .brdf include.
+//
+// Each .brdf include declares the model it implements, since the
+// HLSL itself cannot be evaluated here:
+//     #define BRDF_MODEL GGX          (or BECKMANN, BLINN_PHONG)
+// Includes that declare no model are integrated as GGX.
+//
+// The LUT only depends on which of the three models above is 
+// declared, the HLSL of the include is never evaluated. The cache 
+// key still hashes the whole include, so editing it integrates the 
+// LUT again, but a custom BRDF gets the LUT of its declared model.
+//-----------------------------------------------------------------
+class BrdfIntegrator
+{
+  public:
+    enum Model
+    {
+        BRDF_GGX,
+        BRDF_BECKMANN,
+        BRDF_BLINN_PHONG
+    };
+
+    enum
+    {
+        DefaultResolution = 256,
+        DefaultSampleCount = 1024
+    };
+
+    // Model declared by the BRDF_MODEL define of a .brdf include, 
+    // GGX (with a warning) if it declares none.
+    // Throws if the include cannot be read or declares an unknown model.
+    static Model               modelFromInclude(const std::string& brdfInclude);
+
+    // PF_FLOAT32_RGBA LUT of resolution x resolution.
+    static TextureImagePtr     integrate(Model model, 
+                                         size_t resolution = DefaultResolution, 
+                                         size_t sampleCount = DefaultSampleCount);
+
+    // Hash of the include contents and the LUT parameters.
+    static Hash                lutHash(const std::string& brdfInclude, 
+                                       size_t resolution = DefaultResolution, 
+                                       size_t sampleCount = DefaultSampleCount);
+
+    // Loads the LUT of brdfInclude from cacheDirectory, or integrates 
+    // it and writes it there if the include changed since it was cached.
+    // Throws if the include declares an unknown model.
+    static TextureImagePtr     cachedLut(const std::string& brdfInclude,
+                                         const std::string& cacheDirectory,
+                                         size_t resolution = DefaultResolution, 
+                                         size_t sampleCount = DefaultSampleCount);
+};
+}
+
+#endif
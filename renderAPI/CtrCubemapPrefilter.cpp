@@ -0,0 +1,481 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrCubemapPrefilter.h>
+#include <CtrCubemapConversion.h>
+#include <ppl.h>
+#include <algorithm>
+#include <cmath>
+
+namespace Ctr
+{
+namespace
+{
+const float Pi = 3.14159265358979323f;
+
+size_t
+levelCount(size_t size)
+{
+    size_t levels = 1;
+    while ((size >> levels) > 0)
+        levels++;
+    return levels;
+}
+
+float
+radicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+//-----------------------------------------------------------------
+// Lod of the source mip whose texels cover the solid angle of
+// a sample with probability density pdf (filtered importance sampling).
+//-----------------------------------------------------------------
+float
+sampleLod(float pdf, size_t sampleCount, float texelSolidAngle)
+{
+    const float sampleSolidAngle = 1.0f / (float(sampleCount) * pdf + 1e-6f);
+    return std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+}
+
+void
+pad(std::vector<float>& values, float value)
+{
+    while (values.size() & 3)
+        values.push_back(value);
+}
+
+//-----------------------------------------------------------------
+// Rotates the tangent space samples into the frame around normal.
+//-----------------------------------------------------------------
+void
+rotateSamples(const float* sx, const float* sy, const float* sz, size_t count,
+              const float* tangent, const float* bitangent, const float* normal,
+              float* x, float* y, float* z)
+{
+    size_t i = 0;
+#if CTR_SSE2
+    const __m128 tx = _mm_set1_ps(tangent[0]);
+    const __m128 ty = _mm_set1_ps(tangent[1]);
+    const __m128 tz = _mm_set1_ps(tangent[2]);
+    const __m128 bx = _mm_set1_ps(bitangent[0]);
+    const __m128 by = _mm_set1_ps(bitangent[1]);
+    const __m128 bz = _mm_set1_ps(bitangent[2]);
+    const __m128 nx = _mm_set1_ps(normal[0]);
+    const __m128 ny = _mm_set1_ps(normal[1]);
+    const __m128 nz = _mm_set1_ps(normal[2]);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 u = _mm_loadu_ps(sx + i);
+        const __m128 v = _mm_loadu_ps(sy + i);
+        const __m128 w = _mm_loadu_ps(sz + i);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(u, tx), _mm_mul_ps(v, bx)), _mm_mul_ps(w, nx)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(u, ty), _mm_mul_ps(v, by)), _mm_mul_ps(w, ny)));
+        _mm_storeu_ps(z + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(u, tz), _mm_mul_ps(v, bz)), _mm_mul_ps(w, nz)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        x[i] = sx[i] * tangent[0] + sy[i] * bitangent[0] + sz[i] * normal[0];
+        y[i] = sx[i] * tangent[1] + sy[i] * bitangent[1] + sz[i] * normal[1];
+        z[i] = sx[i] * tangent[2] + sy[i] * bitangent[2] + sz[i] * normal[2];
+    }
+}
+}
+
+CubemapPrefilter::Settings::Settings() :
+    specularResolution(512),
+    diffuseResolution(128),
+    sampleCount(1024),
+    mipDrop(0),
+    format(PF_FLOAT32_RGBA),
+    fixupType(CP_FIXUP_AVERAGE_HERMITE),
+    fixupWidth(0.015f),
+    seamlessBilinear(false)
+{
+}
+
+CubemapPrefilter::CubemapPrefilter(const TextureImage& source) :
+    _sourceSize(0),
+    _sourceLevels(0)
+{
+    if (!source.hasFlag(IF_CUBEMAP) || source.getNumFaces() != 6)
+        throw(std::exception("Source is not a cube map - CubemapPrefilter::CubemapPrefilter"));
+    if (PixelUtil::isCompressed(source.getFormat()))
+        throw(std::exception("Compressed sources are not supported - CubemapPrefilter::CubemapPrefilter"));
+    if (source.getWidth() != source.getHeight() || source.getWidth() == 0)
+        throw(std::exception("Cube faces must be square - CubemapPrefilter::CubemapPrefilter"));
+
+    _sourceSize = source.getWidth();
+    _sourceLevels = levelCount(_sourceSize);
+    _source.create(Vector2i(int32_t(_sourceSize), int32_t(_sourceSize)), PF_FLOAT32_RGBA, 
+                   uint32_t(_sourceLevels - 1), IF_CUBEMAP);
+    for (size_t face = 0; face < 6; ++face)
+        PixelUtil::bulkPixelConversion(source.getPixelBox(face, 0).source(), _source.getWritablePixelBox(face, 0));
+    if (_sourceLevels > 1)
+        _source.generateMipmaps(TextureImage::FILTER_BOX);
+
+    const TextureImage& levels = _source;
+    _texels.resize(6 * _sourceLevels);
+    for (size_t face = 0; face < 6; ++face)
+    {
+        for (size_t level = 0; level < _sourceLevels; ++level)
+            _texels[face * _sourceLevels + level] = static_cast<const float*>(levels.getPixelBox(face, level).data);
+    }
+}
+
+CubemapPrefilter::~CubemapPrefilter()
+{
+}
+
+float
+CubemapPrefilter::mipRoughness(size_t mipId, size_t numMips, size_t mipDrop)
+{
+    const size_t filteredMips = numMips > mipDrop ? numMips - mipDrop : 1;
+    if (filteredMips < 2)
+        return mipId == 0 ? 0.0f : 1.0f;
+    return std::min(float(mipId) / float(filteredMips - 1), 1.0f);
+}
+
+TextureImagePtr
+CubemapPrefilter::prefilterSpecular(const Settings& settings) const
+{
+    const size_t size = std::max<size_t>(settings.specularResolution, 1);
+    const size_t numMips = levelCount(size);
+
+    TextureImagePtr cube(new TextureImage());
+    cube->create(Vector2i(int32_t(size), int32_t(size)), PF_FLOAT32_RGBA, uint32_t(numMips - 1), IF_CUBEMAP);
+
+    SampleSet samples;
+    float sampledRoughness = -1.0f;
+    for (size_t mipId = 0; mipId < numMips; ++mipId)
+    {
+        const float roughness = mipRoughness(mipId, numMips, settings.mipDrop);
+        if (roughness > 0.0f)
+        {
+            // The mips past the drop share roughness 1.
+            if (roughness != sampledRoughness)
+            {
+                ggxSamples(roughness, settings.sampleCount, samples);
+                sampledRoughness = roughness;
+            }
+            convolve(*cube, mipId, samples, 0.0f);
+        }
+        else
+        {
+            // A mirror, resample the source at the texel footprint.
+            const size_t mipSize = std::max<size_t>(size >> mipId, 1);
+            const float lod = std::max(std::log2(float(_sourceSize) / float(mipSize)), 0.0f);
+            convolve(*cube, mipId, SampleSet(), lod);
+        }
+    }
+    return finish(cube, settings);
+}
+
+TextureImagePtr
+CubemapPrefilter::irradiance(const Settings& settings) const
+{
+    const size_t size = std::max<size_t>(settings.diffuseResolution, 1);
+
+    TextureImagePtr cube(new TextureImage());
+    cube->create(Vector2i(int32_t(size), int32_t(size)), PF_FLOAT32_RGBA, 0, IF_CUBEMAP);
+
+    SampleSet samples;
+    cosineSamples(settings.sampleCount, samples);
+    convolve(*cube, 0, samples, 0.0f);
+    return finish(cube, settings);
+}
+
+void
+CubemapPrefilter::ggxSamples(float roughness, size_t sampleCount, SampleSet& samples) const
+{
+    samples = SampleSet();
+    sampleCount = std::max<size_t>(sampleCount, 1);
+
+    const float alpha = roughness * roughness;
+    const float alpha2 = alpha * alpha;
+    const float texelSolidAngle = 4.0f * Pi / (6.0f * float(_sourceSize * _sourceSize));
+    for (size_t sampleId = 0; sampleId < sampleCount; ++sampleId)
+    {
+        const float e1 = float(sampleId) / float(sampleCount);
+        const float e2 = radicalInverse(uint32_t(sampleId));
+        const float phi = 2.0f * Pi * e1;
+        const float cosTheta = std::sqrt((1.0f - e2) / (1.0f + (alpha2 - 1.0f) * e2));
+        const float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+
+        // N = V, so L is H reflected about the normal.
+        const float hx = sinTheta * std::cos(phi);
+        const float hy = sinTheta * std::sin(phi);
+        const float nDotL = 2.0f * cosTheta * cosTheta - 1.0f;
+        if (nDotL <= 0.0f)
+            continue;
+
+        // pdf(L) = D(H) * NdotH / (4 * VdotH) = D(H) / 4.
+        const float d = cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f;
+        const float pdf = alpha2 / (Pi * d * d) * 0.25f;
+
+        samples.x.push_back(2.0f * cosTheta * hx);
+        samples.y.push_back(2.0f * cosTheta * hy);
+        samples.z.push_back(nDotL);
+        samples.weight.push_back(nDotL);
+        samples.lod.push_back(sampleLod(pdf, sampleCount, texelSolidAngle));
+    }
+
+    pad(samples.x, 0.0f);
+    pad(samples.y, 0.0f);
+    pad(samples.z, 1.0f);
+    pad(samples.weight, 0.0f);
+    pad(samples.lod, 0.0f);
+}
+
+void
+CubemapPrefilter::cosineSamples(size_t sampleCount, SampleSet& samples) const
+{
+    samples = SampleSet();
+    sampleCount = std::max<size_t>(sampleCount, 1);
+
+    const float texelSolidAngle = 4.0f * Pi / (6.0f * float(_sourceSize * _sourceSize));
+    for (size_t sampleId = 0; sampleId < sampleCount; ++sampleId)
+    {
+        const float e1 = float(sampleId) / float(sampleCount);
+        const float e2 = radicalInverse(uint32_t(sampleId));
+        const float phi = 2.0f * Pi * e1;
+        const float cosTheta = std::sqrt(1.0f - e2);
+        const float sinTheta = std::sqrt(e2);
+        if (cosTheta <= 0.0f)
+            continue;
+
+        // The cosine is in the pdf, every sample has the same weight.
+        samples.x.push_back(sinTheta * std::cos(phi));
+        samples.y.push_back(sinTheta * std::sin(phi));
+        samples.z.push_back(cosTheta);
+        samples.weight.push_back(1.0f);
+        samples.lod.push_back(sampleLod(cosTheta / Pi, sampleCount, texelSolidAngle));
+    }
+
+    pad(samples.x, 0.0f);
+    pad(samples.y, 0.0f);
+    pad(samples.z, 1.0f);
+    pad(samples.weight, 0.0f);
+    pad(samples.lod, 0.0f);
+}
+
+void
+CubemapPrefilter::convolve(TextureImage& target, size_t mipId,
+                           const SampleSet& samples, float lod) const
+{
+    std::vector<PixelBox> faces;
+    for (size_t face = 0; face < 6; ++face)
+        faces.push_back(target.getWritablePixelBox(face, mipId));
+
+    const size_t size = faces[0].size().x;
+    const size_t tiles = (size + TileSize - 1) / TileSize;
+    const size_t sampleCount = samples.weight.size();
+
+    concurrency::parallel_for(size_t(0), 6 * tiles * tiles, [&](size_t tile)
+    {
+        const size_t face = tile / (tiles * tiles);
+        const size_t tileX = (tile % tiles) * TileSize;
+        const size_t tileY = ((tile / tiles) % tiles) * TileSize;
+        const size_t columns = std::min<size_t>(TileSize, size - tileX);
+        const size_t rows = std::min<size_t>(TileSize, size - tileY);
+
+        float us[TileSize];
+        float normals[3][TileSize];
+        std::vector<float> directions(sampleCount * 3);
+        float* dx = sampleCount > 0 ? &directions[0] : nullptr;
+        float* dy = dx + sampleCount;
+        float* dz = dy + sampleCount;
+
+        for (size_t x = 0; x < columns; ++x)
+            us[x] = (float(tileX + x) + 0.5f) * 2.0f / float(size) - 1.0f;
+
+        const PixelBox& box = faces[face];
+        for (size_t y = tileY; y < tileY + rows; ++y)
+        {
+            const float v = (float(y) + 0.5f) * 2.0f / float(size) - 1.0f;
+            CubemapConversion::faceDirections(face, v, us, columns, normals[0], normals[1], normals[2]);
+
+            float* dst = static_cast<float*>(box.data) + (y * box.rowPitch + tileX) * 4;
+            for (size_t x = 0; x < columns; ++x, dst += 4)
+            {
+                const float normal[3] = { normals[0][x], normals[1][x], normals[2][x] };
+                if (sampleCount == 0)
+                {
+                    sample(normal[0], normal[1], normal[2], lod, dst);
+                    continue;
+                }
+
+                // tangent = normalize(cross(up, normal)).
+                const bool zUp = std::fabs(normal[2]) < 0.999f;
+                float tangent[3] = { zUp ? -normal[1] : 0.0f,
+                                     zUp ? normal[0] : -normal[2],
+                                     zUp ? 0.0f : normal[1] };
+                const float inverse = 1.0f / std::sqrt(tangent[0] * tangent[0] + 
+                                                       tangent[1] * tangent[1] + 
+                                                       tangent[2] * tangent[2]);
+                tangent[0] *= inverse;
+                tangent[1] *= inverse;
+                tangent[2] *= inverse;
+                const float bitangent[3] = { normal[1] * tangent[2] - normal[2] * tangent[1],
+                                             normal[2] * tangent[0] - normal[0] * tangent[2],
+                                             normal[0] * tangent[1] - normal[1] * tangent[0] };
+
+                rotateSamples(&samples.x[0], &samples.y[0], &samples.z[0], sampleCount,
+                              tangent, bitangent, normal, dx, dy, dz);
+
+                float accum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                float totalWeight = 0.0f;
+                for (size_t sampleId = 0; sampleId < sampleCount; ++sampleId)
+                {
+                    const float weight = samples.weight[sampleId];
+                    if (weight <= 0.0f)
+                        continue;
+
+                    float color[4];
+                    sample(dx[sampleId], dy[sampleId], dz[sampleId], samples.lod[sampleId], color);
+                    accum[0] += color[0] * weight;
+                    accum[1] += color[1] * weight;
+                    accum[2] += color[2] * weight;
+                    accum[3] += color[3] * weight;
+                    totalWeight += weight;
+                }
+
+                const float scale = totalWeight > 0.0f ? 1.0f / totalWeight : 0.0f;
+                dst[0] = accum[0] * scale;
+                dst[1] = accum[1] * scale;
+                dst[2] = accum[2] * scale;
+                dst[3] = accum[3] * scale;
+            }
+        }
+    });
+}
+
+void
+CubemapPrefilter::sample(float x, float y, float z, float lod, float* color) const
+{
+    lod = std::min(std::max(lod, 0.0f), float(_sourceLevels - 1));
+    const size_t level = size_t(lod);
+    const float fraction = lod - float(level);
+
+    sampleLevel(level, x, y, z, color);
+    if (fraction > 0.0f && level + 1 < _sourceLevels)
+    {
+        float next[4];
+        sampleLevel(level + 1, x, y, z, next);
+        for (size_t channel = 0; channel < 4; ++channel)
+            color[channel] += (next[channel] - color[channel]) * fraction;
+    }
+}
+
+void
+CubemapPrefilter::sampleLevel(size_t level, float x, float y, float z, float* color) const
+{
+    float u, v;
+    const size_t face = CubemapConversion::directionToFace(x, y, z, u, v);
+    const size_t size = std::max<size_t>(_sourceSize >> level, 1);
+    const float* texels = _texels[face * _sourceLevels + level];
+
+    // Bilinear within the face, the seams are left to the edge fixup.
+    const float maxCoord = float(size - 1);
+    const float px = std::min(std::max((u * 0.5f + 0.5f) * float(size) - 0.5f, 0.0f), maxCoord);
+    const float py = std::min(std::max((v * 0.5f + 0.5f) * float(size) - 0.5f, 0.0f), maxCoord);
+    const size_t x0 = size_t(px);
+    const size_t y0 = size_t(py);
+    const size_t x1 = std::min(x0 + 1, size - 1);
+    const size_t y1 = std::min(y0 + 1, size - 1);
+    const float fx = px - float(x0);
+    const float fy = py - float(y0);
+
+    const float* t00 = texels + (y0 * size + x0) * 4;
+    const float* t10 = texels + (y0 * size + x1) * 4;
+    const float* t01 = texels + (y1 * size + x0) * 4;
+    const float* t11 = texels + (y1 * size + x1) * 4;
+#if CTR_SSE2
+    const __m128 top = _mm_add_ps(_mm_loadu_ps(t00), 
+                                  _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(t10), _mm_loadu_ps(t00)), _mm_set1_ps(fx)));
+    const __m128 bottom = _mm_add_ps(_mm_loadu_ps(t01), 
+                                     _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(t11), _mm_loadu_ps(t01)), _mm_set1_ps(fx)));
+    _mm_storeu_ps(color, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(fy))));
+#else
+    for (size_t channel = 0; channel < 4; ++channel)
+    {
+        const float top = t00[channel] + (t10[channel] - t00[channel]) * fx;
+        const float bottom = t01[channel] + (t11[channel] - t01[channel]) * fx;
+        color[channel] = top + (bottom - top) * fy;
+    }
+#endif
+}
+
+TextureImagePtr
+CubemapPrefilter::finish(const TextureImagePtr& cube, const Settings& settings) const
+{
+    if (settings.seamlessBilinear)
+    {
+        CubemapSeams::seamlessBilinear(*cube);
+    }
+    else
+    {
+        CubemapSeams::fixup(*cube, settings.fixupType, settings.fixupWidth);
+    }
+
+    if (settings.format == PF_FLOAT32_RGBA || settings.format == PF_UNKNOWN)
+        return cube;
+
+    TextureImagePtr converted(new TextureImage());
+    converted->create(Vector2i(int32_t(cube->getWidth()), int32_t(cube->getHeight())), 
+                      settings.format, uint32_t(cube->getNumMipmaps()), IF_CUBEMAP);
+    for (size_t face = 0; face < 6; ++face)
+    {
+        for (size_t mipId = 0; mipId <= cube->getNumMipmaps(); ++mipId)
+        {
+            PixelUtil::bulkPixelConversion(cube->getPixelBox(face, mipId).source(), converted->getWritablePixelBox(face, mipId));
+        }
+    }
+    return converted;
+}
+}
@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_CUBEMAP_PREFILTER
+#define INCLUDED_CRT_CUBEMAP_PREFILTER
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+#include <CtrTextureImage.h>
+#include <CtrFilterCubemap.h>
+#include <vector>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// CPU reference for the IBLRenderPass convolutions, so probes can
+// be baked without a device.
+// Specular mips are GGX prefiltered and the irradiance cube is cosine
+// convolved, both with filtered importance sampling from a mip chain
+// of the source cube. Faces are split into texel tiles that are
+// filtered in parallel, samples are rotated into place four at a time
+// with SSE2.
+//-----------------------------------------------------------------
+class CubemapPrefilter
+{
+  public:
+    enum
+    {
+        TileSize = 16
+    };
+
+    // Mirrors the IBLProbe properties (see IBLProbe::prefilterSettings).
+    struct Settings
+    {
+        Settings();
+
+        size_t                 specularResolution;
+        size_t                 diffuseResolution;
+        size_t                 sampleCount;
+        // Roughness reaches 1 at mip (mips - mipDrop - 1), 
+        // the mips below that are filtered at roughness 1.
+        size_t                 mipDrop;
+        PixelFormat            format;
+        CubemapFixupType       fixupType;
+        // Fraction of each mip size, at least one texel.
+        float                  fixupWidth;
+        // Resample every mip for seamless bilinear filtering instead of 
+        // the edge fixup (see CubemapSeams::seamlessBilinear).
+        bool                   seamlessBilinear;
+    };
+
+    // source must be an uncompressed cube map, only its top level is used.
+    CubemapPrefilter(const TextureImage& source);
+    virtual ~CubemapPrefilter();
+
+    // Specular cube map with a full mip chain, the roughness of each
+    // mip is mip / (mips - mipDrop - 1) as in IBLRenderPass::refineSpecular.
+    TextureImagePtr            prefilterSpecular(const Settings& settings) const;
+
+    // Diffuse cube map, the cosine weighted mean of the radiance 
+    // over the hemisphere around each texel (irradiance / pi).
+    TextureImagePtr            irradiance(const Settings& settings) const;
+
+    // GGX roughness of a specular mip.
+    static float               mipRoughness(size_t mipId, size_t numMips, size_t mipDrop);
+
+  protected:
+    // Importance samples in tangent space (z along the normal), 
+    // padded to a multiple of four with zero weight.
+    struct SampleSet
+    {
+        std::vector<float>     x;
+        std::vector<float>     y;
+        std::vector<float>     z;
+        std::vector<float>     weight;
+        std::vector<float>     lod;
+    };
+
+    void                       ggxSamples(float roughness, size_t sampleCount, 
+                                          SampleSet& samples) const;
+    void                       cosineSamples(size_t sampleCount, 
+                                             SampleSet& samples) const;
+
+    // Convolves every texel of level mipId of target with samples, or
+    // samples the source at lod when samples is empty.
+    void                       convolve(TextureImage& target, size_t mipId,
+                                        const SampleSet& samples, float lod) const;
+
+    // Trilinear lookup of the source along a unit direction.
+    void                       sample(float x, float y, float z, float lod, 
+                                      float* color) const;
+    void                       sampleLevel(size_t level, float x, float y, float z,
+                                           float* color) const;
+
+    // Converts a float32 RGBA cube to format and fixes up the seams.
+    TextureImagePtr            finish(const TextureImagePtr& cube, 
+                                      const Settings& settings) const;
+
+    // Float32 RGBA copy of the source with a full mip chain.
+    TextureImage               _source;
+    size_t                     _sourceSize;
+    size_t                     _sourceLevels;
+    // Texels of each face and level, indexed by face * _sourceLevels + level.
+    std::vector<const float*>  _texels;
+};
+}
+
+#endif
@@ -0,0 +1,518 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrFilterCubemap.h>
+#include <CtrCubemapConversion.h>
+#include <CtrBitwise.h>
+#include <ppl.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Ctr
+{
+namespace
+{
+const CPCubeMapNeighbor sg_CubeNgh[6][4] =
+{
+    //XPOS face
+    {{CP_FACE_Z_POS, CP_EDGE_RIGHT },
+     {CP_FACE_Z_NEG, CP_EDGE_LEFT  },
+     {CP_FACE_Y_POS, CP_EDGE_RIGHT },
+     {CP_FACE_Y_NEG, CP_EDGE_RIGHT }},
+    //XNEG face
+    {{CP_FACE_Z_NEG, CP_EDGE_RIGHT },
+     {CP_FACE_Z_POS, CP_EDGE_LEFT  },
+     {CP_FACE_Y_POS, CP_EDGE_LEFT  },
+     {CP_FACE_Y_NEG, CP_EDGE_LEFT  }},
+    //YPOS face
+    {{CP_FACE_X_NEG, CP_EDGE_TOP },
+     {CP_FACE_X_POS, CP_EDGE_TOP },
+     {CP_FACE_Z_NEG, CP_EDGE_TOP },
+     {CP_FACE_Z_POS, CP_EDGE_TOP }},
+    //YNEG face
+    {{CP_FACE_X_NEG, CP_EDGE_BOTTOM},
+     {CP_FACE_X_POS, CP_EDGE_BOTTOM},
+     {CP_FACE_Z_POS, CP_EDGE_BOTTOM},
+     {CP_FACE_Z_NEG, CP_EDGE_BOTTOM}},
+    //ZPOS face
+    {{CP_FACE_X_NEG, CP_EDGE_RIGHT  },
+     {CP_FACE_X_POS, CP_EDGE_LEFT   },
+     {CP_FACE_Y_POS, CP_EDGE_BOTTOM },
+     {CP_FACE_Y_NEG, CP_EDGE_TOP    }},
+    //ZNEG face
+    {{CP_FACE_X_POS, CP_EDGE_RIGHT  },
+     {CP_FACE_X_NEG, CP_EDGE_LEFT   },
+     {CP_FACE_Y_POS, CP_EDGE_TOP    },
+     {CP_FACE_Y_NEG, CP_EDGE_BOTTOM }}
+};
+
+//The 12 edges of the cubemap, (entries are used to index into the neighbor table)
+// this table is used to average over the edges.
+const int32_t sg_CubeEdgeList[12][2] = {
+   {CP_FACE_X_POS, CP_EDGE_LEFT},
+   {CP_FACE_X_POS, CP_EDGE_RIGHT},
+   {CP_FACE_X_POS, CP_EDGE_TOP},
+   {CP_FACE_X_POS, CP_EDGE_BOTTOM},
+
+   {CP_FACE_X_NEG, CP_EDGE_LEFT},
+   {CP_FACE_X_NEG, CP_EDGE_RIGHT},
+   {CP_FACE_X_NEG, CP_EDGE_TOP},
+   {CP_FACE_X_NEG, CP_EDGE_BOTTOM},
+
+   {CP_FACE_Z_POS, CP_EDGE_TOP},
+   {CP_FACE_Z_POS, CP_EDGE_BOTTOM},
+   {CP_FACE_Z_NEG, CP_EDGE_TOP},
+   {CP_FACE_Z_NEG, CP_EDGE_BOTTOM}
+};
+
+const int32_t sg_CubeCornerList[6][4] = {
+   { CP_CORNER_PPP, CP_CORNER_PPN, CP_CORNER_PNP, CP_CORNER_PNN }, // XPOS face
+   { CP_CORNER_NPN, CP_CORNER_NPP, CP_CORNER_NNN, CP_CORNER_NNP }, // XNEG face
+   { CP_CORNER_NPN, CP_CORNER_PPN, CP_CORNER_NPP, CP_CORNER_PPP }, // YPOS face
+   { CP_CORNER_NNP, CP_CORNER_PNP, CP_CORNER_NNN, CP_CORNER_PNN }, // YNEG face
+   { CP_CORNER_NPP, CP_CORNER_PPP, CP_CORNER_NNP, CP_CORNER_PNP }, // ZPOS face
+   { CP_CORNER_PPN, CP_CORNER_NPN, CP_CORNER_PNN, CP_CORNER_NNN }  // ZNEG face
+};
+
+// Corners and the 12 edges of a level are independent tasks.
+const size_t CornerTask = 12;
+const size_t TasksPerLevel = 13;
+
+//-----------------------------------------------------------------
+// One level of a cube map, texels are read and written as float RGBA.
+//-----------------------------------------------------------------
+struct CubeLevel
+{
+    CubeLevel(TextureImage& cubemap, size_t mipId)
+    {
+        for (size_t face = 0; face < 6; ++face)
+        {
+            PixelBox box = cubemap.getWritablePixelBox(face, mipId);
+            faces[face] = (uint8_t*)(box.data);
+            if (face == 0)
+            {
+                size = box.size().x;
+                rowPitch = box.rowPitch;
+            }
+        }
+        format = cubemap.getFormat();
+        elemBytes = PixelUtil::getNumElemBytes(format);
+    }
+
+    uint8_t*
+    texel(size_t face, size_t x, size_t y) const
+    {
+        return faces[face] + (y * rowPitch + x) * elemBytes;
+    }
+
+    void
+    load(const uint8_t* src, float* color) const
+    {
+        switch (format)
+        {
+            case PF_FLOAT32_RGBA:
+                memcpy(color, src, sizeof(float) * 4);
+                break;
+            case PF_FLOAT16_RGBA:
+                Bitwise::halfToFloat((const uint16_t*)(src), color, 4);
+                break;
+            default:
+                PixelUtil::unpackColor(&color[0], &color[1], &color[2], &color[3], format, src);
+                break;
+        }
+    }
+
+    void
+    store(const float* color, uint8_t* dst) const
+    {
+        switch (format)
+        {
+            case PF_FLOAT32_RGBA:
+                memcpy(dst, color, sizeof(float) * 4);
+                break;
+            case PF_FLOAT16_RGBA:
+                Bitwise::floatToHalf(color, (uint16_t*)(dst), 4);
+                break;
+            default:
+                PixelUtil::packColor(color[0], color[1], color[2], color[3], format, dst);
+                break;
+        }
+    }
+
+    // Texel at depth texels in from edge, j texels along it.
+    uint8_t*
+    edgeTexel(size_t face, int32_t edge, size_t j, size_t depth) const
+    {
+        switch (edge)
+        {
+            case CP_EDGE_LEFT:
+                return texel(face, depth, j);
+            case CP_EDGE_RIGHT:
+                return texel(face, size - 1 - depth, j);
+            case CP_EDGE_TOP:
+                return texel(face, j, depth);
+            default:
+                return texel(face, j, size - 1 - depth);
+        }
+    }
+
+    uint8_t*                   faces[6];
+    size_t                     size;
+    size_t                     rowPitch;
+    size_t                     elemBytes;
+    PixelFormat                format;
+};
+
+inline void
+average(const float* a, const float* b, float* result)
+{
+#if CTR_SSE2
+    _mm_storeu_ps(result, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)), _mm_set1_ps(0.5f)));
+#else
+    for (size_t channel = 0; channel < 4; ++channel)
+        result[channel] = 0.5f * (a[channel] + b[channel]);
+#endif
+}
+
+// texel -= weight * (reference - average)
+inline void
+blendTexel(float* texel, const float* reference, const float* average, float weight)
+{
+#if CTR_SSE2
+    const __m128 deviation = _mm_sub_ps(_mm_loadu_ps(reference), _mm_loadu_ps(average));
+    _mm_storeu_ps(texel, _mm_sub_ps(_mm_loadu_ps(texel), _mm_mul_ps(deviation, _mm_set1_ps(weight))));
+#else
+    for (size_t channel = 0; channel < 4; ++channel)
+        texel[channel] -= weight * (reference[channel] - average[channel]);
+#endif
+}
+
+void
+fixupCorners(const CubeLevel& level)
+{
+    const size_t last = level.size - 1;
+
+    //special case 1x1 cubemap, average face colors
+    if (level.size == 1)
+    {
+        float accum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (size_t faceId = 0; faceId < 6; ++faceId)
+        {
+            float color[4];
+            level.load(level.texel(faceId, 0, 0), color);
+            for (size_t channel = 0; channel < 4; ++channel)
+                accum[channel] += color[channel] * (1.0f / 6.0f);
+        }
+        for (size_t faceId = 0; faceId < 6; ++faceId)
+            level.store(accum, level.texel(faceId, 0, 0));
+        return;
+    }
+
+    uint8_t* cornerPtr[8][3];
+    size_t cornerNumPtrs[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (size_t faceId = 0; faceId < 6; ++faceId)
+    {
+        uint8_t* faceCornerPtrs[4] = { level.texel(faceId, 0, 0),
+                                       level.texel(faceId, last, 0),
+                                       level.texel(faceId, 0, last),
+                                       level.texel(faceId, last, last) };
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const int32_t corner = sg_CubeCornerList[faceId][i];
+            cornerPtr[corner][cornerNumPtrs[corner]++] = faceCornerPtrs[i];
+        }
+    }
+
+    for (size_t cornerId = 0; cornerId < 8; ++cornerId)
+    {
+        float accum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (size_t i = 0; i < 3; ++i)
+        {
+            float color[4];
+            level.load(cornerPtr[cornerId][i], color);
+            for (size_t channel = 0; channel < 4; ++channel)
+                accum[channel] += color[channel] * (1.0f / 3.0f);
+        }
+        for (size_t i = 0; i < 3; ++i)
+            level.store(accum, cornerPtr[cornerId][i]);
+    }
+}
+
+void
+fixupEdge(const CubeLevel& level, size_t edgeId, 
+          CubemapFixupType fixupType, int32_t fixupDist)
+{
+    const size_t size = level.size;
+    const size_t face = sg_CubeEdgeList[edgeId][0];
+    const int32_t edge = sg_CubeEdgeList[edgeId][1];
+    const CPCubeMapNeighbor& neighborInfo = sg_CubeNgh[face][edge];
+    const size_t neighborFace = neighborInfo.m_Face;
+    const int32_t neighborEdge = neighborInfo.m_Edge;
+
+    //If the edge enums are the same, or the sum of the enums == 3, 
+    //  the neighbor edge walk needs to be flipped
+    const bool flip = (edge == neighborEdge) || ((edge + neighborEdge) == 3);
+    const bool averageTaps = fixupType == CP_FIXUP_AVERAGE_LINEAR || 
+                         fixupType == CP_FIXUP_AVERAGE_HERMITE;
+    const bool hermite = fixupType == CP_FIXUP_AVERAGE_HERMITE || 
+                         fixupType == CP_FIXUP_PULL_HERMITE;
+    const bool vertical = edge == CP_EDGE_LEFT || edge == CP_EDGE_RIGHT;
+    const bool neighborVertical = neighborEdge == CP_EDGE_LEFT || neighborEdge == CP_EDGE_RIGHT;
+
+    // note that this loop does not process the corner texels, since they have already been
+    //  averaged across faces across earlier
+    for (size_t j = 1; j + 1 < size; ++j)
+    {
+        const size_t neighborJ = flip ? size - 1 - j : j;
+        uint8_t* edgePtr = level.edgeTexel(face, edge, j, 0);
+        uint8_t* neighborEdgePtr = level.edgeTexel(neighborFace, neighborEdge, neighborJ, 0);
+
+        float edgeTap[4], neighborEdgeTap[4], avgTap[4];
+        level.load(edgePtr, edgeTap);
+        level.load(neighborEdgePtr, neighborEdgeTap);
+        average(edgeTap, neighborEdgeTap, avgTap);
+        level.store(avgTap, edgePtr);
+        level.store(avgTap, neighborEdgePtr);
+
+        // Only the texels closer to this edge than to the two adjacent edges
+        // are blended, the wedges of the 24 face edges do not overlap.
+        // The diagonals of the corner squares, equally close to two 
+        // edges, belong to the left and right edges.
+        const size_t wedge = std::min(j, size - 1 - j);
+        const size_t depth = std::min<size_t>(fixupDist, wedge + (vertical ? 1 : 0));
+        const size_t neighborDepth = std::min<size_t>(fixupDist, wedge + (neighborVertical ? 1 : 0));
+        for (size_t iFixup = 1; iFixup < std::max(depth, neighborDepth); ++iFixup)
+        {
+            //fractional amount to apply change in tap intensity along edge to taps 
+            //  in a perpendicular direction to edge 
+            const float fixupFrac = float(fixupDist - int32_t(iFixup)) / float(fixupDist);
+            //hermite spline interpolation between 1 and 0 with both pts derivatives = 0 
+            //  p(t) =  - 2t^3 + 3t^2
+            const float fixupWeight = hermite ? (-2.0f * fixupFrac + 3.0f) * fixupFrac * fixupFrac : 
+                                                fixupFrac;
+
+            uint8_t* tapPtr = level.edgeTexel(face, edge, j, iFixup);
+            uint8_t* neighborTapPtr = level.edgeTexel(neighborFace, neighborEdge, neighborJ, iFixup);
+            float tap[4], neighborTap[4];
+            level.load(tapPtr, tap);
+            level.load(neighborTapPtr, neighborTap);
+
+            // vary intensity of taps within fixup region toward edge values to hide changes made to edge taps
+            if (iFixup < depth)
+            {
+                blendTexel(tap, averageTaps ? tap : edgeTap, avgTap, fixupWeight);
+                level.store(tap, tapPtr);
+            }
+            if (iFixup < neighborDepth)
+            {
+                blendTexel(neighborTap, averageTaps ? neighborTap : neighborEdgeTap, avgTap, fixupWeight);
+                level.store(neighborTap, neighborTapPtr);
+            }
+        }
+    }
+}
+
+void
+fixupTask(const CubeLevel& level, size_t taskId, 
+          CubemapFixupType fixupType, float fixupWidth)
+{
+    if (taskId == CornerTask)
+    {
+        fixupCorners(level);
+        return;
+    }
+
+    //maximum width of fixup region is one half of the cube face size
+    const int32_t fixupDist = (int32_t)Ctr::minValue(fixupWidth, (float)(level.size / 2.0f));
+    fixupEdge(level, taskId, fixupType, fixupDist);
+}
+
+void
+validate(const TextureImage& cubemap, const char* method)
+{
+    if (!cubemap.hasFlag(IF_CUBEMAP) || cubemap.getNumFaces() != 6)
+    {
+        throw(std::exception((std::string("Source is not a cube map - CubemapSeams::") + method).c_str()));
+    }
+    if (PixelUtil::isCompressed(cubemap.getFormat()))
+    {
+        throw(std::exception((std::string("Cannot fix the seams of a compressed cube map - CubemapSeams::") + method).c_str()));
+    }
+}
+}
+
+void
+CubemapSeams::fixup(TextureImage& cubemap, 
+                    CubemapFixupType fixupType, 
+                    float relativeFixupWidth)
+{
+    //if there is no fixup, or fixup width = 0, do nothing
+    if (fixupType == CP_FIXUP_NONE || relativeFixupWidth == 0)
+        return;
+    validate(cubemap, "fixup");
+
+    std::vector<CubeLevel> levels;
+    std::vector<float> fixupWidths;
+    for (size_t mipId = 0; mipId <= cubemap.getNumMipmaps(); ++mipId)
+    {
+        levels.push_back(CubeLevel(cubemap, mipId));
+        fixupWidths.push_back(Ctr::maxValue(float(levels.back().size) * relativeFixupWidth, 1.0f));
+    }
+
+    concurrency::parallel_for(size_t(0), levels.size() * TasksPerLevel, [&](size_t taskId)
+    {
+        const size_t levelId = taskId / TasksPerLevel;
+        fixupTask(levels[levelId], taskId % TasksPerLevel, fixupType, fixupWidths[levelId]);
+    });
+}
+
+void
+CubemapSeams::fixupLevel(TextureImage& cubemap, 
+                         size_t mipId,
+                         CubemapFixupType fixupType, 
+                         float fixupWidth)
+{
+    if (fixupType == CP_FIXUP_NONE || fixupWidth == 0)
+        return;
+    validate(cubemap, "fixupLevel");
+
+    const CubeLevel level(cubemap, mipId);
+    concurrency::parallel_for(size_t(0), TasksPerLevel, [&](size_t taskId)
+    {
+        fixupTask(level, taskId, fixupType, fixupWidth);
+    });
+}
+
+void
+CubemapSeams::seamlessBilinear(TextureImage& cubemap)
+{
+    validate(cubemap, "seamlessBilinear");
+    for (size_t mipId = 0; mipId <= cubemap.getNumMipmaps(); ++mipId)
+        seamlessBilinearLevel(cubemap, mipId);
+}
+
+void
+CubemapSeams::seamlessBilinearLevel(TextureImage& cubemap, size_t mipId)
+{
+    validate(cubemap, "seamlessBilinearLevel");
+
+    const CubeLevel level(cubemap, mipId);
+    const size_t size = level.size;
+    if (size > 1)
+    {
+        const size_t faceTexels = size * size;
+        std::vector<float> source(6 * faceTexels * 4);
+        std::vector<float> result(6 * faceTexels * 4);
+        concurrency::parallel_for(size_t(0), 6 * size, [&](size_t row)
+        {
+            const size_t face = row / size;
+            const size_t y = row % size;
+            for (size_t x = 0; x < size; ++x)
+                level.load(level.texel(face, x, y), &source[((face * size + y) * size + x) * 4]);
+        });
+
+        // Texel (x, y) of face, texels outside of the face are taken
+        // from the neighbouring face that the direction through them hits.
+        auto fetch = [&](size_t face, int32_t x, int32_t y) -> const float*
+        {
+            if (x < 0 || y < 0 || x >= int32_t(size) || y >= int32_t(size))
+            {
+                const float u = float(2 * x + 1) / float(size) - 1.0f;
+                const float v = float(2 * y + 1) / float(size) - 1.0f;
+                float dx, dy, dz, nu, nv;
+                CubemapConversion::faceDirections(face, v, &u, 1, &dx, &dy, &dz);
+                face = CubemapConversion::directionToFace(dx, dy, dz, nu, nv);
+                x = std::min(std::max(int32_t((nu * 0.5f + 0.5f) * float(size)), 0), int32_t(size) - 1);
+                y = std::min(std::max(int32_t((nv * 0.5f + 0.5f) * float(size)), 0), int32_t(size) - 1);
+            }
+            return &source[((face * size + y) * size + x) * 4];
+        };
+
+        // Stretch the face so that the outer texel centres land on the face edges.
+        const float scale = float(size) / float(size - 1);
+        concurrency::parallel_for(size_t(0), 6 * size, [&](size_t row)
+        {
+            const size_t face = row / size;
+            const size_t y = row % size;
+            const float py = float(y) * scale - 0.5f;
+            const int32_t y0 = int32_t(std::floor(py));
+            const float fy = py - float(y0);
+            for (size_t x = 0; x < size; ++x)
+            {
+                const float px = float(x) * scale - 0.5f;
+                const int32_t x0 = int32_t(std::floor(px));
+                const float fx = px - float(x0);
+
+                const float* t00 = fetch(face, x0, y0);
+                const float* t10 = fetch(face, x0 + 1, y0);
+                const float* t01 = fetch(face, x0, y0 + 1);
+                const float* t11 = fetch(face, x0 + 1, y0 + 1);
+                float* color = &result[((face * size + y) * size + x) * 4];
+#if CTR_SSE2
+                const __m128 top = _mm_add_ps(_mm_loadu_ps(t00), 
+                                              _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(t10), _mm_loadu_ps(t00)), _mm_set1_ps(fx)));
+                const __m128 bottom = _mm_add_ps(_mm_loadu_ps(t01), 
+                                                 _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(t11), _mm_loadu_ps(t01)), _mm_set1_ps(fx)));
+                _mm_storeu_ps(color, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(fy))));
+#else
+                for (size_t channel = 0; channel < 4; ++channel)
+                {
+                    const float top = t00[channel] + (t10[channel] - t00[channel]) * fx;
+                    const float bottom = t01[channel] + (t11[channel] - t01[channel]) * fx;
+                    color[channel] = top + (bottom - top) * fy;
+                }
+#endif
+            }
+            for (size_t x = 0; x < size; ++x)
+                level.store(&result[((face * size + y) * size + x) * 4], level.texel(face, x, y));
+        });
+    }
+
+    // The edge and corner texels of neighbouring faces now sample the same 
+    // points, averaging them removes what is left of the differences.
+    const CubemapFixupType fixupType = CP_FIXUP_AVERAGE_LINEAR;
+    concurrency::parallel_for(size_t(0), TasksPerLevel, [&](size_t taskId)
+    {
+        fixupTask(level, taskId, fixupType, 1.0f);
+    });
+}
+}
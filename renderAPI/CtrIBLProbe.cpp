@@ -47,6 +47,8 @@
 #include <CtrPostEffectsMgr.h>
 #include <CtrScene.h>
 #include <CtrMatrixAlgo.h>
+#include <CtrImageStatistics.h>
+#include <CtrLog.h>
 #include <MurmurHash.h>
 #include <Ctrimgui.h>
 
@@ -73,6 +75,12 @@ ImguiEnumVal IblSourceResolutionEnum[] =
 
 static const EnumTweakType IblSourceResolutionType(&IblSourceResolutionEnum[0], 6, "SourceResolution");
 
+// Face size the environment is projected into spherical harmonics at.
+static const uint32_t IrradianceSHResolution = 64;
+
+// Frames between requesting the environment readback and reading it.
+static const uint32_t ReadLatency = 2;
+
 IBLProbe::IBLProbe(Ctr::IDevice * device) : 
     Ctr::TransformNode(device),
     _environmentCubeMap(nullptr),
@@ -83,6 +91,7 @@ IBLProbe::IBLProbe(Ctr::IDevice * device) :
     _cachedTranslation (Ctr::Vector3f (Ctr::Limits<float>::minimum(),Ctr::Limits<float>::minimum(),Ctr::Limits<float>::minimum())),
     _renderId(0),
     _samplesRemaining(1024),
+    _refineSamples(1024),
     _sampleCountProperty(new Ctr::IntProperty(this, "Total Samples", new Ctr::TweakFlags(0, 16384, 1, "IBL"))),
     _samplesPerFrameProperty(new Ctr::IntProperty(this, "Samples Per Frame", new Ctr::TweakFlags(0, 16384, 1, "IBL"))),
     _markedComputedProperty(new Ctr::BoolProperty(this, "Computed")),
@@ -100,7 +109,10 @@ IBLProbe::IBLProbe(Ctr::IDevice * device) :
     _hdrPixelFormatProperty(new PixelFormatProperty(this, "HDRFormat", new TweakFlags(&IblFormatType, "IBL"))),
     _mdrPixelFormatProperty(new PixelFormatProperty(this, "MDRFormat", new TweakFlags(&IblFormatType, "IBL"))),
     _dimensionProperty(new IntProperty(this, "Dimension")),
-    _sourceResolutionProperty(new IntProperty(this, "Source Resolution", new TweakFlags(&IblSourceResolutionType, "IBL")))
+    _sourceResolutionProperty(new IntProperty(this, "Source Resolution", new TweakFlags(&IblSourceResolutionType, "IBL"))),
+    _environmentMaxValue(Ctr::Vector4f(0,0,0,0)),
+    _environmentReadPending(false),
+    _environmentReadFrame(0)
 {
     _samplesPerFrameProperty->set(1024);
     _sampleCountProperty->set(1024);
@@ -221,6 +233,96 @@ IBLProbe::maxPixelB() const
     return _maxPixelBProperty->get();
 }
 
+const Ctr::Vector4f&
+IBLProbe::environmentMaxValue() const
+{
+    return _environmentMaxValue;
+}
+
+Ctr::Vector4f
+IBLProbe::maxPixelValue() const
+{
+    return Ctr::Vector4f(maxPixelR() > 0 ? maxPixelR() : _environmentMaxValue.x,
+                         maxPixelG() > 0 ? maxPixelG() : _environmentMaxValue.y,
+                         maxPixelB() > 0 ? maxPixelB() : _environmentMaxValue.z,
+                         1.0f);
+}
+
+const Ctr::SphericalHarmonics&
+IBLProbe::irradianceSH() const
+{
+    return _irradianceSH;
+}
+
+void
+IBLProbe::requestEnvironmentRead(uint32_t frameId)
+{
+    if (const Ctr::ITexture* environment = environmentCubeMap())
+    {
+        // Textures that cannot copy asynchronously are read synchronously 
+        // once the latency has passed.
+        environment->requestRead();
+        _environmentReadPending = true;
+        _environmentReadFrame = frameId;
+    }
+}
+
+bool
+IBLProbe::environmentReadPending() const
+{
+    return _environmentReadPending;
+}
+
+bool
+IBLProbe::environmentReadReady(uint32_t frameId) const
+{
+    if (!_environmentReadPending || frameId - _environmentReadFrame < ReadLatency)
+        return false;
+
+    const Ctr::ITexture* environment = environmentCubeMap();
+    return !environment || environment->readReady();
+}
+
+void
+IBLProbe::readEnvironment()
+{
+    _environmentReadPending = false;
+    if (const Ctr::ITexture* environment = environmentCubeMap())
+    {
+        Ctr::TextureImagePtr image = environment->readImage(environment->format());
+        if (!PixelUtil::isAccessible(image->getFormat()))
+        {
+            LOG ("Unhandled format for environment statistics");
+            return;
+        }
+
+        // The brightest texel (largest rgb length) of the top level mip.
+        Ctr::ImageStatistics::Summary summary = Ctr::ImageStatistics::compute(*image, 0);
+        _environmentMaxValue = Ctr::Vector4f(summary.brightest[0], summary.brightest[1], summary.brightest[2], 0.0f);
+
+        // L2 needs little resolution, project the first mip at or below the projection size.
+        size_t mipId = 0;
+        while (mipId < image->getNumMipmaps() &&
+               (image->getWidth() >> mipId) > IrradianceSHResolution)
+        {
+            mipId++;
+        }
+        _irradianceSH = Ctr::SphericalHarmonics::project(*image, mipId).irradiance();
+    }
+}
+
+Ctr::CubemapPrefilter::Settings
+IBLProbe::prefilterSettings() const
+{
+    Ctr::CubemapPrefilter::Settings settings;
+    settings.specularResolution = size_t(Ctr::maxValue(specularResolution(), 1));
+    settings.diffuseResolution = size_t(Ctr::maxValue(diffuseResolution(), 1));
+    settings.sampleCount = size_t(Ctr::maxValue(sampleCount(), 1));
+    settings.mipDrop = size_t(Ctr::maxValue(mipDrop(), 0));
+    settings.format = hdrPixelFormat();
+    return settings;
+}
+
 Ctr::FloatProperty*
 IBLProbe::environmentScaleProperty()
 {
@@ -388,10 +490,34 @@ IBLProbe::sampleOffset() const
     return _sampleOffset;
 }
 
+int32_t
+IBLProbe::refineSamples() const
+{
+    return _refineSamples;
+}
+
+void
+IBLProbe::setRefineSamples(int32_t refineSamples)
+{
+    // The passes of a run accumulate with the same sample count.
+    if (_sampleOffset == 0)
+    {
+        _refineSamples = Ctr::maxValue(refineSamples, 1);
+    }
+}
+
+float
+IBLProbe::convergence() const
+{
+    if (computed() || _sampleCountProperty->get() <= 0)
+        return 1.0f;
+    return 1.0f - float(_samplesRemaining) / float(_sampleCountProperty->get());
+}
+
 void
 IBLProbe::updateSamples()
 {
-    _samplesRemaining -= _samplesPerFrameProperty->get();
+    _samplesRemaining -= _refineSamples;
     if (_samplesRemaining > 0)
     {
         _renderId = _renderId == 0 ? 1 : 0;
@@ -417,6 +543,7 @@ IBLProbe::uncache()
     _markedComputedProperty->set(false);
     _samplesRemaining = _sampleCountProperty->get();
     _sampleOffset = 0;
+    _refineSamples = Ctr::maxValue(_samplesPerFrameProperty->get(), 1);
     _renderId = 0;
 }
 
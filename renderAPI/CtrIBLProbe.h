@@ -49,6 +49,8 @@
 #include <CtrMatrix44.h>
 #include <CtrITexture.h>
 #include <CtrHash.h>
+#include <CtrCubemapPrefilter.h>
+#include <CtrSphericalHarmonics.h>
 
 namespace Ctr
 {
@@ -70,6 +72,14 @@ class IBLProbe : public Ctr::TransformNode
 
     void                       updateSamples();
 
+    // Samples taken by each refinement pass of the current run. Set by 
+    // the IBLScheduler before the first pass, samplesPerFrame otherwise.
+    int32_t                    refineSamples() const;
+    void                       setRefineSamples(int32_t refineSamples);
+
+    // Fraction of sampleCount taken so far.
+    float                      convergence() const;
+
     void                       markComputed(bool computed);
     bool                       isCached ();
     void                       update();
@@ -134,12 +144,37 @@ class IBLProbe : public Ctr::TransformNode
     FloatProperty*             maxPixelBProperty();
     float                      maxPixelB() const;
 
+    // Brightest texel of the environment map. Computed from the 
+    // readback, the max pixel properties above stay user values.
+    const Ctr::Vector4f&       environmentMaxValue() const;
+
+    // The max pixel properties, with the channels left at 0 taken
+    // from environmentMaxValue. Set as IBLMAXVALUE.
+    Ctr::Vector4f              maxPixelValue() const;
+
+    // L2 irradiance of the environment map (irradiance / pi, as in the 
+    // diffuse cube map).
+    const Ctr::SphericalHarmonics& irradianceSH() const;
+
+    // The environment statistics are read back asynchronously. The
+    // read is requested after the environment is rendered on frameId
+    // and is ready ReadLatency frames later, once the copy has arrived.
+    // readEnvironment then updates environmentMaxValue and irradianceSH.
+    void                       requestEnvironmentRead(uint32_t frameId);
+    bool                       environmentReadPending() const;
+    bool                       environmentReadReady(uint32_t frameId) const;
+    void                       readEnvironment();
+
     IntProperty*               sourceResolutionProperty();
     int32_t                    sourceRespolution() const;
 
     Ctr::PixelFormatProperty* hdrPixelFormatProperty();
     Ctr::PixelFormat           hdrPixelFormat() const;
 
+    // Resolutions, sample count, mip drop and format for baking 
+    // the probe on the CPU with CubemapPrefilter.
+    Ctr::CubemapPrefilter::Settings prefilterSettings() const;
+
   protected:
     void                       setupCubeMap(Ctr::RenderTextureProperty* cubeMapProperty, 
                                             IntProperty*  size, 
@@ -148,6 +183,7 @@ class IBLProbe : public Ctr::TransformNode
     int32_t                    _renderId;
     int32_t                    _samplesRemaining;
     int32_t                    _sampleOffset;
+    int32_t                    _refineSamples;
 
     // Mip drop for roughness.
     // Diffuse is encoded on export into numMips -_mipDrop as an option.
@@ -195,6 +231,12 @@ class IBLProbe : public Ctr::TransformNode
     FloatProperty*             _maxPixelGProperty;
     FloatProperty*             _maxPixelBProperty;
 
+    Ctr::Vector4f              _environmentMaxValue;
+    Ctr::SphericalHarmonics    _irradianceSH;
+
+    bool                       _environmentReadPending;
+    uint32_t                   _environmentReadFrame;
+
     IDevice*                   _device;
     Ctr::Vector3f               _center;
 
@@ -57,12 +57,15 @@
 #include <CtrShaderMgr.h>
 #include <CtrIEffect.h>
 #include <CtrMatrixAlgo.h>
+#include <cmath>
 
 namespace Ctr
 {
 IBLRenderPass::IBLRenderPass(Ctr::IDevice* device) :
     Ctr::RenderPass (device),
     _convolve (nullptr),
+    _costTimer (new CpuCostTimer()),
+    _frameId (0),
     _cached (false),
     _material(nullptr),
     _colorConversionShader(nullptr),
@@ -107,6 +110,7 @@ IBLRenderPass::~IBLRenderPass()
 {
     safedelete(_sphereEntity);
     safedelete(_material);
+    safedelete(_costTimer);
 }
 
 bool
@@ -179,7 +183,7 @@ IBLRenderPass::refineDiffuse(Ctr::Scene* scene,
     float roughness = 0;
     float roughnessDelta = 1.0f / (float)(mipLevels);
     float samplesOffset = (float)(probe->sampleOffset());
-    float samplesPerFrame = (float)(probe->samplesPerFrame());
+    float samplesPerFrame = (float)(probe->refineSamples());
     float sampleCount = (float)(probe->sampleCount());
 
     roughness = 1.0;
@@ -258,7 +262,7 @@ IBLRenderPass::refineSpecular(Ctr::Scene* scene,
     float roughness = 0;
     float roughnessDelta = 1.0f / (float)(mipLevels-1);
     float samplesOffset = (float)(probe->sampleOffset());
-    float samplesPerFrame = (float)(probe->samplesPerFrame());
+    float samplesPerFrame = (float)(probe->refineSamples());
     float sampleCount = (float)(probe->sampleCount());
 
     const Ctr::Brdf* brdf = scene->activeBrdf();
@@ -267,8 +271,17 @@ IBLRenderPass::refineSpecular(Ctr::Scene* scene,
     // Convolve specular.
     uint32_t mipSize = probe->specularCubeMap()->resource()->width();
 
-    for (uint32_t mipId = 0; mipId < mipLevels; mipId++)
+    const int32_t samplesDone = probe->sampleCount() - probe->samplesRemaining();
+
+    for (uint32_t mipId = 0; mipId < mipLevels; mipId++, roughness += roughnessDelta, mipSize = mipSize >> 1)
     {
+        // Skip the mips that have converged.
+        if (!Ctr::IBLScheduler::refineMip(mipId, mipLevels, probe->sampleCount(), 
+                                          probe->refineSamples(), samplesDone))
+        {
+            continue;
+        }
+
         float currentMip = (float)(mipId);
 
         const Ctr::ISurface* targetSurface = probe->specularCubeMap()->surface(-1, mipId);
@@ -308,9 +321,118 @@ IBLRenderPass::refineSpecular(Ctr::Scene* scene,
 
         // Render the paraboloid out.
         importanceSamplingShaderSpecular->renderMesh (Ctr::RenderRequest(importanceSamplingSpecularTechnique, scene, camera, _sphereMesh));
-        roughness += roughnessDelta;
+    }
+}
+
+void
+IBLRenderPass::renderEnvironment(Ctr::Scene* scene, 
+                                 Ctr::IBLProbe* probe)
+{
+    Ctr::Camera* camera = scene->camera();
+
+    // The ibl probe could also have a znear and zfar.
+    // In this example it is more expedient just to use the camera znear - zfar.
+    float projNear = camera->zNear();
+    float projFar = camera->zFar();
+    Ctr::Matrix44f proj;
+    Ctr::projectionPerspectiveMatrixLH (Ctr::BB_PI * 0.5f,
+                                        1.0, 
+                                        projNear, 
+                                        projFar,
+                                        &proj);
+
+    // Setup view matrix for the environment source render.
+    _environmentTransformCache->set(probe->basis(), proj, probe->basis(), probe->center(), projNear, projFar, -1);
+
+    // Setup camera cache.
+    camera->setCameraTransformCache(_environmentTransformCache);
+
+    // Set framebuffer to cubemap.
+    // Render to environment top level mip (highest resolution).
+    size_t mipLevels = probe->environmentCubeMap()->resource()->mipLevels();
 
-        mipSize = mipSize >> 1;
+    Ctr::Vector2f mipSize = Ctr::Vector2f(float(probe->environmentCubeMap()->resource()->width()), 
+                                        float(probe->environmentCubeMap()->resource()->height()));
+
+    for (size_t mipId = 0; mipId < mipLevels; mipId++)
+    {
+        Ctr::Viewport mipViewport (0.0f, 0.0f, (float)(mipSize.x), (float)(mipSize.y), 0.0f, 1.0f);
+
+        // Render to top level mip for both cubemaps. A better strategy would be to blit after the first render...
+        Ctr::FrameBuffer framebuffer(probe->environmentCubeMap()->surface(-1, (int32_t)(mipId)), nullptr);
+        _deviceInterface->bindFrameBuffer(framebuffer);
+        _deviceInterface->setViewport(&mipViewport);
+        _deviceInterface->clearSurfaces (0, Ctr::CLEAR_TARGET, 0, 0, 0, 1);
+
+        // Render the scene to cubemap (single pass).
+        //renderMeshes (_passName, scene);
+        const std::vector<Ctr::Mesh*>& meshes = scene->meshesForPass(_passName);
+        for (auto it = meshes.begin(); it != meshes.end(); it++)
+        {
+            const Ctr::Mesh* mesh = (*it);
+            const Ctr::Material* material = mesh->material();
+            const Ctr::IShader* shader = material->shader();
+            const Ctr::GpuTechnique* technique = material->technique();
+
+            RenderRequest renderRequest (technique, scene, scene->camera(), mesh);
+            shader->renderMesh(renderRequest);
+        }
+
+        mipSize.x /= 2.0f;
+        mipSize.y /= 2.0f;
+    }
+
+    // Generate mip maps post rendering.
+    probe->environmentCubeMap()->generateMipMaps();    
+
+    // The statistics are read back a few frames later, within the budget.
+    probe->requestEnvironmentRead(_frameId);
+}
+
+Ctr::IBLScheduler::ProbeState
+IBLRenderPass::probeState(const Ctr::CameraTransformCachePtr& cameraTransforms, 
+                          const Ctr::IBLProbe* probe) const
+{
+    Ctr::IBLScheduler::ProbeState state;
+    state.key = reinterpret_cast<uintptr_t>(probe);
+
+    const Ctr::Vector3f& center = probe->center();
+    const Ctr::Vector4f clip = cameraTransforms->viewProjMatrix().transform(Ctr::Vector4f(center.x, center.y, center.z, 1.0f));
+    state.visible = clip.w > 0 && std::fabs(clip.x) <= clip.w && std::fabs(clip.y) <= clip.w;
+    state.distance = center.distance(cameraTransforms->cameraLocation());
+
+    state.sampleCount = probe->sampleCount();
+    // Probes marked computed are only scheduled for their reads.
+    state.samplesRemaining = probe->computed() ? 0 : probe->samplesRemaining();
+    state.refineSamples = probe->sampleOffset() == 0 ? 0 : probe->refineSamples();
+    state.maxRefineSamples = probe->samplesPerFrame();
+    state.specularSize = probe->specularCubeMap()->resource()->width();
+    state.specularMips = probe->specularCubeMap()->resource()->mipLevels() - probe->mipDrop();
+    state.diffuseSize = probe->diffuseCubeMap()->resource()->width();
+    state.readReady = probe->environmentReadReady(_frameId);
+    state.environmentSize = probe->environmentCubeMap()->resource()->width();
+    return state;
+}
+
+Ctr::IBLScheduler&
+IBLRenderPass::scheduler()
+{
+    return _scheduler;
+}
+
+const Ctr::IBLScheduler&
+IBLRenderPass::scheduler() const
+{
+    return _scheduler;
+}
+
+void
+IBLRenderPass::setCostTimer(Ctr::IBLCostTimer* costTimer)
+{
+    if (costTimer && costTimer != _costTimer)
+    {
+        safedelete(_costTimer);
+        _costTimer = costTimer;
     }
 }
 
@@ -318,6 +440,7 @@ void
 IBLRenderPass::render (Ctr::Scene* scene)
 {
     Ctr::Camera* camera           = scene->camera();
+    _frameId++;
 
     _deviceInterface->enableDepthWrite();
     _deviceInterface->enableZTest();
@@ -350,6 +473,11 @@ IBLRenderPass::render (Ctr::Scene* scene)
     }
 
     Ctr::CameraTransformCachePtr cachedTransforms = scene->camera()->cameraTransformCache();
+
+    // Collect the probes that still need refinement, or a read of their
+    // environment, for the scheduler.
+    std::vector<Ctr::IBLProbe*> refiningProbes;
+    std::vector<Ctr::IBLScheduler::ProbeState> probeStates;
     for (auto it = probes.begin(); it != probes.end(); it++)
     {
         // Todo, cull probe by location and range.
@@ -358,123 +486,78 @@ IBLRenderPass::render (Ctr::Scene* scene)
         if (forceUncache)
             probe->uncache();
 
-        bool cached = probe->isCached();
-        if (cached)
+        if (!probe->isCached() || probe->environmentReadPending())
         {
-            continue;
+            refiningProbes.push_back(probe);
+            probeStates.push_back(probeState(cachedTransforms, probe));
         }
-        else if (probe->sampleOffset() == 0)
-        {
-            // If sample offset is 0, we need to create the environment
-            // map and perform a first set of samples.
-            _deviceInterface->disableZTest();
-            _deviceInterface->disableDepthWrite();
-            _deviceInterface->disableStencilTest();
-            _deviceInterface->setCullMode (Ctr::CullNone);
-
-             {
-				// The ibl probe could also have a znear and zfar.
-				// In this example it is more expedient just to use the camera znear - zfar.
-				float projNear = camera->zNear();
-				float projFar = camera->zFar();
-                Ctr::Matrix44f proj;
-                Ctr::projectionPerspectiveMatrixLH (Ctr::BB_PI * 0.5f,
-                                                    1.0, 
-                                                    projNear, 
-                                                    projFar,
-                                                    &proj);
-    
-                // Setup view matrix for the environment source render.
-                _environmentTransformCache->set(probe->basis(), proj, probe->basis(), probe->center(), projNear, projFar, -1);
-    
-                // Setup camera cache.
-                camera->setCameraTransformCache(_environmentTransformCache);
-    
-                // Set framebuffer to cubemap.
-                // Render to environment top level mip (highest resolution).
-                size_t mipLevels = probe->environmentCubeMap()->resource()->mipLevels();
-
-                Ctr::Vector2f mipSize = Ctr::Vector2f(float(probe->environmentCubeMap()->resource()->width()), 
-                                                    float(probe->environmentCubeMap()->resource()->height()));
-
-                for (size_t mipId = 0; mipId < mipLevels; mipId++)
-                {
-                    Ctr::Viewport mipViewport (0.0f, 0.0f, (float)(mipSize.x), (float)(mipSize.y), 0.0f, 1.0f);
-
-                    // Render to top level mip for both cubemaps. A better strategy would be to blit after the first render...
-                    Ctr::FrameBuffer framebuffer(probe->environmentCubeMap()->surface(-1, (int32_t)(mipId)), nullptr);
-                    _deviceInterface->bindFrameBuffer(framebuffer);
-                    _deviceInterface->setViewport(&mipViewport);
-                    _deviceInterface->clearSurfaces (0, Ctr::CLEAR_TARGET, 0, 0, 0, 1);
-    
-                    // Render the scene to cubemap (single pass).
-                    //renderMeshes (_passName, scene);
-                    const std::vector<Ctr::Mesh*>& meshes = scene->meshesForPass(_passName);
-                    for (auto it = meshes.begin(); it != meshes.end(); it++)
-                    {
-                        const Ctr::Mesh* mesh = (*it);
-                        const Ctr::Material* material = mesh->material();
-                        const Ctr::IShader* shader = material->shader();
-                        const Ctr::GpuTechnique* technique = material->technique();
-    
-                        RenderRequest renderRequest (technique, scene, scene->camera(), mesh);
-                        shader->renderMesh(renderRequest);
-                    }
-
-                    mipSize.x /= 2.0f;
-                    mipSize.y /= 2.0f;
-                }
+    }
 
-                // Generate mip maps post rendering.
-                probe->environmentCubeMap()->generateMipMaps();    
-                refineSpecular(scene, probe);
-                refineDiffuse(scene, probe);
+    // Cpu timings only cover the submission of the draws, a budget 
+    // planned with them would fit several times the passes it should.
+    const std::vector<Ctr::IBLScheduler::Refinement>& refinements = 
+        _scheduler.plan(probeStates, _costTimer->measuresDevice());
+    for (auto it = refinements.begin(); it != refinements.end(); it++)
+    {
+        IBLProbe * probe = refiningProbes[it->probeId];
+        Ctr::IBLScheduler::ProbeState& state = probeStates[it->probeId];
 
-                colorConvert(scene, probe);
-                // Update the sample count
-                probe->updateSamples();
-            }
-            _deviceInterface->enableZTest();
-            _deviceInterface->enableDepthWrite();
-            _deviceInterface->setCullMode (Ctr::CullNone);
+        if (it->readEnvironment)
+        {
+            _costTimer->begin();
+            probe->readEnvironment();
+            _scheduler.record(Ctr::IBLScheduler::ReadEnvironment, 
+                              Ctr::IBLScheduler::stepWork(Ctr::IBLScheduler::ReadEnvironment, state, 0, 0),
+                              _costTimer->end());
         }
-        else
+        if (it->passes == 0)
+            continue;
+
+        _deviceInterface->disableZTest();
+        _deviceInterface->disableDepthWrite();
+        _deviceInterface->disableStencilTest();
+        _deviceInterface->setCullMode (Ctr::CullNone);
+
+        if (probe->sampleOffset() == 0)
         {
-            // Refine samples.
             // If sample offset is 0, we need to create the environment
             // map and perform a first set of samples.
-            _deviceInterface->disableZTest();
-            _deviceInterface->disableDepthWrite();
-            _deviceInterface->disableStencilTest();
-            _deviceInterface->setCullMode (Ctr::CullNone);
-    
-            float projNear = camera->zNear();
-            float projFar = camera->zFar();
-            Ctr::Matrix44f proj;
-            Ctr::projectionPerspectiveMatrixLH (Ctr::BB_PI * 0.5f,
-                                                1.0, 
-                                                projNear, 
-                                                projFar,
-                                                &proj);
-    
-    
-            // Setup view matrix
-            _environmentTransformCache->set(probe->basis(), proj, probe->basis(), probe->center(), projNear, projFar, -1);
-    
-            // Setup camera cache.
-            scene->camera()->setCameraTransformCache(_environmentTransformCache);
-    
+            probe->setRefineSamples(it->refineSamples);
+            state.refineSamples = probe->refineSamples();
+            renderEnvironment(scene, probe);
+        }
+
+        for (int32_t passId = 0; passId < it->passes && !probe->computed(); passId++)
+        {
+            const int32_t samplesDone = probe->sampleCount() - probe->samplesRemaining();
+            const int32_t refineSamples = probe->refineSamples();
+
+            _costTimer->begin();
             refineSpecular(scene, probe);
+            _scheduler.record(Ctr::IBLScheduler::RefineSpecular, 
+                              Ctr::IBLScheduler::stepWork(Ctr::IBLScheduler::RefineSpecular, state, refineSamples, samplesDone),
+                              _costTimer->end());
+
+            _costTimer->begin();
             refineDiffuse(scene, probe);
+            _scheduler.record(Ctr::IBLScheduler::RefineDiffuse, 
+                              Ctr::IBLScheduler::stepWork(Ctr::IBLScheduler::RefineDiffuse, state, refineSamples, samplesDone),
+                              _costTimer->end());
+
+            // Convert the maps of the last pass of the frame before 
+            // updateSamples swaps the render targets.
+            if (passId + 1 == it->passes || probe->samplesRemaining() <= refineSamples)
+            {
+                colorConvert(scene, probe);
+            }
 
             // Update the sample count
             probe->updateSamples();
-            colorConvert(scene, probe);
-
-            _deviceInterface->enableZTest();
-            _deviceInterface->enableDepthWrite();
-            _deviceInterface->setCullMode (Ctr::CullNone);
         }
+
+        _deviceInterface->enableZTest();
+        _deviceInterface->enableDepthWrite();
+        _deviceInterface->setCullMode (Ctr::CullNone);
     }
     
     // Restore original camera transforms.
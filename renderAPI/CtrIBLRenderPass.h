@@ -48,6 +48,7 @@
 #include <CtrScene.h>
 #include <CtrIDepthSurface.h>
 #include <CtrIBLProbe.h>
+#include <CtrIBLScheduler.h>
 
 namespace Ctr
 {
@@ -76,10 +77,25 @@ class IBLRenderPass : public Ctr::RenderPass
                                             Ctr::ITexture* src,
                                             Ctr::IBLProbe* probe);
 
+    // Time budget and statistics of the probe refinement.
+    Ctr::IBLScheduler&         scheduler();
+    const Ctr::IBLScheduler&   scheduler() const;
+
+    // Takes ownership of costTimer, which times the refinement steps.
+    // The scheduler budget is ignored until the timer measures the device.
+    void                       setCostTimer(Ctr::IBLCostTimer* costTimer);
+
   protected:
     bool                       loadMesh();
 
   private:
+    // Renders the scene into the environment map of the probe.
+    void                       renderEnvironment(Ctr::Scene* scene,
+                                                 Ctr::IBLProbe* probe);
+
+    Ctr::IBLScheduler::ProbeState probeState(const Ctr::CameraTransformCachePtr& cameraTransforms,
+                                             const Ctr::IBLProbe* probe) const;
+
     // Refine importance sampling for specular cube.
     void                       refineSpecular(Ctr::Scene* scene,
                                               const Ctr::IBLProbe* probe);
@@ -93,6 +109,12 @@ class IBLRenderPass : public Ctr::RenderPass
     Ctr::CameraTransformCachePtr _environmentTransformCache;
     Ctr::IBLConvolutions*        _convolve;
 
+    // Refinement scheduling.
+    Ctr::IBLScheduler            _scheduler;
+    Ctr::IBLCostTimer*           _costTimer;
+    // Frames rendered, for the latency of the environment reads.
+    uint32_t                     _frameId;
+
     // Procedural Splat Geometry
     Ctr::Entity*                _sphereEntity;
     Ctr::Mesh*                  _sphereMesh; 
@@ -0,0 +1,417 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrIBLScheduler.h>
+#include <CtrMath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace Ctr
+{
+namespace
+{
+// Weight of the older measurements in the cost fit, per measurement.
+const double CostFitDecay = 0.9;
+}
+
+CpuCostTimer::CpuCostTimer() :
+    _start(0)
+{
+}
+
+CpuCostTimer::~CpuCostTimer()
+{
+}
+
+void
+CpuCostTimer::begin()
+{
+    _start = std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+float
+CpuCostTimer::end()
+{
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    return float(double(now - _start) * 1e-6);
+}
+
+bool
+CpuCostTimer::measuresDevice() const
+{
+    return false;
+}
+
+IBLScheduler::ProbeState::ProbeState() :
+    key(0),
+    visible(true),
+    distance(0),
+    sampleCount(0),
+    samplesRemaining(0),
+    refineSamples(0),
+    maxRefineSamples(0),
+    specularSize(0),
+    specularMips(0),
+    diffuseSize(0),
+    readReady(false),
+    environmentSize(0)
+{
+}
+
+IBLScheduler::Report::Report() :
+    budget(0),
+    estimatedCost(0),
+    measuredCost(0),
+    passes(0),
+    reads(0),
+    probesRefined(0),
+    probesConverged(0),
+    probeCount(0),
+    convergence(1)
+{
+}
+
+IBLScheduler::CostFit::CostFit() :
+    weight(0),
+    work(0),
+    cost(0),
+    workSquared(0),
+    workCost(0)
+{
+}
+
+IBLScheduler::IBLScheduler() :
+    _budget(0)
+{
+}
+
+IBLScheduler::~IBLScheduler()
+{
+}
+
+void
+IBLScheduler::setBudget(float milliseconds)
+{
+    _budget = Ctr::maxValue(milliseconds, 0.0f);
+}
+
+float
+IBLScheduler::budget() const
+{
+    return _budget;
+}
+
+const IBLScheduler::Report&
+IBLScheduler::report() const
+{
+    return _report;
+}
+
+const std::vector<IBLScheduler::Refinement>&
+IBLScheduler::plan(const std::vector<ProbeState>& probes, bool budgeted)
+{
+    const float budget = budgeted ? _budget : 0.0f;
+
+    _plan.clear();
+    _report = Report();
+    _report.budget = budget;
+    _report.probeCount = probes.size();
+
+    // Probes that are no longer refined are forgotten.
+    std::map<uintptr_t, uint32_t> framesWaiting;
+    for (auto it = probes.begin(); it != probes.end(); ++it)
+    {
+        auto waiting = _framesWaiting.find(it->key);
+        framesWaiting[it->key] = waiting != _framesWaiting.end() ? waiting->second : 0;
+    }
+    _framesWaiting.swap(framesWaiting);
+
+    std::vector<size_t> order;
+    float convergenceSum = 0;
+    for (size_t probeId = 0; probeId < probes.size(); ++probeId)
+    {
+        const ProbeState& probe = probes[probeId];
+        convergenceSum += convergence(probe);
+        if (probe.samplesRemaining <= 0)
+            _report.probesConverged++;
+        if (probe.samplesRemaining > 0 || probe.readReady)
+            order.push_back(probeId);
+    }
+    if (!probes.empty())
+        _report.convergence = convergenceSum / float(probes.size());
+
+    if (budget <= 0)
+    {
+        // Unbudgeted, one pass for every probe and every read that has arrived.
+        for (auto it = order.begin(); it != order.end(); ++it)
+        {
+            const ProbeState& probe = probes[*it];
+            Refinement refinement;
+            refinement.probeId = *it;
+            refinement.refineSamples = probe.refineSamples > 0 ? probe.refineSamples : 
+                                       Ctr::maxValue(probe.maxRefineSamples, 1);
+            refinement.passes = probe.samplesRemaining > 0 ? 1 : 0;
+            refinement.readEnvironment = probe.readReady;
+            refinement.estimatedCost = probe.readReady ? readCost(probe) : 0;
+            if (refinement.passes > 0)
+            {
+                refinement.estimatedCost += passCost(probe, refinement.refineSamples, 
+                                                     probe.sampleCount - probe.samplesRemaining);
+            }
+            _plan.push_back(refinement);
+        }
+    }
+    else
+    {
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return priority(probes[a]) > priority(probes[b]);
+        });
+
+        // Until both steps have been measured the costs are unknown,
+        // a single pass is planned to measure them.
+        const bool measured = _fits[RefineSpecular].weight > 0 && _fits[RefineDiffuse].weight > 0;
+
+        float remaining = budget;
+        for (auto it = order.begin(); it != order.end() && (measured || _plan.empty()); ++it)
+        {
+            const ProbeState& probe = probes[*it];
+            Refinement refinement;
+            refinement.probeId = *it;
+            refinement.refineSamples = probe.refineSamples > 0 ? probe.refineSamples : 
+                                       chooseRefineSamples(probe, remaining);
+            refinement.passes = 0;
+            refinement.readEnvironment = false;
+            refinement.estimatedCost = 0;
+
+            if (probe.readReady)
+            {
+                // Reads are cheaper than leaving the statistics stale, 
+                // they go first and wait only if they do not fit.
+                const float cost = readCost(probe);
+                if (cost <= remaining || _plan.empty())
+                {
+                    refinement.readEnvironment = true;
+                    refinement.estimatedCost = cost;
+                }
+            }
+
+            int32_t samplesDone = probe.sampleCount - probe.samplesRemaining;
+            const int32_t maxPasses = measured ? MaxPassesPerFrame : 1;
+            while (refinement.passes < maxPasses && samplesDone < probe.sampleCount)
+            {
+                // The first refinement of the frame always gets a pass,
+                // so that something converges whatever the budget.
+                const float cost = passCost(probe, refinement.refineSamples, samplesDone);
+                if (refinement.estimatedCost + cost > remaining && 
+                    (refinement.passes > 0 || refinement.readEnvironment || !_plan.empty()))
+                {
+                    break;
+                }
+                refinement.estimatedCost += cost;
+                samplesDone += refinement.refineSamples;
+                refinement.passes++;
+            }
+
+            if (refinement.passes > 0 || refinement.readEnvironment)
+            {
+                remaining -= refinement.estimatedCost;
+                _framesWaiting[probe.key] = 0;
+                _plan.push_back(refinement);
+            }
+            else
+            {
+                _framesWaiting[probe.key]++;
+            }
+        }
+    }
+
+    for (auto it = _plan.begin(); it != _plan.end(); ++it)
+    {
+        _report.estimatedCost += it->estimatedCost;
+        _report.passes += it->passes;
+        if (it->readEnvironment)
+            _report.reads++;
+    }
+    _report.probesRefined = _plan.size();
+    return _plan;
+}
+
+void
+IBLScheduler::record(RefineStep step, double work, float milliseconds)
+{
+    CostFit& fit = _fits[step];
+    fit.weight = fit.weight * CostFitDecay + 1.0;
+    fit.work = fit.work * CostFitDecay + work;
+    fit.cost = fit.cost * CostFitDecay + milliseconds;
+    fit.workSquared = fit.workSquared * CostFitDecay + work * work;
+    fit.workCost = fit.workCost * CostFitDecay + work * milliseconds;
+
+    _report.measuredCost += milliseconds;
+}
+
+float
+IBLScheduler::stepCost(RefineStep step, double work) const
+{
+    const CostFit& fit = _fits[step];
+    if (fit.weight <= 0 || work <= 0)
+        return 0;
+
+    const double meanWork = fit.work / fit.weight;
+    const double meanCost = fit.cost / fit.weight;
+    const double variance = fit.workSquared / fit.weight - meanWork * meanWork;
+    const double covariance = fit.workCost / fit.weight - meanWork * meanCost;
+
+    // Without a spread of work to fit the line to, or with a fit 
+    // that does not make sense, the cost is taken as proportional.
+    double rate = meanWork > 0 ? meanCost / meanWork : 0;
+    double overhead = 0;
+    if (variance > 1e-6 * meanWork * meanWork)
+    {
+        const double fitRate = covariance / variance;
+        const double fitOverhead = meanCost - fitRate * meanWork;
+        if (fitRate >= 0 && fitOverhead >= 0)
+        {
+            rate = fitRate;
+            overhead = fitOverhead;
+        }
+    }
+    return float(overhead + rate * work);
+}
+
+float
+IBLScheduler::passCost(const ProbeState& probe, 
+                       int32_t refineSamples, 
+                       int32_t samplesDone) const
+{
+    return stepCost(RefineSpecular, stepWork(RefineSpecular, probe, refineSamples, samplesDone)) +
+           stepCost(RefineDiffuse, stepWork(RefineDiffuse, probe, refineSamples, samplesDone));
+}
+
+float
+IBLScheduler::readCost(const ProbeState& probe) const
+{
+    return stepCost(ReadEnvironment, stepWork(ReadEnvironment, probe, 0, 0));
+}
+
+double
+IBLScheduler::stepWork(RefineStep step, 
+                       const ProbeState& probe, 
+                       int32_t refineSamples, 
+                       int32_t samplesDone)
+{
+    if (step == ReadEnvironment)
+    {
+        // The whole mip chain, 4 / 3 of the top level.
+        const double size = double(probe.environmentSize);
+        return 6.0 * size * size * 4.0 / 3.0;
+    }
+
+    double texels = 0;
+    if (step == RefineDiffuse)
+    {
+        texels = 6.0 * double(probe.diffuseSize) * double(probe.diffuseSize);
+    }
+    else
+    {
+        for (size_t mipId = 0; mipId < probe.specularMips; ++mipId)
+        {
+            if (refineMip(mipId, probe.specularMips, probe.sampleCount, refineSamples, samplesDone))
+            {
+                const double mipSize = double(Ctr::maxValue(probe.specularSize >> mipId, size_t(1)));
+                texels += 6.0 * mipSize * mipSize;
+            }
+        }
+    }
+    return texels * double(refineSamples);
+}
+
+bool
+IBLScheduler::refineMip(size_t mipId, 
+                        size_t mips, 
+                        int32_t sampleCount,
+                        int32_t refineSamples, 
+                        int32_t samplesDone)
+{
+    if (mips <= 1)
+        return true;
+
+    const float roughness = Ctr::minValue(float(mipId) / float(mips - 1), 1.0f);
+    const float alpha = roughness * roughness;
+    const int32_t samplesNeeded = Ctr::maxValue(int32_t(std::ceil(float(sampleCount) * alpha * alpha)), 
+                                                refineSamples);
+    return samplesDone < samplesNeeded + refineSamples;
+}
+
+float
+IBLScheduler::convergence(const ProbeState& probe)
+{
+    if (probe.sampleCount <= 0)
+        return 1;
+    const float remaining = float(Ctr::maxValue(probe.samplesRemaining, 0)) / float(probe.sampleCount);
+    return Ctr::maxValue(1.0f - remaining, 0.0f);
+}
+
+float
+IBLScheduler::priority(const ProbeState& probe) const
+{
+    // Probes that have waited are boosted so that none of them starve.
+    auto waiting = _framesWaiting.find(probe.key);
+    const uint32_t framesWaiting = waiting != _framesWaiting.end() ? waiting->second : 0;
+    const float visibility = probe.visible ? 1.0f : 0.25f;
+    return visibility / (1.0f + Ctr::maxValue(probe.distance, 0.0f)) * 
+           float(1 + framesWaiting);
+}
+
+int32_t
+IBLScheduler::chooseRefineSamples(const ProbeState& probe, float budget) const
+{
+    int32_t refineSamples = Ctr::maxValue(Ctr::minValue(probe.maxRefineSamples, probe.sampleCount), 1);
+    while (refineSamples > MinRefineSamples && passCost(probe, refineSamples, 0) > budget)
+    {
+        refineSamples = Ctr::maxValue(refineSamples / 2, int32_t(MinRefineSamples));
+    }
+    return refineSamples;
+}
+}
@@ -0,0 +1,257 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_IBL_SCHEDULER
+#define INCLUDED_CRT_IBL_SCHEDULER
+
+#include <CtrPlatform.h>
+#include <map>
+#include <vector>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Measures the milliseconds spent in one refinement step.
+// IBLRenderPass times the steps with CpuCostTimer, which only sees
+// the cpu side of the draws. The time budget only applies once a 
+// timer that measures the device, one based on gpu timestamps or a
+// mock, is set on the pass in its place.
+//-----------------------------------------------------------------
+class IBLCostTimer
+{
+  public:
+    virtual ~IBLCostTimer() {}
+
+    virtual void               begin() = 0;
+    // Milliseconds since begin.
+    virtual float              end() = 0;
+
+    // Whether the milliseconds cover the work of the device, and
+    // not just the submission of the draws.
+    virtual bool               measuresDevice() const { return true; }
+};
+
+class CpuCostTimer : public IBLCostTimer
+{
+  public:
+    CpuCostTimer();
+    virtual ~CpuCostTimer();
+
+    virtual void               begin();
+    virtual float              end();
+    virtual bool               measuresDevice() const;
+
+  protected:
+    int64_t                    _start;
+};
+
+//-----------------------------------------------------------------
+// Time budgeted scheduling of the progressive probe refinement.
+// Each frame plan() picks the probes to refine, in order of 
+// visibility, distance and the frames they have waited, and the 
+// number of passes each of them gets to fit the budget. The cost of
+// a pass is predicted from the measurements passed to record(), 
+// fitted per step as milliseconds = overhead + rate * work, with the
+// work in samples * texels.
+//
+// Reading the environment map of a probe back for its statistics is
+// planned and measured as a step of its own. The read is started
+// when the environment is rendered and planned once it has arrived,
+// so it only costs the copy out of the staging texture and the 
+// reduction.
+//
+// The refinement shaders accumulate passes of a fixed sample count,
+// so the samples per pass are chosen when a probe starts converging
+// and kept until it is uncached. Within a run the passes per frame
+// adapt, and the specular mips whose lobes have enough samples drop 
+// out of the passes (see refineMip).
+//
+// The scheduler does not touch the device, it can be driven with a
+// mock cost model on the cpu.
+//-----------------------------------------------------------------
+class IBLScheduler
+{
+  public:
+    enum RefineStep
+    {
+        RefineSpecular = 0,
+        RefineDiffuse,
+        ReadEnvironment,
+        RefineStepCount
+    };
+
+    enum
+    {
+        MaxPassesPerFrame = 8,
+        MinRefineSamples = 16
+    };
+
+    // A probe that still needs refinement, filled in each frame.
+    struct ProbeState
+    {
+        ProbeState();
+
+        // Identifies the probe across frames, the states are rebuilt
+        // every frame and their order changes.
+        uintptr_t              key;
+
+        // Inside the camera frustum.
+        bool                   visible;
+        // From the camera.
+        float                  distance;
+        int32_t                sampleCount;
+        int32_t                samplesRemaining;
+        // Samples per pass of the current run, 0 if it has not started.
+        int32_t                refineSamples;
+        // The samples per frame of the probe.
+        int32_t                maxRefineSamples;
+        size_t                 specularSize;
+        // Specular mips refined (mips - mip drop).
+        size_t                 specularMips;
+        size_t                 diffuseSize;
+        // The environment readback has arrived and can be read.
+        bool                   readReady;
+        size_t                 environmentSize;
+    };
+
+    struct Refinement
+    {
+        // Index into the probe states passed to plan.
+        size_t                 probeId;
+        int32_t                refineSamples;
+        int32_t                passes;
+        // Read the environment back before the passes.
+        bool                   readEnvironment;
+        float                  estimatedCost;
+    };
+
+    struct Report
+    {
+        Report();
+
+        float                  budget;
+        float                  estimatedCost;
+        float                  measuredCost;
+        size_t                 passes;
+        size_t                 reads;
+        size_t                 probesRefined;
+        size_t                 probesConverged;
+        size_t                 probeCount;
+        // Fraction of the samples taken over all probes.
+        float                  convergence;
+    };
+
+    IBLScheduler();
+    virtual ~IBLScheduler();
+
+    // Milliseconds of refinement per frame. A budget of 0 refines every
+    // probe with one pass of its samples per frame.
+    void                       setBudget(float milliseconds);
+    float                      budget() const;
+
+    // Refinements for this frame, in the order they should run.
+    // Without budgeted, as when the costs are only measured on the 
+    // cpu, the frame is planned as with a budget of 0.
+    const std::vector<Refinement>& plan(const std::vector<ProbeState>& probes,
+                                        bool budgeted = true);
+
+    // Milliseconds spent on step for work samples * texels, or 
+    // texels for ReadEnvironment.
+    void                       record(RefineStep step, double work, float milliseconds);
+
+    // Predicted milliseconds of a pass of refineSamples, samplesDone 
+    // samples into the run.
+    float                      passCost(const ProbeState& probe, 
+                                        int32_t refineSamples, 
+                                        int32_t samplesDone) const;
+
+    // Predicted milliseconds of reading the environment of probe back.
+    float                      readCost(const ProbeState& probe) const;
+
+    // Statistics of the last planned frame, the measured cost 
+    // accumulates as the steps are recorded.
+    const Report&              report() const;
+
+    static double              stepWork(RefineStep step, 
+                                        const ProbeState& probe, 
+                                        int32_t refineSamples, 
+                                        int32_t samplesDone);
+
+    // Whether a pass samplesDone samples into the run renders mip.
+    // The GGX lobe of mip covers a solid angle of about roughness^4 
+    // of the widest lobe, and needs that fraction of the samples. Mips
+    // get one pass past that, so that both of the ping pong targets
+    // hold the result.
+    static bool                refineMip(size_t mipId, 
+                                         size_t mips, 
+                                         int32_t sampleCount,
+                                         int32_t refineSamples, 
+                                         int32_t samplesDone);
+
+    static float               convergence(const ProbeState& probe);
+
+  protected:
+    float                      priority(const ProbeState& probe) const;
+    int32_t                    chooseRefineSamples(const ProbeState& probe, float budget) const;
+    float                      stepCost(RefineStep step, double work) const;
+
+    // Exponentially weighted sums for the per step line fit.
+    struct CostFit
+    {
+        CostFit();
+
+        double                 weight;
+        double                 work;
+        double                 cost;
+        double                 workSquared;
+        double                 workCost;
+    };
+
+    float                      _budget;
+    CostFit                    _fits[RefineStepCount];
+    std::vector<Refinement>    _plan;
+    // Frames each probe waited for a refinement, by ProbeState::key.
+    std::map<uintptr_t, uint32_t> _framesWaiting;
+    Report                     _report;
+};
+}
+
+#endif
@@ -145,6 +145,7 @@ void
 IDevice::update()
 {
     _shaderMgr->update();
+    _textureMgr->update(0.0f);
 }
 
 bool
@@ -207,4 +207,16 @@ ITexture::mipCount() const
     return _mipCount;
 }
 
+bool
+ITexture::requestRead() const
+{
+    return false;
+}
+
+bool
+ITexture::readReady() const
+{
+    return true;
+}
+
 }
\ No newline at end of file
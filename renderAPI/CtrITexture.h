@@ -106,6 +106,17 @@ ITexture : public IRenderResource
 
     // Read all pixels. Pixels should be preallocated to byteSize().
     virtual Ctr::Vector4f      read (Ctr::byte* pos) const = 0;
+
+    // Reads the texture back into an image, every face and mip
+    // or only mipId when it is not -1.
+    virtual Ctr::TextureImagePtr readImage(Ctr::PixelFormat format, int32_t mipId = -1) const = 0;
+
+    // Starts copying the texture to the cpu for the next readImage, 
+    // without waiting for the copy. readReady is true once readImage
+    // will not stall. Textures that cannot copy asynchronously return
+    // false here, and readImage reads them synchronously.
+    virtual bool               requestRead() const;
+    virtual bool               readReady() const;
     
     virtual bool               save(const std::string& filePathName,
                                     bool fixSeams = false,
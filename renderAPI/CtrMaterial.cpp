@@ -80,7 +80,8 @@ Material::Material (IDevice* device,
     _environmentMap(new Ctr::TextureProperty(this, "env")),
     _albedoMap(new Ctr::TextureProperty(this, "albedo")),
     _detailMap(new Ctr::TextureProperty(this, "detail")),
-    _textureScaleOffsetProperty(new Ctr::Vector4fProperty(this, "Texture Scale Offset"))
+    _textureScaleOffsetProperty(new Ctr::Vector4fProperty(this, "Texture Scale Offset")),
+    _lifetime(std::make_shared<Material*>(this))
 {
     _textureScaleOffsetProperty->set(Ctr::Vector4f(1, 1, 0, 0));
     _userAlbedoProperty->set(Ctr::Vector4f(1, 1, 1, 0));
@@ -407,30 +408,40 @@ Material::passes() const
 void
 Material::setAlbedoMap(Ctr::ITexture* texture)
 {
+    // Cancels a load still pending for the map.
+    _mapGenerations[_albedoMap]++;
     _albedoMap->set(texture);
 }
 
 void
 Material::setDetailMap(Ctr::ITexture* texture)
 {
+    // Cancels a load still pending for the map.
+    _mapGenerations[_detailMap]++;
     _detailMap->set(texture);
 }
 
 void
 Material::setNormalMap(Ctr::ITexture* texture)
 {
+    // Cancels a load still pending for the map.
+    _mapGenerations[_normalMap]++;
     _normalMap->set(texture);
 }
 
 void
 Material::setEnvironmentMap(Ctr::ITexture* texture)
 {
+    // Cancels a load still pending for the map.
+    _mapGenerations[_environmentMap]++;
     _environmentMap->set(texture);
 }
 
 void
 Material::setSpecularRMCMap(Ctr::ITexture* texture)
 {
+    // Cancels a load still pending for the map.
+    _mapGenerations[_specularRMCMap]++;
     _specularRMCMap->set(texture);
 }
 
@@ -465,6 +476,61 @@ Material::setSpecularRMCMap(const std::string& filePathName)
     setSpecularRMCMap(_device->textureMgr()->loadTexture(filePathName));
 }
 
+void
+Material::setAlbedoMap(const AsyncTexturePtr& texture)
+{
+    bindAsync(_albedoMap, texture, _device->textureMgr()->placeholderTexture(TextureMgr::PlaceholderColor));
+}
+
+void
+Material::setDetailMap(const AsyncTexturePtr& texture)
+{
+    bindAsync(_detailMap, texture, _device->textureMgr()->placeholderTexture(TextureMgr::PlaceholderColor));
+}
+
+void
+Material::setNormalMap(const AsyncTexturePtr& texture)
+{
+    bindAsync(_normalMap, texture, _device->textureMgr()->placeholderTexture(TextureMgr::PlaceholderNormal));
+}
+
+void
+Material::setEnvironmentMap(const AsyncTexturePtr& texture)
+{
+    bindAsync(_environmentMap, texture, _device->textureMgr()->placeholderTexture(TextureMgr::PlaceholderCube));
+}
+
+void
+Material::setSpecularRMCMap(const AsyncTexturePtr& texture)
+{
+    bindAsync(_specularRMCMap, texture, _device->textureMgr()->placeholderTexture(TextureMgr::PlaceholderRMC));
+}
+
+void
+Material::bindAsync(TextureProperty* map, const AsyncTexturePtr& texture, ITexture* placeholder)
+{
+    // Each bind gets a generation, so a load that completes after the
+    // map was given another texture leaves it alone.
+    const uint32_t generation = ++_mapGenerations[map];
+    map->set(texture->ready() ? texture->texture() : placeholder);
+
+    std::weak_ptr<Material*> lifetime = _lifetime;
+    std::string key = texture->key();
+    texture->onReady([lifetime, map, generation, key](ITexture* loaded)
+    {
+        std::shared_ptr<Material*> material = lifetime.lock();
+        if (!material || (*material)->_mapGenerations[map] != generation)
+            return;
+
+        if (!loaded)
+        {
+            // The map is unbound, as if it had never been set.
+            LOG ("Failed to load " << key << ", leaving the map unset");
+        }
+        map->set(loaded);
+    });
+}
+
 Ctr::IntProperty*
 Material::specularWorkflowProperty()
 {
@@ -44,11 +44,15 @@
 #include <CtrPlatform.h>
 #include <CtrRenderNode.h>
 #include <CtrVector4.h>
+#include <map>
+#include <memory>
 
 namespace Ctr
 {
 class GpuTechnique;
 class IShader;
+class AsyncTexture;
+typedef std::shared_ptr<AsyncTexture> AsyncTexturePtr;
 
 enum SpecularWorkflow
 {
@@ -112,6 +116,15 @@ class Material : public RenderNode
     void                       setSpecularRMCMap(const std::string& filePathName);
     void                       setDetailMap(const std::string& filePathName);
 
+    // Binds a neutral placeholder for the map while the texture is 
+    // loading, swapped for the texture once it is ready. Failed loads
+    // leave the map unset.
+    void                       setAlbedoMap(const AsyncTexturePtr& texture);
+    void                       setNormalMap(const AsyncTexturePtr& texture);
+    void                       setEnvironmentMap(const AsyncTexturePtr& texture);
+    void                       setSpecularRMCMap(const AsyncTexturePtr& texture);
+    void                       setDetailMap(const AsyncTexturePtr& texture);
+
     const std::vector<std::string>& passes() const;
 
     Ctr::BoolProperty*          twoSidedProperty();
@@ -152,6 +165,10 @@ class Material : public RenderNode
     TextureProperty*            detailMapProperty();
 
   private:
+    void                       bindAsync(TextureProperty* map, 
+                                         const AsyncTexturePtr& texture,
+                                         ITexture* placeholder);
+
     // Shader and pass management
     std::vector<std::string>   _passes;
     std::string                _shaderName;
@@ -181,6 +198,11 @@ class Material : public RenderNode
     Ctr::Vector4fProperty*      _userRMProperty;
     Ctr::Vector4fProperty*      _iblOcclProperty;
     Ctr::Vector4fProperty*      _textureScaleOffsetProperty;
+
+    // Expires with the material, so loads completing later do not bind into it.
+    std::shared_ptr<Material*>  _lifetime;
+    // Bumped each time a map is set, see bindAsync.
+    std::map<const TextureProperty*, uint32_t> _mapGenerations;
 };
 }
 
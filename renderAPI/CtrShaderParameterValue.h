@@ -238,6 +238,7 @@ enum ShaderParameter
     IBLBRDFMap,
     IBLCorrection,
     IBLMaxValue,
+    IBLIrradianceSH,
 
     // Debug parameters
     RenderDebugTermOut,
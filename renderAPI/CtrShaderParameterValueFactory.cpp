@@ -58,6 +58,7 @@
 #include <CtrMaterial.h>
 #include <CtrIBLProbe.h>
 #include <CtrScene.h>
+#include <CtrProbeGrid.h>
 #include <CtrBrdf.h>
 
 namespace Ctr
@@ -1064,11 +1065,7 @@ class IBLMaxValueValue :  public ShaderParameterValue
     virtual void setParam (const Ctr::RenderRequest& request) const
     {
         {
-            Ctr::Vector4f iblCorrection = 
-                Ctr::Vector4f(request.scene->probes()[0]->maxPixelR(),
-                             request.scene->probes()[0]->maxPixelG(),
-                             request.scene->probes()[0]->maxPixelB(),
-                             1.0f);
+            Ctr::Vector4f iblCorrection = request.scene->probes()[0]->maxPixelValue();
             _variable->setVector ((const float*)&iblCorrection.x);
         }
     }
@@ -1079,6 +1076,42 @@ class IBLMaxValueValue :  public ShaderParameterValue
     }
 };
 
+class IBLIrradianceSHValue :  public ShaderParameterValue
+{
+  public:
+    IBLIrradianceSHValue (const GpuVariable* variable, Ctr::IEffect*effect) : 
+        ShaderParameterValue (variable, effect)
+    {
+        setParameterScope (PerMesh);
+        setParameterType (IBLIrradianceSH);
+    }
+
+    virtual void setParam (const Ctr::RenderRequest& request) const
+    {
+        // float4[9], L2 irradiance / pi in rgb.
+        // Blended from the probe grid for the mesh, or from the first probe.
+        const Ctr::SphericalHarmonics* sh = nullptr;
+        if (request.mesh)
+        {
+            sh = request.scene->probeGrid()->meshIrradiance(request.mesh);
+        }
+        if (!sh && request.scene->probes().size() > 0)
+        {
+            sh = &request.scene->probes()[0]->irradianceSH();
+        }
+
+        if (sh)
+        {
+            _variable->setVectorArray (sh->data(), Ctr::SphericalHarmonics::NumCoefficients);
+        }
+    }
+
+    static bool supports (GpuVariable* variable)
+    {
+        return _strcmpi((char*)variable->semantic().c_str(), "IBLIRRADIANCESH")==0;
+    }
+};
+
 class EnvironmentMapValue :  public ShaderParameterValue
 {
   public:
@@ -1602,6 +1635,7 @@ ShaderParameterValueFactory::createShaderParameterValue (Ctr::IDevice* device,
         _parameters.insert (new ShaderParameterFactory <EnvironmentMapValue>());
         _parameters.insert (new ShaderParameterFactory <IBLCorrectionValue>());
         _parameters.insert (new ShaderParameterFactory <IBLMaxValueValue>());
+        _parameters.insert (new ShaderParameterFactory <IBLIrradianceSHValue>());
         
         _parameters.insert (new ShaderParameterFactory <PostProcessMapValue>());
         _parameters.insert (new ShaderParameterFactory <ViewUpValue>());
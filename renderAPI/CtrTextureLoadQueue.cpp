@@ -0,0 +1,312 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrTextureLoadQueue.h>
+#include <CtrAssetManager.h>
+#include <CtrLog.h>
+#include <algorithm>
+
+namespace Ctr
+{
+namespace
+{
+std::string
+fileExtension(const std::string& filename)
+{
+    size_t pos = filename.rfind(".");
+    if (pos != std::string::npos && pos < (filename.length() - 1))
+    {
+        return filename.substr(pos + 1);
+    }
+    return std::string();
+}
+
+void
+prefetch(DataStream* stream)
+{
+    // Fault mapped files in on the I/O thread, so the decode workers
+    // read from memory rather than waiting on the disk.
+    if (MappedFileDataStream* mappedStream = dynamic_cast<MappedFileDataStream*>(stream))
+    {
+        const size_t pageSize = 4096;
+        const volatile uint8_t* data = mappedStream->getDataPtr();
+        uint8_t sum = 0;
+        for (size_t offset = 0; offset < mappedStream->size(); offset += pageSize)
+        {
+            sum += data[offset];
+        }
+        (void)sum;
+    }
+}
+}
+
+TextureLoadQueue::Request::Request() :
+    dimension(Ctr::TwoD),
+    priority(PRIORITY_NORMAL),
+    bytes(0),
+    failed(false),
+    sequence(0)
+{
+}
+
+bool
+TextureLoadQueue::RequestOrder::operator()(const RequestPtr& a, const RequestPtr& b) const
+{
+    // Highest priority first, then first come first served.
+    if (a->priority != b->priority)
+        return a->priority < b->priority;
+    return a->sequence > b->sequence;
+}
+
+TextureLoadQueue::TextureLoadQueue(const Decoder& decoder, 
+                                   const Converter& converter, 
+                                   size_t decodeThreads) :
+    _decoder(decoder),
+    _converter(converter),
+    _sequence(0),
+    _outstanding(0),
+    _running(true)
+{
+    if (decodeThreads == 0)
+    {
+        size_t cores = std::thread::hardware_concurrency();
+        decodeThreads = cores > 1 ? cores - 1 : 1;
+    }
+
+    _ioThread = std::thread(&TextureLoadQueue::ioThread, this);
+    for (size_t threadId = 0; threadId < decodeThreads; threadId++)
+    {
+        _decodeThreads.push_back(std::thread(&TextureLoadQueue::decodeThread, this));
+    }
+}
+
+TextureLoadQueue::~TextureLoadQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _running = false;
+    }
+    _readSignal.notify_all();
+    _decodeSignal.notify_all();
+    _decodedSignal.notify_all();
+
+    _ioThread.join();
+    for (auto it = _decodeThreads.begin(); it != _decodeThreads.end(); it++)
+    {
+        it->join();
+    }
+}
+
+void
+TextureLoadQueue::submit(const RequestPtr& request)
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        request->sequence = _sequence++;
+        request->streams.resize(request->filenames.size());
+        request->images.resize(request->filenames.size());
+        _readQueue.push(request);
+        _outstanding++;
+    }
+    _readSignal.notify_one();
+}
+
+TextureLoadQueue::RequestPtr
+TextureLoadQueue::popDecoded()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    RequestPtr request;
+    if (!_decoded.empty())
+    {
+        request = _decoded.front();
+        _decoded.pop_front();
+        _outstanding--;
+    }
+    return request;
+}
+
+TextureLoadQueue::RequestPtr
+TextureLoadQueue::waitDecoded()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    _decodedSignal.wait(lock, [this] { return !_decoded.empty() || !_running || _outstanding == 0; });
+
+    RequestPtr request;
+    if (!_decoded.empty())
+    {
+        request = _decoded.front();
+        _decoded.pop_front();
+        _outstanding--;
+    }
+    return request;
+}
+
+size_t
+TextureLoadQueue::outstanding() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _outstanding;
+}
+
+void
+TextureLoadQueue::ioThread()
+{
+    for (;;)
+    {
+        RequestPtr request;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _readSignal.wait(lock, [this] { return !_readQueue.empty() || !_running; });
+            if (!_running)
+                return;
+            request = _readQueue.top();
+            _readQueue.pop();
+        }
+
+        for (size_t fileId = 0; fileId < request->filenames.size(); fileId++)
+        {
+            if (request->images[fileId])
+                continue;
+
+            request->streams[fileId].reset
+                (AssetManager::assetManager()->openStream(request->filenames[fileId]));
+            if (request->streams[fileId])
+            {
+                prefetch(request->streams[fileId].get());
+            }
+            else
+            {
+                LOG("Failed to open image " << request->filenames[fileId]);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _decodeQueue.push(request);
+        }
+        _decodeSignal.notify_one();
+    }
+}
+
+void
+TextureLoadQueue::decodeThread()
+{
+    for (;;)
+    {
+        RequestPtr request;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _decodeSignal.wait(lock, [this] { return !_decodeQueue.empty() || !_running; });
+            if (!_running)
+                return;
+            request = _decodeQueue.top();
+            _decodeQueue.pop();
+        }
+
+        // A texture is only created when every one of its files loads.
+        request->failed = false;
+        for (size_t fileId = 0; fileId < request->filenames.size(); fileId++)
+        {
+            TextureImagePtr& image = request->images[fileId];
+            if (!image && request->streams[fileId])
+            {
+                try
+                {
+                    const std::string& filename = request->filenames[fileId];
+                    if (_decoder)
+                    {
+                        image = _decoder(filename, fileExtension(filename), request->streams[fileId]);
+                    }
+                    else
+                    {
+                        image.reset(new TextureImage());
+                        image->load(request->streams[fileId], fileExtension(filename));
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    LOG("Failed to decode image " << request->filenames[fileId] << " " << e.what());
+                    image.reset();
+                }
+            }
+
+            if (image && image->valid())
+            {
+                request->bytes += image->getSize();
+            }
+            else
+            {
+                LOG("Failed to load image " << request->filenames[fileId]);
+                image.reset();
+                request->failed = true;
+            }
+        }
+        request->streams.clear();
+
+        if (!request->failed && _converter)
+        {
+            try
+            {
+                _converter(*request);
+            }
+            catch (const std::exception& e)
+            {
+                LOG("Failed to convert " << request->key << " " << e.what());
+                request->failed = true;
+            }
+
+            // The conversion changes the size of the images.
+            request->bytes = 0;
+            for (auto it = request->images.begin(); it != request->images.end(); it++)
+            {
+                if (*it)
+                    request->bytes += (*it)->getSize();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _decoded.push_back(request);
+        }
+        _decodedSignal.notify_all();
+    }
+}
+}
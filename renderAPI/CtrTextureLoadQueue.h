@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_TEXTURE_LOAD_QUEUE
+#define INCLUDED_CRT_TEXTURE_LOAD_QUEUE
+
+#include <CtrPlatform.h>
+#include <CtrRenderEnums.h>
+#include <CtrTextureImage.h>
+#include <CtrDataStream.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace Ctr
+{
+//-----------------------------------------------------------------
+// Background half of asynchronous texture loading. Requests are 
+// read from disk by a single I/O thread in priority order, then
+// decoded into TextureImages by a pool of worker threads. Decoded
+// requests are collected by the owner (TextureMgr), which creates
+// the device textures on the main thread.
+//-----------------------------------------------------------------
+class TextureLoadQueue
+{
+  public:
+    enum Priority
+    {
+        PRIORITY_LOW = 0,
+        PRIORITY_NORMAL = 1,
+        PRIORITY_HIGH = 2
+    };
+
+    struct Request
+    {
+        Request();
+
+        std::string              key;
+        std::vector<std::string> filenames;
+        TextureDimension         dimension;
+        Priority                 priority;
+        // One entry per filename. Images already in memory may be 
+        // filled in by the caller, only empty entries are loaded. 
+        // Entries that fail to load are left empty.
+        TextureImageArray        images;
+        // Total size of the decoded images.
+        size_t                   bytes;
+        // Set if any of the files failed to load.
+        bool                     failed;
+
+      private:
+        friend class TextureLoadQueue;
+        size_t                   sequence;
+        std::vector<DataStreamPtr> streams;
+    };
+    typedef std::shared_ptr<Request> RequestPtr;
+
+    // Decodes one file from its open stream, type is the file extension.
+    // Called on the decode threads, so it must be thread safe.
+    typedef std::function<TextureImagePtr(const std::string& filename,
+                                          const std::string& type,
+                                          DataStreamPtr& stream)> Decoder;
+
+    // Converts the images of a request for its dimension once every
+    // file has loaded, images that were already in memory included.
+    // Called on the decode threads, so it must be thread safe.
+    typedef std::function<void(Request& request)> Converter;
+
+    // A decodeThreads count of 0 uses one thread per core, less one
+    // for the main thread. Without a decoder files are loaded with 
+    // TextureImage::load.
+    TextureLoadQueue(const Decoder& decoder = Decoder(),
+                     const Converter& converter = Converter(),
+                     size_t decodeThreads = 0);
+    virtual ~TextureLoadQueue();
+
+    void                         submit(const RequestPtr& request);
+
+    // Returns the next decoded request, or an empty pointer.
+    RequestPtr                   popDecoded();
+    // Blocks until a decoded request is available. Only call this 
+    // while requests are outstanding.
+    RequestPtr                   waitDecoded();
+
+    // Requests submitted and not yet returned by popDecoded/waitDecoded.
+    size_t                       outstanding() const;
+
+  protected:
+    void                         ioThread();
+    void                         decodeThread();
+
+  private:
+    struct RequestOrder
+    {
+        bool operator()(const RequestPtr& a, const RequestPtr& b) const;
+    };
+    typedef std::priority_queue<RequestPtr, std::vector<RequestPtr>, RequestOrder> RequestQueue;
+
+    Decoder                      _decoder;
+    Converter                    _converter;
+    mutable std::mutex           _lock;
+    std::condition_variable      _readSignal;
+    std::condition_variable      _decodeSignal;
+    std::condition_variable      _decodedSignal;
+    RequestQueue                 _readQueue;
+    RequestQueue                 _decodeQueue;
+    std::deque<RequestPtr>       _decoded;
+    size_t                       _sequence;
+    size_t                       _outstanding;
+    bool                         _running;
+
+    std::thread                  _ioThread;
+    std::vector<std::thread>     _decodeThreads;
+};
+}
+
+#endif
@@ -46,50 +46,211 @@
 #include <CtrIRenderResourceParameters.h>
 #include <CtrLog.h>
 #include <CtrDDSCodec.h>
+#include <CtrCookedTextureCodec.h>
+#include <CtrCubemapConversion.h>
 #include <CtrFreeImageCodec.h>
 #include <CtrTextureImage.h>
 #include <CtrApplication.h>
 #include <CtrStringUtilities.h>
 #include <direct.h>
+#include <ppl.h>
 
 namespace Ctr
 {
+AsyncTexture::AsyncTexture(const std::string& key, ITexture* placeholder) :
+    _key(key),
+    _placeholder(placeholder),
+    _texture(nullptr),
+    _ready(false),
+    _future(_promise.get_future().share()),
+    _mainThread(std::this_thread::get_id())
+{
+}
 
+AsyncTexture::~AsyncTexture()
+{
+}
 
-TextureImagePtr
-TextureMgr::loadImage(const std::string& filePathName, 
-                      const Ctr::Hash& archiveHash)
+const std::string&
+AsyncTexture::key() const
+{
+    return _key;
+}
+
+ITexture*
+AsyncTexture::texture() const
+{
+    return _texture ? _texture : _placeholder;
+}
+
+bool
+AsyncTexture::ready() const
+{
+    return _ready;
+}
+
+bool
+AsyncTexture::failed() const
+{
+    return _ready && _texture == nullptr;
+}
+
+std::shared_future<ITexture*>
+AsyncTexture::future() const
+{
+    // Waiting on the main thread would never return, see the header.
+    assert(_ready || std::this_thread::get_id() != _mainThread);
+    return _future;
+}
+
+void
+AsyncTexture::onReady(const Callback& callback)
 {
-    TextureImagePtr image;
+    if (_ready)
+    {
+        callback(_texture);
+    }
+    else
+    {
+        _callbacks.push_back(callback);
+    }
+}
+
+void
+AsyncTexture::resolve(ITexture* texture)
+{
+    _texture = texture;
+    _ready = true;
+    _promise.set_value(texture);
+
+    std::vector<Callback> callbacks;
+    callbacks.swap(_callbacks);
+    for (auto it = callbacks.begin(); it != callbacks.end(); it++)
+    {
+        (*it)(texture);
+    }
+}
 
+Ctr::Hash
+TextureMgr::imageHash(const std::string& filePathName,
+                      const Ctr::Hash& archiveHash)
+{
     Ctr::Hash fileHash;
     fileHash.build(filePathName);
     fileHash.append(archiveHash);
+    return fileHash;
+}
 
+TextureImagePtr
+TextureMgr::cachedImage(const Ctr::Hash& fileHash) const
+{
+    std::lock_guard<std::mutex> lock(_imageLock);
     auto it = _images.find(fileHash);
     if (it != _images.end())
     {
         return it->second;
     }
-    else
+    return TextureImagePtr();
+}
+
+TextureImagePtr
+TextureMgr::loadImage(const std::string& filePathName, 
+                      const Ctr::Hash& archiveHash)
+{
+    DataStreamPtr stream;
+    return loadImage(filePathName, archiveHash, std::string(), stream);
+}
+
+TextureImagePtr
+TextureMgr::loadImage(const std::string& filePathName, 
+                      const Ctr::Hash& archiveHash,
+                      const std::string& type,
+                      DataStreamPtr& stream)
+{
+    Ctr::Hash fileHash = imageHash(filePathName, archiveHash);
+
+    // Either find the image, join a load already in flight, or 
+    // register this call as the one that loads it.
+    std::promise<TextureImagePtr> loaded;
+    std::shared_future<TextureImagePtr> inFlight;
+    {
+        std::lock_guard<std::mutex> lock(_imageLock);
+        auto it = _images.find(fileHash);
+        if (it != _images.end())
+        {
+            return it->second;
+        }
+
+        auto loading = _loadingImages.find(fileHash);
+        if (loading != _loadingImages.end())
+        {
+            inFlight = loading->second;
+        }
+        else
+        {
+            _loadingImages.insert(std::make_pair(fileHash, loaded.get_future().share()));
+        }
+    }
+
+    if (inFlight.valid())
     {
-        image.reset(new Ctr::TextureImage());
-        image->load(filePathName.c_str(), std::string(), archiveHash);
+        return inFlight.get();
+    }
+
+    TextureImagePtr image(new Ctr::TextureImage());
+    try
+    {
+        if (stream)
+        {
+            image->load(stream, type);
+        }
+        else
+        {
+            image->load(filePathName.c_str(), std::string(), archiveHash);
+        }
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_imageLock);
+            _loadingImages.erase(fileHash);
+        }
+        loaded.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_imageLock);
         if (image->valid())
         {
             _images.insert(std::make_pair(fileHash, image));
         }
-        return image;
+        _loadingImages.erase(fileHash);
     }
+    loaded.set_value(image);
+    return image;
 }
 
 std::vector<TextureImagePtr>
 TextureMgr::loadImages(const std::vector<std::string>& filenames)
 {
+    std::vector<TextureImagePtr> loaded(filenames.size());
+    concurrency::parallel_for(size_t(0), filenames.size(), [&](size_t fileId)
+    {
+        try
+        {
+            loaded[fileId] = loadImage(filenames[fileId], Ctr::Hash());
+        }
+        catch (const std::exception& e)
+        {
+            LOG("Failed to load image " << filenames[fileId] << " " << e.what());
+        }
+    });
+
     std::vector<TextureImagePtr> images;
-    for (auto it = filenames.begin(); it != filenames.end(); it++)
+    for (size_t fileId = 0; fileId < filenames.size(); fileId++)
     {
-        if (Ctr::TextureImagePtr image = loadImage(*it, Ctr::Hash()))
+        if (Ctr::TextureImagePtr image = loaded[fileId])
         {
             if (image->valid())
             {
@@ -98,7 +259,7 @@ TextureMgr::loadImages(const std::vector<std::string>& filenames)
         }
         else
         {
-            LOG("Failed to load image " << *it << " " << __LINE__ << " " << __FILE__);
+            LOG("Failed to load image " << filenames[fileId] << " " << __LINE__ << " " << __FILE__);
         }
     }
     return images;
@@ -106,17 +267,36 @@ TextureMgr::loadImages(const std::vector<std::string>& filenames)
 
 TextureMgr::TextureMgr(const Ctr::Application* application,
                        Ctr::IDevice* device) :  
-    _deviceInterface(device)
+    _deviceInterface(device),
+    _uploadBudget(size_t(32) << 20)
 {
+    for (size_t placeholderId = 0; placeholderId < PlaceholderCount; placeholderId++)
+    {
+        _placeholderTextures[placeholderId] = nullptr;
+    }
+
 #if IBL_USE_ASS_IMP_AND_FREEIMAGE
     FreeImageCodec::startup();
 #endif
     DDSCodec::startup();
+    CookedTextureCodec::startup();
 
 }
 
 TextureMgr::~TextureMgr()
 {
+    // Stop the loader threads before the codecs go away.
+    _loadQueue.reset();
+    _pendingTextures.clear();
+
+    for (size_t placeholderId = 0; placeholderId < PlaceholderCount; placeholderId++)
+    {
+        if (_placeholderTextures[placeholderId])
+        {
+            _deviceInterface->destroyResource(_placeholderTextures[placeholderId]);
+        }
+    }
+
     for (auto it = _textures.begin();
          it != _textures.end();
          it++)
@@ -138,6 +318,7 @@ TextureMgr::~TextureMgr()
     FreeImageCodec::shutdown();
 #endif
     DDSCodec::shutdown();
+    CookedTextureCodec::shutdown();
 
     _textures.erase (_textures.begin(), _textures.end());
 }    
@@ -145,6 +326,248 @@ TextureMgr::~TextureMgr()
 void
 TextureMgr::update(float delta)
 {
+    if (!_loadQueue)
+        return;
+
+    // Create textures for decoded images until this frame's budget is spent.
+    size_t uploadedBytes = 0;
+    while (_uploadBudget == 0 || uploadedBytes < _uploadBudget)
+    {
+        TextureLoadQueue::RequestPtr request = _loadQueue->popDecoded();
+        if (!request)
+            break;
+        upload(request);
+        uploadedBytes += request->bytes;
+    }
+}
+
+void
+TextureMgr::setUploadBudget(size_t bytes)
+{
+    _uploadBudget = bytes;
+}
+
+size_t
+TextureMgr::uploadBudget() const
+{
+    return _uploadBudget;
+}
+
+AsyncTexturePtr
+TextureMgr::loadTextureAsync (const std::string& filename,
+                              Ctr::TextureDimension dimension,
+                              TextureLoadQueue::Priority priority)
+{
+    std::vector<std::string> filenames;
+    filenames.push_back(filename);
+    return queueLoad(filename, filenames, dimension, priority);
+}
+
+AsyncTexturePtr
+TextureMgr::loadTextureSetAsync (const std::string& key, 
+                                 const std::vector<std::string> & filenames,
+                                 TextureLoadQueue::Priority priority)
+{
+    return queueLoad(key, filenames, Ctr::TwoD, priority);
+}
+
+AsyncTexturePtr
+TextureMgr::queueLoad (const std::string& key,
+                       const std::vector<std::string>& filenames,
+                       Ctr::TextureDimension dimension,
+                       TextureLoadQueue::Priority priority)
+{
+    auto pending = _pendingTextures.find(key);
+    if (pending != _pendingTextures.end())
+    {
+        return pending->second;
+    }
+
+    AsyncTexturePtr handle(new AsyncTexture(key, placeholderTexture(dimension == Ctr::CubeMap ? 
+                                                                    PlaceholderCube : PlaceholderColor)));
+    if (ITexture* texture = findTexture(key))
+    {
+        handle->resolve(texture);
+        return handle;
+    }
+
+    if (!_loadQueue)
+    {
+        // Decodes go through loadImage, so they share the image cache and 
+        // loads in flight with the synchronous paths.
+        // Cube maps go through the same conversion as loadCubeTexture.
+        _loadQueue.reset(new TextureLoadQueue([this](const std::string& filename,
+                                                     const std::string& type,
+                                                     DataStreamPtr& stream)
+        {
+            return loadImage(filename, Ctr::Hash(), type, stream);
+        },
+        [](TextureLoadQueue::Request& request)
+        {
+            if (request.dimension == Ctr::CubeMap)
+                convertToCubemap(request.key, request.images);
+        }));
+    }
+
+    TextureLoadQueue::RequestPtr request(new TextureLoadQueue::Request());
+    request->key = key;
+    request->filenames = filenames;
+    request->dimension = dimension;
+    request->priority = priority;
+
+    // Images that are already cached skip the I/O and decode stages.
+    request->images.resize(filenames.size());
+    for (size_t fileId = 0; fileId < filenames.size(); fileId++)
+    {
+        request->images[fileId] = cachedImage(imageHash(filenames[fileId], Ctr::Hash()));
+    }
+
+    _pendingTextures.insert(std::make_pair(key, handle));
+    _loadQueue->submit(request);
+
+    return handle;
+}
+
+void
+TextureMgr::upload (const TextureLoadQueue::RequestPtr& request)
+{
+    AsyncTexturePtr handle;
+    auto pending = _pendingTextures.find(request->key);
+    if (pending != _pendingTextures.end())
+    {
+        handle = pending->second;
+        _pendingTextures.erase(pending);
+    }
+
+    // The decoded images were cached by loadImage on the decode threads.
+    TextureImageArray images;
+    for (size_t fileId = 0; fileId < request->filenames.size(); fileId++)
+    {
+        if (const TextureImagePtr& image = request->images[fileId])
+        {
+            images.push_back(image);
+        }
+    }
+
+    // A partial set is not uploaded, the handle keeps its placeholder 
+    // and its callbacks see the failure.
+    ITexture* texture = findTexture(request->key);
+    if (!texture && request->failed)
+    {
+        LOG ("Failed  " << request->key);
+    }
+    else if (!texture)
+    {
+        Ctr::TextureParameters resource = (request->dimension == Ctr::ThreeD) ?
+            Ctr::TextureParameters(request->filenames, 
+                                   images,
+                                   Ctr::ThreeD, 
+                                   Ctr::FromFile, 
+                                   Ctr::PF_A8R8G8B8, 
+                                   Ctr::Vector3i(0, 0, 0),
+                                   true, // generate mips
+                                   1 /* number of textures*/ ) :
+            Ctr::TextureParameters(request->filenames, images, request->dimension);
+
+        if (texture = _deviceInterface->createTexture(&resource))
+        {
+            _textures.insert (std::make_pair(request->key, texture));
+            LOG ("Loaded texture " << request->key);
+        }
+        else
+        {
+            LOG ("Failed  " << request->key);
+        }
+    }
+
+    if (handle)
+    {
+        handle->resolve(texture);
+    }
+}
+
+void
+TextureMgr::finishAsyncLoad (const std::string& key)
+{
+    while (_loadQueue && _pendingTextures.find(key) != _pendingTextures.end())
+    {
+        TextureLoadQueue::RequestPtr request = _loadQueue->waitDecoded();
+        if (!request)
+            break;
+        upload(request);
+    }
+}
+
+void
+TextureMgr::finishAsyncLoads()
+{
+    while (_loadQueue && !_pendingTextures.empty())
+    {
+        TextureLoadQueue::RequestPtr request = _loadQueue->waitDecoded();
+        if (!request)
+            break;
+        upload(request);
+    }
+}
+
+ITexture*
+TextureMgr::placeholderTexture(Placeholder placeholder)
+{
+    ITexture*& texture = _placeholderTextures[placeholder];
+    if (!texture)
+    {
+        // A8R8G8B8 texels.
+        static const uint32_t texels[PlaceholderCount] = 
+        { 
+            0xff808080,
+            0xff8080ff,
+            0xffff00ff,
+            0xff000000
+        };
+        static const char* names[PlaceholderCount] = 
+        { 
+            "placeholder", 
+            "placeholderNormal", 
+            "placeholderRMC", 
+            "placeholderCube" 
+        };
+
+        const bool cube = placeholder == PlaceholderCube;
+        TextureImagePtr image(new Ctr::TextureImage());
+        image->create(Ctr::Vector2i(1, 1), Ctr::PF_A8R8G8B8, 0, cube ? IF_CUBEMAP : 0);
+        for (size_t face = 0; face < image->getNumFaces(); face++)
+        {
+            *reinterpret_cast<uint32_t*>(image->getWritablePixelBox(face, 0).data) = texels[placeholder];
+        }
+
+        std::vector<std::string> filenames;
+        filenames.push_back(names[placeholder]);
+        TextureImageArray images;
+        images.push_back(image);
+
+        TextureParameters resource = TextureParameters(filenames, images, cube ? Ctr::CubeMap : Ctr::TwoD);
+        texture = _deviceInterface->createTexture(&resource);
+    }
+    return texture;
+}
+
+void
+TextureMgr::convertToCubemap(const std::string& key, TextureImageArray& images)
+{
+    // Lat-long and cross environments are converted to six faces.
+    CubemapLayout layout;
+    if (images.size() == 1 && images[0]->getNumFaces() == 1 &&
+        CubemapConversion::detectLayout(images[0]->getWidth(), images[0]->getHeight(), layout))
+    {
+        const size_t faceSize = CubemapConversion::naturalFaceSize(layout, images[0]->getWidth());
+        // floor(log2(faceSize)) levels below the top, down to 1x1.
+        uint32_t numMipmaps = 0;
+        while ((faceSize >> (numMipmaps + 1)) > 0)
+            numMipmaps++;
+        images[0] = CubemapConversion::convert(*images[0], layout, faceSize, 
+                                               CUBE_SAMPLE_AREA, PF_UNKNOWN, numMipmaps);
+        LOG ("Converted " << key << " to a " << faceSize << " cubemap");
+    }
 }
 
 ITexture*
@@ -155,6 +578,7 @@ TextureMgr::loadTexture (const std::string& filename,
         return nullptr;
     LOG ("Attempting to load texture " << filename);
 
+    finishAsyncLoad(filename);
     ITexture* texture = findTexture (filename);
     if (!texture)
     {
@@ -182,6 +606,7 @@ ITexture*
 TextureMgr::loadTextureSet (const std::string& key, 
                             const std::vector<std::string>      & filenames)
 {
+    finishAsyncLoad(key);
     ITexture* texture = findTexture (key);
     if (!texture)
     {
@@ -254,6 +679,7 @@ TextureMgr::loadCubeTexture (const std::string& filename,
     if (filename.length() == 0)
         return nullptr;
 
+    finishAsyncLoad(filename);
     ITexture* texture = findTexture (filename);
     if (!texture)
     {
@@ -261,7 +687,10 @@ TextureMgr::loadCubeTexture (const std::string& filename,
         std::vector<std::string>       filenames;
         filenames.push_back(filename);
 
-        TextureParameters resource = TextureParameters(filenames, loadImages(filenames), dimension);
+        std::vector<TextureImagePtr> images = loadImages(filenames);
+        convertToCubemap(filename, images);
+
+        TextureParameters resource = TextureParameters(filenames, images, dimension);
         if (texture = _deviceInterface->createTexture(&resource))
         {
             _textures.insert (std::make_pair(std::string(filename), texture));        
@@ -279,6 +708,7 @@ const ITexture*
 TextureMgr::loadThreeD (const std::string& filename,
                         Ctr::PixelFormat format)
 {
+    finishAsyncLoad(filename);
     ITexture* texture = findTexture (filename);
     
     if (!texture)
@@ -46,6 +46,11 @@
 #include <CtrRenderEnums.h>
 #include <CtrHash.h>
 #include <CtrTextureImage.h>
+#include <CtrTextureLoadQueue.h>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
 
 namespace Ctr
 {
@@ -54,6 +59,54 @@ class IDevice;
 class Texture2DProperty;
 class ITexture;
 
+//-----------------------------------------------------------------
+// Handle to a texture that is being loaded in the background.
+// texture() returns the placeholder until the load completes.
+// Resolved by TextureMgr::update on the main thread.
+//-----------------------------------------------------------------
+class AsyncTexture
+{
+  public:
+    typedef std::function<void(ITexture*)> Callback;
+
+    AsyncTexture(const std::string& key, ITexture* placeholder);
+    virtual ~AsyncTexture();
+
+    const std::string&           key() const;
+
+    ITexture*                    texture() const;
+    bool                         ready() const;
+    bool                         failed() const;
+
+    // Resolves to the loaded texture, or nullptr if it failed.
+    // The future is fulfilled by TextureMgr::update on the main thread,
+    // so waiting on it there deadlocks. Off the main thread it can be
+    // waited on, the main thread polls ready() or uses onReady, or
+    // calls TextureMgr::finishAsyncLoads to block.
+    std::shared_future<ITexture*> future() const;
+
+    // Called on the main thread once the load completes, or 
+    // immediately if it already has. The callback is given nullptr
+    // if any file failed to load, texture() stays the placeholder.
+    void                         onReady(const Callback& callback);
+
+  protected:
+    friend class TextureMgr;
+    void                         resolve(ITexture* texture);
+
+  private:
+    std::string                  _key;
+    ITexture*                    _placeholder;
+    ITexture*                    _texture;
+    bool                         _ready;
+    std::promise<ITexture*>      _promise;
+    std::shared_future<ITexture*> _future;
+    std::vector<Callback>        _callbacks;
+    // The thread that resolves the handle.
+    std::thread::id              _mainThread;
+};
+typedef std::shared_ptr<AsyncTexture> AsyncTexturePtr;
+
 class TextureMgr
 {
   public:
@@ -72,6 +125,40 @@ class TextureMgr
     // Load texture from an array of images.
     ITexture*                    removeProperty ();
 
+    // Asynchronous loads. Files are read and decoded in the background, 
+    // textures are created by update() within the upload budget.
+    AsyncTexturePtr              loadTextureAsync (const std::string& filename,
+                                                   Ctr::TextureDimension dimension = Ctr::TwoD,
+                                                   TextureLoadQueue::Priority priority = TextureLoadQueue::PRIORITY_NORMAL);
+
+    AsyncTexturePtr              loadTextureSetAsync (const std::string& key, 
+                                                      const std::vector<std::string> & filenames,
+                                                      TextureLoadQueue::Priority priority = TextureLoadQueue::PRIORITY_NORMAL);
+
+    // Bytes of decoded image data uploaded per update(). At least one
+    // texture is created per update. 0 is unlimited.
+    void                         setUploadBudget(size_t bytes);
+    size_t                       uploadBudget() const;
+
+    // Blocks until every asynchronous load has completed.
+    void                         finishAsyncLoads();
+
+    // Neutral 1x1 textures bound in place of textures still loading, 
+    // one per kind of map so that the shading stays valid.
+    enum Placeholder
+    {
+        // Mid grey.
+        PlaceholderColor = 0,
+        // Flat tangent space normal.
+        PlaceholderNormal,
+        // Roughness 1, metal 0, cavity 1, as Material's userRMC default.
+        PlaceholderRMC,
+        // Black cube map.
+        PlaceholderCube,
+        PlaceholderCount
+    };
+    ITexture*                    placeholderTexture(Placeholder placeholder = PlaceholderColor);
+
 
     // Usually for texture reads or building complex maps. These textures cannot be bound on the GPU.
     ITexture*                     loadStagingTexture(const std::string& filename);
@@ -92,20 +179,55 @@ class TextureMgr
 
     void                          update (float delta);
 
+    // Thread safe. Concurrent requests for the same image load it once.
     TextureImagePtr               loadImage(const std::string& filePathName,
                                             const Ctr::Hash& archiveHash);
+    // Loads the images in parallel.
     std::vector<TextureImagePtr>  loadImages(const std::vector<std::string>& filenames);
 
   protected:
     ITexture*                    findTexture (const std::string& name);
 
+    AsyncTexturePtr              queueLoad (const std::string& key,
+                                            const std::vector<std::string>& filenames,
+                                            Ctr::TextureDimension dimension,
+                                            TextureLoadQueue::Priority priority);
+    void                         upload (const TextureLoadQueue::RequestPtr& request);
+    void                         finishAsyncLoad (const std::string& key);
+
+    // Converts a lat-long or cross environment in images to six faces
+    // with a full mip chain. Thread safe.
+    static void                  convertToCubemap (const std::string& key,
+                                                   TextureImageArray& images);
+
+    // As loadImage, but decodes from stream when it is open. Used by
+    // the asynchronous decode threads to share the cache and loads in flight.
+    TextureImagePtr              loadImage(const std::string& filePathName,
+                                           const Ctr::Hash& archiveHash,
+                                           const std::string& type,
+                                           DataStreamPtr& stream);
+
+    static Ctr::Hash             imageHash (const std::string& filePathName,
+                                            const Ctr::Hash& archiveHash);
+    TextureImagePtr              cachedImage (const Ctr::Hash& fileHash) const;
+
   private:
     typedef std::map<std::string, ITexture*> TextureMap;
     typedef std::map<Ctr::Hash, TextureImagePtr> ImageMap;
+    typedef std::map<Ctr::Hash, std::shared_future<TextureImagePtr> > ImageLoadMap;
+    typedef std::map<std::string, AsyncTexturePtr> AsyncTextureMap;
     TextureMap                   _textures;
     TextureMap                   _stagingTextures;
     ImageMap                     _images;
+    // Images being loaded by loadImage, guarded along with _images.
+    ImageLoadMap                 _loadingImages;
+    mutable std::mutex           _imageLock;
     Ctr::IDevice*                _deviceInterface;
+
+    std::unique_ptr<TextureLoadQueue> _loadQueue;
+    AsyncTextureMap              _pendingTextures;
+    size_t                       _uploadBudget;
+    ITexture*                    _placeholderTextures[PlaceholderCount];
 };
 }
 
@@ -75,6 +75,14 @@ PixelFormat findFormat(DXGI_FORMAT format)
             return PF_DXT2;
         case DXGI_FORMAT_BC3_UNORM:
             return PF_DXT4;
+        case DXGI_FORMAT_BC4_UNORM:
+            return PF_BC4;
+        case DXGI_FORMAT_BC5_UNORM:
+            return PF_BC5;
+        case DXGI_FORMAT_BC7_UNORM:
+            return PF_BC7;
+        case DXGI_FORMAT_BC6H_UF16:
+            return PF_BC6H;
         case DXGI_FORMAT_R16_TYPELESS:
             return PF_DEPTH16;
         case DXGI_FORMAT_R32_TYPELESS:
@@ -146,6 +154,14 @@ DXGI_FORMAT findFormat(PixelFormat format)
             return DXGI_FORMAT_BC3_UNORM;
         case PF_DXT5:
             return DXGI_FORMAT_BC3_UNORM;
+        case PF_BC4:
+            return DXGI_FORMAT_BC4_UNORM;
+        case PF_BC5:
+            return DXGI_FORMAT_BC5_UNORM;
+        case PF_BC7:
+            return DXGI_FORMAT_BC7_UNORM;
+        case PF_BC6H:
+            return DXGI_FORMAT_BC6H_UF16;
         case PF_DEPTH16:
             return DXGI_FORMAT_R16_TYPELESS;
         case PF_DEPTH32:
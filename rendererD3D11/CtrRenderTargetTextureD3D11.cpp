@@ -58,7 +58,8 @@ _surface (nullptr),
 _texture (nullptr),
 _uav(nullptr),
 _mappedSubresourceId(-1),
-_stagingTexture(nullptr)
+_stagingTexture(nullptr),
+_readRequested(false)
 {
 }
 
@@ -127,9 +128,54 @@ RenderTargetTextureD3D11::unmapFromRead() const
     return false;
 }
 
+bool
+RenderTargetTextureD3D11::requestRead() const
+{
+    if (_readRequested)
+    {
+        // Refresh the pending copy.
+        _immediateCtx->CopyResource(_stagingTexture, _texture);
+        return true;
+    }
+
+    if (mapForRead())
+    {
+        _readRequested = true;
+        return true;
+    }
+    return false;
+}
+
+bool
+RenderTargetTextureD3D11::readReady() const
+{
+    if (!_readRequested)
+        return false;
+
+    // Polls the copy without stalling on it.
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    HRESULT hr = _immediateCtx->Map(_stagingTexture, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mappedResource);
+    if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+    {
+        return false;
+    }
+    if (SUCCEEDED(hr))
+    {
+        _immediateCtx->Unmap(_stagingTexture, 0);
+    }
+    return true;
+}
+
 bool                
 RenderTargetTextureD3D11::mapForRead() const
 {
+    if (_readRequested)
+    {
+        // The staging texture already holds the copy from requestRead.
+        _readRequested = false;
+        return true;
+    }
+
     if (!_mapped)
     {
         // If it's a texture2D
@@ -525,6 +571,10 @@ RenderTargetTextureD3D11::free()
     safedelete(_surface);
     saferelease(_uav);
 
+    // Drops a pending requestRead.
+    unmapFromRead();
+    _readRequested = false;
+
     return __super::free();
 }
 
@@ -75,11 +75,17 @@ class RenderTargetTextureD3D11 : public Ctr::TextureD3D11
     virtual bool                map(uint32_t imageLevel = 0, uint32_t mipLevel = 0) const;
     virtual bool                unmap() const;
 
+    // Copies into the staging texture, the next mapForRead uses the copy.
+    virtual bool                requestRead() const;
+    virtual bool                readReady() const;
+
     const D3D11_TEXTURE2D_DESC desc() const { return _desc; }
 
   private:
     D3D11_TEXTURE2D_DESC        _desc;
     mutable ID3D11Texture2D *   _stagingTexture;
+    // The staging texture holds a copy from requestRead.
+    mutable bool                _readRequested;
 
   private:
     ID3D11Texture2D*                _texture;
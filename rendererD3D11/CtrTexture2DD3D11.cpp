@@ -217,15 +217,16 @@ Texture2DD3D11::create()
         size_t offset = 0;
         for (size_t imageId = 0; imageId < images.size(); imageId++)
         {
-            const Ctr::TextureImagePtr& image = images[imageId];
-            for (size_t face = 0; face < image->getNumFaces(); face++)
+            // Uploads only read the pixels, shared images stay shared.
+            const Ctr::TextureImage& image = *images[imageId];
+            for (size_t face = 0; face < image.getNumFaces(); face++)
             {
                 for (size_t m = 0; m < mipMapCount; m++)
                 {
                     size_t outNumBytes = 0;
                     size_t outNumRows = 0;
                     size_t outRowBytes = 0;
-                    Ctr::PixelBox box = image->getPixelBox(face, m);
+                    Ctr::ConstPixelBox box = image.getPixelBox(face, m);
 
                     GetSurfaceInfo( box.size().x,
                                     box.size().y,
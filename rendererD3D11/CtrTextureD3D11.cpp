@@ -43,23 +43,24 @@
 #include <CtrLog.h>
 #include <CtrFormatConversionD3D11.h>
 #include <CtrFilterCubemap.h>
+#include <CtrImageStatistics.h>
 #include <strstream>
 namespace Ctr
 {
 
 template <typename T>
 void
-splitChannelsForFormat (TextureImagePtr& src, TextureImagePtr& rgb, TextureImagePtr& mmm)
+splitChannelsForFormat (const TextureImage& src, TextureImagePtr& rgb, TextureImagePtr& mmm)
 {
-    for(size_t face = 0; face < src->getNumFaces(); face++)
+    for(size_t face = 0; face < src.getNumFaces(); face++)
     {
-        for (size_t m = 0; m < src->getNumMipmaps(); m++)
+        for (size_t m = 0; m < src.getNumMipmaps(); m++)
         {
-            Ctr::PixelBox srcBox = src->getPixelBox(face, m);
-            Ctr::PixelBox rgbBox = rgb->getPixelBox(face, m);
-            Ctr::PixelBox mmmBox = mmm->getPixelBox(face, m);
+            Ctr::ConstPixelBox srcBox = src.getPixelBox(face, m);
+            Ctr::PixelBox rgbBox = rgb->getWritablePixelBox(face, m);
+            Ctr::PixelBox mmmBox = mmm->getWritablePixelBox(face, m);
 
-            typename T * srcPtr = (typename T*)srcBox.data;
+            const typename T * srcPtr = (const typename T*)srcBox.data;
             typename T * rgbPtr = (typename T*)rgbBox.data;
             typename T * mmmPtr = (typename T*)mmmBox.data;
 
@@ -93,16 +94,16 @@ splitChannelsForFormat (TextureImagePtr& src, TextureImagePtr& rgb, TextureImage
 
 // Copy a source mip slice to the top mip of a specified image.
 void
-copyMip (TextureImagePtr& dst, const TextureImagePtr& src, int32_t mipLevel)
+copyMip (TextureImagePtr& dst, const TextureImage& src, int32_t mipLevel)
 {
     // Copy number of images for specified mip level
     for (uint32_t faceId = 0; faceId < dst->getNumFaces(); faceId++)
     {
-        PixelBox dstBox = dst->getPixelBox(faceId);
-        PixelBox srcBox = src->getPixelBox(faceId, mipLevel);
+        PixelBox dstBox = dst->getWritablePixelBox(faceId);
+        ConstPixelBox srcBox = src.getPixelBox(faceId, mipLevel);
         // Copy A to B
         uint8_t * dstPixels = (uint8_t*)dstBox.data;
-        uint8_t * srcPixels = (uint8_t*)srcBox.data;
+        const uint8_t * srcPixels = (const uint8_t*)srcBox.data;
         size_t byteSize = dstBox.size().y * dstBox.rowPitch * dstBox.getNumChannels();
         memcpy (dstPixels, srcPixels, byteSize);
     }
@@ -247,132 +248,54 @@ TextureD3D11::maxValue() const
                              (uint32_t)parameters->mipLevels(),
                              parameters->dimension() == Ctr::CubeMap ? IF_CUBEMAP : 0);
 
-        Ctr::Vector4f maxValue;
+        _maxValue = Ctr::Vector4f(0,0,0,0);
 
         if (mapForRead())
         {
-            size_t dstOffset = 0;
-            size_t srcOffset = 0;
-
-            uint8_t * dstData = (uint8_t*)textureImage->getData();
             uint32_t bytesPerPixel = (uint32_t)(bitsPerPixel(findFormat(this->format())) / 8);
 
+            // Only the top level mip of each face is reduced.
             for(size_t face = 0; face < textureImage->getNumFaces(); face++)
             {
-                for (size_t m = 0; m < parameters->mipLevels(); m++)
-                {
-                    map((uint32_t)face, (uint32_t)m);
-                    uint8_t * srcData = (uint8_t*)_mappedResource.pData;
-
-                    size_t outNumBytes = 0;
-                    size_t outNumRows = 0;
-                    size_t outRowBytes = 0;
-                    Ctr::PixelBox box = textureImage->getPixelBox(face, m);
+                map((uint32_t)face, 0);
+                uint8_t * srcData = (uint8_t*)_mappedResource.pData;
 
-                    size_t dstRowPitch = box.size().x * bytesPerPixel;
+                size_t outNumBytes = 0;
+                size_t outNumRows = 0;
+                size_t outRowBytes = 0;
+                Ctr::PixelBox box = textureImage->getWritablePixelBox(face, 0);
+                uint8_t * dstData = (uint8_t*)box.data;
 
-                    GetSurfaceInfo( box.size().x,
-                                    box.size().y,
-                                    findFormat(this->format()),
-                                    &outNumBytes,
-                                    &outRowBytes,
-                                    &outNumRows);
+                size_t dstRowPitch = box.size().x * bytesPerPixel;
 
-                    // Take into account row skip alignment.
-                    for (size_t y = 0; y < outNumRows; y++)
-                    {
-                        // Copy each row for each mipmap
-                        memcpy(dstData, srcData, dstRowPitch);
-
-                        // If row stride == row bytestride.
-                        // 16 is for d3d11 cards, if d3d10 support is ever added, this must be altered to 
-                        // 4 for cards that support it.
-                        srcData += _mappedResource.RowPitch;
-                        dstData += dstRowPitch;
-                    }
-                    unmap();
-                }
-             }
-            unmapFromRead();
-        }
+                GetSurfaceInfo( box.size().x,
+                                box.size().y,
+                                findFormat(this->format()),
+                                &outNumBytes,
+                                &outRowBytes,
+                                &outNumRows);
 
-        // Compute the max value.
-        PixelFormat internalFormat = parameters->format();
-        float maxValueDistance = 0;
-        Ctr::Vector4f zero (0,0,0,0);
-        switch (internalFormat)
-        {
-            case PF_FLOAT32_RGBA:
-            case PF_FLOAT32_RGB:
-            case PF_FLOAT32_GR:
-            case PF_FLOAT32_R:
-            {
-                for (uint32_t faceId = 0; faceId < textureImage->getNumFaces(); faceId++)
+                // Take into account row skip alignment.
+                for (size_t y = 0; y < outNumRows; y++)
                 {
-                    PixelBox pixelBox = textureImage->getPixelBox(faceId, 0);
-
-                    float* pixels = (float*)pixelBox.data;
-                    for (uint32_t y = 0; y < pixelBox.size().y; y++)
-                    {
-                        for (uint32_t x = 0; x < pixelBox.size().x; x++)
-                        {
-                            Ctr::Vector4f testValue(0,0,0,0);
-                            memcpy(&testValue.x, &pixels[(((y * pixelBox.size().x) + x) * pixelBox.getNumChannels())], sizeof(float)*pixelBox.getNumChannels());
-                            testValue.w = 0.0;
-                            // Rescale is color
-                            float testDistance = testValue.distance(zero);
-                            if (testDistance > maxValueDistance)
-                            {
-                                _maxValue = testValue;
-                                maxValueDistance = testDistance;
-                            }
-                        }
-                    }
+                    memcpy(dstData, srcData, dstRowPitch);
+                    srcData += _mappedResource.RowPitch;
+                    dstData += dstRowPitch;
                 }
-                break;
+                unmap();
             }
-            case PF_FLOAT16_RGBA:
-            case PF_FLOAT16_RGB:
-            case PF_FLOAT16_GR:
-            case PF_FLOAT16_R:
+            unmapFromRead();
+
+            // The brightest texel (largest rgb length) over every face.
+            if (PixelUtil::isAccessible(parameters->format()))
             {
-                // TODO: Half support
-                LOG("TODO: Unhandled format computing maxvalue. " << __LINE__ << " " << __FILE__)
+                Ctr::ImageStatistics::Summary summary = Ctr::ImageStatistics::compute(*textureImage, 0);
+                _maxValue = Ctr::Vector4f(summary.brightest[0], summary.brightest[1], summary.brightest[2], 0.0f);
             }
-            case PF_A8B8G8R8:
-            case PF_A8R8G8B8:
-            case PF_R8G8B8:
-            case PF_B8G8R8:
-            case PF_R8:
+            else
             {
-                for (uint32_t faceId = 0; faceId < textureImage->getNumFaces(); faceId++)
-                {
-                    PixelBox pixelBox = textureImage->getPixelBox(faceId, 0);
-
-                    uint8_t* pixels = (uint8_t*)pixelBox.data;
-                    for (uint32_t y = 0; y < pixelBox.size().y; y++)
-                    {
-                        for (uint32_t x = 0; x < pixelBox.size().x; x++)
-                        {
-                            Ctr::Vector4f testValue(0,0,0,0);
-                            for (uint32_t c = 0; c < pixelBox.getNumChannels(); c++)
-                            {
-                                testValue[c] = ((float)pixels[(((y * pixelBox.size().x) + x) * pixelBox.getNumChannels())]) / 255.0f;
-                            }
-                            // Rescale is color
-                            float testDistance = testValue.distance(zero);
-                            if (testDistance > maxValueDistance)
-                            {
-                                _maxValue = testValue;
-                                maxValueDistance = testDistance;
-                            }
-                        }
-                    }
-                }
-                break;
-            }
-            default:
                 LOG ("Unhandled format for max value calcuation");
+            }
         }
 
         _maxValueCached = true;
@@ -383,10 +306,16 @@ TextureD3D11::maxValue() const
 Ctr::TextureImagePtr 
 TextureD3D11::readImage(Ctr::PixelFormat format, int32_t mipId) const
 {
+    // A single mip is read into an image of that size, without mips.
+    const bool singleMip = mipId >= 0 && mipId < (int32_t)resource()->mipLevels();
+    const uint32_t firstMip = singleMip ? (uint32_t)mipId : 0;
+    const uint32_t mipCount = singleMip ? 1 : (uint32_t)resource()->mipLevels();
+
     Ctr::TextureImagePtr textureImage(new Ctr::TextureImage());
-    textureImage->create(Ctr::Vector2i(resource()->width(), resource()->height()), 
+    textureImage->create(Ctr::Vector2i(Ctr::maxValue((int32_t)resource()->width() >> firstMip, 1), 
+                                       Ctr::maxValue((int32_t)resource()->height() >> firstMip, 1)), 
                          resource()->format(),
-                         (uint32_t)resource()->mipLevels(),
+                         singleMip ? 0 : (uint32_t)resource()->mipLevels(),
                          resource()->dimension() == Ctr::CubeMap ? IF_CUBEMAP : 0);
     bool reverse = false;
 
@@ -400,15 +329,16 @@ TextureD3D11::readImage(Ctr::PixelFormat format, int32_t mipId) const
 
         for(size_t face = 0; face < textureImage->getNumFaces(); face++)
         {
-            for (size_t m = 0; m < resource()->mipLevels(); m++)
+            for (size_t m = 0; m < mipCount; m++)
             {
-                map((uint32_t)face, (uint32_t)m);
+                map((uint32_t)face, (uint32_t)(firstMip + m));
                 uint8_t * srcData = (uint8_t*)_mappedResource.pData;
 
                 size_t outNumBytes = 0;
                 size_t outNumRows = 0;
                 size_t outRowBytes = 0;
-                Ctr::PixelBox box = textureImage->getPixelBox(face, m);
+                Ctr::PixelBox box = textureImage->getWritablePixelBox(face, m);
+                dstData = (uint8_t*)box.data;
 
                 size_t dstRowPitch = box.size().x * bytesPerPixel;
 
@@ -522,7 +452,7 @@ TextureD3D11::save(const std::string& filePathName,
 
     if (mipLevel != -1)
     {
-        Ctr::PixelBox sourceBox = textureImage->getPixelBox(0, mipLevel);
+        Ctr::ConstPixelBox sourceBox = textureImage->getPixelBox(0, mipLevel);
         Ctr::PixelFormat format = sourceBox.format;
         if (splitChannels || rgbOnly)
         {
@@ -555,7 +485,7 @@ TextureD3D11::save(const std::string& filePathName,
                 size_t outNumBytes = 0;
                 size_t outNumRows = 0;
                 size_t outRowBytes = 0;
-                Ctr::PixelBox box = textureImage->getPixelBox(face, m);
+                Ctr::ConstPixelBox box = textureImage->getPixelBox(face, m);
 
                 size_t dstRowPitch = box.size().x * bytesPerPixel;
 
@@ -624,7 +554,7 @@ TextureD3D11::save(const std::string& filePathName,
             {
                 Ctr::PixelFormat format;
                 {
-                    Ctr::PixelBox dstBox = textureImage->getPixelBox(0, dstMipId);
+                    Ctr::ConstPixelBox dstBox = textureImage->getPixelBox(0, dstMipId);
                     format = dstBox.format;
                 }
                 // Create merge image
@@ -637,37 +567,16 @@ TextureD3D11::save(const std::string& filePathName,
                 // Copy the faces from the merge image to the mip map for all faces.
                 for (uint32_t mergeFaceId = 0; mergeFaceId < 6; mergeFaceId++)
                 {
-                    Ctr::PixelBox srcBox = mergeImage->getPixelBox(mergeFaceId, 0);
-                    Ctr::PixelBox dstBox = textureImage->getPixelBox(mergeFaceId, dstMipId);
+                    Ctr::ConstPixelBox srcBox = mergeImage->getPixelBox(mergeFaceId, 0);
+                    Ctr::PixelBox dstBox = textureImage->getWritablePixelBox(mergeFaceId, dstMipId);
                     memcpy(dstBox.data, srcBox.data, mergeSize.x * mergeSize.y * 4); // Fix bytes per pixel code.
                 }
             }
         }
 
-        if (this->isCubeMap())
+        if (this->isCubeMap() && !PixelUtil::isCompressed(textureImage->getFormat()))
         {
-            if (parameters->format() == Ctr::PF_A8R8G8B8)
-            {
-                for (uint32_t mipId = 0; mipId < textureImage->getNumMipmaps(); mipId++)
-                {
-                    PixelBox mip = textureImage->getPixelBox();
-                    fixupCubeEdges <uint8_t> (textureImage, 
-                                              mipId,
-                                              CP_FIXUP_AVERAGE_HERMITE, 
-                                              Ctr::maxValue(mip.size().x * 0.015f, 1.0f));
-                }
-            }
-            else if (parameters->format() == PixelFormat::PF_FLOAT32_RGBA)
-            {
-                for (uint32_t mipId = 0; mipId < textureImage->getNumMipmaps(); mipId++)
-                {
-                    PixelBox mip = textureImage->getPixelBox();
-                    fixupCubeEdges <float> (textureImage, 
-                                            mipId,
-                                            CP_FIXUP_AVERAGE_HERMITE, 
-                                            Ctr::maxValue(mip.size().x * 0.015f, 1.0f));
-                }
-            }
+            CubemapSeams::fixup(*textureImage, CP_FIXUP_AVERAGE_HERMITE, 0.015f);
         }
 
         // TODO: Filter for cubemap.
@@ -678,14 +587,14 @@ TextureD3D11::save(const std::string& filePathName,
             switch (threeChannelFormat)
             {
                 case PF_FLOAT32_RGB:
-                    splitChannelsForFormat<typename float>(textureImage, textureImageRGB, textureImageMMM);
+                    splitChannelsForFormat<typename float>(*textureImage, textureImageRGB, textureImageMMM);
                     break;
                 case PF_FLOAT16_RGB:
-                    splitChannelsForFormat<typename uint16_t>(textureImage, textureImageRGB, textureImageMMM);
+                    splitChannelsForFormat<typename uint16_t>(*textureImage, textureImageRGB, textureImageMMM);
                     break;
                 case PF_R8G8B8:
                 case PF_B8G8R8:
-                    splitChannelsForFormat<typename uint8_t>(textureImage, textureImageRGB, textureImageMMM);
+                    splitChannelsForFormat<typename uint8_t>(*textureImage, textureImageRGB, textureImageMMM);
                     break;
             }
 
@@ -701,7 +610,7 @@ TextureD3D11::save(const std::string& filePathName,
                     memset(mipImageFilePathName, 0, 512);
                     sprintf_s(mipImageFilePathName, "%s%d%s", filePathName.substr(0, extension).c_str(), mipLevel, "RGB.dds");
                     // Copy texture image into mip image.
-                    copyMip (mipImage, textureImageRGB, mipLevel);
+                    copyMip (mipImage, *textureImageRGB, mipLevel);
                     mipImage->save(std::string(mipImageFilePathName));
                 }
                 else
@@ -718,13 +627,13 @@ TextureD3D11::save(const std::string& filePathName,
                     sprintf_s(mipImageFilePathName, "%s%d%s", filePathName.substr(0, extension).c_str(), mipLevel, "RGB.dds");
 
                     // Copy texture image into mip image.
-                    copyMip (mipImage, textureImageRGB, mipLevel);
+                    copyMip (mipImage, *textureImageRGB, mipLevel);
                     mipImage->save(std::string(mipImageFilePathName));
 
                     memset(mipImageFilePathName, 0, 512);
                     sprintf_s(mipImageFilePathName, "%s%d%s", filePathName.substr(0, extension).c_str(), mipLevel, "MMM.dds");
                     // Copy texture image into mip image.
-                    copyMip (mipImage, textureImageMMM, mipLevel);
+                    copyMip (mipImage, *textureImageMMM, mipLevel);
                     mipImage->save(mipImageFilePathName);
                 }
                 else
@@ -743,7 +652,7 @@ TextureD3D11::save(const std::string& filePathName,
                 sprintf_s(mipImageFilePathName, "%s%d%s", filePathName.substr(0, extension).c_str(), mipLevel, ".dds");
 
                 // Copy texture image into mip image.
-                copyMip (mipImage, textureImage, mipLevel);
+                copyMip (mipImage, *textureImage, mipLevel);
                 mipImage->save(mipImageFilePathName);
             }
             else
@@ -858,6 +767,9 @@ TextureD3D11::generateMipMaps() const
     {
         _immediateCtx->GenerateMips (resourceView());
     }
+
+    // The contents have been rendered to, recompute the max value on demand.
+    _maxValueCached = false;
 }
 
 DXGI_FORMAT
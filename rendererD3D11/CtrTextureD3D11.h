@@ -94,7 +94,8 @@ protected:
 
     virtual bool               mapForWrite();
     
-    // Dumb max value. Need to implement this on the gpu.
+    // Brightest texel of the top level mip, reduced on the cpu after a readback.
+    // Cached until the next generateMipMaps.
     virtual const Ctr::Vector4f& maxValue() const;
 
     virtual bool               clearSurface (uint32_t layerId, float r  = 1.0f, float g  = 1.0f, float b  = 1.0f, float a = 1.0f) ;
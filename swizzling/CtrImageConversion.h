@@ -47,6 +47,7 @@
 #include <CtrTypedProperty.h>
 #include <CtrIDevice.h>
 #include <CtrBitwise.h>
+#include <CtrGamma.h>
 #include <ppl.h>
 
 namespace Ctr
@@ -154,123 +155,6 @@ namespace Ctr
         {
             dst = src;
         }
-
-        // With gamma conversion.
-        template <typename T, typename S>
-        inline void operator()(T& dst, const S& src, float power) const
-        {
-            dst = T(src);
-        }
-
-        template < >
-        inline void operator()(uint8_t& dst, const uint8_t& src, float power) const
-        {
-            float converted = saturate(pow((((float)src)/255.0f), power));
-            dst = (uint8_t)(converted * 255.0f);
-        }
-
-        template < >
-        inline void operator()(uint8_t& dst, const uint16_t& src, float power) const
-        {
-            float converted = saturate(pow((((float)src) / USHRT_MAX), power));
-            dst = uint8_t(converted * 255.0f);
-        }
-
-        template < >
-        inline void operator()(uint8_t& dst, const half& src, float power) const
-        {
-            float converted = saturate(pow(Bitwise::halfToFloat(src()), power));
-            dst = (uint8_t)(converted * 255.0f);
-        }
-
-        template < >
-        inline void operator()(uint8_t& dst, const float& src, float power) const
-        {
-            float converted = saturate(pow(src, power));
-            dst = (uint8_t)(converted * 255.0f);
-        }
-        template < >
-        inline void operator()(uint16_t& dst, const uint8_t& src, float power) const
-        {
-            float converted = saturate(pow(((src / 255.0f)), power));
-            dst = (uint16_t)(converted * USHRT_MAX);
-        }
-
-        template < >
-        inline void operator()(uint16_t& dst, const float& src, float power) const
-        {
-            float converted = saturate(pow(src, power));
-            dst = (uint16_t)(converted * USHRT_MAX);
-        }
-
-        template < >
-        inline void operator()(uint16_t& dst, const uint16_t& src, float power) const
-        {
-            float converted = saturate(float(pow((float)(src / USHRT_MAX), power)));
-            dst = uint16_t(converted * USHRT_MAX);
-        }
-        template < >
-        inline void operator()(uint16_t& dst, const half& src, float power) const
-        {
-            float converted = saturate(pow(saturate(Bitwise::halfToFloat(src())), power));
-            dst = uint16_t(converted / USHRT_MAX);
-        }
-
-        template < >
-        inline void operator()(half& dst, const uint8_t& src, float power) const
-        {
-            float converted = saturate(pow((src / 255.0f), power));
-            dst = Bitwise::floatToHalf(converted);
-        }
-
-        template < >
-        inline void operator()(half& dst, const uint16_t& src, float power) const
-        {
-            float converted = saturate(pow(float(src / USHRT_MAX), power));
-            dst = Bitwise::floatToHalf(converted);
-        }
-
-        template < >
-        inline void operator()(half& dst, const half& src, float power) const
-        {
-            float converted = saturate(pow(Bitwise::halfToFloat(src()), power));
-            dst = Bitwise::floatToHalf(converted);
-        }
-
-        template < >
-        inline void operator()(half& dst, const float& src, float power) const
-        {
-            float converted = saturate(pow(src, power));
-            dst = Bitwise::floatToHalf(converted);
-        }
-
-        template < >
-        inline void operator()(float& dst, const uint8_t& src, float power) const
-        {
-            float converted = saturate(pow(float(src / 255.0f), power));
-            dst = (float)(converted);
-        }
-
-        template < >
-        inline void operator()(float& dst, const uint16_t& src, float power) const
-        {
-            float converted = saturate(pow(float(src / USHRT_MAX), power));
-            dst = (float)(converted);
-        }
-
-        template < >
-        inline void operator()(float& dst, const half& src, float power) const
-        {
-            float converted = saturate(pow(Bitwise::halfToFloat(src()), power));
-            dst = converted;
-        }
-
-        template < >
-        inline void operator()(float& dst, const float& src, float power) const
-        {
-            float converted = saturate(pow(src, power));
-            dst = converted;
-        }
     };
 
 
@@ -307,17 +191,11 @@ namespace Ctr
             }
             else
             {
-                float power = srcGamma/dstGamma;
-                for (uint32_t i = 0; i < width; i++)
-                {
-                    size_t dstPixelId = dstOffset + (i * dstChannels);
-                    size_t srcPixelId = srcOffset + (i * srcChannels);
-                    for (uint32_t c = 0; c < dstChannels; c++)
-                    {
-                        uint32_t srcChannel = channelMapping[c];
-                        convertPixel(dst[dstPixelId + c], src[srcPixelId + srcChannel], power);
-                    }
-                }
+                // Gamma correct the source row, then convert it as is.
+                std::vector<float> srcRow(width * srcChannels);
+                Gamma::applyPower(src + srcOffset, &srcRow[0], srcRow.size(), srcGamma / dstGamma);
+                convert(size_t(0), dst + dstOffset, &srcRow[0], width, 1, 
+                        dstChannels, srcChannels, channelMapping, 1.0f, 1.0f);
             }
         }
 
@@ -348,19 +226,91 @@ namespace Ctr
             }
             else
             {
-                float power = srcGamma / dstGamma;
                 size_t dstOffset = (width * rowId) * dstChannels;
                 size_t srcOffset = (width * rowId) * srcChannels;
-                for (uint32_t i = 0; i < width; i++)
-                {
-                    size_t dstPixelId = dstOffset + (i * dstChannels);
-                    size_t srcPixelId = srcOffset + (i * srcChannels);
-                    for (uint32_t c = 0; c < dstChannels; c++)
-                        convertPixel(dst[dstPixelId + c], src[srcPixelId + c], power);
-                }
+                std::vector<float> srcRow(width * srcChannels);
+                Gamma::applyPower(src + srcOffset, &srcRow[0], srcRow.size(), srcGamma / dstGamma);
+                convert(size_t(0), dst + dstOffset, &srcRow[0], width, 1, 
+                        dstChannels, srcChannels, 1.0f, 1.0f);
             }
         }
 
+        template <typename T, typename S>
+        void convertRow(size_t rowId,
+                        T* dst,
+                        S* src,
+                        size_t width,
+                        size_t height,
+                        size_t dstChannels,
+                        size_t srcChannels,
+                        uint32_t * channelMapping,
+                        float   dstGamma,
+                        float   srcGamma)
+        {
+            if (channelMapping)
+                convert(rowId, dst, src, width, height, dstChannels, srcChannels, channelMapping, dstGamma, srcGamma);
+            else
+                convert(rowId, dst, src, width, height, dstChannels, srcChannels, dstGamma, srcGamma);
+        }
+
+        // Half rows are widened to float (and float rows narrowed to half) 
+        // with the Bitwise span conversions rather than a channel at a time.
+        template <typename T>
+        void convertRow(size_t rowId,
+                        T* dst,
+                        half* src,
+                        size_t width,
+                        size_t height,
+                        size_t dstChannels,
+                        size_t srcChannels,
+                        uint32_t * channelMapping,
+                        float   dstGamma,
+                        float   srcGamma)
+        {
+            std::vector<float> srcRow(width * srcChannels);
+            Bitwise::halfToFloat(reinterpret_cast<const uint16_t*>(src + width * rowId * srcChannels), 
+                                 &srcRow[0], srcRow.size());
+            convertRow(size_t(0), dst + width * rowId * dstChannels, &srcRow[0], 
+                       width, 1, dstChannels, srcChannels, channelMapping, dstGamma, srcGamma);
+        }
+
+        template <typename S>
+        void convertRow(size_t rowId,
+                        half* dst,
+                        S* src,
+                        size_t width,
+                        size_t height,
+                        size_t dstChannels,
+                        size_t srcChannels,
+                        uint32_t * channelMapping,
+                        float   dstGamma,
+                        float   srcGamma)
+        {
+            std::vector<float> dstRow(width * dstChannels);
+            convertRow(size_t(0), &dstRow[0], src + width * rowId * srcChannels, 
+                       width, 1, dstChannels, srcChannels, channelMapping, dstGamma, srcGamma);
+            Bitwise::floatToHalf(&dstRow[0], reinterpret_cast<uint16_t*>(dst + width * rowId * dstChannels), 
+                                 dstRow.size());
+        }
+
+        void convertRow(size_t rowId,
+                        half* dst,
+                        half* src,
+                        size_t width,
+                        size_t height,
+                        size_t dstChannels,
+                        size_t srcChannels,
+                        uint32_t * channelMapping,
+                        float   dstGamma,
+                        float   srcGamma)
+        {
+            std::vector<float> srcRow(width * srcChannels);
+            Bitwise::halfToFloat(reinterpret_cast<const uint16_t*>(src + width * rowId * srcChannels), 
+                                 &srcRow[0], srcRow.size());
+            convertRow(size_t(0), dst + width * rowId * dstChannels, &srcRow[0], 
+                       width, 1, dstChannels, srcChannels, channelMapping, dstGamma, srcGamma);
+        }
+
         template <typename T, typename S>
         void convert(T* dst, 
                      S* src,
@@ -372,20 +322,10 @@ namespace Ctr
                      float   dstGamma,
                      float   srcGamma)
         {
-            if (channelMapping)
+            concurrency::parallel_for(size_t(0), size_t(height), [&](size_t rowId)
             {
-                concurrency::parallel_for(size_t(0), size_t(height), [&](size_t rowId)
-                {
-                    convert(rowId, dst, src, width, height, dstChannels, srcChannels, channelMapping, dstGamma, srcGamma);
-                });
-            }
-            else
-            {
-                concurrency::parallel_for(size_t(0), size_t(height), [&](size_t rowId)
-                {
-                    convert(rowId, dst, src, width, height, dstChannels, srcChannels, dstGamma, srcGamma);
-                });
-            }
+                convertRow(rowId, dst, src, width, height, dstChannels, srcChannels, channelMapping, dstGamma, srcGamma);
+            });
         }
 
         uint32_t* defaultChannelMapping(size_t dstComponents, size_t srcComponents)
@@ -478,8 +418,8 @@ namespace Ctr
             Ctr::PixelFormat dstFormat = dstImage->getFormat();
             Ctr::PixelFormat srcFormat = srcImage->getFormat();
 
-            Ctr::PixelBox dstPixelBox = dstImage->getPixelBox(0, 0);
-            Ctr::PixelBox srcPixelBox = srcImage->getPixelBox(0, 0);
+            Ctr::PixelBox dstPixelBox = dstImage->getWritablePixelBox(0, 0);
+            Ctr::ConstPixelBox srcPixelBox = srcImage->getPixelBox(0, 0);
 
             Ctr::PixelComponentType dstType = PixelUtil::getComponentType(dstFormat);
             Ctr::PixelComponentType srcType = PixelUtil::getComponentType(srcFormat);
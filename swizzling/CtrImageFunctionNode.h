@@ -101,10 +101,25 @@ public:
     {
     }
 
-    virtual void refilterMip(Ctr::TextureImagePtr& mipImage) const
+    // Fix up a generated mip level (float32 RGBA) before it is used
+    // as the source of the next level.
+    virtual void refilterMip(const Ctr::PixelBox& mipPixels) const
     {
     }
 
+    // True if the pixels hold colour, which is filtered in linear space.
+    // Normals, roughness, masks and the like are filtered as stored.
+    virtual bool isColorData() const
+    {
+        IntProperty* interpretPixelsAsProperty =
+            dynamic_cast<IntProperty*>(_node->property("interpretAs"));
+        if (!interpretPixelsAsProperty)
+            return true;
+        InterpretPixelsAsType interpretAs = 
+            InterpretPixelsAsType(interpretPixelsAsProperty->get());
+        return interpretAs == UnknownImage || interpretAs == AlbedoImage;
+    }
+
     const TextureImageProperty*     imageResultProperty() const
     {
         return _imageResultProperty;
@@ -212,64 +227,20 @@ public:
                 PF_A8R8G8B8,
                 mipLevels,
                 IF_DEFAULT);
-            int32_t mipWidth = int32_t(convertedImage->getWidth());
-            int32_t mipHeight = int32_t(convertedImage->getHeight());
-
-            bool resampleLevel0 = false;
+            {
+                ConstPixelBox convertedPixels = convertedImage->getPixelBox();
+                memcpy(mipChainImage->getWritablePixelBox(0, 0).data, convertedPixels.data, convertedPixels.getConsecutiveSize());
+            }
 
+            // Filter colour in linear space and data as stored, giving the node 
+            // a chance to fix up any problems as a result of scaling down.
             // TODO: Push this to a compute shader.
-            for (int32_t mipId = 0; mipId < int32_t(mipLevels); mipId++)
+            float filterGamma = isColorData() ? dstGamma : 1.0f;
+            mipChainImage->generateMipmaps(Ctr::TextureImage::FILTER_BOX, filterGamma,
+                [this](size_t, size_t, const PixelBox& mipPixels)
             {
-                PixelBox mipLevelPixels = mipChainImage->getPixelBox(0, mipId);
-
-                if (mipId > 0)
-                {
-                    PixelBox convertedPixels = convertedImage->getPixelBox();
-
-                    if (resampleLevel0)
-                    {
-                        // Create temporary, copy and resize.
-                        Ctr::TextureImagePtr resizedConvertedImage(new Ctr::TextureImage());
-                        resizedConvertedImage->create(Ctr::Vector2i(int32_t(convertedImage->getWidth()), int32_t(convertedImage->getHeight())),
-                            PF_A8R8G8B8,
-                            (uint32_t)(0),
-                            IF_DEFAULT);
-
-                        // Resize to mip size.
-                        {
-                            PixelBox resizedPixels = resizedConvertedImage->getPixelBox();
-                            memcpy(resizedPixels.data, convertedPixels.data, convertedPixels.getConsecutiveSize());
-                        }
-                
-                        resizedConvertedImage->resize(mipWidth, mipHeight);
-
-                        // Give the node a chance to fix up any problems as a result of 
-                        // scaling down.
-                        refilterMip(resizedConvertedImage);
-
-                        // Copy to mip chain.
-                        {
-                            PixelBox resizedPixels = resizedConvertedImage->getPixelBox();
-                            memcpy(mipLevelPixels.data, resizedPixels.data, resizedPixels.getConsecutiveSize());
-                        }
-                    }
-                    else
-                    {
-                        convertedImage->resize(mipWidth, mipHeight);
-                        refilterMip(convertedImage);
-                        PixelBox convertedPixels = convertedImage->getPixelBox();
-                        memcpy(mipLevelPixels.data, convertedPixels.data, convertedPixels.getConsecutiveSize());
-                    }
-                }
-                else
-                {
-                    PixelBox convertedPixels = convertedImage->getPixelBox();
-                    memcpy(mipLevelPixels.data, convertedPixels.data, convertedPixels.getConsecutiveSize() );
-                }
-
-                mipWidth = mipWidth / 2;
-                mipHeight = mipHeight / 2;
-            }
+                refilterMip(mipPixels);
+            });
 
             Ctr::TextureParameters textureData =
                 Ctr::TextureParameters("ImageFunctionOutput",
@@ -356,7 +327,7 @@ class ImageFileSourceFunction : public ImageFunction
             sourceImage->create(Ctr::Vector2i(commonSize.x, commonSize.y), PF_A8R8G8B8, 1, 0);
 
             // Fill the missing image.
-            PixelBox sourcePixelBox = sourceImage->getPixelBox();
+            PixelBox sourcePixelBox = sourceImage->getWritablePixelBox();
             size_t sourceWidth = sourceImage->getWidth();
             size_t sourceHeight = sourceImage->getHeight();
             concurrency::parallel_for(size_t(0), size_t(sourceWidth), [&](size_t rowId)
@@ -1047,32 +1018,32 @@ public:
         }
     }
 
-    virtual void refilterMip(Ctr::TextureImagePtr& mipImage) const
+    virtual bool isColorData() const
     {
-        if (mipImage->getFormat() == PF_A8R8G8B8)
+        return false;
+    }
+
+    virtual void refilterMip(const Ctr::PixelBox& mipPixels) const
+    {
+        if (_normalizeMips)
         {
-            if (_normalizeMips)
+            float* mipTexels = (float*)mipPixels.data;
+            size_t mipWidth = mipPixels.size().x;
+            size_t mipHeight = mipPixels.size().y;
+            concurrency::parallel_for(size_t(0), size_t(mipHeight), [&](size_t rowId)
             {
-                Ctr::PixelBox mipPixelBox = mipImage->getPixelBox(0, 0);
-                size_t mipWidth = mipImage->getWidth();
-                size_t mipHeight = mipImage->getHeight();
-                uint8_t* mipPixels = (uint8_t*)mipPixelBox.data;
-                concurrency::parallel_for(size_t(0), size_t(mipHeight), [&](size_t rowId)
+                for (size_t columnId = 0; columnId < mipWidth; columnId++)
                 {
-                    for (size_t columnId = 0; columnId < mipWidth; columnId++)
-                    {
-                        size_t startId = (rowId * mipWidth);
-                        size_t pixelId = (startId + columnId) * 4;
-                        Vector3f normal(mipPixels[pixelId] / 255.0f, mipPixels[pixelId+1] / 255.0f, mipPixels[pixelId+2] / 255.0f);
-                        normal.expandUnit();
-                        normal.normalize();
-                        normal.compressUnit();
-
-                        for (uint32_t componentId = 0; componentId < 3; componentId++)
-                            mipPixels[pixelId + componentId] = uint8_t(normal[componentId] * 255.0f);
-                    }
-                });
-            }
+                    size_t texelId = ((rowId * mipWidth) + columnId) * 4;
+                    Vector3f normal(mipTexels[texelId], mipTexels[texelId+1], mipTexels[texelId+2]);
+                    normal.expandUnit();
+                    normal.normalize();
+                    normal.compressUnit();
+
+                    for (uint32_t componentId = 0; componentId < 3; componentId++)
+                        mipTexels[texelId + componentId] = normal[componentId];
+                }
+            });
         }
     }
 
@@ -1215,8 +1186,8 @@ class ImageProcessorFunction : public ImageFunctionT
                 // TODO: Mips and faces later.
                 size_t faceId = 0;
                 size_t mipId = 0;
-                Ctr::PixelBox sourcePixelBox = sourceImage->getPixelBox(faceId, mipId);
-                sources.push_back(sourcePixelBox);
+                // The operations only read their sources.
+                sources.push_back(sourceImage->getPixelBox(faceId, mipId).source());
             }
         }
 
@@ -1249,7 +1220,7 @@ class ImageProcessorFunction : public ImageFunctionT
                              format,
                              (uint32_t)(0) /* no mips*/,
                              IF_DEFAULT);
-        Ctr::PixelBox destinationPixelBox = destinationImage->getPixelBox(0,0);
+        Ctr::PixelBox destinationPixelBox = destinationImage->getWritablePixelBox(0,0);
 
         concurrency::parallel_for(size_t(0), size_t(_imageHeight), [&](size_t rowId)
         {